@@ -0,0 +1,136 @@
+import { useState, useEffect } from 'react'
+import axios from 'axios'
+
+const TCS = [0, 1, 2, 3, 4, 5, 6, 7]
+
+const fmt = (v, digits = 1) => (v === undefined || v === null ? '-' : Number(v).toFixed(digits))
+
+// Predicted (network calculus, /api/bounds) vs measured (C capture) per TC
+function BoundsCard({ gcl, idleSlopes }) {
+  const [linkMbps, setLinkMbps] = useState(1000)
+  const [guardBand, setGuardBand] = useState(true)
+  const [streams, setStreams] = useState([
+    { tc: 7, burstBytes: 128, rateKbps: 1000, maxFrame: 64 }
+  ])
+  const [bounds, setBounds] = useState(null)
+  const [measured, setMeasured] = useState(null)
+  const [error, setError] = useState(null)
+
+  // Recompute while the schedule is edited (debounced)
+  const request = JSON.stringify({ linkMbps, guardBand, gcl, idleSlopes, streams })
+  useEffect(() => {
+    const timer = setTimeout(async () => {
+      try {
+        const res = await axios.post('/api/bounds', JSON.parse(request), { timeout: 3000 })
+        setBounds(res.data)
+        setError(null)
+      } catch (err) {
+        setError(err.response?.data?.error || err.message)
+      }
+    }, 250)
+    return () => clearTimeout(timer)
+  }, [request])
+
+  useEffect(() => {
+    const poll = async () => {
+      try {
+        const res = await axios.get('/api/capture/status-c')
+        const stats = res.data.stats
+        setMeasured(stats ? (stats.analysis || stats.tc || null) : null)
+      } catch {
+        setMeasured(null)
+      }
+    }
+    poll()
+    const timer = setInterval(poll, 2000)
+    return () => clearInterval(timer)
+  }, [])
+
+  const updateStream = (idx, field, value) => {
+    const updated = [...streams]
+    updated[idx] = { ...updated[idx], [field]: parseInt(value) || 0 }
+    setStreams(updated)
+  }
+  const addStream = () => setStreams([...streams, { tc: 0, burstBytes: 1518, rateKbps: 10000, maxFrame: 1518 }])
+  const removeStream = (idx) => setStreams(streams.filter((_, i) => i !== idx))
+
+  return (
+    <div className="card">
+      <div className="card-header">
+        <h2 className="card-title">Latency Bounds (predicted vs measured)</h2>
+      </div>
+
+      <div style={{ display: 'flex', gap: '12px', alignItems: 'flex-end', marginBottom: '12px' }}>
+        <div>
+          <label className="form-label">Link (Mbps)</label>
+          <input type="number" className="form-input" style={{ width: '100px' }} value={linkMbps} onChange={(e) => setLinkMbps(parseInt(e.target.value) || 0)} />
+        </div>
+        <label style={{ fontSize: '0.85rem', display: 'flex', gap: '4px', alignItems: 'center' }}>
+          <input type="checkbox" checked={guardBand} onChange={(e) => setGuardBand(e.target.checked)} />
+          Guard band
+        </label>
+        <button className="btn btn-secondary" onClick={addStream}>+ Stream</button>
+      </div>
+
+      <table className="table" style={{ fontSize: '0.8rem', marginBottom: '12px' }}>
+        <thead>
+          <tr><th>TC</th><th>Burst (B)</th><th>Rate (kbps)</th><th>Max frame (B)</th><th></th></tr>
+        </thead>
+        <tbody>
+          {streams.map((s, idx) => (
+            <tr key={idx}>
+              {['tc', 'burstBytes', 'rateKbps', 'maxFrame'].map(field => (
+                <td key={field}>
+                  <input type="number" className="form-input" style={{ width: '90px', padding: '2px 4px' }} value={s[field]} onChange={(e) => updateStream(idx, field, e.target.value)} />
+                </td>
+              ))}
+              <td>
+                <button onClick={() => removeStream(idx)} style={{ background: 'none', border: 'none', cursor: 'pointer', color: '#dc2626' }}>X</button>
+              </td>
+            </tr>
+          ))}
+        </tbody>
+      </table>
+
+      {error && <div className="alert alert-error">{error}</div>}
+
+      {bounds && (
+        <table className="table" style={{ fontSize: '0.8rem', fontFamily: 'monospace' }}>
+          <thead>
+            <tr>
+              <th>TC</th><th>Rate (Mbps)</th><th>Latency (us)</th><th>Util</th>
+              <th>Delay bound (us)</th><th>Backlog (B)</th><th>Measured p99 / max (us)</th>
+            </tr>
+          </thead>
+          <tbody>
+            {TCS.map(tc => {
+              const b = bounds.tc?.[tc]
+              if (!b || !b.open) return null
+              const m = measured?.[tc]?.seq
+              const over = m?.lat_max_us !== undefined && b.stable && m.lat_max_us > b.delay_us
+              return (
+                <tr key={tc}>
+                  <td>TC{tc}</td>
+                  <td>{fmt(b.rate_mbps)}</td>
+                  <td>{fmt(b.latency_us)}</td>
+                  <td>{b.utilization !== undefined ? `${(b.utilization * 100).toFixed(1)}%` : '-'}</td>
+                  <td style={{ color: b.stable ? undefined : '#dc2626' }}>{b.stable ? fmt(b.delay_us) : 'unbounded'}</td>
+                  <td>{b.stable ? fmt(b.backlog_bytes, 0) : '-'}</td>
+                  <td style={{ color: over ? '#dc2626' : undefined }}>
+                    {m?.lat_max_us !== undefined ? `${fmt(m.lat_p99_us)} / ${fmt(m.lat_max_us)}` : '-'}
+                  </td>
+                </tr>
+              )
+            })}
+          </tbody>
+        </table>
+      )}
+
+      <div style={{ marginTop: '8px', fontSize: '0.75rem', color: '#64748b' }}>
+        Bounds are worst case for the streams above; measured values come from the running C capture (red = above bound).
+      </div>
+    </div>
+  )
+}
+
+export default BoundsCard
@@ -0,0 +1,158 @@
+import { useState, useEffect, useRef } from 'react'
+import axios from 'axios'
+
+const WIDTH = 720
+const ROW_H = 18
+const LEFT = 40
+
+const METRICS = [
+  { key: 'accuracy', label: 'Worst-cycle accuracy' },
+  { key: 'badShare', label: 'Cycles with wrong-slot frames' },
+  { key: 'excess', label: 'Max excess (us)' }
+]
+
+const PTP_EVENTS = [
+  { key: 'sync_gap', label: 'Sync gap' },
+  { key: 'sync_interval', label: 'Sync interval violation' },
+  { key: 'correction', label: 'correctionField jump' },
+  { key: 'gm_change', label: 'grandmaster change' },
+  { key: 'step', label: 'clock step' }
+]
+const SHOWN_DIPS = 8
+
+// "coincident with 3 missing Syncs, 1 grandmaster change"
+function ptpCause(a) {
+  if (a.cause === 'unknown') return 'no PTP timebase to compare'
+  if (a.cause !== 'ptp') return 'no PTP events around it'
+  const missing = a.events.filter(e => e.kind === 'sync_gap').reduce((n, e) => n + e.value, 0)
+  const parts = PTP_EVENTS.filter(k => a.ptp[k.key] > 0).map(k =>
+    k.key === 'sync_gap' && missing > 0 ? `${missing} missing Sync${missing > 1 ? 's' : ''}`
+      : `${a.ptp[k.key]} ${k.label}${a.ptp[k.key] > 1 ? 's' : ''}`)
+  return `coincident with ${parts.join(', ')}`
+}
+
+// 0 = good (green) .. 1 = bad (red)
+const heat = (v) => `hsl(${Math.round(120 * (1 - Math.min(Math.max(v, 0), 1)))}, 70%, 45%)`
+
+function badness(col, t, metric, maxExcess) {
+  if (metric === 'accuracy') return 1 - t.minAccuracy
+  if (metric === 'badShare') return t.badCycles / col.cycles
+  return maxExcess > 0 ? t.maxExcessNs / maxExcess : 0
+}
+
+// Per-cycle TAS scorecards of a capture session (/api/capture/cycles-c),
+// one column per ~1 s of cycles; `update` merges live WebSocket columns,
+// `anomaly` appends a live accuracy dip to the list under the map
+function CycleHeatmap({ sessionId, update, anomaly }) {
+  const [board, setBoard] = useState(null)   // { cycleNs, cyclesPerColumn, columns: Map, anomalies }
+  const [metric, setMetric] = useState('accuracy')
+  const [hover, setHover] = useState(null)
+  const canvasRef = useRef(null)
+
+  useEffect(() => {
+    setBoard(null)
+    if (!sessionId) return
+    axios.get('/api/capture/cycles-c', { params: { sessionId } }).then(res => {
+      setBoard({ ...res.data, columns: new Map(res.data.columns.map(c => [c.cycle, c])), anomalies: res.data.anomalies || [] })
+    }).catch(() => {})
+  }, [sessionId])
+
+  useEffect(() => {
+    if (!update) return
+    setBoard(prev => {
+      const columns = new Map(prev?.columns || [])
+      for (const c of update.columns) columns.set(c.cycle, c)
+      return { ...(prev || {}), cycleNs: update.cycleNs, cyclesPerColumn: update.cyclesPerColumn, dropped: update.dropped, columns }
+    })
+  }, [update])
+
+  useEffect(() => {
+    if (!anomaly) return
+    setBoard(prev => prev && { ...prev, anomalies: [...(prev.anomalies || []), anomaly] })
+  }, [anomaly])
+
+  const cols = board ? Array.from(board.columns.values()).sort((a, b) => a.cycle - b.cycle) : []
+  const tcs = Array.from(new Set(cols.flatMap(c => Object.keys(c.tc)))).sort((a, b) => a - b)
+  const maxExcess = cols.reduce((m, c) => Math.max(m, ...Object.values(c.tc).map(t => t.maxExcessNs)), 0)
+  const plotW = WIDTH - LEFT
+  // Several columns share a pixel once hours are shown; the worst one wins
+  const colW = cols.length ? Math.max(plotW / cols.length, 1) : 1
+  const height = Math.max(tcs.length, 1) * ROW_H
+
+  useEffect(() => {
+    const ctx = canvasRef.current?.getContext('2d')
+    if (!ctx) return
+    ctx.clearRect(0, 0, WIDTH, height)
+    ctx.font = '10px monospace'
+    ctx.textBaseline = 'middle'
+    tcs.forEach((tc, row) => {
+      const y = row * ROW_H
+      ctx.fillStyle = '#64748b'
+      ctx.fillText(`TC${tc}`, 4, y + ROW_H / 2)
+      const worst = new Map()
+      cols.forEach((c, i) => {
+        const t = c.tc[tc]
+        const x = Math.floor(LEFT + (cols.length > plotW ? (i * plotW) / cols.length : i * colW))
+        const v = t ? badness(c, t, metric, maxExcess) : -1
+        if (!worst.has(x) || v > worst.get(x)) worst.set(x, v)
+      })
+      for (const [x, v] of worst) {
+        ctx.fillStyle = v < 0 ? '#e2e8f0' : heat(v)
+        ctx.fillRect(x, y + 1, Math.ceil(colW), ROW_H - 2)
+      }
+    })
+  })
+
+  const onMove = (e) => {
+    const rect = e.currentTarget.getBoundingClientRect()
+    const x = e.clientX - rect.left - LEFT
+    const row = Math.floor((e.clientY - rect.top) / ROW_H)
+    if (x < 0 || row < 0 || row >= tcs.length || !cols.length) return setHover(null)
+    const i = Math.min(cols.length - 1, Math.floor(cols.length > plotW ? (x * cols.length) / plotW : x / colW))
+    setHover({ col: cols[i], tc: tcs[row], index: i })
+  }
+
+  if (!sessionId || !cols.length) return null
+
+  const seconds = (cycle) => ((cycle - cols[0].cycle) * board.cycleNs / 1e9).toFixed(0)
+  const h = hover?.col.tc[hover.tc]
+  const dips = (board.anomalies || []).slice(-SHOWN_DIPS).reverse()
+
+  return (
+    <div className="card">
+      <div className="card-header">
+        <h2 className="card-title">Cycle Scorecards</h2>
+        <select className="form-select" style={{ width: 'auto' }} value={metric} onChange={(e) => setMetric(e.target.value)}>
+          {METRICS.map(m => <option key={m.key} value={m.key}>{m.label}</option>)}
+        </select>
+      </div>
+
+      <canvas ref={canvasRef} width={WIDTH} height={height} style={{ maxWidth: '100%' }}
+        onMouseMove={onMove} onMouseLeave={() => setHover(null)} />
+
+      <div style={{ marginTop: '8px', fontSize: '0.75rem', color: '#64748b', minHeight: '1.2em' }}>
+        {hover && h ? (
+          <>TC{hover.tc} @ {seconds(hover.col.cycle)}s ({hover.col.cycles} cycles): {h.frames} frames, {h.wrong} wrong slot
+            in {h.badCycles} cycles, worst accuracy {(h.minAccuracy * 100).toFixed(1)}%, max excess {(h.maxExcessNs / 1000).toFixed(2)} us,
+            arrival {(h.firstNs / 1000).toFixed(1)}-{(h.lastNs / 1000).toFixed(1)} us</>
+        ) : (
+          <>{cols.length} columns of {board.cyclesPerColumn} cycles ({board.cycleNs / 1000} us cycle)
+            {board.dropped > 0 && `, ${board.dropped} cycles dropped`}</>
+        )}
+      </div>
+
+      {dips.length > 0 && (
+        <div style={{ marginTop: '8px', fontSize: '0.75rem' }}>
+          {dips.map(a => (
+            <div key={a.firstCycle} style={{ color: a.cause === 'ptp' ? '#b91c1c' : '#475569' }}>
+              @ {seconds(a.firstCycle)}s: accuracy fell {a.dropPct.toFixed(1)}% in cycles {a.firstCycle - cols[0].cycle}-{a.lastCycle - cols[0].cycle}
+              {' '}({(a.accuracy * 100).toFixed(1)}% vs {(a.baseline * 100).toFixed(1)}%), {ptpCause(a)}
+            </div>
+          ))}
+        </div>
+      )}
+    </div>
+  )
+}
+
+export default CycleHeatmap
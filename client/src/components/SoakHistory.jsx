@@ -0,0 +1,159 @@
+import { useState, useEffect, useCallback } from 'react'
+import axios from 'axios'
+import { LineChart, Line, XAxis, YAxis, CartesianGrid, Tooltip, ResponsiveContainer, ReferenceArea } from 'recharts'
+
+const TC_COLORS = ['#94a3b8', '#64748b', '#22c55e', '#14b8a6', '#3b82f6', '#8b5cf6', '#f59e0b', '#ef4444']
+
+const METRICS = [
+  { key: 'kbps', label: 'Throughput (kbps)' },
+  { key: 'lat_p99_us', label: 'Latency p99 (us)' },
+  { key: 'lat_max_us', label: 'Latency max (us)' },
+  { key: 'interval_p99_us', label: 'Interval p99 (us)' },
+  { key: 'lost', label: 'Lost frames' },
+  { key: 'gate_out', label: 'Out-of-gate frames' }
+]
+
+const RANGES = [
+  { label: '15m', seconds: 900 },
+  { label: '1h', seconds: 3600 },
+  { label: '6h', seconds: 6 * 3600 },
+  { label: '24h', seconds: 86400 },
+  { label: '7d', seconds: 7 * 86400 },
+  { label: 'All', seconds: 0 }
+]
+
+const POINTS = 800
+
+const fmtTime = (t, span) => {
+  const d = new Date(t * 1000)
+  return span > 2 * 86400 ? d.toLocaleDateString([], { month: 'numeric', day: 'numeric', hour: '2-digit' }) : d.toLocaleTimeString()
+}
+
+// Per-TC series of one tsn-rollup result merged into chart rows keyed by time
+function toRows(data, metric) {
+  const rows = new Map()
+  for (const [tc, s] of Object.entries(data?.tc || {})) {
+    s.t.forEach((t, i) => {
+      if (!rows.has(t)) rows.set(t, { t })
+      rows.get(t)[`tc${tc}`] = s[metric][i]
+    })
+  }
+  return Array.from(rows.values()).sort((a, b) => a.t - b.t)
+}
+
+// Long-run history of a capture rollup store (/api/rollups); drag to zoom
+function SoakHistory() {
+  const [stores, setStores] = useState([])
+  const [enabled, setEnabled] = useState(true)
+  const [store, setStore] = useState('')
+  const [metric, setMetric] = useState('kbps')
+  const [range, setRange] = useState(null)   // { from, to } or null = preset
+  const [preset, setPreset] = useState(3600)
+  const [data, setData] = useState(null)
+  const [drag, setDrag] = useState(null)
+  const [error, setError] = useState(null)
+
+  useEffect(() => {
+    axios.get('/api/rollups').then(res => {
+      setEnabled(res.data.enabled)
+      setStores(res.data.stores)
+      if (res.data.stores.length) setStore(s => s || res.data.stores[0].name)
+    }).catch(err => setError(err.response?.data?.error || err.message))
+  }, [])
+
+  const load = useCallback(async () => {
+    if (!store) return
+    const params = { points: POINTS }
+    if (range) {
+      params.from = range.from
+      params.to = range.to
+    } else if (preset > 0) {
+      params.from = Math.floor(Date.now() / 1000) - preset
+    }
+    try {
+      const res = await axios.get(`/api/rollups/${encodeURIComponent(store)}`, { params, timeout: 8000 })
+      setData(res.data)
+      setError(null)
+    } catch (err) {
+      setData(null)
+      setError(err.response?.data?.error || err.message)
+    }
+  }, [store, range, preset])
+
+  // Live ranges follow the store; zoomed ranges are fixed
+  useEffect(() => {
+    load()
+    if (range) return
+    const timer = setInterval(load, 5000)
+    return () => clearInterval(timer)
+  }, [load, range])
+
+  const finishDrag = () => {
+    if (drag?.to !== undefined && drag.to !== drag.from) {
+      setRange({ from: Math.min(drag.from, drag.to), to: Math.max(drag.from, drag.to) + (data?.bin_s || 1) })
+    }
+    setDrag(null)
+  }
+
+  if (!enabled) return null
+
+  const rows = toRows(data, metric)
+  const tcs = Object.keys(data?.tc || {})
+  const span = data ? data.to - data.from : 0
+
+  return (
+    <div className="card">
+      <div className="card-header">
+        <h2 className="card-title">Soak History</h2>
+      </div>
+
+      <div style={{ display: 'flex', gap: '8px', alignItems: 'center', flexWrap: 'wrap', marginBottom: '12px' }}>
+        <select className="form-select" style={{ width: 'auto' }} value={store} onChange={(e) => { setStore(e.target.value); setRange(null) }}>
+          {stores.length === 0 && <option value="">No stores</option>}
+          {stores.map(s => <option key={s.name} value={s.name}>{s.name}</option>)}
+        </select>
+        <select className="form-select" style={{ width: 'auto' }} value={metric} onChange={(e) => setMetric(e.target.value)}>
+          {METRICS.map(m => <option key={m.key} value={m.key}>{m.label}</option>)}
+        </select>
+        {RANGES.map(r => (
+          <button key={r.label}
+            className={`btn ${!range && preset === r.seconds ? 'btn-primary' : 'btn-secondary'}`}
+            style={{ padding: '4px 10px' }}
+            onClick={() => { setPreset(r.seconds); setRange(null) }}>
+            {r.label}
+          </button>
+        ))}
+        {range && <button className="btn btn-secondary" style={{ padding: '4px 10px' }} onClick={() => setRange(null)}>Reset zoom</button>}
+      </div>
+
+      {error && <div className="alert alert-error">{error}</div>}
+
+      <div style={{ height: '260px', userSelect: 'none' }}>
+        <ResponsiveContainer width="100%" height="100%">
+          <LineChart data={rows}
+            onMouseDown={(e) => e?.activeLabel !== undefined && setDrag({ from: e.activeLabel })}
+            onMouseMove={(e) => drag && e?.activeLabel !== undefined && setDrag({ ...drag, to: e.activeLabel })}
+            onMouseUp={finishDrag}>
+            <CartesianGrid strokeDasharray="3 3" stroke="#e2e8f0" />
+            <XAxis dataKey="t" type="number" domain={['dataMin', 'dataMax']} tickFormatter={(t) => fmtTime(t, span)} tick={{ fontSize: 10 }} />
+            <YAxis tick={{ fontSize: 10 }} width={60} />
+            <Tooltip labelFormatter={(t) => new Date(t * 1000).toLocaleString()} />
+            {tcs.map(tc => (
+              <Line key={tc} dataKey={`tc${tc}`} name={`TC${tc}`} stroke={TC_COLORS[tc]} dot={false} isAnimationActive={false} connectNulls={false} />
+            ))}
+            {drag?.to !== undefined && <ReferenceArea x1={drag.from} x2={drag.to} strokeOpacity={0.3} />}
+          </LineChart>
+        </ResponsiveContainer>
+      </div>
+
+      {data && (
+        <div style={{ marginTop: '8px', fontSize: '0.75rem', color: '#64748b' }}>
+          {data.tier} tier, {data.bin_s}s bins, {data.records} records
+          {' '}({new Date(data.extent.first * 1000).toLocaleString()} - {new Date(data.extent.last * 1000).toLocaleString()} stored)
+        </div>
+      )}
+    </div>
+  )
+}
+
+export default SoakHistory
@@ -1,4 +1,5 @@
 import { createContext, useContext, useState, useRef, useCallback, useEffect } from 'react'
+import { captureSocketUrl, decodeFrame, packetAt } from '../lib/captureStream'
 
 const CaptureContext = createContext(null)
 
@@ -13,6 +14,7 @@ export function CaptureProvider({ children }) {
   const reconnectRef = useRef(null)
   const mountedRef = useRef(true)
   const packetListenersRef = useRef(new Set())
+  const batchListenersRef = useRef(new Set())
 
   // Register packet listener (called by Capture page)
   const addPacketListener = useCallback((listener) => {
@@ -20,6 +22,12 @@ export function CaptureProvider({ children }) {
     return () => packetListenersRef.current.delete(listener)
   }, [])
 
+  // Register columnar batch listener (charts consume the typed arrays directly)
+  const addBatchListener = useCallback((listener) => {
+    batchListenersRef.current.add(listener)
+    return () => batchListenersRef.current.delete(listener)
+  }, [])
+
   // Connect WebSocket
   const connectWebSocket = useCallback(() => {
     if (wsRef.current?.readyState === WebSocket.OPEN ||
@@ -27,11 +35,9 @@ export function CaptureProvider({ children }) {
       return
     }
 
-    const wsProtocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:'
-    const wsUrl = `${wsProtocol}//${window.location.host}/ws/capture`
-
     try {
-      const ws = new WebSocket(wsUrl)
+      const ws = new WebSocket(captureSocketUrl())
+      ws.binaryType = 'arraybuffer'
 
       ws.onopen = () => {
         if (!mountedRef.current) return
@@ -42,6 +48,18 @@ export function CaptureProvider({ children }) {
       ws.onmessage = (event) => {
         if (!mountedRef.current) return
         try {
+          if (typeof event.data !== 'string') {
+            const batch = decodeFrame(event.data)
+            if (batch?.kind !== 'packets') return
+            batchListenersRef.current.forEach(listener => listener(batch))
+            if (packetListenersRef.current.size === 0) return
+            for (let i = 0; i < batch.count; i++) {
+              const packet = packetAt(batch, i)
+              packetListenersRef.current.forEach(listener => listener(packet))
+            }
+            return
+          }
+
           const msg = JSON.parse(event.data)
 
           if (msg.type === 'sync') {
@@ -159,6 +177,7 @@ export function CaptureProvider({ children }) {
     startCapture,
     stopCapture,
     addPacketListener,
+    addBatchListener,
     setError
   }
 
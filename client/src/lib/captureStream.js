@@ -0,0 +1,194 @@
+// Decoder for batched binary frames on /ws/capture (?format=binary)
+// Frame layout and column schemas: server/services/capture-stream.js
+
+const FRAME_MAGIC = 0x424e5354 // 'TSNB'
+const FRAME_VERSION = 3
+const HEADER_LEN = 16
+const MAX_TC = 8
+
+const DICT = 'dict'
+
+// Keep in sync with server/services/capture-stream.js
+const PACKET_COLUMNS = [
+  ['id', Uint32Array], ['time', Float64Array], ['captureNs', BigUint64Array],
+  ['interface', DICT], ['protocol', DICT], ['source', DICT], ['destination', DICT],
+  ['srcMac', DICT], ['dstMac', DICT], ['srcPort', Uint16Array], ['dstPort', Uint16Array],
+  ['length', Uint32Array], ['vlan', Int32Array], ['info', DICT],
+  ['ptpMsgType', DICT], ['ptpSeq', Uint16Array], ['ptpDomain', Uint8Array], ['ptpClockId', DICT],
+  ['ptpPort', Uint16Array], ['ptpTsSec', Float64Array], ['ptpTsNs', Uint32Array],
+  ['ptpCorrection', Float64Array], ['ptpTwoStep', Uint8Array], ['ptpLogPeriod', Int8Array],
+  ['ptpReqSec', Float64Array], ['ptpReqNs', Uint32Array], ['ext', DICT],
+  ['rawOffset', Uint32Array], ['rawLength', Uint32Array], ['payloadOffset', Int32Array]
+]
+
+const STATS_COLUMNS = [
+  ['session', DICT], ['elapsedMs', Float64Array], ['total', Float64Array],
+  ['tcCount', Float64Array, MAX_TC], ['tcAvgUs', Float64Array, MAX_TC],
+  ['tcMinUs', Float64Array, MAX_TC], ['tcMaxUs', Float64Array, MAX_TC],
+  ['tcKbps', Float64Array, MAX_TC], ['tcSeqCount', Float64Array, MAX_TC],
+  ['tcSeqLost', Float64Array, MAX_TC], ['tcSeqOoo', Float64Array, MAX_TC],
+  ['tcLatAvgUs', Float64Array, MAX_TC], ['tcLatMinUs', Float64Array, MAX_TC],
+  ['tcLatMaxUs', Float64Array, MAX_TC], ['tcGateIn', Float64Array, MAX_TC],
+  ['tcGateOut', Float64Array, MAX_TC], ['tcGateUnmapped', Float64Array, MAX_TC],
+  ['tcGateExcessUs', Float64Array, MAX_TC], ['ext', DICT]
+]
+
+const KINDS = { 1: ['packets', PACKET_COLUMNS], 2: ['stats', STATS_COLUMNS] }
+
+const textDecoder = new TextDecoder()
+const align8 = n => (n + 7) & ~7
+
+export function captureSocketUrl(binary = true) {
+  const wsProtocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:'
+  return `${wsProtocol}//${window.location.host}/ws/capture${binary ? '?format=binary' : ''}`
+}
+
+// Decode one frame; columns are views into the received ArrayBuffer (no copy)
+export function decodeFrame(buffer) {
+  const header = new DataView(buffer)
+  if (header.getUint32(0, true) !== FRAME_MAGIC || header.getUint8(4) !== FRAME_VERSION) return null
+  const kindInfo = KINDS[header.getUint8(5)]
+  if (!kindInfo) return null
+  const [kind, schema] = kindInfo
+  const count = header.getUint32(8, true)
+
+  let offset = HEADER_LEN
+  const columns = {}
+  const dictColumns = []
+  for (const [name, type, width = 1] of schema) {
+    const Type = type === DICT ? Uint32Array : type
+    columns[name] = new Type(buffer, offset, count * width)
+    if (type === DICT) dictColumns.push(name)
+    offset += align8(count * width * Type.BYTES_PER_ELEMENT)
+  }
+
+  const stringsOffset = offset
+  const n = new Uint32Array(buffer, stringsOffset, 1)[0]
+  const offsets = new Uint32Array(buffer, stringsOffset, n + 2)
+  const bytes = new Uint8Array(buffer)
+  const strings = [null]
+  for (let s = 1; s <= n; s++) {
+    strings.push(textDecoder.decode(bytes.subarray(stringsOffset + offsets[s], stringsOffset + offsets[s + 1])))
+  }
+  const rawStart = stringsOffset + align8(offsets[n + 1])
+
+  return { kind, count, columns, dictColumns, strings, raw: bytes.subarray(rawStart) }
+}
+
+// Dictionary index of a string in a batch (0 if absent), for filtering columns
+export function stringIndex(batch, value) {
+  const idx = batch.strings.indexOf(value)
+  return idx > 0 ? idx : 0
+}
+
+const toHex = bytes => Array.from(bytes, b => b.toString(16).padStart(2, '0')).join(' ')
+const toAscii = bytes => Array.from(bytes, b => (b >= 32 && b < 127) ? String.fromCharCode(b) : '.').join('')
+
+// Hex/ASCII dumps are only built when a packet is actually inspected
+const PACKET_PROTO = {
+  get hex() { return toHex(this.bytes) },
+  get ascii() { return toAscii(this.bytes) },
+  get payloadHex() { return this.payloadStart >= 0 ? toHex(this.bytes.subarray(this.payloadStart)) : null },
+  get payloadAscii() { return this.payloadStart >= 0 ? toAscii(this.bytes.subarray(this.payloadStart)) : null }
+}
+
+// Packet i as the object shape of the JSON protocol
+export function packetAt(batch, i) {
+  const c = batch.columns
+  const str = name => batch.strings[c[name][i]]
+  const p = Object.create(PACKET_PROTO)
+  p.id = c.id[i]
+  p.time = new Date(c.time[i]).toISOString()
+  if (c.captureNs[i]) p.captureNs = c.captureNs[i].toString()
+  p.interface = str('interface')
+  p.source = str('source') || ''
+  p.srcMac = str('srcMac') || ''
+  p.srcPort = c.srcPort[i]
+  p.destination = str('destination') || ''
+  p.dstMac = str('dstMac') || ''
+  p.dstPort = c.dstPort[i]
+  p.protocol = str('protocol')
+  p.length = c.length[i]
+  const tci = c.vlan[i]
+  p.vlan = tci >= 0 ? { pcp: (tci >> 13) & 0x07, dei: (tci >> 12) & 0x01, vid: tci & 0x0fff } : null
+  p.info = str('info') || ''
+  p.ptp = null
+  if (c.ptpMsgType[i]) {
+    p.ptp = {
+      msgType: str('ptpMsgType'),
+      sequenceId: c.ptpSeq[i],
+      domainNumber: c.ptpDomain[i],
+      clockId: str('ptpClockId'),
+      sourcePort: c.ptpPort[i],
+      sourcePortId: `${str('ptpClockId')}:${c.ptpPort[i]}`,
+      timestamp: Number.isNaN(c.ptpTsSec[i]) ? null : { seconds: c.ptpTsSec[i], nanoseconds: c.ptpTsNs[i] },
+      correction: c.ptpCorrection[i],
+      twoStepFlag: !!c.ptpTwoStep[i],
+      logMessagePeriod: c.ptpLogPeriod[i],
+      requestReceiptTimestamp: Number.isNaN(c.ptpReqSec[i]) ? null : { seconds: c.ptpReqSec[i], nanoseconds: c.ptpReqNs[i] }
+    }
+  }
+  const ext = str('ext')
+  const { coap = null, tcp = null } = ext ? JSON.parse(ext) : {}
+  p.coap = coap
+  p.tcp = tcp
+  p.bytes = batch.raw.subarray(c.rawOffset[i], c.rawOffset[i] + c.rawLength[i])
+  p.payloadStart = c.payloadOffset[i]
+  return p
+}
+
+// Stats record i as the `data` of a JSON c-capture-stats message
+export function statsAt(batch, i) {
+  const c = batch.columns
+  const tc = {}
+  for (let t = 0; t < MAX_TC; t++) {
+    const k = i * MAX_TC + t
+    if (!c.tcCount[k]) continue
+    tc[t] = {
+      count: c.tcCount[k],
+      avg_us: c.tcAvgUs[k],
+      min_us: c.tcMinUs[k],
+      max_us: c.tcMaxUs[k],
+      kbps: c.tcKbps[k]
+    }
+    if (c.tcSeqCount[k]) {
+      tc[t].seq = { count: c.tcSeqCount[k], lost: c.tcSeqLost[k], ooo: c.tcSeqOoo[k] }
+      if (!Number.isNaN(c.tcLatAvgUs[k])) {
+        Object.assign(tc[t].seq, { lat_avg_us: c.tcLatAvgUs[k], lat_min_us: c.tcLatMinUs[k], lat_max_us: c.tcLatMaxUs[k] })
+      }
+    }
+    // PTP-aligned sessions only (NaN otherwise)
+    if (!Number.isNaN(c.tcGateIn[k])) {
+      tc[t].gate = { in: c.tcGateIn[k], out: c.tcGateOut[k], unmapped: c.tcGateUnmapped[k], max_excess_us: c.tcGateExcessUs[k] }
+    }
+  }
+  const data = { elapsed_ms: c.elapsedMs[i], total: c.total[i], tc, final: false }
+
+  // Fields without a column (guard, integrity, preemption, ...) merged back
+  const ext = batch.strings[c.ext[i]]
+  if (ext) {
+    const { tc: extTc = {}, ...rest } = JSON.parse(ext)
+    Object.assign(data, rest)
+    for (const [t, { seq, ...fields }] of Object.entries(extTc)) {
+      tc[t] = { ...tc[t], ...fields }
+      if (seq) tc[t].seq = { ...tc[t].seq, ...seq }
+    }
+  }
+  return data
+}
+
+// Turn a WebSocket message (text or binary) into JSON-protocol messages
+export function captureMessages(data) {
+  if (typeof data === 'string') return [JSON.parse(data)]
+  const batch = decodeFrame(data)
+  if (!batch) return []
+  const out = []
+  for (let i = 0; i < batch.count; i++) {
+    if (batch.kind === 'packets') {
+      out.push({ type: 'packet', data: packetAt(batch, i) })
+    } else {
+      out.push({ type: 'c-capture-stats', sessionId: batch.strings[batch.columns.session[i]], data: statsAt(batch, i) })
+    }
+  }
+  return out
+}
@@ -1,6 +1,7 @@
 import { useState, useEffect, useRef } from 'react'
 import axios from 'axios'
 import { useDevices } from '../contexts/DeviceContext'
+import BoundsCard from '../components/BoundsCard'
 
 function CBS() {
   const { devices, selectedDevice, selectDevice } = useDevices()
@@ -314,6 +315,14 @@ function CBS() {
         </div>
       )}
 
+      {/* Configured shapers of the selected device plus the one being edited */}
+      <BoundsCard
+        idleSlopes={{
+          ...Object.fromEntries((deviceStatuses[selectedDevice?.id]?.shapers || []).map(s => [s.tc, s.idleSlope])),
+          [shaperTC]: idleSlope
+        }}
+      />
+
       {error && <div className="alert alert-error">{error}</div>}
 
       {lastResult && (
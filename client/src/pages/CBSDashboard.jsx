@@ -1,5 +1,6 @@
 import { useState, useEffect, useRef, useMemo } from 'react'
 import axios from 'axios'
+import { captureSocketUrl, captureMessages } from '../lib/captureStream'
 import { useDevices } from '../contexts/DeviceContext'
 
 const TAP_INTERFACE = 'enxc84d44231cc2'
@@ -249,6 +250,7 @@ function CBSDashboard() {
   const [creditHistory, setCreditHistory] = useState([])
   const [startTime, setStartTime] = useState(null)
   const wsRef = useRef(null)
+  const captureSessionRef = useRef(null)
   const creditRef = useRef({})
   const simulationRef = useRef(null)
   const monitorTCsRef = useRef(monitorTCs)
@@ -354,21 +356,24 @@ function CBSDashboard() {
   // WebSocket for capture data
   useEffect(() => {
     const connect = () => {
-      const ws = new WebSocket(`${location.protocol === 'https:' ? 'wss:' : 'ws:'}//${location.host}/ws/capture`)
+      const ws = new WebSocket(captureSocketUrl())
+      ws.binaryType = 'arraybuffer'
       ws.onopen = () => setTapConnected(true)
       ws.onclose = () => { setTapConnected(false); setTimeout(connect, 3000) }
       ws.onmessage = (e) => {
         try {
-          const msg = JSON.parse(e.data)
-          if (msg.type === 'c-capture-stats') {
-            setCaptureStats(msg.data)
-            // startTimeRef를 사용하여 최신 startTime 참조
-            if (startTimeRef.current) {
-              const elapsed = Date.now() - startTimeRef.current
-              updateCredit(msg.data, elapsed)
+          for (const msg of captureMessages(e.data)) {
+            if (msg.sessionId && msg.sessionId !== captureSessionRef.current) continue
+            if (msg.type === 'c-capture-stats') {
+              setCaptureStats(msg.data)
+              // startTimeRef를 사용하여 최신 startTime 참조
+              if (startTimeRef.current) {
+                const elapsed = Date.now() - startTimeRef.current
+                updateCredit(msg.data, elapsed)
+              }
+            } else if (msg.type === 'c-capture-stopped' && msg.stats?.analysis) {
+              setCaptureStats(prev => ({ ...prev, final: true, analysis: msg.stats.analysis }))
             }
-          } else if (msg.type === 'c-capture-stopped' && msg.stats?.analysis) {
-            setCaptureStats(prev => ({ ...prev, final: true, analysis: msg.stats.analysis }))
           }
         } catch {}
       }
@@ -490,7 +495,10 @@ function CBSDashboard() {
     const totalPps = trafficInfo.totalPps
 
     try {
-      await axios.post('/api/capture/start-c', { interface: TAP_INTERFACE, duration: duration + 2, vlanId })
+      // Idle slopes let the engine judge each TC's burst against its CBS envelope
+      const cbs = Object.fromEntries(Object.entries(idleSlope).filter(([, kbps]) => kbps < LINK_SPEED_KBPS))
+      const { data } = await axios.post('/api/capture/start-c', { interface: TAP_INTERFACE, duration: duration + 2, vlanId, cbs })
+      captureSessionRef.current = data.sessionId
       await new Promise(r => setTimeout(r, 300))
       setTrafficRunning(true)
       setStartTime(Date.now())  // 트래픽 시작 직전에 시간 설정
@@ -508,7 +516,7 @@ function CBSDashboard() {
     setTrafficRunning(false)
     stopSimulation()
     try { await axios.post(`${TRAFFIC_API}/api/traffic/stop-precision`, {}) } catch {}
-    try { await axios.post('/api/capture/stop-c', {}) } catch {}
+    try { await axios.post('/api/capture/stop-c', { sessionId: captureSessionRef.current }) } catch {}
   }
 
   // TC별 예상 트래픽 계산
@@ -749,6 +757,7 @@ function CBSDashboard() {
                   <th style={{ padding: '12px', textAlign: 'right', fontWeight: '600' }}>실제 속도</th>
                   <th style={{ padding: '12px', textAlign: 'right', fontWeight: '600' }}>전송 속도</th>
                   <th style={{ padding: '12px', textAlign: 'right', fontWeight: '600' }}>Idle Slope</th>
+                  <th style={{ padding: '12px', textAlign: 'right', fontWeight: '600' }}>Burst σ / 허용</th>
                   <th style={{ padding: '12px', textAlign: 'center', fontWeight: '600' }}>결과</th>
                 </tr>
               </thead>
@@ -756,6 +765,8 @@ function CBSDashboard() {
                 {selectedTCs.map(tc => {
                   const stats = captureStats.tc?.[tc] || captureStats.analysis?.[tc]
                   const info = trafficInfo[tc]
+                  // Token-bucket fit from the final analysis (measured σ vs CBS envelope)
+                  const fit = captureStats.analysis?.[tc]?.arrival ? captureStats.analysis[tc] : null
                   const actualKbps = stats?.kbps || 0
                   // Shaping 판정: 실제 속도가 전송 속도의 80% 미만이면 shaped
                   const wasShaped = actualKbps > 0 && actualKbps < info.trafficKbps * 0.8
@@ -772,6 +783,9 @@ function CBSDashboard() {
                       <td style={{ padding: '12px', textAlign: 'right', fontFamily: 'monospace', fontWeight: '600' }}>{actualKbps ? formatBw(actualKbps) : '-'}</td>
                       <td style={{ padding: '12px', textAlign: 'right', fontFamily: 'monospace', color: colors.textMuted }}>{formatBw(info.trafficKbps)}</td>
                       <td style={{ padding: '12px', textAlign: 'right', fontFamily: 'monospace', color: info.willShape ? colors.error : colors.textMuted }}>{formatBw(info.slope)}</td>
+                      <td style={{ padding: '12px', textAlign: 'right', fontFamily: 'monospace', color: fit ? (fit.shaped ? colors.success : colors.error) : colors.textMuted }}>
+                        {fit ? `${fit.arrival.burst_at_cfg_bytes} / ${fit.arrival.cfg_burst_bytes} B` : '-'}
+                      </td>
                       <td style={{ padding: '12px', textAlign: 'center' }}>
                         {stats?.count ? (
                           <span style={{ padding: '6px 12px', borderRadius: '6px', fontSize: '0.8rem', fontWeight: '700',
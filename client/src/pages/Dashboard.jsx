@@ -1,5 +1,6 @@
 import { useState, useEffect, useRef, useCallback } from 'react'
 import axios from 'axios'
+import { captureSocketUrl, decodeFrame, packetAt, stringIndex } from '../lib/captureStream'
 import { useDevices } from '../contexts/DeviceContext'
 import { LineChart, Line, XAxis, YAxis, CartesianGrid, Tooltip, ResponsiveContainer, ReferenceLine } from 'recharts'
 
@@ -334,16 +335,26 @@ function Dashboard() {
   }, [autoRefresh, devices, refreshInterval, fetchAll])
 
   useEffect(() => {
-    const wsProtocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:'
-    const wsUrl = `${wsProtocol}//${window.location.host}/ws/capture`
-
     const connect = () => {
-      const ws = new WebSocket(wsUrl)
+      const ws = new WebSocket(captureSocketUrl())
+      ws.binaryType = 'arraybuffer'
       ws.onopen = () => setTapConnected(true)
       ws.onclose = () => { setTapConnected(false); setTimeout(connect, 3000) }
       ws.onerror = () => {}
       ws.onmessage = (event) => {
         try {
+          if (typeof event.data !== 'string') {
+            // Only PTP rows of a packet batch are materialized
+            const batch = decodeFrame(event.data)
+            if (batch?.kind !== 'packets') return
+            const ptpIdx = stringIndex(batch, 'PTP')
+            if (!ptpIdx) return
+            const protocol = batch.columns.protocol
+            for (let i = 0; i < batch.count; i++) {
+              if (protocol[i] === ptpIdx) handlePtpPacket(packetAt(batch, i))
+            }
+            return
+          }
           const msg = JSON.parse(event.data)
           if (msg.type === 'sync') {
             setTapCapturing(msg.data.running && msg.data.activeCaptures.some(c => c.interface === TAP_INTERFACE))
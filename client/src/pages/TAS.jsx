@@ -1,6 +1,7 @@
 import { useState, useEffect, useRef } from 'react'
 import axios from 'axios'
 import { useDevices } from '../contexts/DeviceContext'
+import BoundsCard from '../components/BoundsCard'
 
 function TAS() {
   const { devices, selectedDevice, selectDevice } = useDevices()
@@ -456,6 +457,13 @@ function TAS() {
         </>
       )}
 
+      <BoundsCard
+        gcl={{
+          entries: gateEntries.map(e => ({ gates: gatesToInt(e.gates), time: e.timeUs * 1000 })),
+          cycleNs: cycleTimeUs * 1000
+        }}
+      />
+
       {error && <div className="alert alert-error">{error}</div>}
 
       {lastResult && (
@@ -1,6 +1,9 @@
 import { useState, useEffect, useRef, useMemo } from 'react'
 import axios from 'axios'
+import { captureSocketUrl, captureMessages } from '../lib/captureStream'
 import { useDevices } from '../contexts/DeviceContext'
+import SoakHistory from '../components/SoakHistory'
+import CycleHeatmap from '../components/CycleHeatmap'
 
 const TAP_INTERFACE = 'enxc84d44231cc2'
 const TRAFFIC_INTERFACE = 'enx00e04c681336'
@@ -162,6 +165,10 @@ function TASDashboard() {
   const [rxHistory, setRxHistory] = useState([])
   const [startTime, setStartTime] = useState(null)
   const wsRef = useRef(null)
+  const captureSessionRef = useRef(null)
+  const [captureSession, setCaptureSession] = useState(null)
+  const [cycleUpdate, setCycleUpdate] = useState(null)
+  const [anomalyUpdate, setAnomalyUpdate] = useState(null)
 
   const board = devices.find(d => d.name?.includes('#1') || d.device?.includes('ACM0')) ||
                 devices.find(d => d.name?.includes('#2') || d.device?.includes('ACM1'))
@@ -187,6 +194,11 @@ function TASDashboard() {
       const guardMatch = yaml.match(/admin-cycle-time-extension:\s*(\d+)/)
       if (guardMatch) data.guard = parseInt(guardMatch[1])
 
+      // AdminBaseTime in PTP ns (exceeds Number precision)
+      const baseSec = yaml.match(/admin-base-time:[\s\S]*?\bseconds:\s*'?(\d+)/)
+      const baseNs = yaml.match(/admin-base-time:[\s\S]*?nanoseconds:\s*(\d+)/)
+      if (baseSec) data.baseTimeNs = (BigInt(baseSec[1]) * 1000000000n + BigInt(baseNs?.[1] || 0)).toString()
+
       const gclMatch = yaml.match(/admin-control-list:[\s\S]*?gate-control-entry:([\s\S]*?)(?=oper-|$)/)
       if (gclMatch) {
         const entries = [...gclMatch[1].matchAll(/gate-states-value:\s*(\d+)[\s\S]*?time-interval-value:\s*(\d+)/g)]
@@ -251,29 +263,36 @@ function TASDashboard() {
   // WebSocket for RX capture data
   useEffect(() => {
     const connect = () => {
-      const ws = new WebSocket(`${location.protocol === 'https:' ? 'wss:' : 'ws:'}//${location.host}/ws/capture`)
+      const ws = new WebSocket(captureSocketUrl())
+      ws.binaryType = 'arraybuffer'
       ws.onopen = () => setTapConnected(true)
       ws.onclose = () => { setTapConnected(false); setTimeout(connect, 3000) }
       ws.onmessage = (e) => {
         try {
-          const msg = JSON.parse(e.data)
-          if (msg.type === 'c-capture-stats') {
-            setRxStats(msg.data)
-            // startTime 기준으로 시간 계산 (TX와 동기화)
-            if (startTime) {
-              const elapsed = Date.now() - startTime
-              setRxHistory(prev => {
-                const newEntry = { time: elapsed, tc: {} }
-                for (let tc = 0; tc < 8; tc++) {
-                  const current = msg.data.tc?.[tc]?.count || 0
-                  const prevTotal = prev.length > 0 ? prev.reduce((sum, d) => sum + (d.tc[tc] || 0), 0) : 0
-                  newEntry.tc[tc] = Math.max(0, current - prevTotal)
-                }
-                return [...prev.slice(-60), newEntry]
-              })
+          for (const msg of captureMessages(e.data)) {
+            if (msg.sessionId && msg.sessionId !== captureSessionRef.current) continue
+            if (msg.type === 'c-capture-stats') {
+              setRxStats(msg.data)
+              // startTime 기준으로 시간 계산 (TX와 동기화)
+              if (startTime) {
+                const elapsed = Date.now() - startTime
+                setRxHistory(prev => {
+                  const newEntry = { time: elapsed, tc: {} }
+                  for (let tc = 0; tc < 8; tc++) {
+                    const current = msg.data.tc?.[tc]?.count || 0
+                    const prevTotal = prev.length > 0 ? prev.reduce((sum, d) => sum + (d.tc[tc] || 0), 0) : 0
+                    newEntry.tc[tc] = Math.max(0, current - prevTotal)
+                  }
+                  return [...prev.slice(-60), newEntry]
+                })
+              }
+            } else if (msg.type === 'c-capture-cycles') {
+              setCycleUpdate(msg.data)
+            } else if (msg.type === 'c-capture-anomaly') {
+              setAnomalyUpdate(msg.data)
+            } else if (msg.type === 'c-capture-stopped' && msg.stats?.analysis) {
+              setRxStats(prev => ({ ...prev, final: true, analysis: msg.stats.analysis }))
             }
-          } else if (msg.type === 'c-capture-stopped' && msg.stats?.analysis) {
-            setRxStats(prev => ({ ...prev, final: true, analysis: msg.stats.analysis }))
           }
         } catch {}
       }
@@ -307,7 +326,12 @@ function TASDashboard() {
     const now = Date.now()
     setStartTime(now)
     try {
-      await axios.post('/api/capture/start-c', { interface: TAP_INTERFACE, duration: duration + 2, vlanId })
+      // GCL lets the engine infer per-TC queue depth at each gate open; with the
+      // AdminBaseTime it checks every frame against the gates in switch PTP time
+      const gcl = tasData.gcl?.length ? { entries: tasData.gcl, cycleNs: tasData.cycleNs, ptpBaseNs: tasData.baseTimeNs } : undefined
+      const { data } = await axios.post('/api/capture/start-c', { interface: TAP_INTERFACE, duration: duration + 2, vlanId, gcl })
+      captureSessionRef.current = data.sessionId
+      setCaptureSession(data.sessionId)
       await new Promise(r => setTimeout(r, 500))
       setTrafficRunning(true)
       // 초기 TX 엔트리 추가
@@ -325,7 +349,7 @@ function TASDashboard() {
   const stopTest = async () => {
     setTrafficRunning(false)
     try { await axios.post(`${TRAFFIC_API}/api/traffic/stop-precision`, {}) } catch {}
-    try { await axios.post('/api/capture/stop-c', {}) } catch {}
+    try { await axios.post('/api/capture/stop-c', { sessionId: captureSessionRef.current }) } catch {}
   }
 
   const cycleMs = tasData.cycleNs ? tasData.cycleNs / 1_000_000 : 1000
@@ -368,6 +392,17 @@ function TASDashboard() {
     return matrix
   }, [rxStats, selectedTCs, tasData, cycleMs])
 
+  // Share of frames inside their gate windows (PTP-aligned sessions)
+  const gateAlign = useMemo(() => {
+    let inGate = 0, total = 0
+    Object.values(rxStats?.tc || {}).forEach(rx => {
+      if (!rx.gate) return
+      inGate += rx.gate.in
+      total += rx.gate.in + rx.gate.out
+    })
+    return total ? inGate / total : null
+  }, [rxStats])
+
   const getSlot = (tc) => {
     if (!tasData.gcl?.length) return null
     for (let i = 0; i < tasData.gcl.length; i++) {
@@ -394,7 +429,7 @@ function TASDashboard() {
       </div>
 
       {/* Status Bar */}
-      <div style={{ display: 'grid', gridTemplateColumns: 'repeat(6, 1fr)', gap: '10px', marginBottom: '16px' }}>
+      <div style={{ display: 'grid', gridTemplateColumns: 'repeat(7, 1fr)', gap: '10px', marginBottom: '16px' }}>
         {[
           { label: 'BOARD', value: board?.name?.split(' ')[0] || 'N/A' },
           { label: 'TAS', value: tasData.enabled ? 'ENABLED' : 'DISABLED', color: tasData.enabled ? colors.success : colors.textMuted },
@@ -402,6 +437,7 @@ function TASDashboard() {
           { label: 'GUARD', value: `${tasData.guard || 0} ns` },
           { label: 'SLOTS', value: `${slotCount}` },
           { label: 'SLOT TIME', value: `${(cycleMs / slotCount).toFixed(1)} ms` },
+          { label: 'PTP ALIGN', value: gateAlign === null ? '-' : `${(gateAlign * 100).toFixed(1)}%`, color: gateAlign === null ? colors.textMuted : gateAlign > 0.99 ? colors.success : colors.error },
         ].map((item, i) => (
           <div key={i} style={{ ...card, marginBottom: 0, padding: '12px' }}>
             <div style={{ fontSize: '0.65rem', color: colors.textMuted, marginBottom: '4px' }}>{item.label}</div>
@@ -643,6 +679,10 @@ function TASDashboard() {
           </div>
         </div>
       )}
+
+      <CycleHeatmap sessionId={captureSession} update={cycleUpdate} anomaly={anomalyUpdate} />
+
+      <SoakHistory />
     </div>
   )
 }
@@ -25,9 +25,15 @@ import patchRoutes from './routes/patch.js';
 import getRoutes from './routes/get.js';
 import configRoutes from './routes/config.js';
 import rpcRoutes from './routes/rpc.js';
-import captureRoutes, { setWsClients, getCaptureState } from './routes/capture.js';
+import captureRoutes, { getCaptureState } from './routes/capture.js';
+import { captureStream } from './services/capture-stream.js';
 import trafficRoutes from './routes/traffic.js';
 import ptpRoutes from './routes/ptp.js';
+import boundsRoutes from './routes/bounds.js';
+import gclRoutes from './routes/gcl.js';
+import rollupRoutes from './routes/rollups.js';
+import fleetRoutes from './routes/fleet.js';
+import campaignRoutes from './routes/campaign.js';
 
 const __filename = fileURLToPath(import.meta.url);
 const __dirname = dirname(__filename);
@@ -39,13 +45,16 @@ const PORT = process.env.PORT || 3000;
 const server = http.createServer(app);
 
 // WebSocket server for packet capture
-const wss = new WebSocketServer({ server, path: '/ws/capture' });
-const wsClients = new Set();
+// Batched binary frames compress well; WS_DEFLATE=1 enables permessage-deflate
+const wss = new WebSocketServer({
+  server,
+  path: '/ws/capture',
+  perMessageDeflate: process.env.WS_DEFLATE === '1' ? { threshold: 1024 } : false
+});
 
-wss.on('connection', (ws) => {
+wss.on('connection', (ws, req) => {
   console.log('WebSocket client connected');
-  wsClients.add(ws);
-  setWsClients(wsClients);
+  captureStream.attach(ws, req);
 
   // Send current capture state to newly connected client
   const state = getCaptureState();
@@ -60,14 +69,10 @@ wss.on('connection', (ws) => {
 
   ws.on('close', () => {
     console.log('WebSocket client disconnected');
-    wsClients.delete(ws);
-    setWsClients(wsClients);
   });
 
   ws.on('error', (err) => {
     console.error('WebSocket error:', err.message);
-    wsClients.delete(ws);
-    setWsClients(wsClients);
   });
 });
 
@@ -90,6 +95,11 @@ app.use('/api/rpc', rpcRoutes);
 app.use('/api/capture', captureRoutes);
 app.use('/api/traffic', trafficRoutes);
 app.use('/api/ptp', ptpRoutes);
+app.use('/api/bounds', boundsRoutes);
+app.use('/api/gcl', gclRoutes);
+app.use('/api/rollups', rollupRoutes);
+app.use('/api/fleet', fleetRoutes);
+app.use('/api/campaigns', campaignRoutes);
 
 // Health check (must be before static wildcard)
 app.get('/api/health', (req, res) => {
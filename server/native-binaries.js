@@ -0,0 +1,21 @@
+import fs from 'fs';
+import path from 'path';
+import { fileURLToPath } from 'url';
+
+const __dirname = path.dirname(fileURLToPath(import.meta.url));
+
+// CMake output (server/build, see CMakeLists.txt) first, then binaries built in-tree
+const SEARCH_DIRS = [
+  process.env.TSNPERF_BIN_DIR,
+  path.join(__dirname, 'build'),
+  __dirname
+].filter(Boolean);
+
+// Resolve a native engine binary (traffic-sender, traffic-capture, ...)
+export function resolveBinary(name) {
+  for (const dir of SEARCH_DIRS) {
+    const candidate = path.join(dir, name);
+    if (fs.existsSync(candidate)) return candidate;
+  }
+  return path.join(__dirname, name);
+}
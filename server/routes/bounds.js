@@ -0,0 +1,69 @@
+import express from 'express';
+import { execFile } from 'child_process';
+import { resolveBinary } from '../native-binaries.js';
+
+const router = express.Router();
+
+const BOUND_TIMEOUT_MS = 2000;
+
+// tsn-bound command line from a request body (see docs/TAS-GCL-Analysis.md)
+export function boundArgs(body = {}) {
+  const args = ['--link', String(body.linkMbps || 1000)];
+
+  const gcl = body.gcl;
+  const entries = Array.isArray(gcl) ? gcl : (gcl?.entries || []);
+  if (entries.length > 0) {
+    args.push('--gcl', entries.map(e => `${e.gates}:${e.time ?? e.interval}`).join(','));
+    if (gcl.cycleNs) args.push('--cycle', String(gcl.cycleNs));
+  }
+  if (body.guardBand === false) args.push('--no-guard');
+  if (body.beFrame !== undefined) args.push('--be-frame', String(body.beFrame));
+
+  // { "6": 20000 } or [{ tc, idleSlope }], kbps
+  const slopes = Array.isArray(body.idleSlopes)
+    ? body.idleSlopes.map(s => [s.tc, s.idleSlope])
+    : Object.entries(body.idleSlopes || {});
+  for (const [tc, kbps] of slopes) {
+    if (Number(kbps) > 0) args.push('--cbs', `${tc}:${kbps}`);
+  }
+
+  for (const s of body.streams || []) {
+    const spec = [s.tc, s.burstBytes ?? 0, s.rateKbps ?? 0];
+    if (s.maxFrame) spec.push(s.maxFrame);
+    args.push('--stream', spec.join(':'));
+  }
+  return args;
+}
+
+function runBound(args) {
+  return new Promise((resolve, reject) => {
+    execFile(resolveBinary('tsn-bound'), args, { timeout: BOUND_TIMEOUT_MS }, (err, stdout, stderr) => {
+      if (err) {
+        reject(new Error(stderr.trim() || err.message));
+        return;
+      }
+      try {
+        resolve(JSON.parse(stdout));
+      } catch (e) {
+        reject(new Error(`Invalid tsn-bound output: ${e.message}`));
+      }
+    });
+  });
+}
+
+/**
+ * POST /api/bounds
+ * Worst-case per-TC delay/backlog bounds for a port configuration
+ * Body: { linkMbps, gcl: { entries: [{ gates, time }], cycleNs }, guardBand,
+ *         beFrame, idleSlopes: { tc: kbps }, streams: [{ tc, burstBytes, rateKbps, maxFrame }] }
+ */
+router.post('/', async (req, res) => {
+  try {
+    const bounds = await runBound(boundArgs(req.body));
+    res.json(bounds);
+  } catch (err) {
+    res.status(400).json({ error: err.message });
+  }
+});
+
+export default router;
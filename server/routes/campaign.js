@@ -0,0 +1,145 @@
+import express from 'express';
+import path from 'path';
+import { fileURLToPath } from 'url';
+import fs from 'fs';
+import { CampaignRunner } from '../services/campaign.js';
+import { pushFleet } from '../services/fleet-push.js';
+import { tasPatches, gateTablePath } from './gcl.js';
+
+const __dirname = path.dirname(fileURLToPath(import.meta.url));
+const TSC2CBOR_LIB = path.resolve(__dirname, '../../tsc2cbor/lib');
+
+const router = express.Router();
+
+async function findYangCache(cacheOption) {
+  const { YangCatalogManager } = await import(`${TSC2CBOR_LIB}/yang-catalog/yang-catalog.js`);
+
+  if (cacheOption) {
+    if (!fs.existsSync(cacheOption)) {
+      throw new Error(`Cache directory not found: ${cacheOption}`);
+    }
+    return cacheOption;
+  }
+
+  const yangCatalog = new YangCatalogManager();
+  const catalogs = yangCatalog.listCachedCatalogs();
+
+  if (catalogs.length === 0) {
+    throw new Error('No YANG catalog found. Please download first.');
+  }
+
+  return catalogs[0].path;
+}
+
+// A run's GCL on the pair's switch port; the schedule keeps the port's
+// AdminBaseTime, config-change starts it on the next cycle
+async function pushGcl(pair, gcl, campaign) {
+  const cacheDir = await findYangCache(campaign.cache);
+  const port = String(pair.target.gclPort ?? gcl.port);
+  const target = {
+    ...pair.target,
+    id: pair.id,
+    patches: [
+      ...tasPatches(port, gcl.entries, gcl.cycleNs, { cycleTimeExtensionNs: gcl.cycleTimeExtensionNs }),
+      { path: `${gateTablePath(port)}/config-change`, value: true }
+    ],
+    readBack: []
+  };
+  const { boards } = await pushFleet([target], { cacheDir, verify: false });
+  if (!boards[0].pushed) throw new Error(`GCL push: ${boards[0].error}`);
+}
+
+export const campaignRunner = new CampaignRunner({ pushGcl });
+
+function findCampaign(req, res) {
+  const campaign = campaignRunner.get(req.params.id);
+  if (!campaign) res.status(404).json({ error: `Campaign ${req.params.id} not found` });
+  return campaign;
+}
+
+function play(campaign) {
+  campaignRunner.start(campaign).catch((err) => {
+    console.error(`[campaign ${campaign.id}]`, err.message);
+  });
+}
+
+/**
+ * GET /api/campaigns
+ * Campaigns in the archive (newest first) with progress
+ */
+router.get('/', (req, res) => {
+  res.json({ campaigns: campaignRunner.list() });
+});
+
+/**
+ * POST /api/campaigns
+ * Create a sweep campaign and start it
+ * Body: { name, sweep: { base, axes: { gcl|packetsPerSecond|frameSize|tcList|vlanId|prbs|duration: [...] }, repeat },
+ *         pairs: [{ id, sender, capture, dstMac, srcMac, senderCpu, captureCpus, drainCpu, workers,
+ *                   target: { host, port, transport, device, gclPort } }],
+ *         settleMs, leadMs, tailMs, cache, start }
+ */
+router.post('/', (req, res) => {
+  const { start = true, ...definition } = req.body;
+  try {
+    const campaign = campaignRunner.create(definition);
+    if (start) play(campaign);
+    res.json({ ...campaignRunner.describe(campaign), runs: campaignRunner.runList(campaign) });
+  } catch (err) {
+    res.status(400).json({ error: err.message });
+  }
+});
+
+/**
+ * GET /api/campaigns/:id
+ * Progress and per-run status/summary (runs in sweep order)
+ */
+router.get('/:id', (req, res) => {
+  const campaign = findCampaign(req, res);
+  if (!campaign) return;
+  res.json({
+    ...campaignRunner.describe(campaign),
+    sweep: campaign.sweep,
+    runs: campaignRunner.runList(campaign)
+  });
+});
+
+/**
+ * GET /api/campaigns/:id/runs/:runId
+ * Archived record of one run: parameters, sender and capture results
+ */
+router.get('/:id/runs/:runId', (req, res) => {
+  const campaign = findCampaign(req, res);
+  if (!campaign) return;
+  const record = campaignRunner.readRun(campaign, req.params.runId);
+  if (!record) return res.status(404).json({ error: `Run ${req.params.runId} has no results` });
+  res.json(record);
+});
+
+/**
+ * POST /api/campaigns/:id/resume
+ * Play the runs that are not done yet (pending, failed, interrupted)
+ */
+router.post('/:id/resume', (req, res) => {
+  const campaign = findCampaign(req, res);
+  if (!campaign) return;
+  try {
+    play(campaign);
+    res.json(campaignRunner.describe(campaign));
+  } catch (err) {
+    res.status(409).json({ error: err.message });
+  }
+});
+
+/**
+ * POST /api/campaigns/:id/stop
+ * Stop after killing the running senders; interrupted runs play again on resume
+ */
+router.post('/:id/stop', (req, res) => {
+  const campaign = findCampaign(req, res);
+  if (!campaign) return;
+  campaignRunner.stop(campaign);
+  res.json(campaignRunner.describe(campaign));
+});
+
+export default router;
@@ -1,22 +1,14 @@
 import express from 'express';
 import Cap from 'cap';
-import { spawn } from 'child_process';
-import path from 'path';
-import { fileURLToPath } from 'url';
-
-const __filename = fileURLToPath(import.meta.url);
-const __dirname = path.dirname(__filename);
+import { captureService } from '../services/capture-service.js';
+import { captureStream } from '../services/capture-stream.js';
 
 const router = express.Router();
 
-// C capture process state
-let cCaptureProcess = null;
-let cCaptureStats = null;
 const { Cap: CapLib, decoders } = Cap;
 
 // Multiple captures (one per interface)
 let captures = new Map(); // interface name -> { cap, packetCount }
-let wsClients = new Set();
 let globalPacketCount = 0;
 
 // CoAP message types
@@ -166,11 +158,6 @@ function parseCoAP(buffer, offset = 0) {
   };
 }
 
-// Set WebSocket clients
-export function setWsClients(clients) {
-  wsClients = clients;
-}
-
 // Get current capture state for sync
 export function getCaptureState() {
   const active = [];
@@ -186,22 +173,7 @@ export function getCaptureState() {
 }
 
 function broadcast(data) {
-  const message = JSON.stringify(data);
-  wsClients.forEach(client => {
-    try {
-      if (client.readyState === 1) client.send(message);
-    } catch (e) {
-      // Ignore send errors
-    }
-  });
-}
-
-function toHex(buffer) {
-  return Array.from(buffer).map(b => b.toString(16).padStart(2, '0')).join(' ');
-}
-
-function toAscii(buffer) {
-  return Array.from(buffer).map(b => (b >= 32 && b < 127) ? String.fromCharCode(b) : '.').join('');
+  captureStream.send(data);
 }
 
 // Get available interfaces
@@ -280,6 +252,7 @@ router.post('/start', (req, res) => {
 
         const rawPacket = buffer.slice(0, nbytes);
         const captureTime = process.hrtime.bigint(); // High-resolution timestamp
+        const captureMs = Date.now();
 
         try {
           // Decode layers
@@ -294,7 +267,7 @@ router.post('/start', (req, res) => {
           let ptp = null;
           let tcp = null;
           let info = '';
-          let udpPayload = null;
+          let udpPayloadOffset = -1;
           let srcMac = '', dstMac = '';
           let source = '', destination = '';
 
@@ -350,9 +323,9 @@ router.post('/start', (req, res) => {
                 captureInfo.packetCount++;
                 globalPacketCount++;
 
-                const packetData = {
+                captureStream.pushPacket({
                   id: globalPacketCount,
-                  time: new Date().toISOString(),
+                  timeMs: captureMs,
                   interface: ifaceName,
                   source,
                   destination,
@@ -373,13 +346,8 @@ router.post('/start', (req, res) => {
                     twoStepFlag: ptp.twoStepFlag,
                     logMessagePeriod: ptp.logMessagePeriod,
                     requestReceiptTimestamp: ptp.requestReceiptTimestamp
-                  }
-                };
-
-                wsClients.forEach(ws => {
-                  if (ws.readyState === 1) {
-                    ws.send(JSON.stringify({ type: 'packet', data: packetData }));
-                  }
+                  },
+                  raw: Buffer.from(rawPacket)
                 });
               }
               return; // Done processing gPTP packet
@@ -403,8 +371,8 @@ router.post('/start', (req, res) => {
             info = `UDP ${srcPort} -> ${dstPort}`;
 
             // UDP header is 8 bytes, payload starts after
-            const udpPayloadOffset = ipInfo.offset + 8;
-            udpPayload = rawPacket.slice(udpPayloadOffset);
+            udpPayloadOffset = ipInfo.offset + 8;
+            const udpPayload = rawPacket.slice(udpPayloadOffset);
 
             // Check for PTP (ports 319, 320)
             if (srcPort === 319 || srcPort === 320 || dstPort === 319 || dstPort === 320) {
@@ -463,10 +431,11 @@ router.post('/start', (req, res) => {
           captureInfo.packetCount++;
           globalPacketCount++;
 
-          const packet = {
+          // Raw bytes are copied: the capture buffer is reused for the next packet
+          captureStream.pushPacket({
             id: globalPacketCount,
-            time: new Date().toISOString(),
-            captureNs: captureTime.toString(),
+            timeMs: captureMs,
+            captureNs: captureTime,
             interface: ifaceName,
             source: ipInfo.info.srcaddr,
             srcMac,
@@ -499,13 +468,9 @@ router.post('/start', (req, res) => {
             } : null,
             tcp: tcp,
             info,
-            hex: toHex(rawPacket),
-            ascii: toAscii(rawPacket),
-            payloadHex: udpPayload ? toHex(udpPayload) : null,
-            payloadAscii: udpPayload ? toAscii(udpPayload) : null
-          };
-
-          broadcast({ type: 'packet', data: packet });
+            raw: Buffer.from(rawPacket),
+            payloadOffset: udpPayloadOffset
+          });
         } catch (err) {
           // Log decode errors for debugging
           if (!captureInfo.errorCount) captureInfo.errorCount = 0;
@@ -579,11 +544,13 @@ router.get('/status', (req, res) => {
     running: captures.size > 0,
     activeCaptures: active,
     totalInterfaces: captures.size,
-    clients: wsClients.size,
+    clients: captureStream.size,
+    stream: captureStream.status(),
     globalPacketCount,
-    cCapture: cCaptureProcess ? {
+    cCapture: captureService.sessions.size > 0 ? {
       running: true,
-      stats: cCaptureStats
+      sessions: captureService.listSessions(),
+      engines: captureService.listEngines()
     } : null
   });
 });
@@ -592,123 +559,131 @@ router.get('/status', (req, res) => {
 // C Capture Integration (High-precision)
 // ============================================
 
-// Start C capture (uses traffic-capture binary)
-router.post('/start-c', (req, res) => {
-  const { interface: iface, duration = 10, vlanId = 100 } = req.body;
-
-  if (!iface) {
-    return res.status(400).json({ error: 'Interface required' });
-  }
-
-  if (cCaptureProcess) {
-    return res.status(400).json({ error: 'C capture already running' });
-  }
-
-  const binaryPath = path.join(__dirname, '..', 'traffic-capture');
-
-  try {
-    cCaptureStats = { startTime: Date.now(), interface: iface, vlanId, packets: 0, tc: {} };
-
-    // Spawn the C capture process (requires cap_net_raw capability)
-    cCaptureProcess = spawn(binaryPath, [iface, String(duration), String(vlanId), 'json'], {
-      stdio: ['ignore', 'pipe', 'pipe']
-    });
-
-    let buffer = '';
+// Sessions on one interface share a single traffic-capture process
+captureService.on('stats', (session, json) => {
+  captureStream.pushStats({
+    sessionId: session.id,
+    elapsed_ms: json.elapsed_ms,
+    total: json.total,
+    tc: json.tc,
+    ...(json.preemption && { preemption: json.preemption })
+  });
+});
 
-    cCaptureProcess.stdout.on('data', (data) => {
-      buffer += data.toString();
+captureService.on('queue', (session, json) => {
+  broadcast({ type: 'c-capture-queue', sessionId: session.id, data: json.queue });
+});
 
-      // Process complete JSON lines
-      const lines = buffer.split('\n');
-      buffer = lines.pop(); // Keep incomplete line in buffer
+captureService.on('cycles', (session, data, columns) => {
+  const board = captureService.getScoreboard(session.id);
+  broadcast({
+    type: 'c-capture-cycles',
+    sessionId: session.id,
+    data: { cycleNs: board.cycleNs, cyclesPerColumn: board.cyclesPerColumn, dropped: data.dropped, columns }
+  });
+});
 
-      for (const line of lines) {
-        if (!line.trim()) continue;
-        try {
-          const json = JSON.parse(line);
+captureService.on('anomaly', (session, anomaly) => {
+  broadcast({ type: 'c-capture-anomaly', sessionId: session.id, data: anomaly });
+});
 
-          // Update stats
-          cCaptureStats.elapsed_ms = json.elapsed_ms;
-          cCaptureStats.packets = json.total || 0;
+captureService.on('final', (session, json) => {
+  broadcast({
+    type: 'c-capture-stats',
+    sessionId: session.id,
+    data: { tc: json.tc, guard: json.guard, preemption: json.preemption, final: true }
+  });
+});
 
-          if (json.tc) {
-            cCaptureStats.tc = json.tc;
-          }
+captureService.on('pipeline', (engine, pipeline) => {
+  broadcast({ type: 'c-capture-pipeline', engine: engine.key, sessions: Array.from(engine.sessions), data: pipeline });
+});
 
-          if (json.final) {
-            cCaptureStats.final = true;
-            cCaptureStats.analysis = json.tc;
-          }
+captureService.on('timebase', (engine, timebase) => {
+  broadcast({ type: 'c-capture-timebase', engine: engine.key, sessions: Array.from(engine.sessions), data: timebase });
+});
 
-          // Broadcast to WebSocket clients
-          broadcast({
-            type: 'c-capture-stats',
-            data: {
-              elapsed_ms: json.elapsed_ms,
-              total: json.total,
-              tc: json.tc,
-              final: json.final || false
-            }
-          });
-        } catch (e) {
-          // Ignore parse errors
-        }
-      }
-    });
+captureService.on('stopped', (session) => {
+  broadcast({ type: 'c-capture-stopped', sessionId: session.id, stats: session.stats });
+});
 
-    cCaptureProcess.stderr.on('data', (data) => {
-      const msg = data.toString().trim();
-      if (msg && !msg.includes('password')) {
-        console.log('[C-capture]', msg);
-      }
-    });
+// Start a C capture session (uses traffic-capture binary)
+router.post('/start-c', (req, res) => {
+  const { interface: iface, duration = 10, vlanId = 100, gcl, cbs, stats, ptp, sessionId } = req.body;
 
-    cCaptureProcess.on('close', (code) => {
-      console.log(`[C-capture] Process exited with code ${code}`);
-      cCaptureProcess = null;
-      broadcast({ type: 'c-capture-stopped', stats: cCaptureStats });
-    });
+  if (!iface) {
+    return res.status(400).json({ error: 'Interface required' });
+  }
 
-    cCaptureProcess.on('error', (err) => {
-      console.error('[C-capture] Error:', err.message);
-      cCaptureProcess = null;
-    });
+  try {
+    const session = captureService.startSession({ interface: iface, duration, vlanId, gcl, cbs, stats, ptp, sessionId });
+    const info = captureService.describe(session);
 
     res.json({
       success: true,
-      message: `C capture started on ${iface}`,
+      message: `C capture started on ${iface}` + (info.sharedWith.length ? ` (shared with ${info.sharedWith.join(', ')})` : ''),
+      sessionId: session.id,
       interface: iface,
       duration,
-      vlanId
+      vlanId,
+      sharedWith: info.sharedWith
     });
   } catch (err) {
-    cCaptureProcess = null;
     res.status(500).json({ error: err.message });
   }
 });
 
-// Stop C capture
+// Stop a C capture session (all sessions if no sessionId)
 router.post('/stop-c', (req, res) => {
-  if (!cCaptureProcess) {
-    return res.json({ success: true, message: 'No C capture running' });
+  const { sessionId } = req.body || {};
+
+  if (sessionId) {
+    const session = captureService.stopSession(sessionId);
+    if (!session) {
+      return res.json({ success: true, message: `No C capture session ${sessionId}` });
+    }
+    return res.json({ success: true, message: 'C capture stopped', sessionId, stats: session.stats });
   }
 
-  try {
-    // Send SIGTERM to gracefully stop
-    cCaptureProcess.kill('SIGTERM');
-    res.json({ success: true, message: 'C capture stopped', stats: cCaptureStats });
-  } catch (err) {
-    res.status(500).json({ error: err.message });
+  const stopped = captureService.stopAll();
+  if (stopped.length === 0) {
+    return res.json({ success: true, message: 'No C capture running' });
   }
+  res.json({ success: true, message: 'C capture stopped', stopped: stopped.map(s => s.id) });
 });
 
-// Get C capture status
+// Get C capture status (one session, or the most recent for older clients)
 router.get('/status-c', (req, res) => {
+  const { sessionId } = req.query;
+  const sessions = Array.from(captureService.sessions.values());
+  const session = sessionId ? captureService.getSession(sessionId) : sessions[sessions.length - 1];
+
   res.json({
-    running: !!cCaptureProcess,
-    stats: cCaptureStats
+    running: !!session,
+    sessionId: session?.id,
+    stats: session?.stats || null,
+    sessions: captureService.listSessions(),
+    engines: captureService.listEngines(),
+    profiles: captureService.listProfiles()
   });
 });
 
+// Per-cycle TAS scorecards of a session (also after it stopped): heatmap
+// columns and accuracy dips from cycle `from` on and the last `raw` cycle records
+router.get('/cycles-c', (req, res) => {
+  const { sessionId } = req.query;
+  const board = sessionId ? captureService.getScoreboard(sessionId) : null;
+  if (!board) {
+    return res.status(404).json({ error: `No cycle scorecards for session ${sessionId}` });
+  }
+  const from = req.query.from !== undefined ? Number(req.query.from) : undefined;
+  const raw = Math.min(parseInt(req.query.raw) || 0, board.rawCycles);
+  res.json({ sessionId, ...board.snapshot({ from, raw }) });
+});
+
+// List C capture sessions
+router.get('/sessions', (req, res) => {
+  res.json({ sessions: captureService.listSessions() });
+});
+
 export default router;
@@ -2,7 +2,7 @@ import express from 'express';
 import path from 'path';
 import { fileURLToPath } from 'url';
 import fs from 'fs';
-import yaml from 'js-yaml';
+import { resolveQueries, decodeCbor } from '../services/yang-pool.js';
 
 const __dirname = path.dirname(fileURLToPath(import.meta.url));
 const TSC2CBOR_LIB = path.resolve(__dirname, '../../tsc2cbor/lib');
@@ -47,12 +47,8 @@ router.post('/', async (req, res) => {
   try {
     const yangCacheDir = await findYangCache(cache);
 
-    const { loadYangInputs } = await import(`${TSC2CBOR_LIB}/common/input-loader.js`);
-    const { isInstanceIdentifierFormat, extractSidsFromInstanceIdentifier } = await import(`${TSC2CBOR_LIB}/encoder/transformer-instance-id.js`);
+    const { isInstanceIdentifierFormat } = await import(`${TSC2CBOR_LIB}/encoder/transformer-instance-id.js`);
     const { createTransport } = await import(`${TSC2CBOR_LIB}/transport/index.js`);
-    const { Cbor2TscConverter } = await import('../../tsc2cbor/cbor2tsc.js');
-
-    const { sidInfo } = await loadYangInputs(yangCacheDir, false);
 
     // Convert paths array to instance-identifier format
     let parsedData = paths.map(p => ({ [p]: null }));
@@ -61,7 +57,8 @@ router.post('/', async (req, res) => {
       return res.status(400).json({ error: 'Invalid path format. Use instance-identifier format.' });
     }
 
-    const queries = extractSidsFromInstanceIdentifier(parsedData, sidInfo, { verbose: false });
+    // SID resolution and CBOR decoding run on the YANG worker pool
+    const queries = await resolveQueries(yangCacheDir, paths);
 
     if (queries.length === 0) {
       return res.status(400).json({ error: 'No valid SIDs found in paths' });
@@ -81,7 +78,6 @@ router.post('/', async (req, res) => {
 
     await transportInstance.waitForReady(5000);
 
-    const decoder = new Cbor2TscConverter(yangCacheDir);
     const response = await transportInstance.sendiFetchRequest(queries);
 
     if (!response.isSuccess()) {
@@ -89,16 +85,12 @@ router.post('/', async (req, res) => {
       return res.status(500).json({ error: `iFETCH failed: CoAP code ${response.code}` });
     }
 
-    const cborPayload = response.payload;
-    const result = await decoder.convertBuffer(cborPayload, {
-      verbose: false,
-      outputFormat: format
-    });
-
     await transportInstance.disconnect();
 
+    const result = await decodeCbor(yangCacheDir, response.payload, format);
+
     res.json({
-      result: result.yaml,
+      result,
       format
     });
   } catch (error) {
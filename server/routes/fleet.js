@@ -0,0 +1,172 @@
+import express from 'express';
+import path from 'path';
+import { fileURLToPath } from 'url';
+import fs from 'fs';
+import { pushFleet } from '../services/fleet-push.js';
+import { captureService } from '../services/capture-service.js';
+import { tasPatches, gateTablePath } from './gcl.js';
+
+const __dirname = path.dirname(fileURLToPath(import.meta.url));
+const TSC2CBOR_LIB = path.resolve(__dirname, '../../tsc2cbor/lib');
+
+const router = express.Router();
+
+const MAX_TARGETS = 256;
+const DEFAULT_ACTIVATE_S = 30;
+
+async function findYangCache(cacheOption) {
+  const { YangCatalogManager } = await import(`${TSC2CBOR_LIB}/yang-catalog/yang-catalog.js`);
+
+  if (cacheOption) {
+    if (!fs.existsSync(cacheOption)) {
+      throw new Error(`Cache directory not found: ${cacheOption}`);
+    }
+    return cacheOption;
+  }
+
+  const yangCatalog = new YangCatalogManager();
+  const catalogs = yangCatalog.listCachedCatalogs();
+
+  if (catalogs.length === 0) {
+    throw new Error('No YANG catalog found. Please download first.');
+  }
+
+  return catalogs[0].path;
+}
+
+// Offset from host time to switch PTP time (ns): a capture engine's fitted
+// timebase when one is valid, else host time plus FLEET_TAI_OFFSET_S (37)
+function ptpOffset() {
+  const engine = captureService.listEngines().find(e => e.timebase?.valid);
+  if (engine) return { offsetNs: engine.timebase.offset_ns, source: `timebase:${engine.key}` };
+  const taiS = Number(process.env.FLEET_TAI_OFFSET_S ?? 37);
+  return { offsetNs: taiS * 1e9, source: 'host' };
+}
+
+// Key of obj (or a module-prefixed "mod:key") anywhere below it
+function findKey(obj, key) {
+  if (!obj || typeof obj !== 'object') return undefined;
+  for (const [k, v] of Object.entries(obj)) {
+    if (k === key || k.endsWith(`:${key}`)) return v;
+  }
+  for (const v of Object.values(obj)) {
+    const found = findKey(v, key);
+    if (found !== undefined) return found;
+  }
+  return undefined;
+}
+
+// Read-back check of a pushed TAS schedule against the admin parameters
+function expectGcl(entries, cycleNs, baseTimeSeconds) {
+  return (parsed) => {
+    const table = findKey(parsed, 'gate-parameter-table');
+    if (!table) return ['gate-parameter-table missing'];
+    const mismatches = [];
+
+    const base = findKey(table, 'admin-base-time');
+    if (String(base?.seconds) !== String(baseTimeSeconds)) {
+      mismatches.push(`admin-base-time ${base?.seconds} != ${baseTimeSeconds}`);
+    }
+    const cycle = findKey(table, 'admin-cycle-time');
+    if (Number(cycle?.numerator) !== cycleNs) mismatches.push(`admin-cycle-time ${cycle?.numerator} != ${cycleNs}`);
+
+    const list = findKey(findKey(table, 'admin-control-list'), 'gate-control-entry') || [];
+    const got = [...list].sort((a, b) => a.index - b.index);
+    if (got.length !== entries.length) {
+      mismatches.push(`${got.length} gate-control entries != ${entries.length}`);
+    } else {
+      got.forEach((g, i) => {
+        if (Number(g['time-interval-value']) !== entries[i].time || Number(g['gate-states-value']) !== entries[i].gates) {
+          mismatches.push(`entry ${i + 1} differs`);
+        }
+      });
+    }
+    return mismatches;
+  };
+}
+
+/**
+ * POST /api/fleet/push
+ * Push one config to many boards concurrently
+ * Body: { targets: [{ id, transport: 'wifi'|'serial', host, port, device, proxy, gclPort, patches }],
+ *         patches: [{ path, value }],                 common to every board
+ *         gcl: { port, entries: [{ gates, time }], cycleNs, cycleTimeExtensionNs },
+ *         baseTimeSeconds, activateInS, concurrency, perProxy, verify, cache }
+ *
+ * With `gcl` every board gets the same TAS schedule and the same future
+ * AdminBaseTime (baseTimeSeconds, or now + activateInS in switch PTP time),
+ * then config-change, so all schedules start on the same cycle; the
+ * read-back compares the admin parameters. Boards listed in `rollback`
+ * took part of the config and failed.
+ */
+router.post('/push', async (req, res) => {
+  const {
+    targets,
+    patches = [],
+    gcl,
+    baseTimeSeconds,
+    activateInS = DEFAULT_ACTIVATE_S,
+    concurrency = 8,
+    perProxy = 1,
+    verify = true,
+    cache
+  } = req.body;
+
+  if (!Array.isArray(targets) || targets.length === 0) {
+    return res.status(400).json({ error: 'targets array is required' });
+  }
+  if (targets.length > MAX_TARGETS) {
+    return res.status(400).json({ error: `At most ${MAX_TARGETS} targets` });
+  }
+  if (!gcl && patches.length === 0 && !targets.some(t => t.patches?.length)) {
+    return res.status(400).json({ error: 'patches or gcl is required' });
+  }
+  if (gcl && (!Array.isArray(gcl.entries) || gcl.entries.length === 0 || !gcl.cycleNs)) {
+    return res.status(400).json({ error: 'gcl needs entries and cycleNs' });
+  }
+
+  try {
+    const yangCacheDir = await findYangCache(cache);
+
+    let activation = null;
+    if (gcl) {
+      const { offsetNs, source } = ptpOffset();
+      const base = baseTimeSeconds ?? Math.ceil((Date.now() * 1e6 + offsetNs) / 1e9 + activateInS);
+      activation = { baseTimeSeconds: base, source, offsetNs };
+    }
+
+    const fleet = targets.map(t => {
+      const target = { ...t, patches: [...patches, ...(t.patches || [])], readBack: [] };
+      if (gcl) {
+        const port = String(t.gclPort ?? gcl.port);
+        target.patches.push(
+          ...tasPatches(port, gcl.entries, gcl.cycleNs, {
+            baseTimeSeconds: activation.baseTimeSeconds,
+            cycleTimeExtensionNs: gcl.cycleTimeExtensionNs
+          }),
+          { path: `${gateTablePath(port)}/config-change`, value: true }
+        );
+        target.readBack = [gateTablePath(port)];
+        target.expect = expectGcl(gcl.entries, gcl.cycleNs, activation.baseTimeSeconds);
+      }
+      return target;
+    });
+
+    const result = await pushFleet(fleet, { cacheDir: yangCacheDir, concurrency, perProxy, verify });
+
+    // A board that finished after the base time still runs in phase, but
+    // starts its schedule some whole cycles after the others
+    if (activation) {
+      const baseMs = (activation.baseTimeSeconds * 1e9 - activation.offsetNs) / 1e6;
+      activation.late = result.boards.filter(b => b.pushed && b.doneAt > baseMs).map(b => b.id);
+      activation.marginMs = Math.round(baseMs - Math.max(...result.boards.map(b => b.doneAt)));
+    }
+    for (const b of result.boards) delete b.doneAt;
+
+    res.json({ ...result, activation });
+  } catch (error) {
+    res.status(500).json({ error: error.message });
+  }
+});
+
+export default router;
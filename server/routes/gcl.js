@@ -0,0 +1,155 @@
+import express from 'express';
+import { spawn } from 'child_process';
+import { resolveBinary } from '../native-binaries.js';
+
+const router = express.Router();
+
+const SYNTH_TIMEOUT_MS = 30000;
+
+export const gateTablePath = (port) =>
+  `/ietf-interfaces:interfaces/interface[name='${port}']/ieee802-dot1q-bridge:bridge-port/ieee802-dot1q-sched-bridge:gate-parameter-table`;
+
+// Same patch set the TAS page applies, ready for POST /api/patch
+export function tasPatches(port, entries, cycleNs, { baseTimeSeconds, cycleTimeExtensionNs = 10000 } = {}) {
+  const basePath = gateTablePath(port);
+  const patches = [
+    { path: `${basePath}/gate-enabled`, value: true },
+    { path: `${basePath}/admin-gate-states`, value: 255 },
+    ...entries.map((entry, idx) => ({
+      path: `${basePath}/admin-control-list/gate-control-entry`,
+      value: {
+        index: idx + 1,
+        'operation-name': 'ieee802-dot1q-sched:set-gate-states',
+        'time-interval-value': entry.time,
+        'gate-states-value': entry.gates
+      }
+    })),
+    { path: `${basePath}/admin-cycle-time/numerator`, value: cycleNs },
+    { path: `${basePath}/admin-cycle-time/denominator`, value: 1 },
+    { path: `${basePath}/admin-cycle-time-extension`, value: cycleTimeExtensionNs }
+  ];
+  if (baseTimeSeconds !== undefined) {
+    patches.push(
+      { path: `${basePath}/admin-base-time/seconds`, value: String(baseTimeSeconds) },
+      { path: `${basePath}/admin-base-time/nanoseconds`, value: 0 }
+    );
+  }
+  return patches;
+}
+
+// Hop of a stream path: "device/port" or { device, port }
+function hopKey(hop) {
+  if (typeof hop === 'string') {
+    const idx = hop.lastIndexOf('/');
+    return idx < 0 ? { device: '', port: hop } : { device: hop.slice(0, idx), port: hop.slice(idx + 1) };
+  }
+  return { device: String(hop.device ?? ''), port: String(hop.port) };
+}
+
+// tsn-synth input: ports are renamed p0, p1, ... so names need no escaping
+function synthInput(streams) {
+  const ports = [];
+  const portIndex = new Map();
+  const lines = streams.map((s, i) => {
+    if (!s.periodNs || !Array.isArray(s.path) || s.path.length === 0) {
+      throw new Error(`Stream ${s.id ?? i}: periodNs and path are required`);
+    }
+    const hops = s.path.map(h => {
+      const hop = hopKey(h);
+      const key = `${hop.device}/${hop.port}`;
+      if (!portIndex.has(key)) {
+        portIndex.set(key, ports.length);
+        ports.push(hop);
+      }
+      return `p${portIndex.get(key)}`;
+    });
+    const tc = s.tc ?? s.pcp ?? 7;
+    return `s${i} ${s.periodNs} ${s.frameBytes || 1518} ${s.maxLatencyNs || 0} ${tc} ${hops.join(',')}`;
+  });
+  return { ports, input: lines.join('\n') + '\n' };
+}
+
+function runSynth(args, input) {
+  return new Promise((resolve, reject) => {
+    const proc = spawn(resolveBinary('tsn-synth'), args);
+    let stdout = '';
+    let stderr = '';
+    const timer = setTimeout(() => proc.kill('SIGKILL'), SYNTH_TIMEOUT_MS);
+
+    proc.stdout.on('data', (data) => { stdout += data; });
+    proc.stderr.on('data', (data) => { stderr += data; });
+    proc.on('error', (err) => {
+      clearTimeout(timer);
+      reject(err);
+    });
+    proc.on('close', (code) => {
+      clearTimeout(timer);
+      if (code !== 0) {
+        reject(new Error(stderr.trim() || `tsn-synth exited with ${code}`));
+        return;
+      }
+      try {
+        resolve(JSON.parse(stdout));
+      } catch (e) {
+        reject(new Error(`Invalid tsn-synth output: ${e.message}`));
+      }
+    });
+    proc.stdin.end(input);
+  });
+}
+
+/**
+ * POST /api/gcl/synthesize
+ * Per-port GCLs from stream requirements
+ * Body: { streams: [{ id, periodNs, frameBytes, maxLatencyNs, tc|pcp, path: ['sw1/2', ...] }],
+ *         objective: 'be'|'cycle', linkMbps, hopNs, guardBytes, maxEntries, cycleNs, baseTimeSeconds }
+ * Each port carries `patches` for POST /api/patch on its device and a `gcl`
+ * usable as a capture session's GCL.
+ */
+router.post('/synthesize', async (req, res) => {
+  const { streams, objective = 'be', linkMbps, hopNs, guardBytes, maxEntries, cycleNs, baseTimeSeconds } = req.body;
+
+  if (!Array.isArray(streams) || streams.length === 0) {
+    return res.status(400).json({ error: 'streams array is required' });
+  }
+
+  try {
+    const { ports, input } = synthInput(streams);
+    const args = ['--objective', objective === 'cycle' ? 'cycle' : 'be'];
+    if (linkMbps) args.push('--link', String(linkMbps));
+    if (hopNs !== undefined) args.push('--hop-ns', String(hopNs));
+    if (guardBytes) args.push('--guard', String(guardBytes));
+    if (maxEntries) args.push('--max-entries', String(maxEntries));
+    if (cycleNs) args.push('--cycle', String(cycleNs));
+
+    const result = await runSynth(args, input);
+
+    res.json({
+      objective: result.objective,
+      cycleNs: result.cycle_ns,
+      hyperperiodNs: result.hyperperiod_ns,
+      feasible: result.feasible,
+      scheduled: result.scheduled,
+      solveMs: result.solve_ms,
+      ports: ports.map((hop, i) => {
+        const p = result.ports[`p${i}`];
+        return {
+          ...hop,
+          tcMask: p.tc_mask,
+          beFraction: p.be_fraction,
+          fits: p.fits,
+          gcl: { entries: p.entries, cycleNs: result.cycle_ns },
+          patches: tasPatches(hop.port, p.entries, result.cycle_ns, { baseTimeSeconds })
+        };
+      }),
+      streams: streams.map((s, i) => {
+        const r = result.streams[`s${i}`];
+        return { id: s.id ?? i, scheduled: r.scheduled, offsetNs: r.offset_ns, latencyNs: r.latency_ns };
+      })
+    });
+  } catch (err) {
+    res.status(400).json({ error: err.message });
+  }
+});
+
+export default router;
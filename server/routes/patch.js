@@ -2,7 +2,7 @@ import express from 'express';
 import path from 'path';
 import { fileURLToPath } from 'url';
 import fs from 'fs';
-import yaml from 'js-yaml';
+import { encodeItems, decodeCbor } from '../services/yang-pool.js';
 
 const __dirname = path.dirname(fileURLToPath(import.meta.url));
 const TSC2CBOR_LIB = path.resolve(__dirname, '../../tsc2cbor/lib');
@@ -48,8 +48,6 @@ router.post('/', async (req, res) => {
 
     const { isInstanceIdentifierFormat } = await import(`${TSC2CBOR_LIB}/encoder/transformer-instance-id.js`);
     const { createTransport } = await import(`${TSC2CBOR_LIB}/transport/index.js`);
-    const { Tsc2CborConverter } = await import('../../tsc2cbor/tsc2cbor.js');
-    const { Cbor2TscConverter } = await import('../../tsc2cbor/cbor2tsc.js');
 
     // Convert patches to instance-identifier format
     const patchItems = patches.map(p => ({ [p.path]: p.value }));
@@ -58,8 +56,8 @@ router.post('/', async (req, res) => {
       return res.status(400).json({ error: 'Invalid path format. Use instance-identifier format.' });
     }
 
-    const encoder = new Tsc2CborConverter(yangCacheDir);
-    const decoder = new Cbor2TscConverter(yangCacheDir);
+    // Encode every item on the YANG worker pool before touching the device
+    const encoded = await encodeItems(yangCacheDir, patchItems);
 
     // Create transport and connect
     const transportInstance = createTransport(transport, { verbose: false });
@@ -85,9 +83,8 @@ router.post('/', async (req, res) => {
       const itemPath = Object.keys(item)[0];
 
       try {
-        const singleItemYaml = yaml.dump([item]);
-        const encodeResult = await encoder.convertString(singleItemYaml, { verbose: false });
-        const patchData = encodeResult.cbor;
+        if (encoded[i].error) throw new Error(encoded[i].error);
+        const patchData = encoded[i];
 
         const response = await transportInstance.sendiPatchRequest(patchData);
 
@@ -96,11 +93,7 @@ router.post('/', async (req, res) => {
 
           if (response.payload && response.payload.length > 0) {
             try {
-              const errorResult = await decoder.convertBuffer(response.payload, {
-                verbose: false,
-                outputFormat: 'rfc7951'
-              });
-              errorDetail = errorResult.yaml;
+              errorDetail = await decodeCbor(yangCacheDir, response.payload, 'rfc7951');
             } catch {
               errorDetail = `Payload: ${response.payload.toString('hex')}`;
             }
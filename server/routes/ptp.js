@@ -2,6 +2,7 @@ import express from 'express';
 import path from 'path';
 import { fileURLToPath } from 'url';
 import fs from 'fs';
+import { resolveQueries, decodeCbor, encodeItems } from '../services/yang-pool.js';
 
 const __dirname = path.dirname(fileURLToPath(import.meta.url));
 const TSC2CBOR_LIB = path.resolve(__dirname, '../../tsc2cbor/lib');
@@ -146,19 +147,10 @@ router.get('/health/:ip', async (req, res) => {
 
   try {
     const yangCacheDir = await findYangCache();
-    const { loadYangInputs } = await import(`${TSC2CBOR_LIB}/common/input-loader.js`);
-    const { extractSidsFromInstanceIdentifier } = await import(`${TSC2CBOR_LIB}/encoder/transformer-instance-id.js`);
-    const { Cbor2TscConverter } = await import('../../tsc2cbor/cbor2tsc.js');
-
-    const { sidInfo } = await loadYangInputs(yangCacheDir, false);
     transport = await createTransportConnection(ip);
 
     // Quick fetch of PTP servo status
-    const queries = extractSidsFromInstanceIdentifier(
-      [{ "/ieee1588-ptp:ptp": null }],
-      sidInfo,
-      { verbose: false }
-    );
+    const queries = await resolveQueries(yangCacheDir, ['/ieee1588-ptp:ptp']);
 
     const response = await transport.sendiFetchRequest(queries);
     try { await transport.disconnect(); } catch (e) {}
@@ -167,8 +159,7 @@ router.get('/health/:ip', async (req, res) => {
       throw new Error(`CoAP code ${response.code}`);
     }
 
-    const decoder = new Cbor2TscConverter(yangCacheDir);
-    const result = await decoder.convertBuffer(response.payload, { verbose: false, outputFormat: 'rfc7951' });
+    const result = { yaml: await decodeCbor(yangCacheDir, response.payload) };
 
     // Parse PTP status
     const ptpData = parsePtpYaml(result.yaml);
@@ -218,18 +209,9 @@ router.get('/offset/:ip', async (req, res) => {
 
   try {
     const yangCacheDir = await findYangCache();
-    const { loadYangInputs } = await import(`${TSC2CBOR_LIB}/common/input-loader.js`);
-    const { extractSidsFromInstanceIdentifier } = await import(`${TSC2CBOR_LIB}/encoder/transformer-instance-id.js`);
-    const { Cbor2TscConverter } = await import('../../tsc2cbor/cbor2tsc.js');
-
-    const { sidInfo } = await loadYangInputs(yangCacheDir, false);
     transport = await createTransportConnection(ip, 5683, 15000);
 
-    const queries = extractSidsFromInstanceIdentifier(
-      [{ "/ieee1588-ptp:ptp": null }],
-      sidInfo,
-      { verbose: false }
-    );
+    const queries = await resolveQueries(yangCacheDir, ['/ieee1588-ptp:ptp']);
 
     const response = await transport.sendiFetchRequest(queries);
     try { await transport.disconnect(); } catch (e) {}
@@ -238,8 +220,7 @@ router.get('/offset/:ip', async (req, res) => {
       throw new Error(`CoAP code ${response.code}`);
     }
 
-    const decoder = new Cbor2TscConverter(yangCacheDir);
-    const result = await decoder.convertBuffer(response.payload, { verbose: false, outputFormat: 'rfc7951' });
+    const result = { yaml: await decodeCbor(yangCacheDir, response.payload) };
 
     // Parse PTP data
     const yaml = result.yaml || '';
@@ -287,18 +268,9 @@ router.get('/config/:ip', async (req, res) => {
 
   try {
     const yangCacheDir = await findYangCache();
-    const { loadYangInputs } = await import(`${TSC2CBOR_LIB}/common/input-loader.js`);
-    const { extractSidsFromInstanceIdentifier } = await import(`${TSC2CBOR_LIB}/encoder/transformer-instance-id.js`);
-    const { Cbor2TscConverter } = await import('../../tsc2cbor/cbor2tsc.js');
-
-    const { sidInfo } = await loadYangInputs(yangCacheDir, false);
     const transport = await createTransportConnection(ip);
 
-    const queries = extractSidsFromInstanceIdentifier(
-      [{ "/ieee1588-ptp:ptp": null }],
-      sidInfo,
-      { verbose: false }
-    );
+    const queries = await resolveQueries(yangCacheDir, ['/ieee1588-ptp:ptp']);
 
     const response = await transport.sendiFetchRequest(queries);
     await transport.disconnect();
@@ -307,8 +279,7 @@ router.get('/config/:ip', async (req, res) => {
       return res.status(500).json({ error: `CoAP code ${response.code}` });
     }
 
-    const decoder = new Cbor2TscConverter(yangCacheDir);
-    const result = await decoder.convertBuffer(response.payload, { verbose: false, outputFormat: 'rfc7951' });
+    const result = { yaml: await decodeCbor(yangCacheDir, response.payload) };
 
     res.json({
       raw: result.yaml,
@@ -330,10 +301,8 @@ router.post('/apply/:ip', async (req, res) => {
 
   try {
     const yangCacheDir = await findYangCache();
-    const { Tsc2CborConverter } = await import('../../tsc2cbor/tsc2cbor.js');
     const { createTransport } = await import(`${TSC2CBOR_LIB}/transport/index.js`);
 
-    const encoder = new Tsc2CborConverter(yangCacheDir);
     const transport = createTransport('wifi', { verbose: false });
     await transport.connect({ host: ip, port: 5683 });
     await transport.waitForReady(5000);
@@ -342,11 +311,15 @@ router.post('/apply/:ip', async (req, res) => {
     const profileConfig = PTP_PROFILES[profile].config;
     const configYaml = buildPtpConfigYaml(profileConfig, portIndex);
 
-    // Encode to CBOR
-    const encodeResult = await encoder.convertString(configYaml, { verbose: false });
+    // Encode to CBOR (YANG worker pool)
+    const [cbor] = await encodeItems(yangCacheDir, [configYaml], { raw: true });
+    if (cbor.error) {
+      await transport.disconnect();
+      throw new Error(cbor.error);
+    }
 
     // Send iPATCH
-    const response = await transport.sendiPatchRequest(encodeResult.cbor);
+    const response = await transport.sendiPatchRequest(cbor);
     await transport.disconnect();
 
     if (!response.isSuccess()) {
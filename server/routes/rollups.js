@@ -0,0 +1,96 @@
+import express from 'express';
+import fs from 'fs';
+import path from 'path';
+import { execFile } from 'child_process';
+import { resolveBinary } from '../native-binaries.js';
+
+const router = express.Router();
+
+const ROLLUP_TIMEOUT_MS = 5000;
+const ROLLUP_MAX_BUFFER = 64 * 1024 * 1024;
+const TIERS = ['1s', '1m', '1h'];
+
+function rollupDir() {
+  return process.env.CAPTURE_ROLLUP_DIR || null;
+}
+
+// Store names are the engine's sanitized session names; reject anything else
+function storePath(name) {
+  const dir = rollupDir();
+  if (!dir || !/^[A-Za-z0-9_-][A-Za-z0-9._-]*$/.test(name)) return null;
+  return path.join(dir, name);
+}
+
+function runRollup(args) {
+  return new Promise((resolve, reject) => {
+    execFile(resolveBinary('tsn-rollup'), args, { timeout: ROLLUP_TIMEOUT_MS, maxBuffer: ROLLUP_MAX_BUFFER },
+      (err, stdout, stderr) => {
+        if (err) {
+          reject(new Error(stderr.trim() || err.message));
+          return;
+        }
+        try {
+          resolve(JSON.parse(stdout));
+        } catch (e) {
+          reject(new Error(`Invalid tsn-rollup output: ${e.message}`));
+        }
+      });
+  });
+}
+
+/**
+ * GET /api/rollups
+ * Rollup stores under CAPTURE_ROLLUP_DIR with the tiers each one holds
+ */
+router.get('/', async (req, res) => {
+  const dir = rollupDir();
+  if (!dir) return res.json({ enabled: false, stores: [] });
+
+  try {
+    const entries = await fs.promises.readdir(dir, { withFileTypes: true });
+    const stores = [];
+    for (const e of entries.filter(e => e.isDirectory())) {
+      const tiers = TIERS.filter(t => fs.existsSync(path.join(dir, e.name, t)));
+      if (tiers.length === 0) continue;
+      const { mtimeMs } = await fs.promises.stat(path.join(dir, e.name, tiers[0]));
+      stores.push({ name: e.name, tiers, updated: new Date(mtimeMs).toISOString() });
+    }
+    stores.sort((a, b) => b.updated.localeCompare(a.updated));
+    res.json({ enabled: true, stores });
+  } catch (err) {
+    if (err.code === 'ENOENT') return res.json({ enabled: true, stores: [] });
+    res.status(500).json({ error: err.message });
+  }
+});
+
+/**
+ * GET /api/rollups/:name?from=<unix s>&to=<unix s>&points=<n>&tier=<auto|1s|1m|1h>
+ * Per-TC series of a store over a time range (default: everything), at the
+ * finest tier that fits in `points` buckets (see tsn-rollup)
+ */
+router.get('/:name', async (req, res) => {
+  const store = storePath(req.params.name);
+  if (!store) return res.status(400).json({ error: 'Invalid store or CAPTURE_ROLLUP_DIR not set' });
+
+  const args = [store];
+  for (const key of ['from', 'to', 'points']) {
+    if (req.query[key] === undefined) continue;
+    const v = Number(req.query[key]);
+    if (!Number.isFinite(v) || v < 0) return res.status(400).json({ error: `Invalid ${key}` });
+    args.push(`--${key}`, String(Math.floor(v)));
+  }
+  if (req.query.tier) {
+    if (req.query.tier !== 'auto' && !TIERS.includes(req.query.tier)) {
+      return res.status(400).json({ error: 'Invalid tier' });
+    }
+    args.push('--tier', req.query.tier);
+  }
+
+  try {
+    res.json(await runRollup(args));
+  } catch (err) {
+    res.status(404).json({ error: err.message });
+  }
+});
+
+export default router;
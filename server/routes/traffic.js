@@ -1,8 +1,10 @@
 import express from 'express';
 import Cap from 'cap';
 import { spawn } from 'child_process';
+import os from 'os';
 import path from 'path';
 import { fileURLToPath } from 'url';
+import { resolveBinary } from '../native-binaries.js';
 
 const __dirname = path.dirname(fileURLToPath(import.meta.url));
 const router = express.Router();
@@ -10,6 +12,12 @@ const { Cap: CapLib } = Cap;
 
 // Active C sender process
 let cSenderProcess = null;
+// Final JSON of the last C sender run (counts + stage profile)
+let cSenderResult = null;
+
+// Compiled send timelines (tsn-timeline) live here; start-precision only plays files from it
+const TIMELINE_DIR = process.env.TIMELINE_DIR || os.tmpdir();
+const TIMELINE_TIMEOUT_MS = 30000;
 
 // Active traffic generators
 const generators = new Map();
@@ -318,7 +326,11 @@ router.get('/status', (req, res) => {
   }
   res.json({
     active: generators.size,
-    generators: status
+    generators: status,
+    precision: {
+      running: !!cSenderProcess,
+      lastResult: cSenderResult
+    }
   });
 });
 
@@ -331,11 +343,18 @@ router.post('/start-precision', (req, res) => {
     vlanId = 100,
     tcList = [1, 2, 3, 4, 5, 6, 7],
     packetsPerSecond = 100,
-    duration = 7
+    duration = 7,
+    frameSize,
+    prbs = false,
+    express,
+    preemptSize,
+    offsets,
+    timeline,
+    phaseNs
   } = req.body;
 
-  if (!ifaceName || !dstMac) {
-    return res.status(400).json({ error: 'Interface and dstMac required' });
+  if (!ifaceName || (!dstMac && !timeline)) {
+    return res.status(400).json({ error: 'Interface and dstMac (or timeline) required' });
   }
 
   // Stop existing C sender if running
@@ -353,17 +372,24 @@ router.post('/start-precision', (req, res) => {
   const tcListStr = Array.isArray(tcList) ? tcList.join(',') : String(tcList);
 
   // Path to C binary
-  const senderPath = path.join(__dirname, '..', 'traffic-sender');
-
-  const args = [
-    ifaceName,
-    dstMac,
-    sourceMac,
-    String(vlanId),
-    tcListStr,
-    String(packetsPerSecond),
-    String(duration)
-  ];
+  const senderPath = resolveBinary('traffic-sender');
+
+  // A compiled timeline replaces the rate/TC arguments; duration 0 plays one pass
+  const args = timeline
+    ? ['--timeline', path.join(TIMELINE_DIR, path.basename(String(timeline))), ifaceName, String(duration)]
+    : [ifaceName, dstMac, sourceMac, String(vlanId), tcListStr, String(packetsPerSecond), String(duration)];
+  if (timeline && phaseNs) args.push('--phase-ns', String(phaseNs));
+  // SENDER_METRICS=<port|unix:path> serves OpenMetrics while the sender runs
+  if (process.env.SENDER_METRICS) args.push('--metrics', process.env.SENDER_METRICS);
+  // PRBS-31 payloads for `traffic-capture --check` (prbs: true or a seed)
+  if (frameSize) args.push('--frame-size', String(frameSize));
+  if (prbs) args.push(prbs === true ? '--prbs' : `--prbs=${Number(prbs)}`);
+  // Frame preemption mix: express TCs against the rest of tcList, offsets in ns or 'alone'
+  if (express && !timeline) {
+    args.push('--express', Array.isArray(express) ? express.join(',') : String(express));
+    if (preemptSize) args.push('--preempt-size', String(preemptSize));
+    if (offsets) args.push('--offsets', Array.isArray(offsets) ? offsets.join(',') : String(offsets));
+  }
 
   console.log(`Starting C sender: sudo ${senderPath} ${args.join(' ')}`);
 
@@ -393,7 +419,8 @@ router.post('/start-precision', (req, res) => {
       try {
         if (stdout.trim()) {
           const result = JSON.parse(stdout.trim());
-          console.log('C sender result:', result);
+          cSenderResult = result;
+          console.log('C sender result:', { ...result, profile: undefined });
         }
       } catch (e) {
         console.log('C sender output:', stdout);
@@ -415,7 +442,11 @@ router.post('/start-precision', (req, res) => {
         vlanId,
         tcList,
         packetsPerSecond,
-        duration
+        duration,
+        frameSize,
+        prbs,
+        express,
+        timeline
       }
     });
   } catch (err) {
@@ -423,6 +454,107 @@ router.post('/start-precision', (req, res) => {
   }
 });
 
+// tsn-timeline stream line: <id> <tc> <period_ns> [key=value ...]
+function timelineInput(streams) {
+  const lines = streams.map((s, i) => {
+    if (!s.periodNs) throw new Error(`Stream ${s.id ?? i}: periodNs is required`);
+    const id = String(s.id ?? `s${i}`).replace(/[^\w.-]/g, '_');
+    const opts = [];
+    const opt = (key, value) => { if (value !== undefined && value !== null) opts.push(`${key}=${Number(value)}`); };
+    opt('frame', s.frameSize);
+    opt('burst', s.burst);
+    opt('gap', s.gapNs);
+    opt('offset', s.offsetNs);
+    opt('vid', s.vlanId);
+    opt('start', s.startNs);
+    opt('stop', s.stopNs);
+    opt('on', s.onNs);
+    opt('off', s.offNs);
+    if (s.prbs) opts.push(`prbs=${s.prbs === true ? 1 : Number(s.prbs)}`);
+    if (s.align) opts.push('align=1');
+    return [id, s.tc ?? s.pcp ?? 0, s.periodNs, ...opts].join(' ');
+  });
+  return lines.join('\n') + '\n';
+}
+
+function runTimeline(args, input) {
+  return new Promise((resolve, reject) => {
+    const proc = spawn(resolveBinary('tsn-timeline'), args);
+    let stdout = '';
+    let stderr = '';
+    const timer = setTimeout(() => proc.kill('SIGKILL'), TIMELINE_TIMEOUT_MS);
+
+    proc.stdout.on('data', (data) => { stdout += data; });
+    proc.stderr.on('data', (data) => { stderr += data; });
+    proc.on('error', (err) => {
+      clearTimeout(timer);
+      reject(err);
+    });
+    proc.on('close', (code) => {
+      clearTimeout(timer);
+      if (code !== 0) {
+        reject(new Error(stderr.trim() || `tsn-timeline exited with ${code}`));
+        return;
+      }
+      try {
+        resolve(JSON.parse(stdout));
+      } catch (e) {
+        reject(new Error(`Invalid tsn-timeline output: ${e.message}`));
+      }
+    });
+    proc.stdin.end(input);
+  });
+}
+
+/**
+ * POST /api/traffic/timeline
+ * Compile a multi-stream send schedule for start-precision { timeline }
+ * Body: { interface|srcMac, dstMac, streams: [{ id, tc, periodNs, frameSize, burst, gapNs, offsetNs,
+ *         vlanId, prbs, startNs, stopNs, onNs, offNs, align }], gcl, linkMbps, lengthNs, once }
+ * gcl takes the capture session shape ({ entries: [{ gates, time }], cycleNs }).
+ */
+router.post('/timeline', async (req, res) => {
+  const { interface: ifaceName, dstMac, srcMac, streams, gcl, linkMbps, lengthNs, once = false } = req.body;
+
+  if (!dstMac || !Array.isArray(streams) || streams.length === 0) {
+    return res.status(400).json({ error: 'dstMac and streams array are required' });
+  }
+
+  try {
+    const input = timelineInput(streams);
+    const name = `tsn-timeline-${Date.now()}.tl`;
+    const args = ['--out', path.join(TIMELINE_DIR, name), '--dst', dstMac];
+    const sourceMac = srcMac || (ifaceName && getInterfaceMac(ifaceName));
+    if (sourceMac) args.push('--src', sourceMac);
+    if (linkMbps) args.push('--link', String(linkMbps));
+    if (lengthNs) args.push('--length', String(lengthNs));
+    if (once) args.push('--once');
+    if (gcl) {
+      const entries = Array.isArray(gcl) ? gcl : (gcl.entries || gcl.gcl || []);
+      args.push('--gcl', entries.map(e => `${e.gates}:${e.time ?? e.interval}`).join(','));
+      if (gcl.cycleNs) args.push('--cycle', String(gcl.cycleNs));
+    }
+
+    const result = await runTimeline(args, input);
+    res.json({
+      timeline: name,
+      digest: result.digest,
+      records: result.records,
+      lengthNs: result.length_ns,
+      loop: result.loop,
+      alignNs: result.align_ns,
+      flows: result.flows,
+      load: result.load,
+      minGapNs: result.min_gap_ns,
+      overlaps: result.overlaps,
+      compileMs: result.compile_ms,
+      streams: result.streams
+    });
+  } catch (err) {
+    res.status(400).json({ error: err.message });
+  }
+});
+
 // Stop precision traffic (C sender)
 router.post('/stop-precision', (req, res) => {
   if (cSenderProcess) {
@@ -0,0 +1,458 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { spawn } from 'child_process';
+import { EventEmitter } from 'events';
+import { resolveBinary } from '../native-binaries.js';
+import { CaptureService } from './capture-service.js';
+
+/**
+ * Parameter-sweep campaigns
+ *
+ * A campaign expands a sweep into runs (the cartesian product of its axes
+ * over the base parameters) and plays them on all sender/capture interface
+ * pairs in parallel, one run per pair at a time. A run optionally pushes
+ * its GCL to the pair's switch port, starts a capture session on the
+ * capture interface, runs traffic-sender on the sender interface and
+ * archives both results.
+ *
+ * Sweep: { base: { duration, vlanId, tcList, packetsPerSecond, frameSize, prbs, gcl },
+ *          axes: { <param>: [value, ...] }, repeat }
+ * Pair:  { id, sender, capture, dstMac, srcMac, senderCpu, captureCpus, drainCpu, workers,
+ *          target }   target: fleet board (with gclPort) that gets each run's GCL
+ *
+ * Isolation: every pair has its own CaptureService, so its engine runs on
+ * the pair's captureCpus/drainCpu, and its sender is pinned with --cpu.
+ * Pairs may not share interfaces or CPUs. A pair that fails
+ * MAX_PAIR_FAILURES runs in a row is retired for the rest of the campaign.
+ *
+ * Archive (CAMPAIGN_DIR, default ~/.tsnperf/campaigns; one directory per campaign):
+ *   campaign.json    sweep, pairs and the expanded runs
+ *   runs/<id>.json   sender and capture results of a finished run
+ *   progress.jsonl   one line per finished run: status and summary
+ * A run's file is written before its progress line. resume() plays the
+ * runs without a 'done' line, so a stopped, crashed or partly failed
+ * campaign continues where it left off.
+ *
+ * Events:
+ *   'run'   (campaign, entry)  a run finished (progress line)
+ *   'state' (campaign)         campaign started, stopped or finished
+ */
+
+export const SWEEP_PARAMS = ['gcl', 'packetsPerSecond', 'frameSize', 'tcList', 'vlanId', 'prbs', 'duration'];
+const BASE_DEFAULTS = { duration: 10, vlanId: 100, tcList: [1, 2, 3, 4, 5, 6, 7], packetsPerSecond: 100 };
+
+const MAX_RUNS = 10000;
+const MAX_PAIR_FAILURES = 3;
+const SENDER_GRACE_MS = 15000;      // Past the run duration before the sender is killed
+const FINAL_TIMEOUT_MS = 5000;
+
+const sleep = (ms) => new Promise(resolve => setTimeout(resolve, ms));
+
+function cpuList(value) {
+  if (value === undefined || value === null || value === '') return [];
+  return (Array.isArray(value) ? value : String(value).split(',')).map(Number);
+}
+
+/**
+ * Expand a sweep into runs
+ * @returns {Array<{id, point, params}>} point: value index per axis
+ */
+export function expandSweep(sweep) {
+  const axes = Object.entries(sweep.axes || {});
+  for (const [name, values] of axes) {
+    if (!SWEEP_PARAMS.includes(name)) throw new Error(`Unknown sweep axis: ${name}`);
+    if (!Array.isArray(values) || values.length === 0) throw new Error(`Axis ${name} needs a list of values`);
+  }
+  const repeat = Math.max(1, Number(sweep.repeat) || 1);
+  const total = axes.reduce((n, [, values]) => n * values.length, repeat);
+  if (total > MAX_RUNS) throw new Error(`Sweep has ${total} runs (at most ${MAX_RUNS})`);
+
+  const base = { ...BASE_DEFAULTS, ...(sweep.base || {}) };
+  const runs = [];
+  for (let n = 0; n < total; n++) {
+    // Last axis varies fastest, repeats innermost
+    let rest = Math.floor(n / repeat);
+    const index = new Array(axes.length);
+    for (let a = axes.length - 1; a >= 0; a--) {
+      index[a] = rest % axes[a][1].length;
+      rest = Math.floor(rest / axes[a][1].length);
+    }
+    const point = {};
+    const params = { ...base };
+    axes.forEach(([name, values], a) => {
+      point[name] = index[a];
+      params[name] = values[index[a]];
+    });
+    if (repeat > 1) point.repeat = n % repeat;
+    runs.push({ id: `r${String(n + 1).padStart(4, '0')}`, point, params });
+  }
+  return runs;
+}
+
+// Pairs may not share interfaces or CPUs
+function checkPairs(pairs) {
+  const ifaces = new Map();
+  const cpus = new Map();
+  const ids = new Set();
+  pairs.forEach((p, i) => {
+    p.id = String(p.id ?? `pair${i + 1}`);
+    if (ids.has(p.id)) throw new Error(`Duplicate pair id ${p.id}`);
+    ids.add(p.id);
+    if (!p.sender || !p.capture || !p.dstMac) throw new Error(`Pair ${p.id}: sender, capture and dstMac are required`);
+    for (const iface of [p.sender, p.capture]) {
+      if (ifaces.has(iface) && ifaces.get(iface) !== p.id) throw new Error(`Interface ${iface} is used by pairs ${ifaces.get(iface)} and ${p.id}`);
+      ifaces.set(iface, p.id);
+    }
+    for (const cpu of [...cpuList(p.senderCpu), ...cpuList(p.captureCpus), ...cpuList(p.drainCpu)]) {
+      if (cpus.has(cpu) && cpus.get(cpu) !== p.id) throw new Error(`CPU ${cpu} is used by pairs ${cpus.get(cpu)} and ${p.id}`);
+      cpus.set(cpu, p.id);
+    }
+  });
+}
+
+function senderArgs(pair, params) {
+  const tcList = Array.isArray(params.tcList) ? params.tcList.join(',') : String(params.tcList);
+  const args = [
+    pair.sender,
+    pair.dstMac,
+    pair.srcMac || '00:00:00:00:00:00',
+    String(params.vlanId),
+    tcList,
+    String(params.packetsPerSecond),
+    String(params.duration)
+  ];
+  if (params.frameSize) args.push('--frame-size', String(params.frameSize));
+  if (params.prbs) args.push(params.prbs === true ? '--prbs' : `--prbs=${Number(params.prbs)}`);
+  if (pair.senderCpu !== undefined && pair.senderCpu !== null) args.push('--cpu', String(pair.senderCpu));
+  return args;
+}
+
+// Headline numbers of a run, summed over TCs
+function summarize(sender, final) {
+  const tcs = Object.values(final?.tc || {});
+  const sum = (get) => tcs.reduce((acc, t) => acc + (get(t) || 0), 0);
+  return {
+    sent: sender?.total ?? 0,
+    received: sum(t => t.count),
+    lost: sum(t => t.seq?.lost),
+    ooo: sum(t => t.seq?.ooo),
+    latP99MaxUs: Math.max(0, ...tcs.map(t => t.seq?.lat_p99_us ?? 0)),
+    gateOut: sum(t => t.gate?.out)
+  };
+}
+
+// Capture final for a session, resolved once the session is stopped
+function sessionResult(capture, id) {
+  let final = null;
+  let resolveStopped;
+  const stopped = new Promise(resolve => { resolveStopped = resolve; });
+  const onFinal = (session, data) => { if (session.id === id) final = data; };
+  const onStopped = (session) => { if (session.id === id) resolveStopped(); };
+  capture.on('final', onFinal);
+  capture.on('stopped', onStopped);
+  return async () => {
+    await Promise.race([stopped, sleep(FINAL_TIMEOUT_MS)]);
+    capture.off('final', onFinal);
+    capture.off('stopped', onStopped);
+    return final;
+  };
+}
+
+function writeJsonAtomic(file, data) {
+  const tmp = `${file}.tmp`;
+  fs.writeFileSync(tmp, JSON.stringify(data, null, 2));
+  fs.renameSync(tmp, file);
+}
+
+export class CampaignRunner extends EventEmitter {
+  constructor(options = {}) {
+    super();
+    this.dir = options.dir || process.env.CAMPAIGN_DIR || path.join(os.homedir(), '.tsnperf', 'campaigns');
+    this.senderBinary = options.senderBinary || resolveBinary('traffic-sender');
+    this.sudo = options.sudo ?? process.env.CAMPAIGN_SUDO !== '0';
+    this.pushGcl = options.pushGcl || null;    // async (pair, gcl, campaign) => void
+    this.campaigns = new Map();                // id -> campaign (loaded or running)
+  }
+
+  /**
+   * Create a campaign in the archive
+   * @param {object} definition - { name, sweep, pairs, settleMs, leadMs, tailMs, cache }
+   */
+  create(definition) {
+    const { name = 'campaign', sweep, pairs } = definition;
+    if (!sweep) throw new Error('sweep is required');
+    if (!Array.isArray(pairs) || pairs.length === 0) throw new Error('pairs array is required');
+    const pairList = pairs.map(p => ({ ...p }));
+    checkPairs(pairList);
+    const runs = expandSweep(sweep);
+    if (runs.some(r => r.params.gcl) && pairList.some(p => p.target) && !this.pushGcl) {
+      throw new Error('GCL push is not available');
+    }
+
+    const id = `${String(name).replace(/[^A-Za-z0-9._-]/g, '_')}-${Date.now().toString(36)}`;
+    const dir = path.join(this.dir, id);
+    fs.mkdirSync(path.join(dir, 'runs'), { recursive: true });
+
+    const stored = {
+      id,
+      name,
+      createdAt: new Date().toISOString(),
+      sweep,
+      pairs: pairList,
+      settleMs: definition.settleMs ?? 2000,
+      leadMs: definition.leadMs ?? 500,
+      tailMs: definition.tailMs ?? 500,
+      cache: definition.cache || null,
+      runs
+    };
+    writeJsonAtomic(path.join(dir, 'campaign.json'), stored);
+    fs.writeFileSync(path.join(dir, 'progress.jsonl'), '');
+    return this._attach(stored, dir, []);
+  }
+
+  list() {
+    if (fs.existsSync(this.dir)) {
+      for (const id of fs.readdirSync(this.dir)) this.get(id);
+    }
+    return Array.from(this.campaigns.values())
+      .sort((a, b) => b.createdAt.localeCompare(a.createdAt))
+      .map(c => this.describe(c));
+  }
+
+  get(id) {
+    if (this.campaigns.has(id)) return this.campaigns.get(id);
+    if (!/^[A-Za-z0-9_-][A-Za-z0-9._-]*$/.test(id)) return null;
+    const dir = path.join(this.dir, id);
+    const file = path.join(dir, 'campaign.json');
+    if (!fs.existsSync(file)) return null;
+    try {
+      const stored = JSON.parse(fs.readFileSync(file, 'utf8'));
+      const lines = fs.readFileSync(path.join(dir, 'progress.jsonl'), 'utf8').split('\n').filter(Boolean);
+      // A torn last line (crash mid-append) is dropped; that run plays again
+      const entries = [];
+      for (const line of lines) {
+        try { entries.push(JSON.parse(line)); } catch (e) {}
+      }
+      return this._attach(stored, dir, entries);
+    } catch (e) {
+      return null;
+    }
+  }
+
+  _attach(stored, dir, entries) {
+    const campaign = {
+      ...stored,
+      dir,
+      progress: new Map(),      // runId -> latest progress entry
+      state: 'idle',
+      active: new Map(),        // pairId -> { runId, startedAt, proc }
+      retired: new Map(),       // pairId -> last error
+      startedAt: null
+    };
+    for (const e of entries) campaign.progress.set(e.id, e);
+    if (this._pending(campaign).length === 0) campaign.state = 'done';
+    this.campaigns.set(campaign.id, campaign);
+    return campaign;
+  }
+
+  _pending(campaign) {
+    return campaign.runs.filter(r => campaign.progress.get(r.id)?.status !== 'done');
+  }
+
+  describe(campaign) {
+    const entries = Array.from(campaign.progress.values());
+    const done = entries.filter(e => e.status === 'done');
+    const failed = entries.filter(e => e.status === 'failed').length;
+    const pending = this._pending(campaign).length;
+    const avgMs = done.length ? done.reduce((s, e) => s + e.wallMs, 0) / done.length : null;
+    const livePairs = campaign.pairs.length - campaign.retired.size;
+    return {
+      id: campaign.id,
+      name: campaign.name,
+      createdAt: campaign.createdAt,
+      state: campaign.state,
+      axes: Object.fromEntries(Object.entries(campaign.sweep.axes || {}).map(([k, v]) => [k, v.length])),
+      pairs: campaign.pairs.map(p => ({
+        id: p.id,
+        sender: p.sender,
+        capture: p.capture,
+        running: campaign.active.get(p.id)?.runId ?? null,
+        retired: campaign.retired.get(p.id) ?? null
+      })),
+      total: campaign.runs.length,
+      done: done.length,
+      failed,
+      pending,
+      etaS: avgMs !== null && livePairs > 0 ? Math.round(pending * avgMs / livePairs / 1000) : null
+    };
+  }
+
+  // Runs with their point in the sweep and latest progress
+  runList(campaign) {
+    const running = new Set(Array.from(campaign.active.values(), slot => slot.runId));
+    return campaign.runs.map(r => {
+      const e = campaign.progress.get(r.id);
+      return {
+        id: r.id,
+        point: r.point,
+        status: running.has(r.id) ? 'running' : (e?.status ?? 'pending'),
+        pair: e?.pair ?? null,
+        summary: e?.summary ?? null,
+        error: e?.error ?? null
+      };
+    });
+  }
+
+  readRun(campaign, runId) {
+    if (!/^r\d+$/.test(runId)) return null;
+    const file = path.join(campaign.dir, 'runs', `${runId}.json`);
+    return fs.existsSync(file) ? JSON.parse(fs.readFileSync(file, 'utf8')) : null;
+  }
+
+  /**
+   * Play the campaign's pending runs (start and resume)
+   * @returns {Promise} settles when the campaign stops or finishes
+   */
+  start(campaign) {
+    if (campaign.state === 'running' || campaign.state === 'stopping') {
+      throw new Error(`Campaign ${campaign.id} is ${campaign.state}`);
+    }
+    const queue = this._pending(campaign);
+    campaign.state = 'running';
+    campaign.startedAt = new Date().toISOString();
+    campaign.retired.clear();
+    this.emit('state', campaign);
+
+    return Promise.all(campaign.pairs.map(pair => this._worker(campaign, pair, queue))).then(() => {
+      campaign.state = this._pending(campaign).length === 0 ? 'done' : 'stopped';
+      this.emit('state', campaign);
+    });
+  }
+
+  stop(campaign) {
+    if (campaign.state !== 'running') return;
+    campaign.state = 'stopping';
+    for (const slot of campaign.active.values()) {
+      try { slot.proc?.kill('SIGTERM'); } catch (e) {}
+    }
+    this.emit('state', campaign);
+  }
+
+  async _worker(campaign, pair, queue) {
+    const capture = new CaptureService({ cpus: pair.captureCpus, drainCpu: pair.drainCpu, workers: pair.workers });
+    let failures = 0;
+    while (campaign.state === 'running' && queue.length > 0) {
+      const run = queue.shift();
+      const entry = await this._execute(campaign, pair, capture, run);
+      // Interrupted by stop(): not archived, so resume() plays it again
+      if (campaign.state !== 'running' && entry.status !== 'done') break;
+      this._archive(campaign, entry);
+
+      failures = entry.status === 'done' ? 0 : failures + 1;
+      if (failures >= MAX_PAIR_FAILURES) {
+        campaign.retired.set(pair.id, entry.error);
+        break;
+      }
+    }
+    capture.stopAll();
+  }
+
+  async _execute(campaign, pair, capture, run) {
+    const params = run.params;
+    const started = Date.now();
+    const record = { id: run.id, pair: pair.id, point: run.point, params, startedAt: new Date(started).toISOString() };
+    const slot = { runId: run.id, startedAt: started, proc: null };
+    campaign.active.set(pair.id, slot);
+
+    const sessionId = `${campaign.id}-${run.id}`;
+    let collect = null;
+    try {
+      if (params.gcl && pair.target) {
+        await this.pushGcl(pair, params.gcl, campaign);
+        await sleep(campaign.settleMs);
+      }
+
+      collect = sessionResult(capture, sessionId);
+      capture.startSession({
+        interface: pair.capture,
+        vlanId: params.vlanId,
+        duration: 0,
+        gcl: params.gcl || null,
+        stats: { seq: true },
+        sessionId
+      });
+      await sleep(campaign.leadMs);
+
+      record.sender = await this._runSender(pair, params, slot);
+      await sleep(campaign.tailMs);
+      capture.stopSession(sessionId);
+      record.capture = await collect();
+      collect = null;
+
+      record.status = 'done';
+    } catch (err) {
+      record.status = 'failed';
+      record.error = err.message;
+    } finally {
+      if (collect) {
+        capture.stopSession(sessionId);
+        record.capture = await collect();
+      }
+      campaign.active.delete(pair.id);
+    }
+    record.wallMs = Date.now() - started;
+    record.summary = summarize(record.sender, record.capture);
+    return record;
+  }
+
+  _runSender(pair, params, slot) {
+    return new Promise((resolve, reject) => {
+      const args = senderArgs(pair, params);
+      const proc = this.sudo
+        ? spawn('sudo', [this.senderBinary, ...args], { stdio: ['ignore', 'pipe', 'pipe'] })
+        : spawn(this.senderBinary, args, { stdio: ['ignore', 'pipe', 'pipe'] });
+      slot.proc = proc;
+      let stdout = '';
+      let stderr = '';
+      const timer = setTimeout(() => proc.kill('SIGKILL'), Number(params.duration) * 1000 + SENDER_GRACE_MS);
+
+      proc.stdout.on('data', (data) => { stdout += data; });
+      proc.stderr.on('data', (data) => { stderr += data; });
+      proc.on('error', (err) => {
+        clearTimeout(timer);
+        reject(err);
+      });
+      proc.on('close', (code) => {
+        clearTimeout(timer);
+        slot.proc = null;
+        if (code !== 0) {
+          const lastLine = stderr.trim().split('\n').pop();
+          reject(new Error(lastLine || `traffic-sender exited with ${code}`));
+          return;
+        }
+        try {
+          resolve(JSON.parse(stdout.trim()));
+        } catch (e) {
+          reject(new Error(`Invalid traffic-sender output: ${e.message}`));
+        }
+      });
+    });
+  }
+
+  _archive(campaign, record) {
+    writeJsonAtomic(path.join(campaign.dir, 'runs', `${record.id}.json`), record);
+    const entry = {
+      id: record.id,
+      status: record.status,
+      pair: record.pair,
+      startedAt: record.startedAt,
+      wallMs: record.wallMs,
+      summary: record.summary,
+      error: record.error ?? null
+    };
+    fs.appendFileSync(path.join(campaign.dir, 'progress.jsonl'), JSON.stringify(entry) + '\n');
+    campaign.progress.set(record.id, entry);
+    this.emit('run', campaign, entry);
+  }
+}
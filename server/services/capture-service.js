@@ -0,0 +1,441 @@
+import { spawn } from 'child_process';
+import { EventEmitter } from 'events';
+import { resolveBinary } from '../native-binaries.js';
+import { CycleScoreboard } from './cycle-scores.js';
+
+// Sessions whose cycle scorecards stay readable after they stop
+const MAX_SCOREBOARDS = 16;
+
+/**
+ * Multi-session C capture service
+ *
+ * Each session has its own interface, VLAN set, GCL and stats config.
+ * Sessions on the same interface (and protocol) share one
+ * `traffic-capture --service` process, i.e. one kernel ring; the engine
+ * fans frames out to per-session counters in userspace.
+ *
+ * A session GCL ({ entries: [{ gates, time }], cycleNs, baseTimeNs, linkMbps })
+ * turns on per-TC queue occupancy inference in the engine.
+ *
+ * UDP engines run with --timebase: they fit the switch's PTP time from the
+ * Sync/Follow_Up frames on the TAP (CAPTURE_TIMEBASE=0 turns it off). A GCL
+ * with ptpBaseNs (the port's AdminBaseTime in PTP ns) then has every frame
+ * checked against its gate windows in switch time (`gate` per TC) instead
+ * of aligning the schedule from the traffic.
+ *
+ * With a known phase (ptpBaseNs, or baseTimeNs on the capture clock) the
+ * engine also checks each frame's time on the wire against its gate close
+ * (`guard` per TC: frames in the guard band, straddling the close or sent
+ * while closed, plus the worst offenders in the final analysis, kept as
+ * session.stats.guard). guardBytes
+ * sets the band as one frame's wire time (default 1518, 0 = no band check).
+ * Such sessions also stream one scorecard per GCL cycle, folded into a
+ * CycleScoreboard (services/cycle-scores.js) that outlives the session.
+ * The engine reports windows where the gated accuracy dips below its
+ * baseline (dipPct, default 5) with the PTP events it saw from corrMs
+ * (default 1000) before each; they are kept on the board as well.
+ *
+ * Each engine drains the kernel ring on one thread and hands frames to
+ * analysis workers (CAPTURE_WORKERS, pinned to CAPTURE_CPUS, drain thread
+ * pinned to CAPTURE_DRAIN_CPU). The engine's pipeline health (ring-full
+ * drops, worker lag, kernel drops) is kept per engine, see listEngines().
+ * Rings and sessions come from a 2 MB-page arena on the NIC's NUMA node
+ * (CAPTURE_ARENA_MB overrides its size, 0 = heap); its placement report is
+ * kept per engine as `arena`.
+ *
+ * CAPTURE_CHECK=1 runs UDP engines with --check: PRBS-31 payloads from
+ * `traffic-sender --prbs` are verified and counted per TC (`integrity`:
+ * ok, corrupt, truncated, bit_errors, ber).
+ *
+ * Sequenced sessions that see the preemption mix of `traffic-sender --express`
+ * carry a session-level `preemption` object in 'stats' and 'final': express
+ * latency alone and contended, overtakes and the verdict (active, partial,
+ * off); the final analysis adds quantiles and the per-offset breakdown. The
+ * latest one is kept as session.stats.preemption.
+ *
+ * CAPTURE_ROLLUP_DIR turns on soak rollup stores: a session started with
+ * `rollup: true` (store named "<sessionId>-<start time>") or `rollup: "<name>"`
+ * writes 1 s / 1 min / 1 h per-TC records to CAPTURE_ROLLUP_DIR/<name>,
+ * read back through routes/rollups.js. CAPTURE_ROLLUP_RETAIN ("s1,s60,s3600"
+ * seconds per tier) overrides the engine's retention.
+ *
+ * CAPTURE_METRICS (e.g. "unix:/run/tsnperf/capture-{iface}-{proto}.sock" or
+ * "127.0.0.1:9464") makes each engine serve OpenMetrics for Prometheus.
+ *
+ * Events:
+ *   'stats'   (session, data)  periodic per-session stats line
+ *   'queue'   (session, data)  per-cycle queue depth series since the last report
+ *   'cycles'  (session, data, columns)  cycle scorecards since the last report
+ *                             and the heatmap columns they touched
+ *   'anomaly' (session, anomaly)  accuracy dip window and coincident PTP events
+ *   'final'   (session, data)  final analysis for a session
+ *   'stopped' (session)        session removed (stats hold the last state)
+ *   'pipeline' (engine, data)  engine pipeline health, once per second
+ *   'timebase' (engine, data)  host-to-PTP clock fit, once per second
+ *   'profile' (engine, data)   per-thread stage profile when an engine exits
+ */
+
+// Engine "add" options for a GCL given as entries or { entries, cycleNs, ... }
+export function gclOptions(gcl) {
+  if (!gcl) return [];
+  const entries = Array.isArray(gcl) ? gcl : (gcl.entries || gcl.gcl || []);
+  if (entries.length === 0) return [];
+
+  const opts = [`gcl=${entries.map(e => `${e.gates}:${e.time ?? e.interval}`).join(',')}`];
+  if (gcl.cycleNs) opts.push(`cycle=${gcl.cycleNs}`);
+  if (gcl.baseTimeNs) opts.push(`base=${gcl.baseTimeNs}`);
+  if (gcl.ptpBaseNs !== undefined && gcl.ptpBaseNs !== null) opts.push(`ptpbase=${gcl.ptpBaseNs}`);
+  if (gcl.linkMbps) opts.push(`link=${gcl.linkMbps}`);
+  if (gcl.jitterNs) opts.push(`jitter=${gcl.jitterNs}`);
+  if (gcl.guardBytes !== undefined && gcl.guardBytes !== null) opts.push(`guard=${gcl.guardBytes}`);
+  if (gcl.dipPct) opts.push(`dip=${gcl.dipPct}`);
+  if (gcl.corrMs) opts.push(`corr=${gcl.corrMs}`);
+  return opts;
+}
+
+// Session option for CBS idle slopes: { tc: kbps } or [{ tc, idleSlope }]
+export function cbsOptions(cbs) {
+  if (!cbs) return [];
+  const slopes = Array.isArray(cbs) ? cbs.map(c => [c.tc, c.idleSlope]) : Object.entries(cbs);
+  const spec = slopes.filter(([, kbps]) => Number(kbps) > 0).map(([tc, kbps]) => `${tc}:${kbps}`);
+  return spec.length ? [`cbs=${spec.join(',')}`] : [];
+}
+
+// Engine command-line options for the worker pipeline
+function pipelineArgs(options) {
+  const args = [];
+  const workers = options.workers ?? process.env.CAPTURE_WORKERS;
+  const cpus = options.cpus ?? process.env.CAPTURE_CPUS;
+  const drainCpu = options.drainCpu ?? process.env.CAPTURE_DRAIN_CPU;
+  if (workers) args.push('--workers', String(workers));
+  if (cpus) args.push('--cpus', Array.isArray(cpus) ? cpus.join(',') : String(cpus));
+  if (drainCpu !== undefined && drainCpu !== '') args.push('--drain-cpu', String(drainCpu));
+  const arenaMb = options.arenaMb ?? process.env.CAPTURE_ARENA_MB;
+  if (arenaMb !== undefined && arenaMb !== '') args.push('--arena', String(arenaMb));
+  return args;
+}
+
+export class CaptureService extends EventEmitter {
+  constructor(options = {}) {
+    super();
+    this.binary = options.binary || resolveBinary('traffic-capture');
+    this.engineArgs = pipelineArgs(options);
+    this.metrics = options.metrics ?? process.env.CAPTURE_METRICS ?? null;
+    this.timebase = options.timebase ?? process.env.CAPTURE_TIMEBASE !== '0';
+    this.check = options.check ?? process.env.CAPTURE_CHECK === '1';
+    this.rollupDir = options.rollupDir ?? process.env.CAPTURE_ROLLUP_DIR ?? null;
+    this.rollupRetain = options.rollupRetain ?? process.env.CAPTURE_ROLLUP_RETAIN ?? null;
+    this.engines = new Map();   // "iface|proto" -> engine
+    this.sessions = new Map();  // sessionId -> session
+    this.lastProfiles = new Map(); // "iface|proto" -> stage profile of the last engine run
+    this.scoreboards = new Map();  // sessionId -> CycleScoreboard (oldest first)
+    this.nextId = 1;
+  }
+
+  startSession(config) {
+    const {
+      interface: iface,
+      vlanId = 100,
+      duration = 10,
+      gcl = null,
+      cbs = null,
+      stats = {},
+      ptp = false,
+      rollup = false
+    } = config;
+
+    if (!iface) throw new Error('Interface required');
+    if (rollup && !this.rollupDir) throw new Error('Rollup stores need CAPTURE_ROLLUP_DIR');
+
+    const id = config.sessionId || `s${this.nextId++}`;
+    if (this.sessions.has(id)) throw new Error(`Session ${id} already exists`);
+    this.scoreboards.delete(id);
+    const rollupName = rollup
+      ? (typeof rollup === 'string' ? rollup : `${id}-${Math.floor(Date.now() / 1000)}`).replace(/[^A-Za-z0-9._-]/g, '_')
+      : null;
+
+    const vlans = Array.isArray(vlanId) ? vlanId.join(',') : String(vlanId);
+    const session = {
+      id,
+      interface: iface,
+      vlanId,
+      duration,
+      gcl,
+      ptp: !!ptp,
+      rollup: rollupName,
+      statsConfig: { intervalMs: stats.intervalMs || 200, seq: !!stats.seq, queue: !!stats.queue },
+      state: 'starting',
+      timer: null,
+      stats: { startTime: Date.now(), interface: iface, vlanId, packets: 0, tc: {} }
+    };
+
+    const engine = this._engineFor(iface, session.ptp);
+    session.engineKey = engine.key;
+    engine.sessions.add(id);
+    this.sessions.set(id, session);
+
+    const opts = [`interval=${session.statsConfig.intervalMs}`];
+    if (session.statsConfig.seq) opts.push('seq');
+    if (session.statsConfig.queue) opts.push('queue');
+    opts.push(...gclOptions(gcl));
+    opts.push(...cbsOptions(cbs));
+    if (rollupName) opts.push(`rollup=${rollupName}`);
+    engine.proc.stdin.write(`add ${id} ${vlans} ${opts.join(' ')}\n`);
+
+    if (duration > 0) {
+      session.timer = setTimeout(() => this.stopSession(id), duration * 1000);
+    }
+
+    return session;
+  }
+
+  stopSession(id) {
+    const session = this.sessions.get(id);
+    if (!session || session.state === 'stopping') return session || null;
+
+    clearTimeout(session.timer);
+    session.state = 'stopping';
+    const engine = this.engines.get(session.engineKey);
+    if (engine?.proc.stdin.writable) {
+      engine.proc.stdin.write(`del ${id}\n`);
+    } else {
+      this._finishSession(session);
+    }
+    return session;
+  }
+
+  stopAll() {
+    return Array.from(this.sessions.keys()).map(id => this.stopSession(id)).filter(Boolean);
+  }
+
+  getSession(id) {
+    return this.sessions.get(id) || null;
+  }
+
+  listSessions() {
+    return Array.from(this.sessions.values()).map(s => this.describe(s));
+  }
+
+  describe(session) {
+    const engine = this.engines.get(session.engineKey);
+    return {
+      sessionId: session.id,
+      interface: session.interface,
+      vlanId: session.vlanId,
+      duration: session.duration,
+      gcl: session.gcl,
+      ptp: session.ptp,
+      rollup: session.rollup,
+      stats: session.statsConfig,
+      state: session.state,
+      sharedWith: engine ? Array.from(engine.sessions).filter(id => id !== session.id) : [],
+      packets: session.stats.packets
+    };
+  }
+
+  listEngines() {
+    return Array.from(this.engines.values()).filter(e => !e.closed).map(e => ({
+      key: e.key,
+      metrics: e.metrics,
+      sessions: Array.from(e.sessions),
+      pipeline: e.pipeline,
+      timebase: e.timebase,
+      arena: e.arena
+    }));
+  }
+
+  listProfiles() {
+    return Object.fromEntries(this.lastProfiles);
+  }
+
+  getScoreboard(id) {
+    return this.scoreboards.get(id) || null;
+  }
+
+  _scoreboardFor(session, cycleNs) {
+    let board = this.scoreboards.get(session.id);
+    if (board && board.cycleNs === cycleNs) return board;
+    board = new CycleScoreboard(cycleNs);
+    this.scoreboards.delete(session.id);
+    this.scoreboards.set(session.id, board);
+    if (this.scoreboards.size > MAX_SCOREBOARDS) {
+      this.scoreboards.delete(this.scoreboards.keys().next().value);
+    }
+    return board;
+  }
+
+  _engineFor(iface, ptp) {
+    const key = `${iface}|${ptp ? 'ptp' : 'udp'}`;
+    const existing = this.engines.get(key);
+    if (existing && !existing.closed) return existing;
+
+    const args = [iface, '--service', ...this.engineArgs];
+    if (ptp) args.push('--ptp');
+    else if (this.timebase) args.push('--timebase');
+    if (!ptp && this.check) args.push('--check');
+    const metrics = this.metrics
+      ? this.metrics.replace('{iface}', iface).replace('{proto}', ptp ? 'ptp' : 'udp')
+      : null;
+    if (metrics) args.push('--metrics', metrics);
+    if (this.rollupDir) args.push('--rollup', this.rollupDir);
+    if (this.rollupDir && this.rollupRetain) args.push('--rollup-retain', String(this.rollupRetain));
+
+    // Spawn the C capture process (requires cap_net_raw capability)
+    const proc = spawn(this.binary, args, { stdio: ['pipe', 'pipe', 'pipe'] });
+    const engine = {
+      key,
+      proc,
+      sessions: new Set(),
+      closed: false,
+      metrics,
+      pipeline: null,
+      timebase: null,
+      arena: null,
+      profile: null
+    };
+    this.engines.set(key, engine);
+
+    let buffer = '';
+    proc.stdout.on('data', (data) => {
+      buffer += data.toString();
+      const lines = buffer.split('\n');
+      buffer = lines.pop(); // Keep incomplete line in buffer
+
+      for (const line of lines) {
+        if (!line.trim()) continue;
+        try {
+          this._handleLine(JSON.parse(line), engine);
+        } catch (e) {
+          // Ignore parse errors
+        }
+      }
+    });
+
+    proc.stderr.on('data', (data) => {
+      const msg = data.toString().trim();
+      if (msg && !msg.includes('password')) {
+        console.log(`[C-capture ${key}]`, msg);
+      }
+    });
+
+    const shutdown = () => {
+      if (engine.closed) return;
+      engine.closed = true;
+      if (this.engines.get(key) === engine) this.engines.delete(key);
+      for (const id of engine.sessions) {
+        const session = this.sessions.get(id);
+        if (session) this._finishSession(session);
+      }
+      engine.sessions.clear();
+    };
+
+    proc.on('close', (code) => {
+      console.log(`[C-capture ${key}] Process exited with code ${code}`);
+      shutdown();
+    });
+
+    proc.on('error', (err) => {
+      console.error(`[C-capture ${key}] Error:`, err.message);
+      shutdown();
+    });
+
+    proc.stdin.on('error', () => {});
+
+    return engine;
+  }
+
+  _handleLine(json, engine) {
+    if (json.pipeline) {
+      engine.pipeline = { ...json.pipeline, updatedAt: Date.now() };
+      this.emit('pipeline', engine, json.pipeline);
+      return;
+    }
+    if (json.arena) {
+      engine.arena = json.arena;
+      return;
+    }
+    if (json.timebase) {
+      engine.timebase = { ...json.timebase, updatedAt: Date.now() };
+      this.emit('timebase', engine, json.timebase);
+      return;
+    }
+    if (json.profile) {
+      engine.profile = json.profile;
+      this.lastProfiles.set(engine.key, json.profile);
+      this.emit('profile', engine, json.profile);
+      return;
+    }
+
+    const session = this.sessions.get(json.session);
+    if (!session) return;
+
+    if (json.event === 'added') {
+      session.state = 'running';
+      return;
+    }
+    if (json.event === 'removed') {
+      this._finishSession(session);
+      return;
+    }
+    if (json.error) {
+      console.error(`[C-capture] Session ${session.id}: ${json.error}`);
+      this._finishSession(session);
+      return;
+    }
+
+    if (json.queue) {
+      this.emit('queue', session, json);
+      return;
+    }
+
+    if (json.cycles) {
+      const columns = this._scoreboardFor(session, json.cycles.cycle_ns).add(json.cycles);
+      this.emit('cycles', session, json.cycles, columns);
+      return;
+    }
+
+    if (json.anomaly) {
+      const board = this.scoreboards.get(session.id);
+      if (board) this.emit('anomaly', session, board.addAnomaly(json.anomaly));
+      return;
+    }
+
+    const stats = session.stats;
+    if (json.final) {
+      stats.final = true;
+      stats.analysis = json.tc;
+      if (json.preemption) stats.preemption = json.preemption;
+      if (json.guard) stats.guard = json.guard;
+      this.emit('final', session, json);
+      return;
+    }
+
+    stats.elapsed_ms = json.elapsed_ms;
+    stats.packets = json.total || 0;
+    if (json.tc) stats.tc = json.tc;
+    if (json.preemption) stats.preemption = json.preemption;
+    this.emit('stats', session, json);
+  }
+
+  _finishSession(session) {
+    if (!this.sessions.has(session.id)) return;
+    clearTimeout(session.timer);
+    session.state = 'stopped';
+    this.sessions.delete(session.id);
+
+    const engine = this.engines.get(session.engineKey);
+    if (engine) {
+      engine.sessions.delete(session.id);
+      // Last session on this interface: let the engine exit
+      if (engine.sessions.size === 0 && !engine.closed) {
+        engine.closed = true;
+        this.engines.delete(engine.key);
+        engine.proc.stdin.end();
+      }
+    }
+
+    this.emit('stopped', session);
+  }
+}
+
+export const captureService = new CaptureService();
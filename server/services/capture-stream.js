@@ -0,0 +1,352 @@
+/**
+ * Batched capture stream for /ws/capture
+ *
+ * Packet and stats updates are queued and flushed at a fixed cadence.
+ * Clients that connect with `?format=binary` receive one columnar frame per
+ * batch (see client/src/lib/captureStream.js for the decoder); other clients
+ * keep receiving one JSON message per update. Control messages (sync,
+ * stopped, errors, final analysis) are always JSON and are sent after any
+ * pending batch so ordering is preserved.
+ *
+ * Binary frame (little-endian, every section 8-byte aligned):
+ *   header   magic 'TSNB' u32, version u8, kind u8, reserved u16, count u32, reserved u32
+ *   columns  schema order; `width` values per record (TC columns are 8 wide)
+ *            (stats fields without a column travel as JSON in `ext`, so binary
+ *            clients get everything JSON clients do)
+ *   strings  u32 n, u32 offsets[n + 1], UTF-8 bytes (dict columns index it, 0 = null)
+ *   raw      packet bytes (packet batches only, rawOffset/rawLength columns)
+ */
+
+export const FRAME_MAGIC = 0x424e5354; // 'TSNB'
+export const FRAME_VERSION = 3;
+export const FRAME_KIND = { packets: 1, stats: 2 };
+
+const HEADER_LEN = 16;
+const MAX_TC = 8;
+
+const F64 = Float64Array;
+const U64 = BigUint64Array;
+const U32 = Uint32Array;
+const I32 = Int32Array;
+const U16 = Uint16Array;
+const U8 = Uint8Array;
+const I8 = Int8Array;
+const DICT = 'dict';
+
+// Column schemas, keep in sync with client/src/lib/captureStream.js
+export const PACKET_COLUMNS = [
+  ['id', U32, p => p.id],
+  ['time', F64, p => p.timeMs],
+  ['captureNs', U64, p => p.captureNs ?? 0n],
+  ['interface', DICT, p => p.interface],
+  ['protocol', DICT, p => p.protocol],
+  ['source', DICT, p => p.source],
+  ['destination', DICT, p => p.destination],
+  ['srcMac', DICT, p => p.srcMac],
+  ['dstMac', DICT, p => p.dstMac],
+  ['srcPort', U16, p => p.srcPort],
+  ['dstPort', U16, p => p.dstPort],
+  ['length', U32, p => p.length],
+  ['vlan', I32, p => p.vlan ? (p.vlan.pcp << 13) | (p.vlan.dei << 12) | p.vlan.vid : -1],
+  ['info', DICT, p => p.info],
+  ['ptpMsgType', DICT, p => p.ptp?.msgType],
+  ['ptpSeq', U16, p => p.ptp?.sequenceId],
+  ['ptpDomain', U8, p => p.ptp?.domainNumber],
+  ['ptpClockId', DICT, p => p.ptp?.clockId],
+  ['ptpPort', U16, p => p.ptp?.sourcePort],
+  ['ptpTsSec', F64, p => p.ptp?.timestamp ? p.ptp.timestamp.seconds : NaN],
+  ['ptpTsNs', U32, p => p.ptp?.timestamp?.nanoseconds],
+  ['ptpCorrection', F64, p => p.ptp?.correction],
+  ['ptpTwoStep', U8, p => p.ptp?.twoStepFlag ? 1 : 0],
+  ['ptpLogPeriod', I8, p => p.ptp?.logMessagePeriod],
+  ['ptpReqSec', F64, p => p.ptp?.requestReceiptTimestamp ? p.ptp.requestReceiptTimestamp.seconds : NaN],
+  ['ptpReqNs', U32, p => p.ptp?.requestReceiptTimestamp?.nanoseconds],
+  ['ext', DICT, p => (p.coap || p.tcp) ? JSON.stringify({ coap: p.coap, tcp: p.tcp }) : null],
+  ['rawOffset', U32, null],
+  ['rawLength', U32, p => p.raw ? p.raw.length : 0],
+  ['payloadOffset', I32, p => p.payloadOffset ?? -1]
+];
+
+const tcValue = (key, missing = 0) => (s, tc) => s.tc?.[tc]?.[key] ?? missing;
+const tcSeq = (key, missing = 0) => (s, tc) => s.tc?.[tc]?.seq?.[key] ?? missing;
+const tcGate = (key, missing = 0) => (s, tc) => s.tc?.[tc]?.gate?.[key] ?? missing;
+
+// Stats fields the columns cover; the rest goes to `ext`
+const STATS_KEYS = new Set(['sessionId', 'elapsed_ms', 'total', 'tc']);
+const TC_KEYS = new Set(['count', 'avg_us', 'min_us', 'max_us', 'kbps', 'seq', 'gate']);
+const SEQ_KEYS = new Set(['count', 'lost', 'ooo', 'lat_avg_us', 'lat_min_us', 'lat_max_us']);
+
+// Uncovered fields of a stats record as JSON ({ ...session, tc: { [t]: { ...fields, seq } } }), null if none
+function statsExt(s) {
+  const ext = {};
+  for (const key in s) if (!STATS_KEYS.has(key)) ext[key] = s[key];
+  for (const t in s.tc || {}) {
+    const rx = s.tc[t];
+    let extra = null;
+    for (const key in rx) {
+      if (!TC_KEYS.has(key)) (extra ||= {})[key] = rx[key];
+    }
+    for (const key in rx.seq || {}) {
+      if (!SEQ_KEYS.has(key)) ((extra ||= {}).seq ||= {})[key] = rx.seq[key];
+    }
+    if (extra) (ext.tc ||= {})[t] = extra;
+  }
+  return Object.keys(ext).length ? JSON.stringify(ext) : null;
+}
+
+export const STATS_COLUMNS = [
+  ['session', DICT, s => s.sessionId],
+  ['elapsedMs', F64, s => s.elapsed_ms],
+  ['total', F64, s => s.total],
+  ['tcCount', F64, tcValue('count'), MAX_TC],
+  ['tcAvgUs', F64, tcValue('avg_us'), MAX_TC],
+  ['tcMinUs', F64, tcValue('min_us'), MAX_TC],
+  ['tcMaxUs', F64, tcValue('max_us'), MAX_TC],
+  ['tcKbps', F64, tcValue('kbps'), MAX_TC],
+  ['tcSeqCount', F64, tcSeq('count'), MAX_TC],
+  ['tcSeqLost', F64, tcSeq('lost'), MAX_TC],
+  ['tcSeqOoo', F64, tcSeq('ooo'), MAX_TC],
+  ['tcLatAvgUs', F64, tcSeq('lat_avg_us', NaN), MAX_TC],
+  ['tcLatMinUs', F64, tcSeq('lat_min_us', NaN), MAX_TC],
+  ['tcLatMaxUs', F64, tcSeq('lat_max_us', NaN), MAX_TC],
+  ['tcGateIn', F64, tcGate('in', NaN), MAX_TC],
+  ['tcGateOut', F64, tcGate('out'), MAX_TC],
+  ['tcGateUnmapped', F64, tcGate('unmapped'), MAX_TC],
+  ['tcGateExcessUs', F64, tcGate('max_excess_us'), MAX_TC],
+  ['ext', DICT, statsExt]
+];
+
+const align8 = n => (n + 7) & ~7;
+const textEncoder = new TextEncoder();
+
+// Encode records into one columnar frame (ArrayBuffer)
+export function encodeBatch(kind, columns, records) {
+  const count = records.length;
+
+  // Dictionary for string columns; index 0 is null
+  const dict = new Map();
+  const strings = [];
+  const intern = (value) => {
+    if (value === null || value === undefined || value === '') return 0;
+    let idx = dict.get(value);
+    if (idx === undefined) {
+      strings.push(textEncoder.encode(String(value)));
+      idx = strings.length;
+      dict.set(value, idx);
+    }
+    return idx;
+  };
+
+  let size = HEADER_LEN;
+  const layout = columns.map(([name, type, get, width = 1]) => {
+    const Type = type === DICT ? U32 : type;
+    const offset = size;
+    size += align8(count * width * Type.BYTES_PER_ELEMENT);
+    return { name, Type, dict: type === DICT, get, width, offset };
+  });
+
+  // Columns are filled first: the frame size depends on the interned strings
+  const views = {};
+  const cols = layout.map(col => (views[col.name] = new col.Type(count * col.width)));
+
+  // Column-major so each inner loop writes a single array type
+  layout.forEach((col, c) => {
+    const { get, width, dict: isDict } = col;
+    const arr = cols[c];
+    if (!get) return;
+    if (isDict) {
+      for (let i = 0; i < count; i++) arr[i] = intern(get(records[i]));
+    } else if (width === 1) {
+      for (let i = 0; i < count; i++) arr[i] = get(records[i]) ?? 0;
+    } else {
+      for (let i = 0; i < count; i++) {
+        for (let k = 0; k < width; k++) arr[i * width + k] = get(records[i], k);
+      }
+    }
+  });
+
+  let rawTotal = 0;
+  if (views.rawOffset) {
+    for (let i = 0; i < count; i++) {
+      views.rawOffset[i] = rawTotal;
+      rawTotal += views.rawLength[i];
+    }
+  }
+
+  let stringBytes = 0;
+  for (const s of strings) stringBytes += s.length;
+  const stringsOffset = size;
+  size += align8(4 * (strings.length + 2) + stringBytes);
+  const rawOffset = size;
+  size += rawTotal;
+
+  const buffer = new ArrayBuffer(size);
+  const header = new DataView(buffer);
+  header.setUint32(0, FRAME_MAGIC, true);
+  header.setUint8(4, FRAME_VERSION);
+  header.setUint8(5, kind);
+  header.setUint32(8, count, true);
+
+  layout.forEach((col, c) => new col.Type(buffer, col.offset, count * col.width).set(cols[c]));
+
+  const offsets = new U32(buffer, stringsOffset, strings.length + 2);
+  offsets[0] = strings.length;
+  const bytes = new U8(buffer);
+  let pos = stringsOffset + 4 * (strings.length + 2);
+  for (let s = 0; s < strings.length; s++) {
+    offsets[s + 1] = pos - stringsOffset;
+    bytes.set(strings[s], pos);
+    pos += strings[s].length;
+  }
+  offsets[strings.length + 1] = pos - stringsOffset;
+
+  if (views.rawOffset) {
+    for (let i = 0; i < count; i++) {
+      const raw = records[i].raw;
+      if (raw) bytes.set(raw, rawOffset + views.rawOffset[i]);
+    }
+  }
+
+  return buffer;
+}
+
+function toHex(buffer) {
+  return Array.from(buffer).map(b => b.toString(16).padStart(2, '0')).join(' ');
+}
+
+function toAscii(buffer) {
+  return Array.from(buffer).map(b => (b >= 32 && b < 127) ? String.fromCharCode(b) : '.').join('');
+}
+
+// JSON message shape expected by clients without binary support
+function legacyPacket(p) {
+  const { raw, payloadOffset, timeMs, captureNs, ...packet } = p;
+  packet.time = new Date(timeMs).toISOString();
+  if (captureNs !== undefined) packet.captureNs = captureNs.toString();
+  if (raw) {
+    const payload = payloadOffset >= 0 ? raw.subarray(payloadOffset) : null;
+    packet.hex = toHex(raw);
+    packet.ascii = toAscii(raw);
+    packet.payloadHex = payload ? toHex(payload) : null;
+    packet.payloadAscii = payload ? toAscii(payload) : null;
+  }
+  return packet;
+}
+
+const DEFAULT_FLUSH_MS = parseInt(process.env.CAPTURE_WS_FLUSH_MS, 10) || 50;
+const MAX_BATCH = 4096;
+const MAX_BUFFERED = 8 * 1024 * 1024;
+
+export class CaptureStream {
+  constructor(options = {}) {
+    this.flushMs = options.flushMs || DEFAULT_FLUSH_MS;
+    this.clients = new Map(); // ws -> { binary, dropped }
+    this.packets = [];
+    this.stats = [];
+    this.timer = null;
+    this.counters = { packets: 0, stats: 0, batches: 0, bytes: 0, dropped: 0 };
+  }
+
+  attach(ws, req) {
+    const url = new URL(req?.url || '/', 'http://localhost');
+    this.clients.set(ws, { binary: url.searchParams.get('format') === 'binary', dropped: 0 });
+    const detach = () => this.clients.delete(ws);
+    ws.on('close', detach);
+    ws.on('error', detach);
+  }
+
+  get size() {
+    return this.clients.size;
+  }
+
+  // Queue one captured packet (raw: Buffer owned by the record)
+  pushPacket(packet) {
+    this.packets.push(packet);
+    this.counters.packets++;
+    if (this.packets.length >= MAX_BATCH) this.flush();
+    else this._schedule();
+  }
+
+  // Queue one periodic stats record ({ sessionId, elapsed_ms, total, tc, ... })
+  pushStats(record) {
+    this.stats.push(record);
+    this.counters.stats++;
+    this._schedule();
+  }
+
+  // Send a control message immediately, after anything already queued
+  send(message) {
+    this.flush();
+    const text = JSON.stringify(message);
+    for (const ws of this.clients.keys()) this._send(ws, text);
+  }
+
+  flush() {
+    clearTimeout(this.timer);
+    this.timer = null;
+    if (this.packets.length === 0 && this.stats.length === 0) return;
+
+    const packets = this.packets;
+    const stats = this.stats;
+    this.packets = [];
+    this.stats = [];
+
+    let binary = false, json = false;
+    for (const c of this.clients.values()) {
+      if (c.binary) binary = true; else json = true;
+    }
+
+    if (binary) {
+      const frames = [];
+      if (packets.length) frames.push(encodeBatch(FRAME_KIND.packets, PACKET_COLUMNS, packets));
+      if (stats.length) frames.push(encodeBatch(FRAME_KIND.stats, STATS_COLUMNS, stats));
+      for (const [ws, c] of this.clients) {
+        if (!c.binary) continue;
+        for (const frame of frames) {
+          // Slow consumers lose whole batches instead of growing the send queue
+          if (ws.bufferedAmount > MAX_BUFFERED) {
+            c.dropped++;
+            this.counters.dropped++;
+            continue;
+          }
+          this._send(ws, frame);
+        }
+      }
+      this.counters.batches += frames.length;
+      for (const frame of frames) this.counters.bytes += frame.byteLength;
+    }
+
+    if (json) {
+      const messages = [];
+      for (const p of packets) messages.push(JSON.stringify({ type: 'packet', data: legacyPacket(p) }));
+      for (const s of stats) {
+        const { sessionId, ...data } = s;
+        messages.push(JSON.stringify({ type: 'c-capture-stats', sessionId, data: { ...data, final: false } }));
+      }
+      for (const [ws, c] of this.clients) {
+        if (c.binary) continue;
+        for (const m of messages) this._send(ws, m);
+      }
+    }
+  }
+
+  status() {
+    let binary = 0;
+    for (const c of this.clients.values()) if (c.binary) binary++;
+    return { clients: this.clients.size, binaryClients: binary, flushMs: this.flushMs, ...this.counters };
+  }
+
+  _schedule() {
+    if (!this.timer) this.timer = setTimeout(() => this.flush(), this.flushMs);
+  }
+
+  _send(ws, data) {
+    try {
+      if (ws.readyState === 1) ws.send(data);
+    } catch (e) {
+      // Ignore send errors
+    }
+  }
+}
+
+export const captureStream = new CaptureStream();
@@ -0,0 +1,134 @@
+/**
+ * Per-cycle TAS scorecards of a capture session, folded for heatmaps
+ *
+ * The engine streams one record per GCL cycle ({"cycles":{...}} lines:
+ * per-TC frames, wrong-slot frames, worst excess, first/last arrival
+ * phase). Hours of 1 ms cycles are millions of records, so the board keeps
+ * two views, plus the dips the engine found in them:
+ *   - raw: the last RAW_CYCLES records as they came
+ *   - columns: cycles folded into fixed spans (about one second of cycles
+ *     each), the last MAX_COLUMNS of them. A column keeps per TC the frame
+ *     and wrong-slot totals, the cycles with any wrong-slot frame, the worst
+ *     cycle's accuracy and excess, and the first/last arrival phase range,
+ *     so one bad cycle still shows in its column.
+ *   - anomalies: the last MAX_ANOMALIES accuracy dip windows the engine
+ *     reported ({"anomaly":{...}}), with the PTP events around each.
+ */
+
+const RAW_CYCLES = 4096;
+const MAX_COLUMNS = 4 * 3600;
+const COLUMN_NS = 1e9;
+const MAX_ANOMALIES = 256;
+
+export class CycleScoreboard {
+  constructor(cycleNs, { rawCycles = RAW_CYCLES, maxColumns = MAX_COLUMNS, columnNs = COLUMN_NS } = {}) {
+    this.cycleNs = cycleNs;
+    this.cyclesPerColumn = Math.max(1, Math.round(columnNs / cycleNs));
+    this.rawCycles = rawCycles;
+    this.maxColumns = maxColumns;
+    this.raw = [];
+    this.columns = [];       // Oldest first
+    this.anomalies = [];     // Oldest first
+    this.cycles = 0;
+    this.dropped = 0;
+    this.stale = 0;
+  }
+
+  // One "cycles" line. Returns the columns it touched (last one still filling).
+  add(data) {
+    if (data.cycle_ns !== this.cycleNs) return [];
+    this.dropped = data.dropped;
+    this.stale = data.stale;
+
+    const touched = new Set();
+    data.cycle.forEach((rel, k) => {
+      const cycle = data.cycle0 + rel;
+      const rec = { cycle, tc: {} };
+      for (const [tc, cols] of Object.entries(data.tc)) {
+        if (!cols.frames[k]) continue;
+        rec.tc[tc] = {
+          frames: cols.frames[k],
+          wrong: cols.wrong[k],
+          excessNs: cols.excess_ns[k],
+          firstNs: cols.first_ns[k],
+          lastNs: cols.last_ns[k]
+        };
+      }
+      this.raw.push(rec);
+      touched.add(this._fold(rec));
+      this.cycles++;
+    });
+
+    if (this.raw.length > this.rawCycles) this.raw.splice(0, this.raw.length - this.rawCycles);
+    if (this.columns.length > this.maxColumns) this.columns.splice(0, this.columns.length - this.maxColumns);
+    return Array.from(touched).filter(c => this.columns.includes(c));
+  }
+
+  _fold(rec) {
+    const start = Math.floor(rec.cycle / this.cyclesPerColumn) * this.cyclesPerColumn;
+    let col = this.columns[this.columns.length - 1];
+    if (!col || col.cycle !== start) {
+      // Late cycles of an older column are rare (stale frames are dropped by the engine)
+      col = this.columns.find(c => c.cycle === start);
+      if (!col) {
+        col = { cycle: start, cycles: 0, tc: {} };
+        this.columns.push(col);
+        if (this.columns.length > 1 && this.columns[this.columns.length - 2].cycle > start) {
+          this.columns.sort((a, b) => a.cycle - b.cycle);
+        }
+      }
+    }
+
+    col.cycles++;
+    for (const [tc, r] of Object.entries(rec.tc)) {
+      if (!col.tc[tc]) {
+        col.tc[tc] = { frames: 0, wrong: 0, badCycles: 0, minAccuracy: 1, maxExcessNs: 0, firstNs: r.firstNs, lastNs: r.lastNs };
+      }
+      const t = col.tc[tc];
+      t.frames += r.frames;
+      t.wrong += r.wrong;
+      if (r.wrong) t.badCycles++;
+      t.minAccuracy = Math.min(t.minAccuracy, 1 - r.wrong / r.frames);
+      t.maxExcessNs = Math.max(t.maxExcessNs, r.excessNs);
+      t.firstNs = Math.min(t.firstNs, r.firstNs);
+      t.lastNs = Math.max(t.lastNs, r.lastNs);
+    }
+    return col;
+  }
+
+  // One "anomaly" line: a dip window and its coincident PTP events
+  addAnomaly(data) {
+    const a = {
+      firstCycle: data.cycles[0],
+      lastCycle: data.cycles[1],
+      tNs: data.t_ns,
+      dipCycles: data.dip_cycles,
+      accuracy: data.accuracy,
+      baseline: data.baseline,
+      dropPct: data.drop_pct,
+      minAccuracy: data.min_accuracy,
+      frames: data.frames,
+      wrong: data.wrong,
+      ptp: data.ptp || null,
+      events: (data.events || []).map(e => ({ kind: e.kind, dtNs: e.dt_ns, value: e.value })),
+      cause: data.cause
+    };
+    this.anomalies.push(a);
+    if (this.anomalies.length > MAX_ANOMALIES) this.anomalies.shift();
+    return a;
+  }
+
+  // Columns from cycle `from` on (all if omitted) and the last `raw` records
+  snapshot({ from, raw = 0 } = {}) {
+    return {
+      cycleNs: this.cycleNs,
+      cyclesPerColumn: this.cyclesPerColumn,
+      cycles: this.cycles,
+      dropped: this.dropped,
+      stale: this.stale,
+      columns: from === undefined ? this.columns : this.columns.filter(c => c.cycle + this.cyclesPerColumn > from),
+      raw: raw > 0 ? this.raw.slice(-raw) : [],
+      anomalies: from === undefined ? this.anomalies : this.anomalies.filter(a => a.lastCycle >= from)
+    };
+  }
+}
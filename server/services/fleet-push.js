@@ -0,0 +1,203 @@
+import path from 'path';
+import { fileURLToPath } from 'url';
+import yaml from 'js-yaml';
+import { encodeItems, resolveQueries, decodeCbor } from './yang-pool.js';
+
+const __dirname = path.dirname(fileURLToPath(import.meta.url));
+const TSC2CBOR_LIB = path.resolve(__dirname, '../../tsc2cbor/lib');
+
+/**
+ * Fleet config push
+ *
+ * Pushes iPATCH sets to many boards at once instead of one /api/patch
+ * request per board. Every distinct patch item is encoded once (on the YANG
+ * worker pool) and the same CBOR payload is sent to every board that uses
+ * it. Boards run concurrently up to `concurrency`; boards behind the same
+ * ESP32 proxy (target.proxy, default its host) share `perProxy` slots, and
+ * a serial device is always one slot.
+ *
+ * A board stops at its first failed patch, so `applied` tells how far it got
+ * for rollback. After the push phase the boards with a `readBack` list are
+ * read back in parallel (same limits) and checked with their `expect`
+ * function, which returns a list of mismatches.
+ *
+ * Target: { id, transport: 'wifi'|'serial', host, port, device, proxy,
+ *           patches: [{ path, value }], readBack: [path], expect(parsed) }
+ */
+
+const READY_TIMEOUT_MS = 5000;
+
+// Concurrency gate; a finishing job hands its slot straight to the next waiter
+function limiter(limit) {
+  let active = 0;
+  const waiting = [];
+  return async (fn) => {
+    if (active < limit) active++;
+    else await new Promise(resolve => waiting.push(resolve));
+    try {
+      return await fn();
+    } finally {
+      const next = waiting.shift();
+      if (next) next();
+      else active--;
+    }
+  };
+}
+
+function proxyKey(target) {
+  if (target.transport === 'serial') return `serial:${target.device}`;
+  return target.proxy || `${target.host}:${target.port || 5683}`;
+}
+
+async function connect(target) {
+  const { createTransport } = await import(`${TSC2CBOR_LIB}/transport/index.js`);
+  const transport = createTransport(target.transport || 'wifi', { verbose: false });
+  if (target.transport === 'serial') {
+    await transport.connect({ device: target.device });
+  } else {
+    if (!target.host) throw new Error('WiFi transport requires host');
+    await transport.connect({ host: target.host, port: target.port || 5683 });
+  }
+  await transport.waitForReady(READY_TIMEOUT_MS);
+  return transport;
+}
+
+const itemKey = (p) => JSON.stringify([p.path, p.value]);
+
+// One CBOR payload per distinct patch item across the fleet
+async function encodeFleet(cacheDir, targets) {
+  const items = new Map();
+  for (const t of targets) {
+    for (const p of t.patches) {
+      const key = itemKey(p);
+      if (!items.has(key)) items.set(key, { [p.path]: p.value });
+    }
+  }
+  const keys = Array.from(items.keys());
+  const encoded = await encodeItems(cacheDir, Array.from(items.values()));
+  return new Map(keys.map((k, i) => [k, encoded[i]]));
+}
+
+async function pushBoard(target, payloads, cacheDir, board) {
+  const start = Date.now();
+  let transport = null;
+  board.stage = 'connect';
+  try {
+    transport = await connect(target);
+    board.latency.connectMs = Date.now() - start;
+
+    board.stage = 'patch';
+    for (const p of target.patches) {
+      const cbor = payloads.get(itemKey(p));
+      if (cbor.error) throw new Error(`${p.path}: ${cbor.error}`);
+
+      const response = await transport.sendiPatchRequest(cbor);
+      if (!response.isSuccess()) {
+        let detail = `CoAP code ${response.code}`;
+        if (response.payload?.length) {
+          try {
+            detail = await decodeCbor(cacheDir, response.payload);
+          } catch {
+            detail = `Payload: ${response.payload.toString('hex')}`;
+          }
+        }
+        throw new Error(`${p.path}: ${detail}`);
+      }
+      board.applied++;
+    }
+    board.pushed = true;
+  } catch (err) {
+    board.error = err.message;
+  } finally {
+    if (transport) {
+      try { await transport.disconnect(); } catch (e) {}
+    }
+    board.doneAt = Date.now();
+    board.latency.pushMs = board.doneAt - start;
+  }
+}
+
+async function verifyBoard(target, cacheDir, board) {
+  const start = Date.now();
+  let transport = null;
+  board.stage = 'verify';
+  try {
+    const queries = await resolveQueries(cacheDir, target.readBack);
+    transport = await connect(target);
+    const response = await transport.sendiFetchRequest(queries);
+    if (!response.isSuccess()) throw new Error(`iFETCH failed: CoAP code ${response.code}`);
+
+    const parsed = yaml.load(await decodeCbor(cacheDir, response.payload));
+    board.mismatches = target.expect ? target.expect(parsed) : [];
+    board.verified = board.mismatches.length === 0;
+    if (!board.verified) board.error = `Read-back mismatch: ${board.mismatches.join('; ')}`;
+  } catch (err) {
+    board.error = err.message;
+  } finally {
+    if (transport) {
+      try { await transport.disconnect(); } catch (e) {}
+    }
+    board.latency.verifyMs = Date.now() - start;
+  }
+}
+
+/**
+ * Push patch sets to a fleet of boards
+ * @returns {Promise<{boards, summary, rollback}>}
+ */
+export async function pushFleet(targets, { cacheDir, concurrency = 8, perProxy = 1, verify = true } = {}) {
+  const started = Date.now();
+  const payloads = await encodeFleet(cacheDir, targets);
+  const encodeMs = Date.now() - started;
+
+  const global = limiter(Math.max(1, concurrency));
+  const proxies = new Map();
+  const slot = (target, fn) => {
+    const key = proxyKey(target);
+    if (!proxies.has(key)) proxies.set(key, limiter(target.transport === 'serial' ? 1 : Math.max(1, perProxy)));
+    return proxies.get(key)(() => global(fn));
+  };
+
+  const boards = targets.map((t, i) => ({
+    id: t.id ?? t.host ?? t.device ?? String(i),
+    proxy: proxyKey(t),
+    pushed: false,
+    verified: null,
+    applied: 0,
+    total: t.patches.length,
+    stage: null,
+    error: null,
+    latency: {}
+  }));
+
+  await Promise.all(targets.map((t, i) => slot(t, () => pushBoard(t, payloads, cacheDir, boards[i]))));
+
+  if (verify) {
+    await Promise.all(targets.map((t, i) => (boards[i].pushed && t.readBack?.length
+      ? slot(t, () => verifyBoard(t, cacheDir, boards[i]))
+      : null)));
+  }
+
+  for (const b of boards) {
+    b.latency.totalMs = (b.latency.pushMs || 0) + (b.latency.verifyMs || 0);
+    if (!b.error) b.stage = 'done';
+  }
+
+  const failed = boards.filter(b => b.error);
+  return {
+    boards,
+    summary: {
+      total: boards.length,
+      pushed: boards.filter(b => b.pushed).length,
+      verified: boards.filter(b => b.verified).length,
+      failed: failed.length,
+      uniquePayloads: payloads.size,
+      proxies: proxies.size,
+      encodeMs,
+      wallMs: Date.now() - started,
+      maxBoardMs: Math.max(0, ...boards.map(b => b.latency.totalMs))
+    },
+    // Boards that took any patch but did not end up pushed and verified
+    rollback: failed.filter(b => b.applied > 0).map(b => b.id)
+  };
+}
@@ -0,0 +1,152 @@
+import { Worker } from 'worker_threads';
+import os from 'os';
+import { runJob } from './yang-transform.js';
+
+/**
+ * Worker-thread pool for the YANG/CBOR transforms of the device routes
+ *
+ * Instance-identifier resolution, CBOR decoding to YAML and YAML encoding to
+ * CBOR are CPU-bound and used to run on the main loop, so one large iFETCH
+ * response stalled every other request and WebSocket stream. The routes now
+ * do only device I/O and hand the transforms to YANG_WORKERS worker threads
+ * (default: CPUs - 1, at most 4; 0 runs them inline on the main thread).
+ *
+ * Each worker keeps one copy of a catalog's SID/type tables for all its
+ * jobs. The first job for a catalog loads it on a single worker, so a
+ * missing pre-compiled cache (<cacheDir>.cache.json) is built once; the
+ * other workers then load from the cache file. CBOR payloads cross the
+ * thread boundary as transferred ArrayBuffers, not copies.
+ */
+
+const WORKER_URL = new URL('./yang-worker.js', import.meta.url);
+
+function poolSize() {
+  const env = process.env.YANG_WORKERS;
+  if (env !== undefined && env !== '') return Math.max(0, parseInt(env, 10) || 0);
+  return Math.max(1, Math.min(4, os.cpus().length - 1));
+}
+
+// Own the bytes of a Buffer so its ArrayBuffer can be transferred
+function detachable(buf) {
+  return buf.buffer.slice(buf.byteOffset, buf.byteOffset + buf.length);
+}
+
+class YangPool {
+  constructor(size) {
+    this.size = size;
+    this.workers = [];
+    this.catalogs = new Map();   // cacheDir -> Promise of the first load
+    this.nextId = 1;
+    this.completed = 0;
+    this.failed = 0;
+  }
+
+  spawn() {
+    const worker = new Worker(WORKER_URL);
+    worker.jobs = new Map();
+    worker.unref();
+
+    worker.on('message', ({ id, result, error }) => {
+      const job = worker.jobs.get(id);
+      if (!job) return;
+      worker.jobs.delete(id);
+      if (error) {
+        this.failed++;
+        job.reject(new Error(error));
+      } else {
+        this.completed++;
+        job.resolve(result);
+      }
+    });
+
+    // A dead worker fails its jobs and is replaced on the next dispatch
+    const lost = (err) => {
+      this.workers = this.workers.filter(w => w !== worker);
+      for (const job of worker.jobs.values()) {
+        this.failed++;
+        job.reject(err);
+      }
+      worker.jobs.clear();
+    };
+    worker.on('error', lost);
+    worker.on('exit', (code) => lost(new Error(`YANG worker exited with code ${code}`)));
+
+    this.workers.push(worker);
+    return worker;
+  }
+
+  // Least busy worker, spawning up to the pool size
+  pick() {
+    if (this.workers.length < this.size) return this.spawn();
+    return this.workers.reduce((a, b) => (b.jobs.size < a.jobs.size ? b : a));
+  }
+
+  post(type, args, transfer = []) {
+    const worker = this.pick();
+    const id = this.nextId++;
+    return new Promise((resolve, reject) => {
+      worker.jobs.set(id, { resolve, reject });
+      worker.postMessage({ id, type, args }, transfer);
+    });
+  }
+
+  async run(type, args, transfer) {
+    let loaded = this.catalogs.get(args.cacheDir);
+    if (!loaded) {
+      loaded = this.post('load', { cacheDir: args.cacheDir });
+      loaded.catch(() => this.catalogs.delete(args.cacheDir));
+      this.catalogs.set(args.cacheDir, loaded);
+    }
+    await loaded;
+    return this.post(type, args, transfer);
+  }
+
+  stats() {
+    return {
+      workers: this.workers.length,
+      size: this.size,
+      pending: this.workers.reduce((n, w) => n + w.jobs.size, 0),
+      completed: this.completed,
+      failed: this.failed
+    };
+  }
+}
+
+const pool = poolSize() > 0 ? new YangPool(poolSize()) : null;
+
+/**
+ * iFETCH SID queries for instance-identifier paths
+ * @returns {Promise<Array>} queries for transport.sendiFetchRequest()
+ */
+export async function resolveQueries(cacheDir, paths) {
+  const args = { cacheDir, paths };
+  const { queries } = pool ? await pool.run('resolve', args) : await runJob('resolve', args);
+  return queries;
+}
+
+/**
+ * Decode a CBOR payload to YAML (outputFormat of Cbor2TscConverter)
+ * @returns {Promise<string>}
+ */
+export async function decodeCbor(cacheDir, payload, format = 'rfc7951') {
+  if (!pool) return (await runJob('decode', { cacheDir, cbor: payload, format })).yaml;
+
+  const cbor = detachable(payload);
+  const { yaml } = await pool.run('decode', { cacheDir, cbor, format }, [cbor]);
+  return yaml;
+}
+
+/**
+ * Encode items to one CBOR payload each: instance-identifier objects
+ * ({ path: value }), or YAML documents with { raw: true }
+ * @returns {Promise<Array<Buffer|{error: string}>>}
+ */
+export async function encodeItems(cacheDir, items, { raw = false } = {}) {
+  const args = { cacheDir, items, raw };
+  const { cbor } = pool ? await pool.run('encode', args) : await runJob('encode', args);
+  return cbor.map(c => (c instanceof ArrayBuffer ? Buffer.from(c) : c));
+}
+
+export function yangPoolStats() {
+  return pool ? pool.stats() : { workers: 0, size: 0 };
+}
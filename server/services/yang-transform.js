@@ -0,0 +1,85 @@
+import path from 'path';
+import { fileURLToPath } from 'url';
+import yaml from 'js-yaml';
+
+const __dirname = path.dirname(fileURLToPath(import.meta.url));
+const TSC2CBOR = path.resolve(__dirname, '../../tsc2cbor');
+
+/**
+ * YANG/CBOR transform jobs, run by services/yang-worker.js (or inline when
+ * the pool is off). Each catalog is loaded once per thread and shared by
+ * the encoder, the decoder and the instance-identifier resolver.
+ *
+ * Jobs:
+ *   resolve { cacheDir, paths }         -> { queries }   iFETCH SID queries
+ *   decode  { cacheDir, cbor, format }  -> { yaml }      CBOR response to YAML
+ *   encode  { cacheDir, items }         -> { cbor: [] }  one iPATCH payload per item
+ *                                                         (or { error } per item)
+ */
+
+const catalogs = new Map();   // cacheDir -> Promise<{ sidInfo, encoder, decoder }>
+
+async function loadCatalog(cacheDir) {
+  const { loadYangInputs } = await import(`${TSC2CBOR}/lib/common/input-loader.js`);
+  const { Tsc2CborConverter } = await import(`${TSC2CBOR}/tsc2cbor.js`);
+  const { Cbor2TscConverter } = await import(`${TSC2CBOR}/cbor2tsc.js`);
+
+  const { sidInfo, typeTable, schemaInfo } = await loadYangInputs(cacheDir, false);
+
+  // Hand the loaded tables to both converters instead of letting each load its own copy
+  const encoder = new Tsc2CborConverter(cacheDir);
+  Object.assign(encoder, { sidInfo, typeTable, schemaInfo, cacheLoaded: true });
+  const decoder = new Cbor2TscConverter(cacheDir);
+  Object.assign(decoder, { sidInfo, typeTable, cacheLoaded: true });
+
+  return { sidInfo, encoder, decoder };
+}
+
+function catalog(cacheDir) {
+  let c = catalogs.get(cacheDir);
+  if (!c) {
+    c = loadCatalog(cacheDir);
+    c.catch(() => catalogs.delete(cacheDir));
+    catalogs.set(cacheDir, c);
+  }
+  return c;
+}
+
+export async function runJob(type, args) {
+  const { sidInfo, encoder, decoder } = await catalog(args.cacheDir);
+
+  switch (type) {
+    case 'load':
+      return { sids: sidInfo.sidToInfo.size };
+
+    case 'resolve': {
+      const { extractSidsFromInstanceIdentifier } = await import(`${TSC2CBOR}/lib/encoder/transformer-instance-id.js`);
+      const queries = extractSidsFromInstanceIdentifier(args.paths.map(p => ({ [p]: null })), sidInfo, { verbose: false });
+      return { queries };
+    }
+
+    case 'decode': {
+      const result = await decoder.convertBuffer(Buffer.from(args.cbor), {
+        verbose: false,
+        outputFormat: args.format || 'rfc7951'
+      });
+      return { yaml: result.yaml };
+    }
+
+    case 'encode': {
+      const cbor = [];
+      for (const item of args.items) {
+        try {
+          const result = await encoder.convertString(args.raw ? item : yaml.dump([item]), { verbose: false });
+          cbor.push(result.cbor);
+        } catch (err) {
+          cbor.push({ error: err.message });
+        }
+      }
+      return { cbor };
+    }
+
+    default:
+      throw new Error(`Unknown transform job: ${type}`);
+  }
+}
@@ -0,0 +1,25 @@
+import { parentPort } from 'worker_threads';
+import { runJob } from './yang-transform.js';
+
+// Own the bytes of a Buffer so its ArrayBuffer can be transferred
+function detachable(buf) {
+  return buf.buffer.slice(buf.byteOffset, buf.byteOffset + buf.length);
+}
+
+parentPort.on('message', async ({ id, type, args }) => {
+  try {
+    const result = await runJob(type, args);
+    const transfer = [];
+    if (type === 'encode') {
+      result.cbor = result.cbor.map(c => {
+        if (!Buffer.isBuffer(c)) return c;
+        const ab = detachable(c);
+        transfer.push(ab);
+        return ab;
+      });
+    }
+    parentPort.postMessage({ id, result }, transfer);
+  } catch (err) {
+    parentPort.postMessage({ id, error: err.message });
+  }
+});
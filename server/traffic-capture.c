@@ -2,56 +2,345 @@
  * traffic-capture.c - High-precision packet capture for TSN analysis
  * Using libpcap for reliable capture
  *
- * Compile: gcc -O2 -o traffic-capture traffic-capture.c -lpcap -lpthread -lm
- * Run: sudo ./traffic-capture <interface> [duration] [vlan_id] [output_mode]
+ * Build: cmake -S . -B build && cmake --build build   (see CMakeLists.txt)
+ * Run: sudo ./traffic-capture <interface> [duration] [vlan_id[,vlan_id...]] [output_mode] [--ptp] [--seq|--check]
+ *      sudo ./traffic-capture <interface> --service [--ptp|--timebase] [--check]
+ *
+ * Service mode shares one pcap handle between several analysis sessions.
+ * Sessions are added and removed with line commands on stdin:
+ *   add <id> <vlan_id[,vlan_id...]|0> [seq] [interval=<ms>] [queue options]
+ *   del <id>
+ * Every output line then carries "session":"<id>".
+ *
+ * Queue options enable per-TC queue occupancy inference (tsnperf/queue.h):
+ *   gcl=<gates>:<ns>,...  gate control list of the egress port under test
+ *   cycle=<ns>            cycle time if longer than the list
+ *   base=<ns>             capture-clock time of a cycle start (else locked from traffic)
+ *   link=<mbps>           link speed (default 1000)
+ *   jitter=<ns>           capture timestamp jitter tolerance (default 2000)
+ *   queue                 report backlog trains even without a GCL
+ *   ptpbase=<ns>          AdminBaseTime of the GCL in switch PTP time (needs --timebase)
+ *   guard=<bytes>         guard band before each gate close as one frame's
+ *                         wire time (default 1518, 0 = no band check)
+ *   dip=<pct>             accuracy drop below baseline that opens a dip
+ *                         window (default 5)
+ *   corr=<ms>             how far before a dip PTP events still count
+ *                         (default 1000)
+ * Sessions with queue inference add {"queue":{...}} lines holding the
+ * per-cycle depth/drain series since the previous report.
+ *   cbs=<tc>:<kbps>,...   CBS idle slopes of the port under test
+ * The final analysis fits each TC's arrival curve to a token bucket
+ * (tsnperf/arrival.h); "shaped" means the measured burst stays within the
+ * envelope of the configured shaper (CBS idle slope, else the TC's gate
+ * windows, else two frames at the mean rate).
+ *
+ * --timebase also captures untagged PTP and fits the switch's PTP time
+ * from the Sync/Follow_Up pairs it sends (tsnperf/timebase.h). Every record
+ * then carries a PTP timestamp; sessions with gcl= and ptpbase= count each
+ * frame in or out of its TC's gate windows exactly ("gate" per TC) and run
+ * queue inference on PTP time with the AdminBaseTime as cycle phase. The
+ * fit is reported once per second as {"timebase":{...}}.
+ *
+ * Sessions with gcl= and a known phase (ptpbase=, else base= on the capture
+ * clock) also rebuild each frame's start and end on the wire from its length
+ * and the link speed and check them against the gate close
+ * (tsnperf/guard.h): frames in the guard band, frames straddling the close
+ * and frames sent while the gate was closed are counted per TC ("guard")
+ * with per-cycle histograms, and the final analysis lists the worst
+ * offenders (session-level "guard"). The same sessions keep one scorecard
+ * per GCL cycle (tsnperf/score.h): per-TC frames, wrong-slot frames, worst
+ * excess and first/last arrival phase, streamed as {"cycles":{...}} lines
+ * holding the cycles closed since the previous report.
+ *
+ * With --timebase the drain thread also turns the PTP stream into events
+ * (tsnperf/ptpmon.h: Sync gaps and interval violations, correctionField
+ * jumps, grandmaster changes, clock steps), counted in "timebase". Each
+ * scorecard session tracks its gated accuracy per cycle against an EWMA
+ * baseline (tsnperf/anomaly.h); a dip window is reported as
+ * {"anomaly":{...}} with the PTP events from corr= before it to its end,
+ * so a dip can be told apart from a time sync cause.
+ *
+ * --check verifies PRBS-31 payloads from traffic-sender --prbs
+ * (tsnperf/payload.h) on the drain thread with a CRC32C over the body and
+ * counts ok / corrupt / truncated frames and flipped bits per TC
+ * ("integrity"). The snaplen grows to whole frames.
+ *
+ * Sequenced sessions also analyse the preemption mix of traffic-sender
+ * --express (tsnperf/preempt.h): express latency alone and behind
+ * preemptable frames, per launch offset, and how many express frames
+ * overtook their preemptable frame, which tells whether the link under
+ * test preempts at all ("preemption", session level).
+ *
+ * --rollup <dir> lets sessions keep a multi-resolution store for soak tests
+ * (tsnperf/rollup.h): the "rollup=<name>" session option (implicit in
+ * single-run mode, named "default") writes <dir>/<name>. The stats thread
+ * turns counter and histogram deltas into one record per TC per second;
+ * read stores back with tsn-rollup.
+ *
+ * Pipeline: the thread draining libpcap only classifies frames and copies
+ * compact records into one SPSC ring per analysis worker (--workers N,
+ * pinned with --cpus a,b,..). Sessions are sharded across workers, so each
+ * session has a single writer. A full ring drops the record for that
+ * worker instead of stalling the drain, so analysis cost never backs up
+ * into the kernel ring. Once per second a {"pipeline":{...}} line reports
+ * ring-full drops, ring depth, worker lag and kernel drops.
+ *
+ * Worker rings, sessions and their rings come from one arena
+ * (tsnperf/arena.h) mapped at startup on 2 MB pages near the NIC's NUMA
+ * node (--arena <MB>, default sized for the rings and a few sessions, 0 =
+ * heap). An {"arena":{...}} line reports the page kind and placement at
+ * startup and the high-water mark at exit; what does not fit spills to
+ * the heap ("heap_bytes").
  */
 
 #define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdint.h>
 #include <unistd.h>
 #include <signal.h>
-#include <time.h>
+#include <ctype.h>
 #include <math.h>
-#include <sys/mman.h>
-#include <sched.h>
 #include <pthread.h>
+#include <getopt.h>
+#include <stdatomic.h>
 #include <pcap/pcap.h>
 
+#include "tsnperf/anomaly.h"
+#include "tsnperf/arena.h"
+#include "tsnperf/arrival.h"
+#include "tsnperf/classify.h"
+#include "tsnperf/clock.h"
+#include "tsnperf/gcl.h"
+#include "tsnperf/guard.h"
+#include "tsnperf/hist.h"
+#include "tsnperf/json.h"
+#include "tsnperf/metrics.h"
+#include "tsnperf/payload.h"
+#include "tsnperf/preempt.h"
+#include "tsnperf/prof.h"
+#include "tsnperf/ptpmon.h"
+#include "tsnperf/queue.h"
+#include "tsnperf/ring.h"
+#include "tsnperf/rollup.h"
+#include "tsnperf/rt.h"
+#include "tsnperf/score.h"
+#include "tsnperf/stats.h"
+#include "tsnperf/timebase.h"
+
 #define MAX_TC 8
 #define MAX_PACKETS_PER_TC 50000
 #define STATS_INTERVAL_MS 200
+#define STATS_TICK_MS 20
+#define MAX_SESSIONS 32
+#define SESSION_ID_LEN 48
+#define MAX_VLAN 4096
+#define QUEUE_RING_SIZE 8192
+#define SCORE_RING_SIZE 8192
+#define PTP_EVENT_RING_SIZE 1024
+#define PTP_HISTORY 256                 // Events kept for dip correlation
+#define DIP_EVENTS 8                    // Events listed per dip window
+#define DIP_LOOKAHEAD_NS 10000000ULL    // Events just after a dip still count
+#define ARENA_SESSIONS 4                // Sessions the default arena holds
+#define ARENA_SLACK (1UL << 20)
+#define DEFAULT_JITTER_NS 2000
+#define ARRIVAL_MIN_WINDOW_NS 1000      // Shortest arrival-curve window, doubling up
+#define GUARD_PUBLISH_NS 10000000ULL    // Least spacing of guard state copies to the readers
+#define HIST_PUBLISH_NS 100000000ULL    // Histogram copies for the metrics exporter
+#define MAX_WORKERS 8
+#define WORKER_RING_SIZE 65536
+#define WORKER_BATCH 64
+#define WORKER_SPIN 1000
+#define PIPELINE_REPORT_MS 1000
+#define CHECK_SNAPLEN (TP_MAX_FRAME_LEN + TP_VLAN_HLEN)
+
+// Compact per-frame record handed from the drain thread to workers
+typedef struct {
+    uint64_t ts_ns;
+    uint64_t ptp_ns;        // Switch PTP time, 0 until the timebase fit is valid
+    uint64_t tx_ns;
+    uint32_t seq;
+    uint32_t len;
+    uint16_t vid;           // 0 = untagged
+    uint8_t pcp;
+    uint8_t has_seq;
+    uint8_t check;          // TP_CHECK_* payload verdict
+    uint8_t mix;            // TP_MIX_* class of a preemption mix frame
+    uint16_t bit_errors;    // Flipped payload bits of a corrupt frame
+    uint32_t mix_offset_ns; // Express launch after its preemptable frame
+    uint32_t mix_slot;
+} capture_rec_t;
+
+// Analysis worker: owns the sessions whose slot % n_workers == id
+typedef struct {
+    int id;
+    int cpu;
+    pthread_t tid;
+    uint32_t session_mask;
+    tp_ring_t ring;                 // Drain thread -> worker
+    _Atomic uint64_t epoch;         // Advances after every batch (quiescence)
+    _Atomic uint64_t processed;
+    _Atomic uint64_t max_depth;     // Since the last pipeline report
+    _Atomic uint64_t max_lag_ns;    // Capture timestamp to processing
+    char name[16];
+    tp_prof_t prof;
+} capture_worker_t;
+
+// Profiled stages per thread (see tsnperf/prof.h)
+enum { DRAIN_DISPATCH, DRAIN_HANDLE };
+enum { WORKER_ANALYZE };
+enum { STATS_REPORT };
+static const char *const drain_stages[] = { "pcap_dispatch", "classify_route", NULL };
+static const char *const worker_stages[] = { "analyze", NULL };
+static const char *const stats_stages[] = { "report", NULL };
+
+// Frames checked against their TC's gate windows in PTP time
+typedef struct {
+    uint64_t in;
+    uint64_t out;
+    uint64_t unmapped;      // Before the timebase fit was valid
+    uint64_t max_excess_ns; // Furthest a frame stuck out of a window
+} capture_gate_t;
 
-// Per-TC statistics
+// PRBS payload verification per TC (--check)
+typedef struct {
+    uint64_t ok;
+    uint64_t corrupt;
+    uint64_t truncated;
+    uint64_t unchecked;     // Longer than the snaplen
+    uint64_t bit_errors;
+    uint64_t bits;          // Frame bits of verified frames
+} capture_integrity_t;
+
+// Guard band counters of one TC that change with every frame; the cycle
+// histograms and worst offenders are published apart (guard_pub)
+typedef struct {
+    uint64_t frames[TP_GUARD_KINDS];
+    uint64_t min_margin_ns;
+    uint64_t max_overrun_ns;
+    uint64_t max_closed_ns;
+} capture_guard_t;
+
+// Counters published to the stats thread through the session seqlock
+typedef struct {
+    tp_flow_stats_t tc[MAX_TC];
+    capture_gate_t gate[MAX_TC];
+    capture_integrity_t integrity[MAX_TC];
+    capture_guard_t guard[MAX_TC];
+    tp_preempt_t preempt;
+    uint64_t total;
+} capture_counters_t;
+
+// Per-session options from the command line or an "add" command
+typedef struct {
+    int seq;
+    int interval_ms;
+    int queue;
+    const char *gcl;
+    uint64_t cycle_ns;
+    int64_t base_ns;
+    uint32_t link_mbps;
+    uint64_t jitter_ns;
+    const char *cbs;
+    int64_t ptp_base_ns;
+    uint32_t guard_bytes;
+    double dip_pct;
+    uint32_t corr_ms;
+    const char *rollup;         // Store name under --rollup
+} session_opts_t;
+
+// One analysis session: own VLAN set, stats config and counters
 typedef struct {
-    uint64_t count;
-    uint64_t first_ts_us;
-    uint64_t last_ts_us;
-    uint64_t total_interval_us;
-    uint64_t min_interval_us;
-    uint64_t max_interval_us;
-    uint64_t intervals[MAX_PACKETS_PER_TC];
-    int interval_count;
-} tc_stats_t;
+    char id[SESSION_ID_LEN];
+    int parse_seq;
+    int interval_ms;
+    int queue_enabled;
+    tp_gcl_t gcl;
+    tp_queue_est_t queue;       // Written by the capture thread
+    tp_ring_t queue_ring;       // Capture thread -> stats thread samples
+    tp_queue_sample_t *queue_batch;
+    uint64_t start_us;
+    uint64_t next_report_us;
+    tp_seqlock_t lock;
+    capture_counters_t counters;
+    tp_hist_t latency_hist[MAX_TC];
+    tp_hist_t interval_hist[MAX_TC];
+    tp_hist_t express_hist[2];          // Express latency alone, contended
+    tp_seqlock_t hist_lock;
+    tp_hist_t *hist_pub;                // Latency then interval per TC for the exporter, NULL = none
+    uint64_t hist_pub_ns;
+    uint32_t link_mbps;
+    uint64_t jitter_ns;
+    int64_t ptp_base_ns;                // AdminBaseTime (PTP ns), -1 = no gate alignment
+    int guard_enabled;                  // Guard band checks in guard
+    tp_guard_t guard;                   // Written by the owning worker
+    tp_seqlock_t guard_lock;
+    tp_guard_t guard_pub;               // Copy of guard at a cycle boundary, for the readers
+    int64_t guard_pub_cycle;
+    uint64_t guard_pub_ns;
+    int score_enabled;
+    tp_score_t score;                   // Written by the owning worker
+    tp_ring_t score_ring;               // Worker -> stats thread cycle scorecards
+    tp_score_rec_t *score_batch;
+    tp_anomaly_t anomaly;               // Dip windows over the scorecards (stats thread)
+    uint64_t corr_ns;                   // PTP event lookback before a dip
+    double idle_slope_kbps[MAX_TC];     // 0 = no CBS on that TC
+    tp_rollup_t *rollup;                // Soak-test store, NULL = none (stats thread)
+    uint64_t rollup_next_ns;            // Next 1 s boundary, capture clock
+    capture_counters_t rollup_prev;
+    tp_hist_t *rollup_hist_prev;        // Latency then interval per TC at the last record
+    int trace_count[MAX_TC];            // Arrival trace for the final analysis
+    uint64_t trace_ts[MAX_TC][MAX_PACKETS_PER_TC];
+    uint16_t trace_len[MAX_TC][MAX_PACKETS_PER_TC];
+} capture_session_t;
 
 // Global state
 static volatile int running = 1;
-static tc_stats_t tc_stats[MAX_TC];
-static uint64_t total_packets = 0;
-static uint64_t start_time_us = 0;
 static int target_vlan = 100;
 static int output_mode = 0;  // 0=json, 1=stats, 2=raw
-static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int vlan_mode = TP_VLAN_ONE;
+static int proto_mode = TP_PROTO_UDP;
+// Payload parsing level of the packet handler
+enum { SEQ_OFF = 0, SEQ_ON = 1, SEQ_CHECK = 2, SEQ_MODES };
+static int parse_seq = SEQ_OFF;
+static int service_mode = 0;
+static int timebase_enabled = 0;
+static tp_timebase_t timebase;      // Written by the drain thread
+static tp_ptpmon_t ptpmon;          // Written by the drain thread
+static tp_ring_t ptp_event_ring;    // Drain thread -> ptp_history
+// Recent PTP events, oldest first from ptp_history_head; read by whoever
+// reports dips (stats thread, or a session's final analysis)
+static pthread_mutex_t ptp_history_mutex = PTHREAD_MUTEX_INITIALIZER;
+static tp_ptp_event_t ptp_history[PTP_HISTORY];
+static int ptp_history_n, ptp_history_head;
+static const char *rollup_root = NULL;
+static tp_arena_t arena;            // Hot structures; spills to the heap when full
+static long arena_mb = -1;          // -1 = sized from the pipeline
+static uint64_t rollup_retain_s[TP_ROLLUP_TIERS];
+static tp_classify_cfg_t classify_cfg;
 static pcap_t *handle = NULL;
-
-// Get current time in microseconds
-static uint64_t get_time_us(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
-}
+static pthread_mutex_t pcap_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static tp_metrics_server_t metrics_server;
+static int metrics_enabled;         // Sessions publish histogram copies
+static uint64_t ts_frac_ns = TP_NSEC_PER_USEC;  // 1 once nanosecond timestamps are granted
+
+static capture_worker_t workers[MAX_WORKERS];
+static tp_prof_t drain_prof;
+static tp_prof_t stats_prof;
+static int n_workers = 1;
+static uint32_t worker_ring_size = WORKER_RING_SIZE;
+static _Atomic int drain_done;
+
+// Session table. Slots are published before their bits appear in
+// vlan_sessions, and freed only after every worker has moved past a
+// batch epoch without them.
+static capture_session_t *sessions[MAX_SESSIONS];
+static _Atomic uint32_t vlan_sessions[MAX_VLAN];   // VID -> session bitmask (VID 0 = untagged)
+static _Atomic int capture_done;
+static pthread_mutex_t sessions_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t output_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 // Signal handler
 static void signal_handler(int sig) {
@@ -60,278 +349,1829 @@ static void signal_handler(int sig) {
     if (handle) pcap_breakloop(handle);
 }
 
-// Setup real-time scheduling
-static void setup_realtime(void) {
-    struct sched_param param;
-    param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
-    if (sched_setscheduler(0, SCHED_FIFO, &param) < 0) {
-        // Not critical
+static inline void guard_counts(capture_guard_t *c, const tp_guard_tc_t *t) {
+    memcpy(c->frames, t->frames, sizeof(c->frames));
+    c->min_margin_ns = t->min_margin_ns;
+    c->max_overrun_ns = t->max_overrun_ns;
+    c->max_closed_ns = t->max_closed_ns;
+}
+
+// Copy the guard state for the readers once a cycle is over, at most every
+// GUARD_PUBLISH_NS: it is too large to go under the per-frame seqlock
+static void guard_publish(capture_session_t *s, uint64_t t_ns) {
+    const tp_guard_t *g = &s->guard;
+    if (!g->checked || g->last_cycle == s->guard_pub_cycle || t_ns - s->guard_pub_ns < GUARD_PUBLISH_NS) return;
+    tp_seqlock_write_begin(&s->guard_lock);
+    s->guard_pub = *g;
+    tp_seqlock_write_end(&s->guard_lock);
+    s->guard_pub_cycle = g->last_cycle;
+    s->guard_pub_ns = t_ns;
+}
+
+// Copy the histograms for the exporter every HIST_PUBLISH_NS: a scrape
+// renders a consistent set (count, sum, buckets) without racing the worker
+static void hist_publish(capture_session_t *s, uint64_t t_ns) {
+    tp_seqlock_write_begin(&s->hist_lock);
+    memcpy(s->hist_pub, s->latency_hist, sizeof(s->latency_hist));
+    memcpy(s->hist_pub + MAX_TC, s->interval_hist, sizeof(s->interval_hist));
+    tp_seqlock_write_end(&s->hist_lock);
+    s->hist_pub_ns = t_ns;
+}
+
+// Update per-TC statistics of one session (owning worker only)
+static inline void record_packet(capture_session_t *s, const capture_rec_t *r) {
+    tp_seqlock_write_begin(&s->lock);
+
+    tp_flow_stats_t *f = &s->counters.tc[r->pcp];
+    int first = f->count == 0;
+    uint64_t interval = tp_flow_update(f, r->ts_ns, r->len);
+
+    if (!first) tp_hist_add(&s->interval_hist[r->pcp], interval);
+    int k = s->trace_count[r->pcp];
+    if (k < MAX_PACKETS_PER_TC) {
+        s->trace_ts[r->pcp][k] = r->ts_ns;
+        s->trace_len[r->pcp][k] = r->len > UINT16_MAX ? UINT16_MAX : (uint16_t)r->len;
+        s->trace_count[r->pcp] = k + 1;
+    }
+
+    if (r->has_seq && s->parse_seq) {
+        // Sender stamps CLOCK_REALTIME, same domain as pcap timestamps
+        int64_t lat = tp_flow_seq(f, r->seq, r->tx_ns, r->ts_ns);
+        if (lat >= 0) tp_hist_add(&s->latency_hist[r->pcp], (uint64_t)lat);
+        if (r->mix) {
+            tp_mix_tag_t t = { .cls = r->mix, .offset_ns = r->mix_offset_ns, .slot = r->mix_slot };
+            tp_preempt_frame(&s->counters.preempt, &t, r->len, lat);
+            if (r->mix == TP_MIX_EXPRESS && lat >= 0) {
+                tp_hist_add(&s->express_hist[r->mix_offset_ns != TP_MIX_ALONE], (uint64_t)lat);
+            }
+        }
+    }
+
+    if (r->check != TP_CHECK_NONE) {
+        capture_integrity_t *v = &s->counters.integrity[r->pcp];
+        if (r->check == TP_CHECK_OK) v->ok++;
+        else if (r->check == TP_CHECK_CORRUPT) v->corrupt++;
+        else if (r->check == TP_CHECK_TRUNCATED) v->truncated++;
+        else v->unchecked++;
+        if (r->check == TP_CHECK_OK || r->check == TP_CHECK_CORRUPT) v->bits += (uint64_t)r->len * 8;
+        v->bit_errors += r->bit_errors;
+    }
+
+    if (s->ptp_base_ns >= 0) {
+        capture_gate_t *g = &s->counters.gate[r->pcp];
+        uint64_t excess;
+        if (!r->ptp_ns) {
+            g->unmapped++;
+        } else if (tp_gcl_window_of(&s->gcl, r->pcp, tp_gcl_cycle_pos(&s->gcl, r->ptp_ns, s->ptp_base_ns),
+                                    tp_wire_ns(r->len, s->link_mbps), s->jitter_ns, &excess) >= 0) {
+            g->in++;
+        } else {
+            g->out++;
+            if (excess > g->max_excess_ns) g->max_excess_ns = excess;
+        }
+    }
+
+    uint64_t phase_t = s->ptp_base_ns >= 0 ? r->ptp_ns : r->ts_ns;
+    if (s->guard_enabled && phase_t) {
+        tp_guard_frame(&s->guard, r->pcp, phase_t, r->len, r->has_seq ? r->seq : 0);
+        guard_counts(&s->counters.guard[r->pcp], &s->guard.tc[r->pcp]);
+    }
+
+    s->counters.total++;
+
+    tp_seqlock_write_end(&s->lock);
+
+    if (s->guard_enabled && phase_t) guard_publish(s, phase_t);
+    if (s->hist_pub && r->ts_ns >= s->hist_pub_ns + HIST_PUBLISH_NS) hist_publish(s, r->ts_ns);
+
+    if (s->score_enabled && phase_t) tp_score_frame(&s->score, r->pcp, phase_t, r->len);
+
+    if (s->queue_enabled) {
+        if (s->ptp_base_ns < 0) tp_queue_frame(&s->queue, r->pcp, r->ts_ns, r->len);
+        else if (r->ptp_ns) tp_queue_frame(&s->queue, r->pcp, r->ptp_ns, r->len);
+    }
+}
+
+// Hand an accepted frame to every worker owning a subscribed session
+// (drain thread). Never blocks: a full ring counts a drop for that worker.
+static inline void route_packet(const tp_pkt_info_t *info, uint64_t ts_ns, uint32_t len,
+                                int check, uint32_t bit_errors, const tp_mix_tag_t *mix) {
+    uint16_t vid = info->vid < 0 ? 0 : (uint16_t)info->vid;
+    uint32_t mask = atomic_load_explicit(&vlan_sessions[vid], memory_order_relaxed);
+    if (!mask) return;
+
+    capture_rec_t r = {
+        .ts_ns = ts_ns,
+        .ptp_ns = tp_timebase_map(&timebase, ts_ns),
+        .tx_ns = info->has_seq ? info->tx_ns : 0,
+        .seq = info->has_seq ? info->seq : 0,
+        .len = len,
+        .vid = vid,
+        .pcp = (uint8_t)info->pcp,
+        .has_seq = (uint8_t)info->has_seq,
+        .check = (uint8_t)check,
+        .bit_errors = bit_errors > UINT16_MAX ? UINT16_MAX : (uint16_t)bit_errors,
+        .mix = mix->cls,
+        .mix_offset_ns = mix->offset_ns,
+        .mix_slot = mix->slot,
+    };
+    for (int w = 0; w < n_workers; w++) {
+        if (mask & workers[w].session_mask) tp_ring_push(&workers[w].ring, &r);
     }
-    mlockall(MCL_CURRENT | MCL_FUTURE);
 }
 
-// Packet handler callback
-static void packet_handler(u_char *user, const struct pcap_pkthdr *hdr, const u_char *pkt) {
-    (void)user;
+// Fan a record out to this worker's sessions subscribed to its VLAN
+static inline void dispatch_packet(const capture_worker_t *w, const capture_rec_t *r) {
+    uint32_t mask = atomic_load_explicit(&vlan_sessions[r->vid], memory_order_acquire) & w->session_mask;
+    while (mask) {
+        int idx = __builtin_ctz(mask);
+        mask &= mask - 1;
+        record_packet(sessions[idx], r);
+    }
+}
 
-    if (hdr->caplen < 18) return;
+static void *worker_thread(void *arg) {
+    capture_worker_t *w = arg;
+    if (w->cpu >= 0 && tp_pin_thread(w->cpu) != 0) {
+        fprintf(stderr, "Warning: could not pin worker %d to CPU %d\n", w->id, w->cpu);
+    }
 
-    // Timestamp from pcap (microseconds)
-    uint64_t ts_us = (uint64_t)hdr->ts.tv_sec * 1000000ULL + hdr->ts.tv_usec;
+    capture_rec_t batch[WORKER_BATCH];
+    int idle = 0;
+
+    for (;;) {
+        // Read before popping: an empty ring after drain_done is final
+        int done = atomic_load_explicit(&drain_done, memory_order_acquire);
+        uint64_t depth = tp_ring_depth(&w->ring);
+        int n = 0;
+        while (n < WORKER_BATCH && tp_ring_pop(&w->ring, &batch[n])) n++;
+
+        if (n > 0) {
+            uint64_t now = tp_real_ns();
+            uint64_t lag = now > batch[0].ts_ns ? now - batch[0].ts_ns : 0;
+            if (lag > atomic_load_explicit(&w->max_lag_ns, memory_order_relaxed)) {
+                atomic_store_explicit(&w->max_lag_ns, lag, memory_order_relaxed);
+            }
+            if (depth > atomic_load_explicit(&w->max_depth, memory_order_relaxed)) {
+                atomic_store_explicit(&w->max_depth, depth, memory_order_relaxed);
+            }
+            uint64_t t0 = tp_prof_begin();
+            for (int i = 0; i < n; i++) dispatch_packet(w, &batch[i]);
+            tp_prof_end(&w->prof, WORKER_ANALYZE, t0, n);
+            atomic_fetch_add_explicit(&w->processed, n, memory_order_relaxed);
+            idle = 0;
+        } else if (done) {
+            break;
+        } else if (++idle > WORKER_SPIN) {
+            usleep(50);
+        }
+        atomic_fetch_add_explicit(&w->epoch, 1, memory_order_release);
+    }
+    tp_prof_thread_done(&w->prof);
+    return NULL;
+}
 
-    // Check for VLAN tag (ethertype at offset 12)
-    uint16_t ethertype = (pkt[12] << 8) | pkt[13];
-    if (ethertype != 0x8100) return;
+// Parse "2,3" into worker CPUs; missing entries stay unpinned
+static void parse_cpu_list(const char *str, int *cpus, int max) {
+    for (int i = 0; i < max; i++) cpus[i] = -1;
+    char *copy = strdup(str);
+    char *save = NULL;
+    char *token = strtok_r(copy, ",", &save);
+    for (int i = 0; token && i < max; i++) {
+        cpus[i] = atoi(token);
+        token = strtok_r(NULL, ",", &save);
+    }
+    free(copy);
+}
+
+// Default arena: the worker rings plus ARENA_SESSIONS fully equipped sessions
+static size_t arena_default_size(void) {
+    size_t ring = 1;
+    while (ring < worker_ring_size) ring <<= 1;
+    size_t session = sizeof(capture_session_t) +
+                     2 * QUEUE_RING_SIZE * sizeof(tp_queue_sample_t) + 2 * SCORE_RING_SIZE * sizeof(tp_score_rec_t);
+    return n_workers * ring * sizeof(capture_rec_t) + ARENA_SESSIONS * session +
+           PTP_EVENT_RING_SIZE * sizeof(tp_ptp_event_t) + ARENA_SLACK;
+}
+
+static int start_workers(const int *cpus) {
+    for (int w = 0; w < n_workers; w++) {
+        capture_worker_t *wk = &workers[w];
+        wk->id = w;
+        wk->cpu = cpus[w];
+        snprintf(wk->name, sizeof(wk->name), "worker%u", (unsigned)w % MAX_WORKERS);
+        tp_prof_init(&wk->prof, wk->name, worker_stages);
+        for (int slot = w; slot < MAX_SESSIONS; slot += n_workers) wk->session_mask |= 1U << slot;
+        if (tp_ring_init_in(&wk->ring, &arena, "worker_rings", worker_ring_size, sizeof(capture_rec_t)) != 0) {
+            return -1;
+        }
+        if (pthread_create(&wk->tid, NULL, worker_thread, wk) != 0) return -1;
+    }
+    return 0;
+}
+
+static inline uint64_t capture_ts_ns(const struct pcap_pkthdr *hdr) {
+    return (uint64_t)hdr->ts.tv_sec * TP_NSEC_PER_SEC + hdr->ts.tv_usec * ts_frac_ns;
+}
 
-    // Parse VLAN TCI (offset 14-15)
-    uint16_t tci = (pkt[14] << 8) | pkt[15];
-    int pcp = (tci >> 13) & 0x07;
-    int vid = tci & 0x0FFF;
+// Verify a sequenced payload against its UDP length, CRC and PRBS
+static inline int check_payload(const struct pcap_pkthdr *hdr, const u_char *pkt,
+                                const tp_pkt_info_t *info, uint32_t *bit_errors) {
+    uint32_t off = info->payload_off;
+    uint16_t udp_len = tp_rd16(pkt + off - TP_UDP_HLEN + 4);
+    uint32_t declared = udp_len > TP_UDP_HLEN ? udp_len - TP_UDP_HLEN : 0;
+    uint32_t wire = hdr->len > off ? hdr->len - off : 0;
+    return tp_payload_check(pkt + off, declared, hdr->caplen - off, wire, bit_errors);
+}
 
-    // Filter by VLAN ID
-    if (target_vlan > 0 && vid != target_vlan) return;
+// Frames the classifier rejected: PTP feeds the timebase fit and the event monitor
+static void handle_rejected(const struct pcap_pkthdr *hdr, const u_char *pkt) {
+    if (!timebase_enabled) return;
+    uint64_t ts_ns = capture_ts_ns(hdr);
+    tp_timebase_frame(&timebase, pkt, hdr->caplen, ts_ns);
+    tp_ptpmon_frame(&ptpmon, &timebase, pkt, hdr->caplen, ts_ns);
+}
 
-    // Filter by inner protocol - must be IPv4 UDP
-    uint16_t inner_proto = (pkt[16] << 8) | pkt[17];
-    if (inner_proto != 0x0800) return;  // Not IPv4
+/*
+ * Packet handler variants. Each expands tp_classify_frame() with constant
+ * configuration so the per-packet path carries no mode checks; main()
+ * selects one before the capture loop starts. Rejected frames take the
+ * out-of-line handle_rejected() path.
+ */
+#define DEFINE_PACKET_HANDLER(name, VMODE, PROTO, SEQ, RAW)                                         \
+static void name(u_char *user, const struct pcap_pkthdr *hdr, const u_char *pkt) {                  \
+    (void)user;                                                                                     \
+    uint64_t t0 = tp_prof_begin();                                                                  \
+    tp_pkt_info_t info;                                                                             \
+    if (!tp_classify_frame(&classify_cfg, pkt, hdr->caplen, &info, VMODE, PROTO, SEQ)) {            \
+        if (PROTO == TP_PROTO_UDP) handle_rejected(hdr, pkt);                                       \
+        return;                                                                                     \
+    }                                                                                               \
+    int check = TP_CHECK_NONE;                                                                      \
+    uint32_t bit_errors = 0;                                                                        \
+    tp_mix_tag_t mix = { .cls = TP_MIX_NONE };                                                      \
+    if (SEQ == SEQ_CHECK && info.has_seq) check = check_payload(hdr, pkt, &info, &bit_errors);      \
+    if (SEQ != SEQ_OFF && info.has_seq) {                                                           \
+        tp_mix_tag_read(pkt + info.payload_off, hdr->caplen - info.payload_off, &mix);              \
+    }                                                                                               \
+    uint64_t ts_ns = capture_ts_ns(hdr);                                                            \
+    route_packet(&info, ts_ns, hdr->len, check, bit_errors, &mix);                                  \
+    tp_prof_end(&drain_prof, DRAIN_HANDLE, t0, 1);                                                  \
+    if (RAW) {                                                                                      \
+        printf("%lu.%06lu TC%d VID%d len=%d\n",                                                     \
+               (unsigned long)hdr->ts.tv_sec, (unsigned long)(hdr->ts.tv_usec * ts_frac_ns / 1000), \
+               info.pcp, info.vid, hdr->len);                                                       \
+        fflush(stdout);                                                                             \
+    }                                                                                               \
+}
+
+#define DEFINE_PACKET_HANDLER_RAW(name, VMODE, PROTO, SEQ) \
+    DEFINE_PACKET_HANDLER(name,       VMODE, PROTO, SEQ, 0) \
+    DEFINE_PACKET_HANDLER(name##_raw, VMODE, PROTO, SEQ, 1)
+
+DEFINE_PACKET_HANDLER_RAW(handle_one_udp,     TP_VLAN_ONE, TP_PROTO_UDP, SEQ_OFF)
+DEFINE_PACKET_HANDLER_RAW(handle_one_udp_seq, TP_VLAN_ONE, TP_PROTO_UDP, SEQ_ON)
+DEFINE_PACKET_HANDLER_RAW(handle_one_udp_chk, TP_VLAN_ONE, TP_PROTO_UDP, SEQ_CHECK)
+DEFINE_PACKET_HANDLER_RAW(handle_set_udp,     TP_VLAN_SET, TP_PROTO_UDP, SEQ_OFF)
+DEFINE_PACKET_HANDLER_RAW(handle_set_udp_seq, TP_VLAN_SET, TP_PROTO_UDP, SEQ_ON)
+DEFINE_PACKET_HANDLER_RAW(handle_set_udp_chk, TP_VLAN_SET, TP_PROTO_UDP, SEQ_CHECK)
+DEFINE_PACKET_HANDLER_RAW(handle_any_udp,     TP_VLAN_ANY, TP_PROTO_UDP, SEQ_OFF)
+DEFINE_PACKET_HANDLER_RAW(handle_any_udp_seq, TP_VLAN_ANY, TP_PROTO_UDP, SEQ_ON)
+DEFINE_PACKET_HANDLER_RAW(handle_any_udp_chk, TP_VLAN_ANY, TP_PROTO_UDP, SEQ_CHECK)
+DEFINE_PACKET_HANDLER_RAW(handle_ptp,         TP_VLAN_ANY, TP_PROTO_PTP, SEQ_OFF)
+
+// [vlan_mode][seq][raw]; PTP-only ignores the VLAN filter
+static const pcap_handler udp_handlers[TP_VLAN_MODES][SEQ_MODES][2] = {
+    [TP_VLAN_ONE] = {{handle_one_udp, handle_one_udp_raw}, {handle_one_udp_seq, handle_one_udp_seq_raw},
+                     {handle_one_udp_chk, handle_one_udp_chk_raw}},
+    [TP_VLAN_SET] = {{handle_set_udp, handle_set_udp_raw}, {handle_set_udp_seq, handle_set_udp_seq_raw},
+                     {handle_set_udp_chk, handle_set_udp_chk_raw}},
+    [TP_VLAN_ANY] = {{handle_any_udp, handle_any_udp_raw}, {handle_any_udp_seq, handle_any_udp_seq_raw},
+                     {handle_any_udp_chk, handle_any_udp_chk_raw}},
+};
+
+static pcap_handler select_packet_handler(void) {
+    int raw = output_mode == 2;
+    if (proto_mode == TP_PROTO_PTP) return raw ? handle_ptp_raw : handle_ptp;
+    return udp_handlers[vlan_mode][parse_seq][raw];
+}
 
-    // Update statistics
-    pthread_mutex_lock(&stats_mutex);
+// Parse "100" (single), "0" (any) or "100,200,300" (set) into a classifier config
+static int parse_vlan_spec(const char *str, tp_classify_cfg_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
 
-    tc_stats_t *tc = &tc_stats[pcp];
+    if (!strchr(str, ',')) {
+        cfg->vlan = atoi(str);
+        return cfg->vlan > 0 ? TP_VLAN_ONE : TP_VLAN_ANY;
+    }
 
-    if (tc->count == 0) {
-        tc->first_ts_us = ts_us;
-        tc->min_interval_us = UINT64_MAX;
+    char *copy = strdup(str);
+    char *save = NULL;
+    char *token = strtok_r(copy, ",", &save);
+    cfg->vlan = token ? atoi(token) : 0;
+    while (token) {
+        tp_classify_vlan_set_add(cfg, atoi(token));
+        token = strtok_r(NULL, ",", &save);
+    }
+    free(copy);
+    return TP_VLAN_SET;
+}
+
+// Build BPF filter matching the selected variant. VLAN sets are filtered
+// in userspace: chained "vlan N or vlan M" shifts offsets per term. The
+// timebase adds untagged PTP ahead of the vlan term, whose offset shift
+// only applies after it.
+static void build_filter(char *filter, size_t len) {
+    const char *ptp = timebase_enabled ? "ether proto 0x88f7 or " : "";
+    if (proto_mode == TP_PROTO_PTP) {
+        snprintf(filter, len, "ether proto 0x88f7 or (vlan and ether proto 0x88f7)");
+    } else if (vlan_mode == TP_VLAN_ONE) {
+        snprintf(filter, len, "%svlan %d", ptp, target_vlan);
     } else {
-        uint64_t interval = ts_us - tc->last_ts_us;
-        tc->total_interval_us += interval;
+        snprintf(filter, len, "%svlan", ptp);
+    }
+}
 
-        if (interval < tc->min_interval_us) tc->min_interval_us = interval;
-        if (interval > tc->max_interval_us) tc->max_interval_us = interval;
+// Write a finished document; service mode lines may come from two threads
+static void emit_json(tp_json_t *j) {
+    pthread_mutex_lock(&output_mutex);
+    tp_json_flush(j, stdout);
+    pthread_mutex_unlock(&output_mutex);
+}
+
+static void json_session_tag(tp_json_t *j, const capture_session_t *s) {
+    if (service_mode) tp_json_str(j, "session", s->id);
+}
 
-        if (tc->interval_count < MAX_PACKETS_PER_TC) {
-            tc->intervals[tc->interval_count++] = interval;
+// Sequence/latency fields for a TC
+static void json_seq(tp_json_t *j, const tp_flow_stats_t *f, const tp_hist_t *lat) {
+    tp_json_obj_begin(j, "seq");
+    tp_json_u64(j, "count", f->seq_count);
+    tp_json_u64(j, "lost", f->seq_lost);
+    tp_json_u64(j, "ooo", f->seq_ooo);
+    if (f->lat_count > 0) {
+        tp_json_f64(j, "lat_avg_us", (double)f->lat_sum_ns / f->lat_count / 1000.0, 2);
+        tp_json_f64(j, "lat_min_us", f->lat_min_ns / 1000.0, 2);
+        tp_json_f64(j, "lat_max_us", f->lat_max_ns / 1000.0, 2);
+        if (lat) {
+            tp_json_f64(j, "lat_p50_us", tp_hist_quantile(lat, 0.50) / 1000.0, 2);
+            tp_json_f64(j, "lat_p99_us", tp_hist_quantile(lat, 0.99) / 1000.0, 2);
         }
     }
+    tp_json_obj_end(j);
+}
 
-    tc->last_ts_us = ts_us;
-    tc->count++;
-    total_packets++;
+// Gate-window check of a TC's frames in PTP time
+static void json_gate(tp_json_t *j, const capture_gate_t *g) {
+    tp_json_obj_begin(j, "gate");
+    tp_json_u64(j, "in", g->in);
+    tp_json_u64(j, "out", g->out);
+    tp_json_u64(j, "unmapped", g->unmapped);
+    tp_json_f64(j, "max_excess_us", g->max_excess_ns / 1000.0, 2);
+    tp_json_obj_end(j);
+}
 
-    pthread_mutex_unlock(&stats_mutex);
+// Guard band check of a TC's frames (c) and its cycles (t); the final
+// analysis adds the histograms
+static void json_guard(tp_json_t *j, const capture_guard_t *c, const tp_guard_tc_t *t, int final) {
+    tp_json_obj_begin(j, "guard");
+    for (int k = 0; k < TP_GUARD_KINDS; k++) tp_json_u64(j, tp_guard_kind_name(k), c->frames[k]);
+    tp_json_f64(j, "min_margin_us", c->min_margin_ns == UINT64_MAX ? 0 : c->min_margin_ns / 1000.0, 2);
+    tp_json_f64(j, "max_overrun_us", c->max_overrun_ns / 1000.0, 2);
+    tp_json_f64(j, "max_closed_us", c->max_closed_ns / 1000.0, 2);
+
+    uint64_t per_cycle[TP_GUARD_PER_CYCLE], violating = 0;
+    tp_guard_per_cycle(t, per_cycle);
+    for (int b = 0; b < TP_GUARD_PER_CYCLE; b++) violating += per_cycle[b];
+    tp_json_u64(j, "cycles_violating", violating);
+    tp_json_u64(j, "max_per_cycle", t->max_per_cycle);
+    if (final) {
+        // per_cycle[n-1]: cycles with n violations (last bin: n or more)
+        tp_json_arr_begin(j, "per_cycle");
+        for (int b = 0; b < TP_GUARD_PER_CYCLE; b++) tp_json_u64(j, NULL, per_cycle[b]);
+        tp_json_arr_end(j);
+        tp_json_arr_begin(j, "position");
+        for (int b = 0; b < TP_GUARD_BINS; b++) tp_json_u64(j, NULL, t->bins[b]);
+        tp_json_arr_end(j);
+    }
+    tp_json_obj_end(j);
+}
 
-    // Raw output
-    if (output_mode == 2) {
-        printf("%lu.%06lu TC%d VID%d len=%d\n",
-               ts_us / 1000000, ts_us % 1000000, pcp, vid, hdr->len);
-        fflush(stdout);
+// Session-wide guard summary and the worst offenders, worst first
+static void json_guard_summary(tp_json_t *j, const tp_guard_t *g) {
+    tp_json_obj_begin(j, "guard");
+    tp_json_u64(j, "guard_ns", g->guard_ns);
+    tp_json_u64(j, "checked", g->checked);
+    tp_json_u64(j, "cycles", tp_guard_cycles(g));
+    tp_json_u64(j, "bin_ns", g->gcl->cycle_ns / TP_GUARD_BINS);
+    tp_json_arr_begin(j, "worst");
+    for (int i = 0; i < g->n_worst; i++) {
+        const tp_guard_event_t *e = &g->worst[i];
+        tp_json_obj_begin(j, NULL);
+        tp_json_str(j, "kind", tp_guard_kind_name(e->kind));
+        tp_json_u64(j, "tc", e->tc);
+        tp_json_u64(j, "seq", e->seq);
+        tp_json_u64(j, "len", e->len);
+        tp_json_u64(j, "t_ns", e->t_ns);
+        tp_json_i64(j, "cycle", e->cycle - g->first_cycle);
+        tp_json_f64(j, "pos_us", e->pos_ns / 1000.0, 3);
+        tp_json_f64(j, "margin_us", e->margin_ns / 1000.0, 3);
+        tp_json_f64(j, "severity_us", e->severity_ns / 1000.0, 3);
+        tp_json_obj_end(j);
     }
+    tp_json_arr_end(j);
+    tp_json_obj_end(j);
 }
 
-// Print JSON stats
-static void print_stats_json(void) {
-    uint64_t now = get_time_us();
-    uint64_t elapsed_us = now - start_time_us;
+// PRBS payload verification of a TC; ber over the verified frames' bits
+static void json_integrity(tp_json_t *j, const capture_integrity_t *v) {
+    tp_json_obj_begin(j, "integrity");
+    tp_json_u64(j, "ok", v->ok);
+    tp_json_u64(j, "corrupt", v->corrupt);
+    tp_json_u64(j, "truncated", v->truncated);
+    tp_json_u64(j, "unchecked", v->unchecked);
+    tp_json_u64(j, "bit_errors", v->bit_errors);
+    tp_json_f64(j, "ber", v->bits ? (double)v->bit_errors / v->bits : 0, 12);
+    tp_json_obj_end(j);
+}
 
-    pthread_mutex_lock(&stats_mutex);
+static inline int integrity_seen(const capture_integrity_t *v) {
+    return v->ok + v->corrupt + v->truncated + v->unchecked > 0;
+}
 
-    printf("{\"elapsed_ms\":%.1f,\"total\":%lu,\"tc\":{",
-           elapsed_us / 1000.0, total_packets);
+static void json_preempt_bin(tp_json_t *j, const tp_preempt_bin_t *b, const tp_hist_t *lat) {
+    tp_json_u64(j, "frames", b->frames);
+    if (b->lat_count > 0) {
+        tp_json_f64(j, "lat_avg_us", (double)b->lat_sum_ns / b->lat_count / 1000.0, 2);
+        tp_json_f64(j, "lat_min_us", b->lat_min_ns / 1000.0, 2);
+        tp_json_f64(j, "lat_max_us", b->lat_max_ns / 1000.0, 2);
+        if (lat) {
+            tp_json_f64(j, "lat_p50_us", tp_hist_quantile(lat, 0.50) / 1000.0, 2);
+            tp_json_f64(j, "lat_p99_us", tp_hist_quantile(lat, 0.99) / 1000.0, 2);
+        }
+    }
+}
 
-    int first = 1;
-    for (int i = 0; i < MAX_TC; i++) {
-        tc_stats_t *tc = &tc_stats[i];
-        if (tc->count == 0) continue;
+// Express latency alone and behind preemptable frames; the final analysis
+// adds quantiles and the per-offset breakdown with the expected waits
+static void json_preempt(tp_json_t *j, const tp_preempt_t *p, const tp_hist_t *lat, int final) {
+    uint64_t overlap, overtakes;
+    tp_preempt_overlap(p, &overlap, &overtakes);
+
+    tp_json_obj_begin(j, "preemption");
+    tp_json_str(j, "verdict", tp_preempt_verdict(p));
+    tp_json_u64(j, "preemptable", p->preemptable);
+    tp_json_u64(j, "preempt_len", p->preempt_len);
+    tp_json_f64(j, "block_us", tp_preempt_block_ns(p, 0) / 1000.0, 2);
+    tp_json_u64(j, "overlap", overlap);
+    tp_json_u64(j, "overtakes", overtakes);
+    tp_json_obj_begin(j, "alone");
+    json_preempt_bin(j, &p->alone, final ? &lat[0] : NULL);
+    tp_json_obj_end(j);
+    tp_json_obj_begin(j, "contended");
+    json_preempt_bin(j, &p->contended, final ? &lat[1] : NULL);
+    tp_json_obj_end(j);
+    if (p->alone.lat_count && p->contended.lat_count) {
+        double added = (double)p->contended.lat_sum_ns / p->contended.lat_count -
+                       (double)p->alone.lat_sum_ns / p->alone.lat_count;
+        tp_json_f64(j, "added_us", added / 1000.0, 2);
+    }
+    if (final) {
+        tp_json_arr_begin(j, "offsets");
+        for (int i = 0; i < p->n_bins; i++) {
+            const tp_preempt_bin_t *b = &p->bins[i];
+            tp_json_obj_begin(j, NULL);
+            tp_json_f64(j, "offset_us", b->offset_ns / 1000.0, 3);
+            json_preempt_bin(j, b, NULL);
+            tp_json_u64(j, "overtakes", b->overtakes);
+            tp_json_f64(j, "block_us", tp_preempt_block_ns(p, b->offset_ns) / 1000.0, 2);
+            tp_json_f64(j, "hold_us", tp_preempt_hold_ns(p, b->offset_ns) / 1000.0, 2);
+            tp_json_obj_end(j);
+        }
+        tp_json_arr_end(j);
+    }
+    tp_json_obj_end(j);
+}
 
-        double avg_interval = tc->count > 1 ?
-            (double)tc->total_interval_us / (tc->count - 1) : 0;
-        double throughput_kbps = tc->count > 1 && tc->last_ts_us > tc->first_ts_us ?
-            (tc->count * 60.0 * 8.0 * 1000.0) / (tc->last_ts_us - tc->first_ts_us) : 0;
+static inline int preempt_seen(const tp_preempt_t *p) {
+    return p->preemptable + p->alone.frames + p->contended.frames > 0;
+}
 
-        if (!first) printf(",");
-        first = 0;
+// Print JSON stats
+static void print_stats_json(tp_json_t *j, capture_session_t *s) {
+    capture_counters_t snap;
+    tp_snapshot(&s->lock, &snap, &s->counters, sizeof(snap));
+    tp_guard_t guard;
+    if (s->guard_enabled) tp_snapshot(&s->guard_lock, &guard, &s->guard_pub, sizeof(guard));
+    uint64_t elapsed_us = tp_mono_us() - s->start_us;
+
+    tp_json_obj_begin(j, NULL);
+    json_session_tag(j, s);
+    tp_json_f64(j, "elapsed_ms", elapsed_us / 1000.0, 1);
+    tp_json_u64(j, "total", snap.total);
+    tp_json_obj_begin(j, "tc");
 
-        printf("\"%d\":{\"count\":%lu,\"avg_us\":%.1f,\"min_us\":%lu,\"max_us\":%lu,\"kbps\":%.1f}",
-               i, tc->count, avg_interval,
-               tc->min_interval_us == UINT64_MAX ? 0 : tc->min_interval_us,
-               tc->max_interval_us, throughput_kbps);
+    for (int i = 0; i < MAX_TC; i++) {
+        const tp_flow_stats_t *f = &snap.tc[i];
+        if (f->count == 0) continue;
+
+        tp_json_obj_begin_idx(j, i);
+        tp_json_u64(j, "count", f->count);
+        tp_json_f64(j, "avg_us", tp_flow_avg_interval_ns(f) / 1000.0, 1);
+        tp_json_u64(j, "min_us", f->interval_min_ns == UINT64_MAX ? 0 : f->interval_min_ns / 1000);
+        tp_json_u64(j, "max_us", f->interval_max_ns / 1000);
+        tp_json_f64(j, "kbps", tp_flow_kbps(f), 1);
+        if (f->seq_count > 0) json_seq(j, f, NULL);
+        if (s->ptp_base_ns >= 0) json_gate(j, &snap.gate[i]);
+        if (s->guard_enabled && tp_guard_gated(&s->gcl, i)) json_guard(j, &snap.guard[i], &guard.tc[i], 0);
+        if (integrity_seen(&snap.integrity[i])) json_integrity(j, &snap.integrity[i]);
+        tp_json_obj_end(j);
     }
 
-    printf("}}\n");
-    fflush(stdout);
-
-    pthread_mutex_unlock(&stats_mutex);
+    tp_json_obj_end(j);
+    if (preempt_seen(&snap.preempt)) json_preempt(j, &snap.preempt, NULL, 0);
+    tp_json_obj_end(j);
+    emit_json(j);
 }
 
 // Print human-readable stats
-static void print_stats_human(void) {
-    uint64_t now = get_time_us();
-    uint64_t elapsed_us = now - start_time_us;
-
-    pthread_mutex_lock(&stats_mutex);
+static void print_stats_human(capture_session_t *s) {
+    capture_counters_t snap;
+    tp_snapshot(&s->lock, &snap, &s->counters, sizeof(snap));
+    uint64_t elapsed_us = tp_mono_us() - s->start_us;
 
     printf("\n=== Capture Stats (%.1f sec) ===\n", elapsed_us / 1000000.0);
-    printf("Total: %lu packets\n\n", total_packets);
+    printf("Total: %lu packets\n\n", snap.total);
     printf("TC  Count     Avg(ms)   Min(ms)   Max(ms)   Throughput\n");
     printf("----------------------------------------------------\n");
 
     for (int i = 0; i < MAX_TC; i++) {
-        tc_stats_t *tc = &tc_stats[i];
-        if (tc->count == 0) continue;
+        const tp_flow_stats_t *f = &snap.tc[i];
+        if (f->count == 0) continue;
 
-        double avg_ms = tc->count > 1 ?
-            (double)tc->total_interval_us / (tc->count - 1) / 1000.0 : 0;
-        double min_ms = tc->min_interval_us == UINT64_MAX ? 0 : tc->min_interval_us / 1000.0;
-        double max_ms = tc->max_interval_us / 1000.0;
-        double kbps = tc->count > 1 && tc->last_ts_us > tc->first_ts_us ?
-            (tc->count * 60.0 * 8.0 * 1000.0) / (tc->last_ts_us - tc->first_ts_us) : 0;
+        double avg_ms = tp_flow_avg_interval_ns(f) / 1e6;
+        double min_ms = f->interval_min_ns == UINT64_MAX ? 0 : f->interval_min_ns / 1e6;
+        double max_ms = f->interval_max_ns / 1e6;
 
         printf("TC%d %8lu %9.2f %9.2f %9.2f %8.1f kbps\n",
-               i, tc->count, avg_ms, min_ms, max_ms, kbps);
+               i, f->count, avg_ms, min_ms, max_ms, tp_flow_kbps(f));
+    }
+    fflush(stdout);
+}
+
+// Queue depth series since the last report, grouped per TC. Cycle numbers
+// are relative to cycle0, times (no GCL) relative to t0_ns.
+static void print_queue_json(tp_json_t *j, capture_session_t *s) {
+    tp_queue_sample_t *batch = s->queue_batch;
+    int n = 0;
+    while (n < QUEUE_RING_SIZE && tp_ring_pop(&s->queue_ring, &batch[n])) n++;
+    if (n == 0) return;
+
+    // Trains close in per-TC order, so start times across TCs interleave
+    uint64_t t0 = batch[0].start_ns;
+    for (int k = 1; k < n; k++) {
+        if (batch[k].start_ns < t0) t0 = batch[k].start_ns;
     }
 
-    pthread_mutex_unlock(&stats_mutex);
+    int gated = s->queue.gcl != NULL;
+    tp_json_obj_begin(j, NULL);
+    json_session_tag(j, s);
+    tp_json_obj_begin(j, "queue");
+    if (gated) {
+        tp_json_u64(j, "cycle_ns", s->gcl.cycle_ns);
+        tp_json_i64(j, "cycle0", batch[0].cycle);
+    }
+    tp_json_u64(j, "t0_ns", t0);
+    tp_json_u64(j, "dropped", s->queue_ring.full_count);
+    tp_json_obj_begin(j, "tc");
+
+    for (int tc = 0; tc < MAX_TC; tc++) {
+        int count = 0, overruns = 0;
+        for (int k = 0; k < n; k++) {
+            if (batch[k].tc != tc) continue;
+            count++;
+            overruns += batch[k].overrun;
+        }
+        if (count == 0) continue;
+
+        tp_json_obj_begin_idx(j, tc);
+        if (gated) {
+            tp_json_arr_begin(j, "cycle");
+            for (int k = 0; k < n; k++) {
+                // Trains of always-open TCs carry no cycle
+                if (batch[k].tc == tc) tp_json_i64(j, NULL, batch[k].cycle < 0 ? -1 : batch[k].cycle - batch[0].cycle);
+            }
+            tp_json_arr_end(j);
+        }
+        tp_json_arr_begin(j, "t_us");
+        for (int k = 0; k < n; k++) {
+            if (batch[k].tc == tc) tp_json_f64(j, NULL, (batch[k].start_ns - t0) / 1000.0, 1);
+        }
+        tp_json_arr_end(j);
+        tp_json_arr_begin(j, "depth");
+        for (int k = 0; k < n; k++) {
+            if (batch[k].tc == tc) tp_json_u64(j, NULL, batch[k].depth);
+        }
+        tp_json_arr_end(j);
+        tp_json_arr_begin(j, "drain_us");
+        for (int k = 0; k < n; k++) {
+            if (batch[k].tc == tc) tp_json_f64(j, NULL, batch[k].drain_ns / 1000.0, 2);
+        }
+        tp_json_arr_end(j);
+        if (gated) tp_json_u64(j, "overrun", overruns);
+        tp_json_obj_end(j);
+    }
+
+    tp_json_obj_end(j);
+    tp_json_obj_end(j);
+    tp_json_obj_end(j);
+    emit_json(j);
+}
+
+// Move new PTP events into the history (caller holds ptp_history_mutex)
+static void ptp_history_update(void) {
+    tp_ptp_event_t ev;
+    while (tp_ring_pop(&ptp_event_ring, &ev)) {
+        ptp_history[(ptp_history_head + ptp_history_n) % PTP_HISTORY] = ev;
+        if (ptp_history_n < PTP_HISTORY) ptp_history_n++;
+        else ptp_history_head = (ptp_history_head + 1) % PTP_HISTORY;
+    }
+}
+
+// One dip window with the PTP events from corr_ns before it to just after it.
+// Event times are taken in the session's phase domain (PTP or capture clock).
+static void print_dip_json(tp_json_t *j, capture_session_t *s, const tp_dip_t *d) {
+    int64_t phase = s->score.phase_ns;
+    uint64_t cycle_ns = s->gcl.cycle_ns;
+    uint64_t start = (uint64_t)(phase + d->first_cycle * (int64_t)cycle_ns);
+    uint64_t end = (uint64_t)(phase + (d->last_cycle + 1) * (int64_t)cycle_ns);
+    uint64_t from = start > s->corr_ns ? start - s->corr_ns : 0;
+    uint64_t count[TP_PTP_EV_KINDS] = { 0 };
+    tp_ptp_event_t listed[DIP_EVENTS];
+    int n_listed = 0;
+
+    if (timebase_enabled) {
+        pthread_mutex_lock(&ptp_history_mutex);
+        ptp_history_update();
+        for (int i = 0; i < ptp_history_n; i++) {
+            const tp_ptp_event_t *ev = &ptp_history[(ptp_history_head + i) % PTP_HISTORY];
+            uint64_t t = s->ptp_base_ns >= 0 ? ev->ptp_ns : ev->host_ns;
+            if (t == 0 || t < from || t > end + DIP_LOOKAHEAD_NS) continue;
+            count[ev->kind]++;
+            if (n_listed < DIP_EVENTS) listed[n_listed++] = *ev;
+        }
+        pthread_mutex_unlock(&ptp_history_mutex);
+    }
+
+    double acc = d->frames ? 1.0 - (double)d->wrong / (double)d->frames : 1.0;
+    int ptp_cause = 0;
+    for (int k = 0; k < TP_PTP_EV_KINDS; k++) ptp_cause |= count[k] > 0;
+
+    tp_json_obj_begin(j, NULL);
+    json_session_tag(j, s);
+    tp_json_obj_begin(j, "anomaly");
+    tp_json_arr_begin(j, "cycles");
+    tp_json_i64(j, NULL, d->first_cycle);
+    tp_json_i64(j, NULL, d->last_cycle);
+    tp_json_arr_end(j);
+    tp_json_u64(j, "t_ns", start);
+    tp_json_u64(j, "dip_cycles", d->cycles);
+    tp_json_f64(j, "accuracy", acc, 4);
+    tp_json_f64(j, "baseline", d->baseline, 4);
+    tp_json_f64(j, "drop_pct", (d->baseline - acc) * 100, 1);
+    tp_json_f64(j, "min_accuracy", d->min_accuracy, 4);
+    tp_json_u64(j, "frames", d->frames);
+    tp_json_u64(j, "wrong", d->wrong);
+    if (timebase_enabled) {
+        tp_json_obj_begin(j, "ptp");
+        for (int k = 0; k < TP_PTP_EV_KINDS; k++) tp_json_u64(j, tp_ptp_event_name(k), count[k]);
+        tp_json_obj_end(j);
+        tp_json_arr_begin(j, "events");
+        for (int i = 0; i < n_listed; i++) {
+            const tp_ptp_event_t *ev = &listed[i];
+            uint64_t t = s->ptp_base_ns >= 0 ? ev->ptp_ns : ev->host_ns;
+            tp_json_obj_begin(j, NULL);
+            tp_json_str(j, "kind", tp_ptp_event_name(ev->kind));
+            tp_json_i64(j, "dt_ns", (int64_t)(t - start));
+            tp_json_i64(j, "value", ev->value);
+            tp_json_obj_end(j);
+        }
+        tp_json_arr_end(j);
+    }
+    tp_json_str(j, "cause", !timebase_enabled ? "unknown" : ptp_cause ? "ptp" : "none");
+    tp_json_obj_end(j);
+    tp_json_obj_end(j);
+    emit_json(j);
+}
+
+// Cycle scorecards closed since the last report, one array entry per cycle.
+// Cycle numbers are relative to cycle0; per-TC arrays follow "cycle".
+static void print_score_json(tp_json_t *j, capture_session_t *s) {
+    tp_score_rec_t *batch = s->score_batch;
+    int n = 0;
+    while (n < SCORE_RING_SIZE && tp_ring_pop(&s->score_ring, &batch[n])) n++;
+    if (n == 0) return;
+
+    tp_json_obj_begin(j, NULL);
+    json_session_tag(j, s);
+    tp_json_obj_begin(j, "cycles");
+    tp_json_u64(j, "cycle_ns", s->gcl.cycle_ns);
+    tp_json_i64(j, "cycle0", batch[0].cycle);
+    tp_json_u64(j, "dropped", s->score_ring.full_count);
+    tp_json_u64(j, "stale", s->score.stale);
+    tp_json_arr_begin(j, "cycle");
+    for (int k = 0; k < n; k++) tp_json_i64(j, NULL, batch[k].cycle - batch[0].cycle);
+    tp_json_arr_end(j);
+    tp_json_obj_begin(j, "tc");
+
+    static const struct {
+        const char *key;
+        size_t offset;
+    } cols[] = {
+        { "frames", offsetof(tp_score_rec_t, frames) },
+        { "wrong", offsetof(tp_score_rec_t, wrong) },
+        { "excess_ns", offsetof(tp_score_rec_t, max_excess_ns) },
+        { "first_ns", offsetof(tp_score_rec_t, first_ns) },
+        { "last_ns", offsetof(tp_score_rec_t, last_ns) },
+    };
+    for (int tc = 0; tc < MAX_TC; tc++) {
+        int seen = 0;
+        for (int k = 0; k < n && !seen; k++) seen = batch[k].frames[tc] > 0;
+        if (!seen) continue;
+
+        tp_json_obj_begin_idx(j, tc);
+        for (size_t c = 0; c < sizeof(cols) / sizeof(cols[0]); c++) {
+            tp_json_arr_begin(j, cols[c].key);
+            for (int k = 0; k < n; k++) {
+                const uint32_t *col = (const uint32_t *)((const char *)&batch[k] + cols[c].offset);
+                tp_json_u64(j, NULL, col[tc]);
+            }
+            tp_json_arr_end(j);
+        }
+        tp_json_obj_end(j);
+    }
+
+    tp_json_obj_end(j);
+    tp_json_obj_end(j);
+    tp_json_obj_end(j);
+    emit_json(j);
+
+    tp_dip_t dip;
+    for (int k = 0; k < n; k++) {
+        if (tp_anomaly_cycle(&s->anomaly, &batch[k], &dip)) print_dip_json(j, s, &dip);
+    }
+}
+
+static void json_queue_summary(tp_json_t *j, const tp_queue_summary_t *q, const tp_gcl_t *gcl, int tc) {
+    tp_json_obj_begin(j, "queue");
+    tp_json_u64(j, "trains", q->trains);
+    tp_json_f64(j, "avg_depth", q->trains ? (double)q->depth_sum / q->trains : 0, 2);
+    tp_json_u64(j, "max_depth", q->max_depth);
+    tp_json_f64(j, "max_drain_us", q->max_drain_ns / 1000.0, 2);
+    if (gcl && gcl->n_windows[tc] > 0) {
+        tp_json_f64(j, "window_us", gcl->windows[tc][0].len_ns / 1000.0, 2);
+        tp_json_u64(j, "overruns", q->overruns);
+        tp_json_u64(j, "unaligned", q->unaligned);
+    }
+    tp_json_obj_end(j);
+}
+
+// Token-bucket envelope (rate bytes/ns, sigma bytes) of tc's configured shaper
+static const char *shaper_envelope(const capture_session_t *s, int tc, const tp_arrival_curve_t *c,
+                                   double *rate, double *sigma) {
+    const tp_gcl_t *g = s->queue_enabled ? s->queue.gcl : NULL;
+
+    if (s->idle_slope_kbps[tc] > 0) {
+        *rate = s->idle_slope_kbps[tc] / 8e6;
+        *sigma = tp_arrival_cbs_sigma(*rate, s->link_mbps, c->max_frame, tp_arrival_wire(TP_MAX_FRAME_LEN));
+        return "cbs";
+    }
+    if (g && g->n_windows[tc] > 0 && g->windows[tc][0].len_ns < g->cycle_ns) {
+        *rate = tp_arrival_gate_rate(g, tc, s->link_mbps);
+        *sigma = tp_arrival_gate_sigma(g, tc, s->link_mbps, c->max_frame);
+        return "tas";
+    }
+    *rate = c->rate;
+    *sigma = 2.0 * c->max_frame;
+    return "none";
 }
 
-// Print final analysis
-static void print_final_analysis(void) {
-    pthread_mutex_lock(&stats_mutex);
+// Arrival curve and token-bucket fit of one TC. Returns 1 if the TC
+// conforms to its shaper's envelope.
+static int json_arrival(tp_json_t *j, const capture_session_t *s, int tc) {
+    const uint64_t *ts = s->trace_ts[tc];
+    const uint16_t *len = s->trace_len[tc];
+    int n = s->trace_count[tc];
+
+    tp_arrival_curve_t c;
+    tp_arrival_fit(&c, ts, len, n, ARRIVAL_MIN_WINDOW_NS);
+
+    double cfg_rate, cfg_sigma;
+    const char *shaper = shaper_envelope(s, tc, &c, &cfg_rate, &cfg_sigma);
+    double sigma = tp_arrival_sigma(ts, len, n, cfg_rate);
+
+    // Capture timestamp jitter can bunch frames by up to jitter_ns at line rate
+    double slack = s->jitter_ns * s->link_mbps / 8000.0;
+    int shaped = sigma <= cfg_sigma + slack;
+
+    tp_json_obj_begin(j, "arrival");
+    tp_json_u64(j, "frames", n);
+    tp_json_f64(j, "rate_kbps", c.rate * 8e6, 1);
+    tp_json_f64(j, "burst_bytes", c.burst, 0);
+    tp_json_u64(j, "max_frame", c.max_frame);
+    tp_json_str(j, "shaper", shaper);
+    tp_json_f64(j, "cfg_rate_kbps", cfg_rate * 8e6, 1);
+    tp_json_f64(j, "cfg_burst_bytes", cfg_sigma, 0);
+    tp_json_f64(j, "burst_at_cfg_bytes", sigma, 0);
+    tp_json_arr_begin(j, "curve");      // [window_us, max bytes]
+    for (int k = 0; k < c.n_points; k++) {
+        tp_json_arr_begin(j, NULL);
+        tp_json_f64(j, NULL, c.window_ns[k] / 1000.0, 0);
+        tp_json_u64(j, NULL, c.bytes[k]);
+        tp_json_arr_end(j);
+    }
+    tp_json_arr_end(j);
+    tp_json_obj_end(j);
+    return shaped;
+}
 
-    printf("\n{\"final\":true,\"tc\":{");
+// Print final analysis (the capture thread no longer writes to s)
+static void print_final_analysis(tp_json_t *j, capture_session_t *s) {
+    if (s->queue_enabled) {
+        tp_queue_flush(&s->queue);
+        print_queue_json(j, s);
+    }
+    if (s->score_enabled) {
+        tp_dip_t dip;
+        tp_score_flush(&s->score);
+        print_score_json(j, s);
+        if (tp_anomaly_flush(&s->anomaly, &dip)) print_dip_json(j, s, &dip);
+    }
+
+    tp_json_obj_begin(j, NULL);
+    json_session_tag(j, s);
+    tp_json_bool(j, "final", 1);
+    tp_json_obj_begin(j, "tc");
 
-    int first_tc = 1;
     for (int i = 0; i < MAX_TC; i++) {
-        tc_stats_t *tc = &tc_stats[i];
-        if (tc->count < 2) continue;
+        const tp_flow_stats_t *f = &s->counters.tc[i];
+        if (f->count < 2) continue;
 
-        double avg = (double)tc->total_interval_us / (tc->count - 1);
+        double avg = tp_flow_avg_interval_ns(f) / 1000.0;
 
-        // Calculate stddev and burst analysis
+        // Interval stddev over the recorded trace (microseconds)
         double sum_sq = 0;
-        int burst_count = 0;
-        uint64_t burst_threshold = 1000;  // 1ms
-
-        for (int j = 0; j < tc->interval_count; j++) {
-            double diff = (double)tc->intervals[j] - avg;
+        int n = s->trace_count[i];
+        for (int k = 1; k < n; k++) {
+            double diff = (s->trace_ts[i][k] - s->trace_ts[i][k - 1]) / 1000.0 - avg;
             sum_sq += diff * diff;
-            if (tc->intervals[j] < burst_threshold) burst_count++;
         }
+        double stddev = n > 1 ? sqrt(sum_sq / (n - 1)) : 0;
+
+        tp_json_obj_begin_idx(j, i);
+        tp_json_u64(j, "count", f->count);
+        tp_json_f64(j, "avg_ms", avg / 1000.0, 2);
+        tp_json_f64(j, "min_ms", f->interval_min_ns == UINT64_MAX ? 0 : f->interval_min_ns / 1e6, 2);
+        tp_json_f64(j, "max_ms", f->interval_max_ns / 1e6, 2);
+        tp_json_f64(j, "stddev_ms", stddev / 1000.0, 2);
+        tp_json_f64(j, "kbps", tp_flow_kbps(f), 1);
+        tp_json_bool(j, "shaped", json_arrival(j, s, i));
+        if (f->seq_count > 0) json_seq(j, f, &s->latency_hist[i]);
+        if (s->ptp_base_ns >= 0) json_gate(j, &s->counters.gate[i]);
+        if (s->guard_enabled && tp_guard_gated(&s->gcl, i)) json_guard(j, &s->counters.guard[i], &s->guard.tc[i], 1);
+        if (integrity_seen(&s->counters.integrity[i])) json_integrity(j, &s->counters.integrity[i]);
+        if (s->queue_enabled && s->queue.summary[i].trains + s->queue.summary[i].unaligned > 0) {
+            json_queue_summary(j, &s->queue.summary[i], s->queue.gcl, i);
+        }
+        tp_json_obj_end(j);
+    }
+
+    tp_json_obj_end(j);
+    if (s->guard_enabled) json_guard_summary(j, &s->guard);
+    if (preempt_seen(&s->counters.preempt)) json_preempt(j, &s->counters.preempt, s->express_hist, 1);
+    tp_json_obj_end(j);
+    emit_json(j);
+}
+
+// Histogram delta since the last record, folded into a rollup sketch
+static void rollup_sketch_delta(uint32_t *sketch, const tp_hist_t *h, tp_hist_t *prev) {
+    for (int b = 0; b < TP_HIST_BUCKETS; b++) {
+        uint64_t c = h->buckets[b];
+        if (c == prev->buckets[b]) continue;
+        tp_rollup_sketch_add(sketch, tp_rollup_bucket(tp_hist_bucket_lower(b)), c - prev->buckets[b]);
+        prev->buckets[b] = c;
+    }
+}
 
-        double stddev = tc->interval_count > 0 ? sqrt(sum_sq / tc->interval_count) : 0;
-        int is_shaped = (stddev > avg * 0.3) || (burst_count > tc->interval_count / 3);
+// One record per active TC for the second starting at t_ns (stats thread).
+// Histograms are read in place; a bucket racing the worker is caught
+// up at the next record.
+static void session_rollup(capture_session_t *s, uint64_t t_ns) {
+    capture_counters_t snap;
+    tp_snapshot(&s->lock, &snap, &s->counters, sizeof(snap));
+
+    for (int tc = 0; tc < MAX_TC; tc++) {
+        const tp_flow_stats_t *f = &snap.tc[tc];
+        const tp_flow_stats_t *p = &s->rollup_prev.tc[tc];
+        if (f->count == p->count && f->seq_lost == p->seq_lost) continue;
+
+        tp_rollup_rec_t rec = {
+            .t_ns = t_ns,
+            .seconds = 1,
+            .tc = (uint8_t)tc,
+            .frames = f->count - p->count,
+            .bytes = f->bytes - p->bytes,
+            .lost = f->seq_lost - p->seq_lost,
+            .ooo = f->seq_ooo - p->seq_ooo,
+            .gate_in = snap.gate[tc].in - s->rollup_prev.gate[tc].in,
+            .gate_out = snap.gate[tc].out - s->rollup_prev.gate[tc].out,
+            .lat_count = f->lat_count - p->lat_count,
+            .lat_sum_ns = f->lat_sum_ns - p->lat_sum_ns,
+            .interval_sum_ns = f->interval_sum_ns - p->interval_sum_ns,
+        };
+        rollup_sketch_delta(rec.lat, &s->latency_hist[tc], &s->rollup_hist_prev[tc]);
+        rollup_sketch_delta(rec.interval, &s->interval_hist[tc], &s->rollup_hist_prev[MAX_TC + tc]);
+        tp_rollup_add(s->rollup, &rec);
+    }
+    s->rollup_prev = snap;
+}
 
-        double kbps = (tc->count * 60.0 * 8.0 * 1000.0) / (tc->last_ts_us - tc->first_ts_us);
+static void session_rollup_tick(capture_session_t *s) {
+    uint64_t now = tp_real_ns();
+    if (now < s->rollup_next_ns) return;
+    session_rollup(s, s->rollup_next_ns - TP_NSEC_PER_SEC);
+    s->rollup_next_ns = (now / TP_NSEC_PER_SEC + 1) * TP_NSEC_PER_SEC;
+}
 
-        if (!first_tc) printf(",");
-        first_tc = 0;
+// Record the current partial second and flush the open minute/hour buckets
+static void session_rollup_close(capture_session_t *s) {
+    if (!s->rollup) return;
+    session_rollup(s, s->rollup_next_ns - TP_NSEC_PER_SEC);
+    tp_rollup_close(s->rollup);
+    free(s->rollup);
+    free(s->rollup_hist_prev);
+    s->rollup = NULL;
+}
 
-        printf("\"%d\":{\"count\":%lu,\"avg_ms\":%.2f,\"min_ms\":%.2f,\"max_ms\":%.2f,"
-               "\"stddev_ms\":%.2f,\"kbps\":%.1f,\"burst\":%d,\"shaped\":%s}",
-               i, tc->count, avg/1000.0,
-               tc->min_interval_us == UINT64_MAX ? 0 : tc->min_interval_us/1000.0,
-               tc->max_interval_us/1000.0, stddev/1000.0, kbps, burst_count,
-               is_shaped ? "true" : "false");
+// Store <rollup_root>/<name>; the name is reduced to [A-Za-z0-9._-]
+static int session_rollup_init(capture_session_t *s, const char *name) {
+    char safe[SESSION_ID_LEN * 2];
+    snprintf(safe, sizeof(safe), "%s", name);
+    for (char *c = safe; *c; c++) {
+        if (!(isalnum((unsigned char)*c) || *c == '.' || *c == '_' || *c == '-')) *c = '_';
     }
+    if (!rollup_root || safe[0] == '\0' || safe[0] == '.') return -1;
+
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s/%s", rollup_root, safe);
+    s->rollup = malloc(sizeof(*s->rollup));
+    s->rollup_hist_prev = calloc(2 * MAX_TC, sizeof(tp_hist_t));
+    if (!s->rollup || !s->rollup_hist_prev || tp_rollup_open(s->rollup, dir, rollup_retain_s) != 0) {
+        free(s->rollup);
+        free(s->rollup_hist_prev);
+        s->rollup = NULL;
+        return -1;
+    }
+    s->rollup_next_ns = (tp_real_ns() / TP_NSEC_PER_SEC + 1) * TP_NSEC_PER_SEC;
+    return 0;
+}
 
-    printf("}}\n");
-    fflush(stdout);
+static void session_free(capture_session_t *s) {
+    session_rollup_close(s);
+    free(s->hist_pub);
+    if (s->queue_enabled) {
+        tp_ring_free(&s->queue_ring);
+        tp_arena_free(&arena, s->queue_batch);
+    }
+    if (s->score_enabled) {
+        tp_ring_free(&s->score_ring);
+        tp_arena_free(&arena, s->score_batch);
+    }
+    tp_arena_free(&arena, s);
+}
+
+static void print_event(const char *id, const char *key, const char *value) {
+    tp_json_t j;
+    tp_json_init(&j);
+    tp_json_obj_begin(&j, NULL);
+    tp_json_str(&j, "session", id);
+    tp_json_str(&j, key, value);
+    tp_json_obj_end(&j);
+    emit_json(&j);
+    tp_json_free(&j);
+}
+
+static int find_session(const char *id) {
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        if (sessions[i] && strcmp(sessions[i]->id, id) == 0) return i;
+    }
+    return -1;
+}
+
+// Parse one "key=value" session option. Returns 0 if tok is not an option.
+static int parse_session_opt(session_opts_t *o, const char *tok) {
+    if (strcmp(tok, "seq") == 0) o->seq = 1;
+    else if (strcmp(tok, "queue") == 0) o->queue = 1;
+    else if (strncmp(tok, "interval=", 9) == 0) o->interval_ms = atoi(tok + 9);
+    else if (strncmp(tok, "gcl=", 4) == 0) o->gcl = tok + 4;
+    else if (strncmp(tok, "cycle=", 6) == 0) o->cycle_ns = strtoull(tok + 6, NULL, 10);
+    else if (strncmp(tok, "base=", 5) == 0) o->base_ns = strtoll(tok + 5, NULL, 10);
+    else if (strncmp(tok, "link=", 5) == 0) o->link_mbps = (uint32_t)atoi(tok + 5);
+    else if (strncmp(tok, "jitter=", 7) == 0) o->jitter_ns = strtoull(tok + 7, NULL, 10);
+    else if (strncmp(tok, "cbs=", 4) == 0) o->cbs = tok + 4;
+    else if (strncmp(tok, "ptpbase=", 8) == 0) o->ptp_base_ns = strtoll(tok + 8, NULL, 10);
+    else if (strncmp(tok, "guard=", 6) == 0) o->guard_bytes = (uint32_t)strtoul(tok + 6, NULL, 10);
+    else if (strncmp(tok, "dip=", 4) == 0) o->dip_pct = strtod(tok + 4, NULL);
+    else if (strncmp(tok, "corr=", 5) == 0) o->corr_ms = (uint32_t)strtoul(tok + 5, NULL, 10);
+    else if (strncmp(tok, "rollup=", 7) == 0) o->rollup = tok + 7;
+    else return 0;
+    return 1;
+}
+
+// "<tc>:<kbps>,..." CBS idle slopes
+static void parse_cbs_spec(capture_session_t *s, const char *spec) {
+    const char *p = spec;
+    while (*p) {
+        char *end;
+        long tc = strtol(p, &end, 10);
+        if (end == p || *end != ':') return;
+        double kbps = strtod(end + 1, &end);
+        if (tc >= 0 && tc < MAX_TC) s->idle_slope_kbps[tc] = kbps;
+        if (*end != ',') return;
+        p = end + 1;
+    }
+}
+
+// "s1,s60,s3600" retention of the rollup tiers in seconds
+static void parse_retention(const char *spec) {
+    const char *p = spec;
+    for (int t = 0; t < TP_ROLLUP_TIERS && *p; t++) {
+        char *end;
+        rollup_retain_s[t] = strtoull(p, &end, 10);
+        if (*end != ',') break;
+        p = end + 1;
+    }
+}
+
+static void session_opts_init(session_opts_t *o) {
+    memset(o, 0, sizeof(*o));
+    o->interval_ms = STATS_INTERVAL_MS;
+    o->base_ns = -1;
+    o->ptp_base_ns = -1;
+    o->link_mbps = 1000;
+    o->jitter_ns = DEFAULT_JITTER_NS;
+    o->guard_bytes = TP_MAX_FRAME_LEN;
+    o->dip_pct = TP_ANOMALY_DIP * 100;
+    o->corr_ms = 1000;
+}
+
+// Set up queue inference for a session. Returns 0 on success.
+static int session_queue_init(capture_session_t *s, const session_opts_t *o) {
+    if (o->gcl && tp_gcl_parse(&s->gcl, o->gcl, o->cycle_ns) != 0) return -1;
+    if (tp_ring_init_in(&s->queue_ring, &arena, "session_rings", QUEUE_RING_SIZE, sizeof(tp_queue_sample_t)) != 0) {
+        return -1;
+    }
+    s->queue_batch = tp_arena_alloc(&arena, "session_batches", QUEUE_RING_SIZE * sizeof(tp_queue_sample_t));
+    if (!s->queue_batch) {
+        tp_ring_free(&s->queue_ring);
+        return -1;
+    }
+    // PTP-aligned sessions feed the estimator switch time: the phase is exact
+    int aligned = o->gcl && o->ptp_base_ns >= 0;
+    tp_queue_init(&s->queue, o->gcl ? &s->gcl : NULL, o->link_mbps, o->jitter_ns,
+                  aligned ? o->ptp_base_ns : o->base_ns, &s->queue_ring);
+    s->queue.phase_fixed = aligned;
+    s->queue_enabled = 1;
+    return 0;
+}
 
-    pthread_mutex_unlock(&stats_mutex);
+// Guard checks and cycle scorecards for a session whose cycle phase is known
+// (timestamps in the same domain as phase_ns). Returns 0 on success.
+static int session_phase_init(capture_session_t *s, const session_opts_t *o, int64_t phase_ns) {
+    tp_guard_init(&s->guard, &s->gcl, phase_ns, s->link_mbps, o->guard_bytes, s->jitter_ns);
+    for (int tc = 0; tc < MAX_TC; tc++) guard_counts(&s->counters.guard[tc], &s->guard.tc[tc]);
+    s->guard_pub = s->guard;
+    s->guard_pub_cycle = s->guard.last_cycle;
+    s->guard_enabled = 1;
+
+    if (tp_ring_init_in(&s->score_ring, &arena, "session_rings", SCORE_RING_SIZE, sizeof(tp_score_rec_t)) != 0) {
+        return -1;
+    }
+    s->score_batch = tp_arena_alloc(&arena, "session_batches", SCORE_RING_SIZE * sizeof(tp_score_rec_t));
+    if (!s->score_batch || tp_score_init(&s->score, &s->gcl, phase_ns, s->link_mbps, s->jitter_ns,
+                                         &s->score_ring) != 0) {
+        tp_arena_free(&arena, s->score_batch);
+        tp_ring_free(&s->score_ring);
+        return -1;
+    }
+    s->score_enabled = 1;
+    tp_anomaly_init(&s->anomaly, &s->gcl, o->dip_pct / 100, TP_ANOMALY_MERGE);
+    s->corr_ns = o->corr_ms * 1000000ULL;
+    return 0;
+}
+
+// Create a session and subscribe it to its VLANs. Returns slot or -1.
+static int session_add(const char *id, const char *vlan_spec, const session_opts_t *o) {
+    pthread_mutex_lock(&sessions_mutex);
+
+    int slot = -1;
+    if (find_session(id) < 0) {
+        for (int i = 0; i < MAX_SESSIONS; i++) {
+            if (!sessions[i]) { slot = i; break; }
+        }
+    }
+    if (slot < 0) {
+        pthread_mutex_unlock(&sessions_mutex);
+        return -1;
+    }
+
+    capture_session_t *s = tp_arena_alloc(&arena, "sessions", sizeof(*s));
+    if (!s) {
+        pthread_mutex_unlock(&sessions_mutex);
+        return -1;
+    }
+    if ((o->gcl || o->queue) && session_queue_init(s, o) != 0) {
+        tp_arena_free(&arena, s);
+        pthread_mutex_unlock(&sessions_mutex);
+        return -1;
+    }
+    if (o->rollup && session_rollup_init(s, o->rollup) != 0) {
+        session_free(s);
+        pthread_mutex_unlock(&sessions_mutex);
+        return -1;
+    }
+    if (metrics_enabled && !(s->hist_pub = calloc(2 * MAX_TC, sizeof(tp_hist_t)))) {
+        session_free(s);
+        pthread_mutex_unlock(&sessions_mutex);
+        return -1;
+    }
+    snprintf(s->id, sizeof(s->id), "%s", id);
+    s->parse_seq = o->seq;
+    s->link_mbps = o->link_mbps ? o->link_mbps : 1000;
+    s->jitter_ns = o->jitter_ns;
+    s->ptp_base_ns = o->gcl ? o->ptp_base_ns : -1;
+    // Same time domain as the gate check: PTP if aligned, else the capture clock
+    if (o->gcl && (s->ptp_base_ns >= 0 || o->base_ns >= 0) &&
+        session_phase_init(s, o, s->ptp_base_ns >= 0 ? s->ptp_base_ns : o->base_ns) != 0) {
+        session_free(s);
+        pthread_mutex_unlock(&sessions_mutex);
+        return -1;
+    }
+    if (o->cbs) parse_cbs_spec(s, o->cbs);
+    s->interval_ms = o->interval_ms > 0 ? o->interval_ms : STATS_INTERVAL_MS;
+    s->start_us = tp_mono_us();
+    s->next_report_us = s->start_us + s->interval_ms * 1000ULL;
+    for (int i = 0; i < MAX_TC; i++) {
+        s->counters.tc[i].interval_min_ns = UINT64_MAX;
+    }
+    tp_preempt_init(&s->counters.preempt, s->link_mbps);
+    sessions[slot] = s;
+
+    // PTP-only capture ignores the VLAN filter (gPTP is untagged)
+    tp_classify_cfg_t cfg;
+    int mode = parse_vlan_spec(vlan_spec, &cfg);
+    if (proto_mode == TP_PROTO_PTP) mode = TP_VLAN_ANY;
+    uint32_t bit = 1U << slot;
+    for (int vid = 0; vid < MAX_VLAN; vid++) {
+        if (tp_classify_vlan_match(&cfg, vid, mode)) {
+            atomic_fetch_or_explicit(&vlan_sessions[vid], bit, memory_order_release);
+        }
+    }
+
+    pthread_mutex_unlock(&sessions_mutex);
+    return slot;
+}
+
+// Wait until every worker has finished any batch that started before
+// now, so unsubscribed sessions are no longer referenced
+static void wait_dispatch_quiescent(void) {
+    uint64_t epoch[MAX_WORKERS];
+    for (int w = 0; w < n_workers; w++) epoch[w] = atomic_load(&workers[w].epoch);
+
+    for (int w = 0; w < n_workers; w++) {
+        while (!atomic_load(&capture_done) && atomic_load(&workers[w].epoch) < epoch[w] + 2) {
+            usleep(1000);
+        }
+    }
+}
+
+// Unsubscribe, print final analysis and free a session
+static void session_remove(int slot, tp_json_t *j) {
+    pthread_mutex_lock(&sessions_mutex);
+    capture_session_t *s = sessions[slot];
+    uint32_t keep = ~(1U << slot);
+    for (int vid = 0; vid < MAX_VLAN; vid++) {
+        atomic_fetch_and_explicit(&vlan_sessions[vid], keep, memory_order_release);
+    }
+    pthread_mutex_unlock(&sessions_mutex);
+
+    wait_dispatch_quiescent();
+
+    // Out of the table before the final report: the stats thread must not
+    // consume the queue ring concurrently
+    pthread_mutex_lock(&sessions_mutex);
+    sessions[slot] = NULL;
+    pthread_mutex_unlock(&sessions_mutex);
+
+    if (output_mode == 0) print_final_analysis(j, s);
+    session_free(s);
+}
+
+// Service mode: session commands on stdin. EOF stops the capture.
+static void *control_thread(void *arg) {
+    (void)arg;
+    char line[4096];
+    tp_json_t j;
+    tp_json_init(&j);
+
+    while (running && fgets(line, sizeof(line), stdin)) {
+        char *save = NULL;
+        char *cmd = strtok_r(line, " \t\r\n", &save);
+        char *id = strtok_r(NULL, " \t\r\n", &save);
+        if (!cmd || !id) continue;
+
+        if (strcmp(cmd, "add") == 0) {
+            char *vlans = strtok_r(NULL, " \t\r\n", &save);
+            session_opts_t opts;
+            session_opts_init(&opts);
+            char *tok;
+            while ((tok = strtok_r(NULL, " \t\r\n", &save))) {
+                parse_session_opt(&opts, tok);
+            }
+            if (session_add(id, vlans ? vlans : "0", &opts) < 0) {
+                print_event(id, "error", "session exists, table full, bad GCL or rollup store");
+            } else {
+                print_event(id, "event", "added");
+            }
+        } else if (strcmp(cmd, "del") == 0) {
+            int slot = find_session(id);
+            if (slot < 0) {
+                print_event(id, "error", "no such session");
+            } else {
+                session_remove(slot, &j);
+                print_event(id, "event", "removed");
+            }
+        }
+    }
+
+    tp_json_free(&j);
+    running = 0;
+    if (handle) pcap_breakloop(handle);
+    return NULL;
+}
+
+// pcap_stats() accumulates into the handle; the stats and metrics threads share it
+static int read_pcap_stats(struct pcap_stat *ps) {
+    pthread_mutex_lock(&pcap_stats_mutex);
+    int rc = handle ? pcap_stats(handle, ps) : -1;
+    pthread_mutex_unlock(&pcap_stats_mutex);
+    return rc;
+}
+
+// Arena page kind, placement and usage by block name
+static void print_arena(tp_json_t *j) {
+    tp_json_obj_begin(j, NULL);
+    tp_arena_json(&arena, j, "arena");
+    tp_json_obj_end(j);
+    emit_json(j);
+}
+
+// Engine-wide pipeline health: per-worker ring drops, depth and lag,
+// plus what the kernel dropped before libpcap saw it
+static void print_pipeline_json(tp_json_t *j) {
+    tp_json_obj_begin(j, NULL);
+    tp_json_obj_begin(j, "pipeline");
+    tp_json_arr_begin(j, "workers");
+    for (int w = 0; w < n_workers; w++) {
+        capture_worker_t *wk = &workers[w];
+        tp_json_obj_begin(j, NULL);
+        tp_json_i64(j, "cpu", wk->cpu);
+        tp_json_u64(j, "processed", atomic_load_explicit(&wk->processed, memory_order_relaxed));
+        tp_json_u64(j, "ring_full", wk->ring.full_count);
+        tp_json_u64(j, "depth", tp_ring_depth(&wk->ring));
+        tp_json_u64(j, "max_depth", atomic_exchange_explicit(&wk->max_depth, 0, memory_order_relaxed));
+        tp_json_f64(j, "lag_us_max",
+                    atomic_exchange_explicit(&wk->max_lag_ns, 0, memory_order_relaxed) / 1000.0, 1);
+        tp_json_obj_end(j);
+    }
+    tp_json_arr_end(j);
+
+    struct pcap_stat ps;
+    if (read_pcap_stats(&ps) == 0) {
+        tp_json_obj_begin(j, "kernel");
+        tp_json_u64(j, "recv", ps.ps_recv);
+        tp_json_u64(j, "drop", ps.ps_drop);
+        tp_json_u64(j, "ifdrop", ps.ps_ifdrop);
+        tp_json_obj_end(j);
+    }
+    tp_json_obj_end(j);
+    tp_json_obj_end(j);
+    emit_json(j);
+}
+
+// Host-to-PTP fit of the timebase
+static void print_timebase_json(tp_json_t *j) {
+    tp_timebase_status_t st;
+    tp_timebase_status(&timebase, &st);
+
+    tp_json_obj_begin(j, NULL);
+    tp_json_obj_begin(j, "timebase");
+    tp_json_bool(j, "valid", st.valid);
+    tp_json_u64(j, "samples", st.samples);
+    tp_json_u64(j, "outliers", st.outliers);
+    tp_json_u64(j, "resets", st.resets);
+    tp_json_obj_begin(j, "events");
+    for (int k = 0; k < TP_PTP_EV_KINDS; k++) tp_json_u64(j, tp_ptp_event_name(k), ptpmon.events[k]);
+    tp_json_obj_end(j);
+    if (st.samples > 0) {
+        tp_json_i64(j, "offset_ns", st.offset_ns);
+        tp_json_f64(j, "rate_ppb", st.rate_ppb, 1);
+        tp_json_f64(j, "spread_ns", st.spread_ns, 0);
+        tp_json_f64(j, "age_ms", ((int64_t)(tp_real_ns() - st.last_host_ns)) / 1e6, 0);
+    }
+    tp_json_obj_end(j);
+    tp_json_obj_end(j);
+    emit_json(j);
+}
+
+// Session state a scrape renders, copied under sessions_mutex
+typedef struct {
+    int active;
+    int guard_enabled;
+    uint8_t gated;                      // TCs with a closing gate
+    char label[SESSION_ID_LEN * 2];
+    capture_counters_t counters;
+    tp_hist_t hist[2 * MAX_TC];         // Latency then interval per TC
+} metrics_session_t;
+
+// OpenMetrics scrape (runs on the exporter thread): session counters from
+// seqlock snapshots and histograms from the last published copies, taken
+// under sessions_mutex and rendered after it; pipeline counters in place
+static void render_metrics(tp_metrics_t *m, void *ctx) {
+    (void)ctx;
+    static metrics_session_t ms[MAX_SESSIONS];
+    char labels[sizeof(ms[0].label) + 64];
+
+    pthread_mutex_lock(&sessions_mutex);
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        capture_session_t *s = sessions[i];
+        ms[i].active = s != NULL;
+        if (!s) continue;
+        tp_snapshot(&s->lock, &ms[i].counters, &s->counters, sizeof(ms[i].counters));
+        tp_snapshot(&s->hist_lock, ms[i].hist, s->hist_pub, sizeof(ms[i].hist));
+        tp_metrics_escape(ms[i].label, sizeof(ms[i].label), s->id);
+        ms[i].guard_enabled = s->guard_enabled;
+        ms[i].gated = 0;
+        for (int tc = 0; tc < MAX_TC; tc++) {
+            if (tp_guard_gated(&s->gcl, tc)) ms[i].gated |= 1U << tc;
+        }
+    }
+    pthread_mutex_unlock(&sessions_mutex);
+
+    static const struct {
+        const char *family;
+        const char *help;
+        size_t offset;
+    } counters[] = {
+        { "tsn_capture_frames", "Frames received per TC", offsetof(tp_flow_stats_t, count) },
+        { "tsn_capture_bytes", "Bytes received per TC", offsetof(tp_flow_stats_t, bytes) },
+        { "tsn_capture_seq_lost", "Frames missing from the sender sequence", offsetof(tp_flow_stats_t, seq_lost) },
+        { "tsn_capture_seq_out_of_order", "Frames received out of sequence", offsetof(tp_flow_stats_t, seq_ooo) },
+    };
+    for (size_t c = 0; c < sizeof(counters) / sizeof(counters[0]); c++) {
+        char name[64];
+        tp_metrics_family(m, counters[c].family, "counter", counters[c].help);
+        snprintf(name, sizeof(name), "%s_total", counters[c].family);
+        for (int i = 0; i < MAX_SESSIONS; i++) {
+            if (!ms[i].active) continue;
+            for (int tc = 0; tc < MAX_TC; tc++) {
+                const tp_flow_stats_t *f = &ms[i].counters.tc[tc];
+                if (f->count == 0) continue;
+                snprintf(labels, sizeof(labels), "session=\"%s\",tc=\"%d\"", ms[i].label, tc);
+                tp_metrics_u64(m, name, labels, *(const uint64_t *)((const char *)f + counters[c].offset));
+            }
+        }
+    }
+
+    static const char *const verdicts[] = { "ok", "corrupt", "truncated", "unchecked" };
+    tp_metrics_family(m, "tsn_capture_payload_frames", "counter", "PRBS payload verdicts per TC (--check)");
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        if (!ms[i].active) continue;
+        for (int tc = 0; tc < MAX_TC; tc++) {
+            const capture_integrity_t *v = &ms[i].counters.integrity[tc];
+            if (!integrity_seen(v)) continue;
+            const uint64_t n[] = { v->ok, v->corrupt, v->truncated, v->unchecked };
+            for (int k = 0; k < 4; k++) {
+                snprintf(labels, sizeof(labels), "session=\"%s\",tc=\"%d\",verdict=\"%s\"", ms[i].label, tc, verdicts[k]);
+                tp_metrics_u64(m, "tsn_capture_payload_frames_total", labels, n[k]);
+            }
+        }
+    }
+    tp_metrics_family(m, "tsn_capture_payload_bit_errors", "counter", "Flipped PRBS payload bits per TC");
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        if (!ms[i].active) continue;
+        for (int tc = 0; tc < MAX_TC; tc++) {
+            if (!integrity_seen(&ms[i].counters.integrity[tc])) continue;
+            snprintf(labels, sizeof(labels), "session=\"%s\",tc=\"%d\"", ms[i].label, tc);
+            tp_metrics_u64(m, "tsn_capture_payload_bit_errors_total", labels, ms[i].counters.integrity[tc].bit_errors);
+        }
+    }
+
+    tp_metrics_family(m, "tsn_capture_guard_frames", "counter", "Frames by start relative to their TC's gate close");
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        if (!ms[i].active || !ms[i].guard_enabled) continue;
+        for (int tc = 0; tc < MAX_TC; tc++) {
+            if (!(ms[i].gated & (1U << tc))) continue;
+            const capture_guard_t *t = &ms[i].counters.guard[tc];
+            for (int k = 0; k < TP_GUARD_KINDS; k++) {
+                snprintf(labels, sizeof(labels), "session=\"%s\",tc=\"%d\",kind=\"%s\"", ms[i].label, tc,
+                         tp_guard_kind_name(k));
+                tp_metrics_u64(m, "tsn_capture_guard_frames_total", labels, t->frames[k]);
+            }
+        }
+    }
+
+    tp_metrics_family(m, "tsn_capture_latency_seconds", "histogram", "One-way latency from the sender timestamp");
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        if (!ms[i].active) continue;
+        for (int tc = 0; tc < MAX_TC; tc++) {
+            if (ms[i].counters.tc[tc].lat_count == 0) continue;
+            snprintf(labels, sizeof(labels), "session=\"%s\",tc=\"%d\"", ms[i].label, tc);
+            tp_metrics_hist(m, "tsn_capture_latency_seconds", labels, &ms[i].hist[tc], 1e-9);
+        }
+    }
+    tp_metrics_family(m, "tsn_capture_interval_seconds", "histogram", "Inter-arrival time per TC");
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        if (!ms[i].active) continue;
+        for (int tc = 0; tc < MAX_TC; tc++) {
+            if (ms[i].counters.tc[tc].count < 2) continue;
+            snprintf(labels, sizeof(labels), "session=\"%s\",tc=\"%d\"", ms[i].label, tc);
+            tp_metrics_hist(m, "tsn_capture_interval_seconds", labels, &ms[i].hist[MAX_TC + tc], 1e-9);
+        }
+    }
+    tp_metrics_family(m, "tsn_capture_worker_frames", "counter", "Records analysed per worker");
+    for (int w = 0; w < n_workers; w++) {
+        snprintf(labels, sizeof(labels), "worker=\"%d\"", w);
+        tp_metrics_u64(m, "tsn_capture_worker_frames_total", labels,
+                       atomic_load_explicit(&workers[w].processed, memory_order_relaxed));
+    }
+    tp_metrics_family(m, "tsn_capture_ring_full", "counter", "Records dropped because a worker ring was full");
+    for (int w = 0; w < n_workers; w++) {
+        snprintf(labels, sizeof(labels), "worker=\"%d\"", w);
+        tp_metrics_u64(m, "tsn_capture_ring_full_total", labels, workers[w].ring.full_count);
+    }
+    tp_metrics_family(m, "tsn_capture_ring_depth", "gauge", "Records waiting in a worker ring");
+    for (int w = 0; w < n_workers; w++) {
+        snprintf(labels, sizeof(labels), "worker=\"%d\"", w);
+        tp_metrics_u64(m, "tsn_capture_ring_depth", labels, tp_ring_depth(&workers[w].ring));
+    }
+
+    struct pcap_stat ps;
+    if (read_pcap_stats(&ps) == 0) {
+        tp_metrics_family(m, "tsn_capture_kernel_packets", "counter", "Packets seen by the kernel capture socket");
+        tp_metrics_u64(m, "tsn_capture_kernel_packets_total", NULL, ps.ps_recv);
+        tp_metrics_family(m, "tsn_capture_kernel_drops", "counter", "Packets dropped before libpcap read them");
+        tp_metrics_u64(m, "tsn_capture_kernel_drops_total", "where=\"buffer\"", ps.ps_drop);
+        tp_metrics_u64(m, "tsn_capture_kernel_drops_total", "where=\"interface\"", ps.ps_ifdrop);
+    }
+
+    tp_metrics_rt(m, "tsn_capture");
 }
 
 // Stats thread
 static void *stats_thread(void *arg) {
     (void)arg;
+    tp_json_t j;
+    tp_json_init(&j);
+    uint64_t next_pipeline_us = tp_mono_us() + PIPELINE_REPORT_MS * 1000ULL;
     while (running) {
-        usleep(STATS_INTERVAL_MS * 1000);
+        usleep(STATS_TICK_MS * 1000);
         if (!running) break;
-        if (output_mode == 0) print_stats_json();
-        else if (output_mode == 1) print_stats_human();
+
+        uint64_t t0 = tp_prof_begin();
+        uint64_t now = tp_mono_us();
+        if (output_mode == 0 && now >= next_pipeline_us) {
+            next_pipeline_us = now + PIPELINE_REPORT_MS * 1000ULL;
+            print_pipeline_json(&j);
+            if (timebase_enabled) {
+                print_timebase_json(&j);
+                pthread_mutex_lock(&ptp_history_mutex);
+                ptp_history_update();
+                pthread_mutex_unlock(&ptp_history_mutex);
+            }
+        }
+        pthread_mutex_lock(&sessions_mutex);
+        for (int i = 0; i < MAX_SESSIONS; i++) {
+            capture_session_t *s = sessions[i];
+            if (!s) continue;
+            if (s->rollup) session_rollup_tick(s);
+            if (now < s->next_report_us) continue;
+            s->next_report_us += s->interval_ms * 1000ULL;
+            if (s->next_report_us < now) s->next_report_us = now + s->interval_ms * 1000ULL;
+
+            if (output_mode == 0) {
+                print_stats_json(&j, s);
+                if (s->queue_enabled) print_queue_json(&j, s);
+                if (s->score_enabled) print_score_json(&j, s);
+            } else if (output_mode == 1) {
+                print_stats_human(s);
+            }
+        }
+        pthread_mutex_unlock(&sessions_mutex);
+        tp_prof_end(&stats_prof, STATS_REPORT, t0, 0);
     }
+    tp_prof_thread_done(&stats_prof);
+    tp_json_free(&j);
     return NULL;
 }
 
+// Engine-wide stage profile of every thread, once after capture ends
+static void print_profile_json(tp_json_t *j) {
+    tp_prof_t *profs[MAX_WORKERS + 2];
+    int n = 0;
+    profs[n++] = &drain_prof;
+    for (int w = 0; w < n_workers; w++) profs[n++] = &workers[w].prof;
+    if (output_mode != 2) profs[n++] = &stats_prof;
+
+    tp_json_obj_begin(j, NULL);
+    tp_prof_json(j, "profile", profs, n);
+    tp_json_obj_end(j);
+    emit_json(j);
+}
+
 static void usage(const char *prog) {
-    fprintf(stderr, "Usage: %s <interface> [duration] [vlan_id] [mode]\n", prog);
+    fprintf(stderr, "Usage: %s <interface> [duration] [vlan_id[,vlan_id...]] [mode] [--ptp] [--seq|--check]\n", prog);
+    fprintf(stderr, "       %s <interface> --service [--ptp] [--check]\n", prog);
+    fprintf(stderr, "  vlan_id: single VID, comma list, or 0 for any VLAN\n");
     fprintf(stderr, "  mode: json (default), stats, raw\n");
-    fprintf(stderr, "Example: %s enxc84d44231cc2 5 100 json\n", prog);
+    fprintf(stderr, "  --ptp: count PTP (0x88F7) frames only\n");
+    fprintf(stderr, "  --seq: parse sequence/timestamp payload from traffic-sender\n");
+    fprintf(stderr, "  --check: also verify PRBS payloads (traffic-sender --prbs), implies --seq\n");
+    fprintf(stderr, "  --service: multi-session mode, commands on stdin (see source header)\n");
+    fprintf(stderr, "  --gcl <gates:ns,...> [--cycle ns] [--base ns] [--link mbps] [--jitter ns]:\n");
+    fprintf(stderr, "         infer per-TC queue depth at each gate open (--queue: without GCL)\n");
+    fprintf(stderr, "  --timebase [--ptp-base ns]: fit switch PTP time from captured Sync/Follow_Up;\n");
+    fprintf(stderr, "         with a GCL and its AdminBaseTime, check frames against the gate windows\n");
+    fprintf(stderr, "  --guard <bytes>: guard band before each gate close (default 1518, 0 = off); with\n");
+    fprintf(stderr, "         a GCL and --base or --ptp-base, count frames in the band, straddling or leaking\n");
+    fprintf(stderr, "  --dip <pct> [--corr ms]: report per-cycle accuracy dips below baseline (default 5),\n");
+    fprintf(stderr, "         with --timebase listing PTP events from ms before each (default 1000)\n");
+    fprintf(stderr, "  --workers N [--cpus a,b,..] [--drain-cpu N] [--ring records]:\n");
+    fprintf(stderr, "         analysis worker threads fed from the drain thread (default 1)\n");
+    fprintf(stderr, "  --metrics <port|addr:port|unix:path>: serve OpenMetrics at /metrics\n");
+    fprintf(stderr, "  --rollup <dir> [--rollup-retain s1,s60,s3600]: 1 s / 1 min / 1 h per-TC store\n");
+    fprintf(stderr, "         for soak tests (retention in seconds per tier, 0 = keep)\n");
+    fprintf(stderr, "  --arena <MB>: hugepage arena near the NIC's NUMA node for rings and sessions\n");
+    fprintf(stderr, "         (default sized for the workers and %d sessions, 0 = heap)\n", ARENA_SESSIONS);
+    fprintf(stderr, "Example: %s enxc84d44231cc2 5 100 json --seq\n", prog);
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
+    static const struct option long_opts[] = {
+        {"ptp", no_argument, NULL, 'p'},
+        {"seq", no_argument, NULL, 's'},
+        {"check", no_argument, NULL, 'V'},
+        {"service", no_argument, NULL, 'S'},
+        {"queue", no_argument, NULL, 'q'},
+        {"gcl", required_argument, NULL, 'g'},
+        {"cycle", required_argument, NULL, 'c'},
+        {"base", required_argument, NULL, 'b'},
+        {"link", required_argument, NULL, 'l'},
+        {"jitter", required_argument, NULL, 'j'},
+        {"workers", required_argument, NULL, 'w'},
+        {"cpus", required_argument, NULL, 'C'},
+        {"drain-cpu", required_argument, NULL, 'D'},
+        {"ring", required_argument, NULL, 'r'},
+        {"metrics", required_argument, NULL, 'm'},
+        {"timebase", no_argument, NULL, 'T'},
+        {"ptp-base", required_argument, NULL, 'P'},
+        {"guard", required_argument, NULL, 'G'},
+        {"dip", required_argument, NULL, 'd'},
+        {"corr", required_argument, NULL, 'o'},
+        {"rollup", required_argument, NULL, 'R'},
+        {"rollup-retain", required_argument, NULL, 'K'},
+        {"arena", required_argument, NULL, 'A'},
+        {NULL, 0, NULL, 0}
+    };
+
+    session_opts_t opts;
+    session_opts_init(&opts);
+    memcpy(rollup_retain_s, tp_rollup_default_retain_s, sizeof(rollup_retain_s));
+    int worker_cpus[MAX_WORKERS];
+    parse_cpu_list("", worker_cpus, MAX_WORKERS);
+    int drain_cpu = -1;
+    const char *metrics_spec = NULL;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'p': proto_mode = TP_PROTO_PTP; break;
+        case 's': if (parse_seq < SEQ_ON) parse_seq = SEQ_ON; break;
+        case 'V': parse_seq = SEQ_CHECK; break;
+        case 'S': service_mode = 1; break;
+        case 'q': opts.queue = 1; break;
+        case 'g': opts.gcl = optarg; break;
+        case 'c': opts.cycle_ns = strtoull(optarg, NULL, 10); break;
+        case 'b': opts.base_ns = strtoll(optarg, NULL, 10); break;
+        case 'l': opts.link_mbps = (uint32_t)atoi(optarg); break;
+        case 'j': opts.jitter_ns = strtoull(optarg, NULL, 10); break;
+        case 'w': n_workers = atoi(optarg); break;
+        case 'C': parse_cpu_list(optarg, worker_cpus, MAX_WORKERS); break;
+        case 'D': drain_cpu = atoi(optarg); break;
+        case 'r': worker_ring_size = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'm': metrics_spec = optarg; metrics_enabled = 1; break;
+        case 'T': timebase_enabled = 1; break;
+        case 'P': opts.ptp_base_ns = strtoll(optarg, NULL, 10); break;
+        case 'G': opts.guard_bytes = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'd': opts.dip_pct = strtod(optarg, NULL); break;
+        case 'o': opts.corr_ms = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'R': rollup_root = optarg; break;
+        case 'K': parse_retention(optarg); break;
+        case 'A': arena_mb = strtol(optarg, NULL, 10); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    // Positional arguments (getopt moves them to the end)
+    char **pos = argv + optind;
+    int npos = argc - optind;
+    if (npos < 1 || n_workers < 1 || n_workers > MAX_WORKERS || worker_ring_size < 2) {
         usage(argv[0]);
         return 1;
     }
 
-    const char *ifname = argv[1];
-    int duration = argc > 2 ? atoi(argv[2]) : 10;
-    target_vlan = argc > 3 ? atoi(argv[3]) : 100;
+    // PTP-only capture already counts the Syncs; there is no data to map
+    if (proto_mode == TP_PROTO_PTP) timebase_enabled = 0;
 
-    if (argc > 4) {
-        if (strcmp(argv[4], "stats") == 0) output_mode = 1;
-        else if (strcmp(argv[4], "raw") == 0) output_mode = 2;
-    }
+    const char *ifname = pos[0];
+    int duration = 0;
+    const char *vlan_arg = "0";
 
-    // Initialize
-    memset(tc_stats, 0, sizeof(tc_stats));
-    for (int i = 0; i < MAX_TC; i++) {
-        tc_stats[i].min_interval_us = UINT64_MAX;
+    if (service_mode) {
+        // Sessions pick their VLANs; classify everything tagged, parse seq when present
+        vlan_mode = TP_VLAN_ANY;
+        if (parse_seq < SEQ_ON) parse_seq = SEQ_ON;
+    } else {
+        duration = npos > 1 ? atoi(pos[1]) : 10;
+        vlan_arg = npos > 2 ? pos[2] : "100";
+        vlan_mode = parse_vlan_spec(vlan_arg, &classify_cfg);
+        target_vlan = classify_cfg.vlan;
+
+        if (npos > 3) {
+            if (strcmp(pos[3], "stats") == 0) output_mode = 1;
+            else if (strcmp(pos[3], "raw") == 0) output_mode = 2;
+        }
     }
 
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
-    setup_realtime();
+    // Mapped before mlockall() so locking faults it in under the node policy
+    size_t arena_size = arena_mb < 0 ? arena_default_size() : (size_t)arena_mb << 20;
+    if (tp_arena_init(&arena, arena_size, ifname) != 0 && arena_size) {
+        fprintf(stderr, "Warning: no memory arena, hot structures on the heap\n");
+    }
+    fprintf(stderr, "Arena: %zu MB %s pages, node %d (NIC node %d)%s\n", arena.size >> 20,
+            tp_arena_page_name(arena.page), arena.node, arena.nic_node,
+            arena.nic_node >= 0 && !arena.bound ? ", not bound" : "");
+    tp_setup_realtime(1, 0);
+    tp_timebase_init(&timebase);
+    if (timebase_enabled &&
+        tp_ring_init_in(&ptp_event_ring, &arena, "ptp_events", PTP_EVENT_RING_SIZE, sizeof(tp_ptp_event_t)) != 0) {
+        fprintf(stderr, "Failed to allocate the PTP event ring\n");
+        return 1;
+    }
+    tp_ptpmon_init(&ptpmon, timebase_enabled ? &ptp_event_ring : NULL);
 
-    // Open pcap
+    // Open pcap; nanosecond timestamps resolve line-rate trains (672 ns at 1G)
     char errbuf[PCAP_ERRBUF_SIZE];
-    handle = pcap_open_live(ifname, 128, 1, 10, errbuf);
+    handle = pcap_create(ifname, errbuf);
     if (!handle) {
-        fprintf(stderr, "pcap_open_live: %s\n", errbuf);
+        fprintf(stderr, "pcap_create: %s\n", errbuf);
         return 1;
     }
+    // Verification needs whole frames; otherwise headers suffice
+    pcap_set_snaplen(handle, parse_seq == SEQ_CHECK ? CHECK_SNAPLEN : 128);
+    pcap_set_promisc(handle, 1);
+    pcap_set_timeout(handle, 10);
+    int nano = pcap_set_tstamp_precision(handle, PCAP_TSTAMP_PRECISION_NANO) == 0;
+    if (pcap_activate(handle) < 0) {
+        fprintf(stderr, "pcap_activate: %s\n", pcap_geterr(handle));
+        pcap_close(handle);
+        return 1;
+    }
+    if (nano) ts_frac_ns = 1;
 
-    // Set filter for VLAN
+    // Set filter for the selected variant
     struct bpf_program fp;
-    char filter[64];
-    snprintf(filter, sizeof(filter), "vlan %d", target_vlan);
+    char filter[96];
+    build_filter(filter, sizeof(filter));
     if (pcap_compile(handle, &fp, filter, 1, PCAP_NETMASK_UNKNOWN) == 0) {
         pcap_setfilter(handle, &fp);
         pcap_freecode(&fp);
     }
 
-    fprintf(stderr, "Capturing on %s, VLAN %d, %ds, mode=%s\n",
-            ifname, target_vlan, duration,
-            output_mode == 0 ? "json" : (output_mode == 1 ? "stats" : "raw"));
+    pcap_handler handler = select_packet_handler();
+
+    fprintf(stderr, "Capturing on %s, VLAN %s, %ds, mode=%s, classifier=%s%s%s%s\n",
+            ifname, service_mode ? "per-session" : vlan_arg, duration,
+            output_mode == 0 ? "json" : (output_mode == 1 ? "stats" : "raw"),
+            proto_mode == TP_PROTO_PTP ? "ptp" :
+                (vlan_mode == TP_VLAN_ONE ? "one-vlan-udp" : (vlan_mode == TP_VLAN_SET ? "multi-vlan-udp" : "any-vlan-udp")),
+            proto_mode != TP_PROTO_UDP ? "" : (parse_seq == SEQ_CHECK ? "+check" : (parse_seq ? "+seq" : "")),
+            timebase_enabled ? "+timebase" : "",
+            service_mode ? ", service" : "");
+
+    // Single-run mode is one implicit session
+    if (!service_mode) {
+        opts.seq = parse_seq;
+        if (rollup_root) opts.rollup = "default";
+        if (session_add("default", vlan_arg, &opts) < 0) {
+            fprintf(stderr, "Invalid GCL or rollup store: %s %s\n", opts.gcl ? opts.gcl : "-",
+                    rollup_root ? rollup_root : "-");
+            return 1;
+        }
+    }
+
+    tp_prof_init(&drain_prof, "drain", drain_stages);
+    tp_prof_init(&stats_prof, "stats", stats_stages);
+
+    // Analysis workers before any session can be subscribed in service mode
+    if (start_workers(worker_cpus) != 0) {
+        fprintf(stderr, "Failed to start analysis workers\n");
+        return 1;
+    }
+    if (output_mode == 0) {
+        tp_json_t j;
+        tp_json_init(&j);
+        print_arena(&j);
+        tp_json_free(&j);
+    }
+    if (drain_cpu >= 0 && tp_pin_thread(drain_cpu) != 0) {
+        fprintf(stderr, "Warning: could not pin drain thread to CPU %d\n", drain_cpu);
+    }
+
+    if (metrics_spec && tp_metrics_start(&metrics_server, metrics_spec, render_metrics, NULL) != 0) {
+        fprintf(stderr, "Warning: could not serve metrics on %s\n", metrics_spec);
+    }
 
-    // Start stats thread
-    pthread_t stats_tid;
+    // Start stats and control threads
+    pthread_t stats_tid, control_tid;
     if (output_mode != 2) {
         pthread_create(&stats_tid, NULL, stats_thread, NULL);
     }
+    if (service_mode) {
+        pthread_create(&control_tid, NULL, control_thread, NULL);
+    }
 
     // Capture
-    start_time_us = get_time_us();
+    uint64_t start_time_us = tp_mono_us();
     uint64_t end_time_us = duration > 0 ? start_time_us + duration * 1000000ULL : UINT64_MAX;
 
-    while (running && get_time_us() < end_time_us) {
-        pcap_dispatch(handle, 100, packet_handler, NULL);
+    while (running && tp_mono_us() < end_time_us) {
+        uint64_t t0 = tp_prof_begin();
+        int n = pcap_dispatch(handle, 100, handler, NULL);
+        tp_prof_end(&drain_prof, DRAIN_DISPATCH, t0, n > 0 ? n : 0);
     }
+    tp_prof_thread_done(&drain_prof);
+
+    // Let the workers drain what was already captured
+    atomic_store(&drain_done, 1);
+    for (int w = 0; w < n_workers; w++) pthread_join(workers[w].tid, NULL);
 
     running = 0;
+    atomic_store(&capture_done, 1);
 
     // Cleanup
     if (output_mode != 2) {
         pthread_join(stats_tid, NULL);
     }
+    if (service_mode) {
+        // Control thread may be blocked on stdin; it exits with the process
+        pthread_detach(control_tid);
+    }
+    tp_metrics_stop(&metrics_server);
+    pthread_mutex_lock(&pcap_stats_mutex);
     pcap_close(handle);
-
-    // Final output
-    if (output_mode == 0) {
-        print_final_analysis();
-    } else if (output_mode == 1) {
-        print_stats_human();
+    handle = NULL;
+    pthread_mutex_unlock(&pcap_stats_mutex);
+
+    // Final output for every remaining session
+    tp_json_t j;
+    tp_json_init(&j);
+    pthread_mutex_lock(&sessions_mutex);
+    for (int i = 0; i < MAX_SESSIONS; i++) {
+        capture_session_t *s = sessions[i];
+        if (!s) continue;
+        if (output_mode == 0) print_final_analysis(&j, s);
+        else if (output_mode == 1) print_stats_human(s);
+        session_rollup_close(s);
     }
+    pthread_mutex_unlock(&sessions_mutex);
+    if (output_mode == 0) print_arena(&j);
+    if (TP_PROFILE && output_mode == 0) print_profile_json(&j);
+    tp_json_free(&j);
 
+    for (int w = 0; w < n_workers; w++) tp_ring_free(&workers[w].ring);
+    if (timebase_enabled) tp_ring_free(&ptp_event_ring);
     return 0;
 }
@@ -1,143 +1,137 @@
 /*
  * Precision Traffic Sender for TSN Testing
- * Compile: gcc -O2 -o traffic-sender traffic-sender.c -lpthread -lrt
+ * Build: cmake -S . -B build && cmake --build build   (see CMakeLists.txt)
  * Run: sudo ./traffic-sender <interface> <dst_mac> <src_mac> <vlan_id> <tc_list> <pps> <duration>
  * Example: sudo ./traffic-sender enx00e04c681336 FA:AE:C9:26:A4:08 00:e0:4c:68:13:36 100 "1,2,3,4,5,6,7" 100 7
+ *
+ * --metrics <port|addr:port|unix:path> serves OpenMetrics (per-TC tx
+ * counters, send errors, send lateness histogram, RT health) while sending.
+ *
+ * --frame-size <bytes> sets the frame length without FCS (60..1518).
+ * --prbs[=seed] fills each TC's payload after the seq/timestamp header with
+ * a PRBS-31 body seeded per TC plus its CRC32C (tsnperf/payload.h), for
+ * traffic-capture --check. The body is built into the template once, so
+ * the per-frame cost stays the header stamp.
+ *
+ * --cpu <n> pins the send loop to a CPU, so parallel senders (campaign runs
+ * on several interface pairs) don't share cores.
+ *
+ * --express <tc,...> turns the run into a frame preemption mix
+ * (tsnperf/preempt.h): the listed TCs are express, the rest of tc_list
+ * preemptable. Each slot (pps) launches a --preempt-size frame of the next
+ * preemptable TC and, at the next offset of --offsets later, a --frame-size
+ * frame of the next express TC; "alone" offsets send the express frame by
+ * itself. Every TC gets its own socket with SO_PRIORITY = TC, so an
+ * mqprio/taprio qdisc with preemptible TCs maps them to the MAC merge
+ * queues. traffic-capture reports the express latency split.
+ *
+ * --timeline <file> plays a schedule compiled by tsn-timeline instead
+ * (tsnperf/timeline.h): sudo ./traffic-sender --timeline <file> <interface> [duration]
+ * The file is mapped and locked before the send loop, which only waits for
+ * each record's launch time, stamps its template and sends it. Looping
+ * timelines repeat until the duration (default: one pass); timelines
+ * compiled against a GCL start on a cycle boundary of CLOCK_REALTIME, plus
+ * --phase-ns.
+ *
+ * Frame templates and the lateness histogram live in a 2 MB-page arena on
+ * the interface's NUMA node (tsnperf/arena.h), mapped before mlockall();
+ * the result's "arena" object reports the page kind and placement.
  */
 
 #define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <errno.h>
-#include <time.h>
-#include <sched.h>
-#include <pthread.h>
-#include <sys/mman.h>
+#include <getopt.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <net/if.h>
 #include <linux/if_packet.h>
 #include <linux/if_ether.h>
 #include <arpa/inet.h>
 
-#define MAX_TCS 8
-#define FRAME_SIZE 64
-#define PAYLOAD_SIZE 10
+#include "tsnperf/arena.h"
+#include "tsnperf/clock.h"
+#include "tsnperf/frame.h"
+#include "tsnperf/hist.h"
+#include "tsnperf/json.h"
+#include "tsnperf/metrics.h"
+#include "tsnperf/payload.h"
+#include "tsnperf/preempt.h"
+#include "tsnperf/prof.h"
+#include "tsnperf/rt.h"
+#include "tsnperf/stats.h"
+#include "tsnperf/timeline.h"
 
-// Frame buffer for each TC
-static unsigned char frames[MAX_TCS][FRAME_SIZE];
+#define MAX_TCS 8
+#define FRAME_SIZE TP_MAX_FRAME_LEN
+#define PRBS_FRAME_SIZE 128     // Default frame length with --prbs
+#define PRBS_DEFAULT_SEED 0x5EED
+#define TIMELINE_LEAD_NS 1000000    // Setup slack before the first timeline record
+#define TIMELINE_PREFETCH 16        // Records ahead
+#define ARENA_HEADERS 4096          // Block header room in the arena
+#define MIX_MAX_OFFSETS 32
+#define MIX_DEFAULT_OFFSETS "alone,0,2000,4000,6000,8000,10000,12000"   // Across 1518 B at 1 Gb/s
+
+// Hot data: frame templates and the lateness histogram
+static tp_arena_t arena;
+static uint8_t (*frames)[FRAME_SIZE];  // One template per TC
 static int frame_lens[MAX_TCS];
 
+// Preemption mix (--express): TCs by class and the offset cycle
+typedef struct {
+    int express[MAX_TCS];
+    int n_express;
+    int preempt[MAX_TCS];
+    int n_preempt;
+    uint32_t offsets[MIX_MAX_OFFSETS];  // TP_MIX_ALONE = express frame by itself
+    int n_offsets;
+    int preempt_size;
+    uint64_t slots;
+    uint64_t contended;
+} mix_cfg_t;
+
 // Statistics
 static unsigned long tx_counts[MAX_TCS];
 static unsigned long total_tx = 0;
 
-// Parse MAC address string to bytes
-int parse_mac(const char *str, unsigned char *mac) {
-    return sscanf(str, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
-                  &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) == 6 ? 0 : -1;
-}
-
-// Calculate IP checksum
-unsigned short ip_checksum(unsigned short *buf, int len) {
-    unsigned long sum = 0;
-    while (len > 1) {
-        sum += *buf++;
-        len -= 2;
-    }
-    if (len == 1)
-        sum += *(unsigned char *)buf;
-    sum = (sum >> 16) + (sum & 0xFFFF);
-    sum += (sum >> 16);
-    return (unsigned short)(~sum);
-}
-
-// Build Ethernet frame with VLAN tag and UDP payload
-int build_frame(unsigned char *frame, unsigned char *dst_mac, unsigned char *src_mac,
-                int vlan_id, int pcp) {
-    int offset = 0;
-
-    // Ethernet header
-    memcpy(frame + offset, dst_mac, 6); offset += 6;
-    memcpy(frame + offset, src_mac, 6); offset += 6;
-
-    // 802.1Q VLAN tag
-    frame[offset++] = 0x81;
-    frame[offset++] = 0x00;
-    // TCI: PCP(3) + DEI(1) + VID(12)
-    unsigned short tci = ((pcp & 0x7) << 13) | (vlan_id & 0xFFF);
-    frame[offset++] = (tci >> 8) & 0xFF;
-    frame[offset++] = tci & 0xFF;
-
-    // EtherType: IPv4
-    frame[offset++] = 0x08;
-    frame[offset++] = 0x00;
-
-    // IP header (20 bytes)
-    int ip_start = offset;
-    frame[offset++] = 0x45;  // Version + IHL
-    frame[offset++] = pcp << 5;  // DSCP = PCP, ECN = 0
-
-    int ip_total_len = 20 + 8 + PAYLOAD_SIZE;  // IP + UDP + payload
-    frame[offset++] = (ip_total_len >> 8) & 0xFF;
-    frame[offset++] = ip_total_len & 0xFF;
-
-    frame[offset++] = 0x00; frame[offset++] = 0x00;  // ID
-    frame[offset++] = 0x00; frame[offset++] = 0x00;  // Flags + Fragment
-    frame[offset++] = 64;   // TTL
-    frame[offset++] = 17;   // Protocol: UDP
-    frame[offset++] = 0x00; frame[offset++] = 0x00;  // Checksum (placeholder)
-
-    // Source IP: 192.168.100.1
-    frame[offset++] = 192; frame[offset++] = 168; frame[offset++] = 100; frame[offset++] = 1;
-    // Dest IP: 192.168.100.2
-    frame[offset++] = 192; frame[offset++] = 168; frame[offset++] = 100; frame[offset++] = 2;
-
-    // Calculate IP checksum
-    unsigned short ip_cksum = ip_checksum((unsigned short *)(frame + ip_start), 20);
-    frame[ip_start + 10] = (ip_cksum >> 8) & 0xFF;
-    frame[ip_start + 11] = ip_cksum & 0xFF;
-
-    // UDP header (8 bytes)
-    int src_port = 10000 + pcp;
-    int dst_port = 20000 + pcp;
-    frame[offset++] = (src_port >> 8) & 0xFF;
-    frame[offset++] = src_port & 0xFF;
-    frame[offset++] = (dst_port >> 8) & 0xFF;
-    frame[offset++] = dst_port & 0xFF;
-
-    int udp_len = 8 + PAYLOAD_SIZE;
-    frame[offset++] = (udp_len >> 8) & 0xFF;
-    frame[offset++] = udp_len & 0xFF;
-    frame[offset++] = 0x00; frame[offset++] = 0x00;  // Checksum (optional for IPv4)
-
-    // Payload
-    for (int i = 0; i < PAYLOAD_SIZE; i++) {
-        frame[offset++] = i & 0xFF;
-    }
-
-    // Pad to minimum 60 bytes (64 with FCS, but we don't add FCS)
-    while (offset < 60) {
-        frame[offset++] = 0x00;
-    }
-
-    return offset;
-}
-
-// Get current time in nanoseconds
-static inline unsigned long get_time_ns(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
-}
-
-// Busy wait until target time
-static inline void wait_until(unsigned long target_ns) {
-    while (get_time_ns() < target_ns) {
-        // Spin
+// Published to the metrics exporter through a seqlock
+typedef struct {
+    uint64_t tx[MAX_TCS];
+    uint64_t send_errors;
+} sender_counters_t;
+
+static tp_seqlock_t counters_lock;
+static sender_counters_t counters;
+static tp_hist_t *late_hist;    // Send start minus scheduled time (ns)
+
+// Send loop stages (see tsnperf/prof.h)
+enum { STAGE_WAIT, STAGE_STAMP, STAGE_SEND };
+static const char *const sender_stages[] = { "wait", "stamp", "send", NULL };
+static tp_prof_t prof;
+
+static void render_metrics(tp_metrics_t *m, void *ctx) {
+    (void)ctx;
+    sender_counters_t snap;
+    tp_snapshot(&counters_lock, &snap, &counters, sizeof(snap));
+
+    char labels[32];
+    tp_metrics_family(m, "tsn_sender_frames", "counter", "Frames sent per TC");
+    for (int tc = 0; tc < MAX_TCS; tc++) {
+        if (!frame_lens[tc]) continue;
+        snprintf(labels, sizeof(labels), "tc=\"%d\"", tc);
+        tp_metrics_u64(m, "tsn_sender_frames_total", labels, snap.tx[tc]);
     }
+    tp_metrics_family(m, "tsn_sender_send_errors", "counter", "send() calls that failed");
+    tp_metrics_u64(m, "tsn_sender_send_errors_total", NULL, snap.send_errors);
+    tp_metrics_family(m, "tsn_sender_lateness_seconds", "histogram", "Send start behind the schedule");
+    tp_metrics_hist(m, "tsn_sender_lateness_seconds", NULL, late_hist, 1e-9);
+
+    tp_metrics_rt(m, "tsn_sender");
 }
 
 // Parse TC list string like "1,2,3,4,5,6,7"
@@ -153,51 +147,12 @@ int parse_tc_list(const char *str, int *tcs) {
     return count;
 }
 
-int main(int argc, char *argv[]) {
-    if (argc < 8) {
-        fprintf(stderr, "Usage: %s <interface> <dst_mac> <src_mac> <vlan_id> <tc_list> <pps> <duration>\n", argv[0]);
-        fprintf(stderr, "Example: %s enx00e04c681336 FA:AE:C9:26:A4:08 00:e0:4c:68:13:36 100 \"1,2,3,4,5,6,7\" 100 7\n", argv[0]);
-        return 1;
-    }
-
-    const char *ifname = argv[1];
-    const char *dst_mac_str = argv[2];
-    const char *src_mac_str = argv[3];
-    int vlan_id = atoi(argv[4]);
-    const char *tc_list_str = argv[5];
-    int pps = atoi(argv[6]);
-    int duration = atoi(argv[7]);
-
-    unsigned char dst_mac[6], src_mac[6];
-    if (parse_mac(dst_mac_str, dst_mac) < 0 || parse_mac(src_mac_str, src_mac) < 0) {
-        fprintf(stderr, "Invalid MAC address format\n");
-        return 1;
-    }
-
-    int tcs[MAX_TCS];
-    int num_tcs = parse_tc_list(tc_list_str, tcs);
-    if (num_tcs == 0) {
-        fprintf(stderr, "No TCs specified\n");
-        return 1;
-    }
-
-    // Set real-time scheduling
-    struct sched_param param;
-    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
-    if (sched_setscheduler(0, SCHED_FIFO, &param) < 0) {
-        fprintf(stderr, "Warning: Failed to set SCHED_FIFO (run as root): %s\n", strerror(errno));
-    }
-
-    // Lock memory
-    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
-        fprintf(stderr, "Warning: mlockall failed: %s\n", strerror(errno));
-    }
-
-    // Create raw socket
+// Raw socket bound to ifname, or -1
+static int open_socket(const char *ifname) {
     int sock = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
     if (sock < 0) {
         perror("socket");
-        return 1;
+        return -1;
     }
 
     // Get interface index
@@ -207,7 +162,7 @@ int main(int argc, char *argv[]) {
     if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0) {
         perror("ioctl SIOCGIFINDEX");
         close(sock);
-        return 1;
+        return -1;
     }
 
     // Bind to interface
@@ -219,62 +174,492 @@ int main(int argc, char *argv[]) {
     if (bind(sock, (struct sockaddr *)&sll, sizeof(sll)) < 0) {
         perror("bind");
         close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Parse "alone,0,2000,..." into the mix offset cycle. Returns the count.
+static int parse_offsets(const char *str, uint32_t *offsets) {
+    int count = 0;
+    char *copy = strdup(str);
+    for (char *token = strtok(copy, ","); token && count < MIX_MAX_OFFSETS; token = strtok(NULL, ",")) {
+        offsets[count++] = strcmp(token, "alone") == 0 ? TP_MIX_ALONE : (uint32_t)strtoul(token, NULL, 10);
+    }
+    free(copy);
+    return count;
+}
+
+// Split tc_list into express TCs (from --express) and preemptable ones
+static int mix_setup(mix_cfg_t *mix, const char *express, const int *tcs, int num_tcs) {
+    int list[MAX_TCS];
+    int n = parse_tc_list(express, list);
+    for (int i = 0; i < num_tcs; i++) {
+        int is_express = 0;
+        for (int k = 0; k < n; k++) is_express |= list[k] == tcs[i];
+        if (is_express) mix->express[mix->n_express++] = tcs[i];
+        else mix->preempt[mix->n_preempt++] = tcs[i];
+    }
+    return mix->n_express > 0 && mix->n_preempt > 0 ? 0 : -1;
+}
+
+// Map the arena near the interface (extra bytes on top of the histogram)
+// and carve the lateness histogram. Returns 0 on success.
+static int arena_setup(const char *ifname, size_t extra) {
+    if (tp_arena_init(&arena, sizeof(tp_hist_t) + extra + ARENA_HEADERS, ifname) != 0) {
+        fprintf(stderr, "Warning: no memory arena, frames on the heap\n");
+    }
+    fprintf(stderr, "Arena: %zu MB %s pages, node %d (NIC node %d)%s\n", arena.size >> 20,
+            tp_arena_page_name(arena.page), arena.node, arena.nic_node,
+            arena.nic_node >= 0 && !arena.bound ? ", not bound" : "");
+    late_hist = tp_arena_alloc(&arena, "histograms", sizeof(tp_hist_t));
+    return late_hist ? 0 : -1;
+}
+
+// Send one frame and account for it
+static inline void send_frame(int sock, int tc, uint8_t *frame, int len, uint32_t seq, uint64_t late) {
+    uint64_t t0 = tp_prof_begin();
+    tp_frame_stamp(frame, seq, tp_real_ns());
+    tp_prof_end(&prof, STAGE_STAMP, t0, 1);
+
+    t0 = tp_prof_begin();
+    ssize_t sent = send(sock, frame, len, 0);
+    tp_prof_end(&prof, STAGE_SEND, t0, 1);
+
+    tp_seqlock_write_begin(&counters_lock);
+    if (sent > 0) {
+        tx_counts[tc]++;
+        total_tx++;
+        counters.tx[tc]++;
+    } else {
+        counters.send_errors++;
+    }
+    tp_hist_add(late_hist, late);
+    tp_seqlock_write_end(&counters_lock);
+}
+
+// Send the preemption mix: one slot per interval until duration_ns
+static void play_mix(const int *socks, mix_cfg_t *mix, uint64_t start, uint64_t interval_ns,
+                     uint64_t duration_ns) {
+    uint64_t next_send = start;
+    uint32_t slot = 0;
+
+    for (uint64_t k = 0; tp_mono_ns() - start < duration_ns; k++) {
+        uint32_t offset = mix->offsets[k % mix->n_offsets];
+        int etc = mix->express[k % mix->n_express];
+
+        uint64_t t0 = tp_prof_begin();
+        uint64_t now = tp_mono_ns();
+        uint64_t late = now > next_send ? now - next_send : 0;
+        tp_spin_until_ns(next_send);
+        tp_prof_end(&prof, STAGE_WAIT, t0, 1);
+
+        tp_mix_tag_t tag = { .cls = TP_MIX_PREEMPTABLE, .offset_ns = 0, .slot = slot };
+        if (offset != TP_MIX_ALONE) {
+            int ptc = mix->preempt[mix->contended % mix->n_preempt];
+            tp_mix_tag_write(frames[ptc] + TP_PAYLOAD_OFFSET, &tag);
+            send_frame(socks[ptc], ptc, frames[ptc], frame_lens[ptc], (uint32_t)tx_counts[ptc], late);
+
+            t0 = tp_prof_begin();
+            uint64_t at = next_send + offset;
+            now = tp_mono_ns();
+            late = now > at ? now - at : 0;
+            tp_spin_until_ns(at);
+            tp_prof_end(&prof, STAGE_WAIT, t0, 1);
+            mix->contended++;
+            slot++;
+        }
+
+        tag.cls = TP_MIX_EXPRESS;
+        tag.offset_ns = offset;
+        tp_mix_tag_write(frames[etc] + TP_PAYLOAD_OFFSET, &tag);
+        send_frame(socks[etc], etc, frames[etc], frame_lens[etc], (uint32_t)tx_counts[etc], late);
+
+        mix->slots++;
+        next_send += interval_ns;
+    }
+}
+
+// Play a mapped timeline; returns the number of passes started
+static uint64_t play_timeline(int sock, const tp_tl_file_t *tl, uint8_t *tpl_frames,
+                              uint64_t start, uint64_t limit_ns) {
+    const tp_tl_hdr_t *h = tl->hdr;
+    const tp_tl_rec_t *recs = tl->recs;
+    uint64_t n = h->n_records;
+    uint64_t passes = 0;
+
+    for (uint64_t pass = 0; pass * h->length_ns < limit_ns; pass++) {
+        uint64_t pass_ns = pass * h->length_ns;
+        passes++;
+        for (uint64_t i = 0; i < n; i++) {
+            const tp_tl_rec_t *r = &recs[i];
+            if (i + TIMELINE_PREFETCH < n) __builtin_prefetch(&recs[i + TIMELINE_PREFETCH]);
+            if (pass_ns + r->launch_ns >= limit_ns) return passes;
+
+            uint64_t t0 = tp_prof_begin();
+            uint64_t at = start + pass_ns + r->launch_ns;
+            uint64_t now = tp_mono_ns();
+            uint64_t late = now > at ? now - at : 0;
+            tp_spin_until_ns(at);
+            tp_prof_end(&prof, STAGE_WAIT, t0, 1);
+
+            const tp_tl_tpl_t *t = &tl->tpls[r->tpl];
+            send_frame(sock, t->tc, tpl_frames + (size_t)r->tpl * TP_TL_FRAME_CAP, t->len,
+                       r->seq + (uint32_t)pass * tl->flows[r->flow], late);
+        }
+        if (!h->loop) break;
+    }
+    return passes;
+}
+
+// Common head of the JSON result: per-TC counts, total, duration and rate
+static void result_begin(tp_json_t *j, double duration) {
+    tp_json_init(j);
+    tp_json_obj_begin(j, NULL);
+    tp_json_bool(j, "success", 1);
+    tp_json_obj_begin(j, "sent");
+    for (int i = 0; i < MAX_TCS; i++) {
+        if (tx_counts[i] > 0) {
+            char key[4];
+            snprintf(key, sizeof(key), "%d", i);
+            tp_json_u64(j, key, tx_counts[i]);
+        }
+    }
+    tp_json_obj_end(j);
+    tp_json_u64(j, "total", total_tx);
+    tp_json_f64(j, "duration", duration, 3);
+    tp_json_f64(j, "actual_pps", duration > 0 ? total_tx / duration : 0, 1);
+}
+
+static void result_end(tp_json_t *j) {
+    tp_arena_json(&arena, j, "arena");
+    if (TP_PROFILE) {
+        tp_prof_t *profs[] = { &prof };
+        tp_prof_json(j, "profile", profs, 1);
+    }
+    tp_json_obj_end(j);
+    tp_json_flush(j, stdout);
+    tp_json_free(j);
+}
+
+// --timeline mode; pos = <interface> [duration]
+static int run_timeline(const char *path, int npos, char **pos, uint64_t phase_ns, int cpu,
+                        const char *metrics_spec) {
+    if (npos < 1) {
+        fprintf(stderr, "Usage: traffic-sender --timeline <file> <interface> [duration] [--phase-ns <ns>] [--cpu <n>] [--metrics <port|unix:path>]\n");
+        return 1;
+    }
+    const char *ifname = pos[0];
+    double duration = npos > 1 ? atof(pos[1]) : 0;
+
+    // Map before tp_setup_realtime() so mlockall() pins the records too
+    tp_tl_file_t tl;
+    char err[256];
+    if (tp_tl_open(&tl, path, err, sizeof(err)) != 0) {
+        fprintf(stderr, "%s: %s\n", path, err);
+        return 1;
+    }
+    const tp_tl_hdr_t *h = tl.hdr;
+    madvise(tl.map, tl.len, MADV_WILLNEED);
+
+    // Writable copies of the templates for stamping; records stay mapped
+    size_t tpl_bytes = (size_t)h->n_templates * TP_TL_FRAME_CAP;
+    uint8_t *tpl_frames = arena_setup(ifname, tpl_bytes) == 0 ? tp_arena_alloc(&arena, "templates", tpl_bytes) : NULL;
+    if (!tpl_frames) {
+        tp_tl_close(&tl);
+        return 1;
+    }
+    for (uint32_t i = 0; i < h->n_templates; i++) {
+        const tp_tl_tpl_t *t = &tl.tpls[i];
+        memcpy(tpl_frames + (size_t)i * TP_TL_FRAME_CAP, t->frame, t->len);
+        if (t->len > frame_lens[t->tc]) frame_lens[t->tc] = t->len;
+    }
+
+    tp_setup_realtime(0, 1);
+    if (cpu >= 0 && tp_pin_thread(cpu) != 0) fprintf(stderr, "Warning: could not pin to CPU %d\n", cpu);
+
+    int sock = open_socket(ifname);
+    if (sock < 0) {
+        tp_tl_close(&tl);
+        return 1;
+    }
+
+    uint64_t limit_ns = duration > 0 ? (uint64_t)(duration * 1e9) : h->length_ns;
+    fprintf(stderr, "Playing timeline %s: %llu records, %llu ns pass, digest %08x%s\n", path,
+            (unsigned long long)h->n_records, (unsigned long long)h->length_ns, h->digest,
+            h->loop ? ", looping" : "");
+
+    tp_prof_init(&prof, "sender", sender_stages);
+
+    tp_metrics_server_t metrics_server = { .fd = -1 };
+    if (metrics_spec && tp_metrics_start(&metrics_server, metrics_spec, render_metrics, NULL) != 0) {
+        fprintf(stderr, "Warning: could not serve metrics on %s\n", metrics_spec);
+    }
+
+    // Start on the next align_ns boundary (+ phase) of the wall clock
+    uint64_t real = tp_real_ns();
+    uint64_t start = tp_mono_ns() + TIMELINE_LEAD_NS;
+    if (h->align_ns) {
+        uint64_t phase = phase_ns % h->align_ns;
+        uint64_t first = real + TIMELINE_LEAD_NS - phase;
+        uint64_t target = (first + h->align_ns - 1) / h->align_ns * h->align_ns + phase;
+        start += target - (real + TIMELINE_LEAD_NS);
+    }
+
+    uint64_t passes = play_timeline(sock, &tl, tpl_frames, start, limit_ns);
+
+    uint64_t end_time = tp_mono_ns();
+    tp_prof_thread_done(&prof);
+
+    char digest[16];
+    snprintf(digest, sizeof(digest), "%08x", h->digest);
+
+    tp_json_t j;
+    result_begin(&j, end_time > start ? (end_time - start) / 1e9 : 0);
+    tp_json_obj_begin(&j, "timeline");
+    tp_json_str(&j, "path", path);
+    tp_json_str(&j, "digest", digest);
+    tp_json_u64(&j, "records", h->n_records);
+    tp_json_u64(&j, "templates", h->n_templates);
+    tp_json_u64(&j, "passes", passes);
+    tp_json_u64(&j, "length_ns", h->length_ns);
+    tp_json_u64(&j, "align_ns", h->align_ns);
+    tp_json_obj_end(&j);
+    result_end(&j);
+
+    tp_metrics_stop(&metrics_server);
+    close(sock);
+    tp_tl_close(&tl);
+    tp_arena_destroy(&arena);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        {"metrics", required_argument, NULL, 'm'},
+        {"frame-size", required_argument, NULL, 'f'},
+        {"prbs", optional_argument, NULL, 'P'},
+        {"timeline", required_argument, NULL, 't'},
+        {"phase-ns", required_argument, NULL, 'p'},
+        {"cpu", required_argument, NULL, 'c'},
+        {"express", required_argument, NULL, 'x'},
+        {"preempt-size", required_argument, NULL, 'z'},
+        {"offsets", required_argument, NULL, 'o'},
+        {NULL, 0, NULL, 0}
+    };
+
+    const char *metrics_spec = NULL;
+    int frame_size = 0;
+    int prbs = 0;
+    uint32_t prbs_seed = PRBS_DEFAULT_SEED;
+    const char *timeline_path = NULL;
+    uint64_t phase_ns = 0;
+    int cpu = -1;
+    const char *express = NULL;
+    const char *offsets = MIX_DEFAULT_OFFSETS;
+    mix_cfg_t mix = { .preempt_size = TP_MAX_FRAME_LEN };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'm': metrics_spec = optarg; break;
+        case 'f': frame_size = atoi(optarg); break;
+        case 'P':
+            prbs = 1;
+            if (optarg) prbs_seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 't': timeline_path = optarg; break;
+        case 'p': phase_ns = strtoull(optarg, NULL, 10); break;
+        case 'c': cpu = atoi(optarg); break;
+        case 'x': express = optarg; break;
+        case 'z': mix.preempt_size = atoi(optarg); break;
+        case 'o': offsets = optarg; break;
+        default: return 1;
+        }
+    }
+    if (timeline_path) return run_timeline(timeline_path, argc - optind, argv + optind, phase_ns, cpu, metrics_spec);
+
+    if (frame_size == 0) frame_size = prbs ? PRBS_FRAME_SIZE : express ? TP_MIX_FRAME_MIN : TP_MIN_FRAME_LEN;
+    if (frame_size < TP_MIN_FRAME_LEN || frame_size > TP_MAX_FRAME_LEN ||
+        (prbs && frame_size < TP_PAYLOAD_OFFSET + TP_PAYLOAD_CHECK_MIN)) {
+        fprintf(stderr, "Invalid --frame-size %d (%d..%d, --prbs needs >= %d)\n", frame_size,
+                TP_MIN_FRAME_LEN, TP_MAX_FRAME_LEN, TP_PAYLOAD_OFFSET + TP_PAYLOAD_CHECK_MIN);
+        return 1;
+    }
+    // The mix tag takes the place of the PRBS check header
+    if (express && (prbs || frame_size < TP_MIX_FRAME_MIN || mix.preempt_size < TP_MIX_FRAME_MIN ||
+                    mix.preempt_size > TP_MAX_FRAME_LEN)) {
+        fprintf(stderr, "--express: no --prbs; --frame-size and --preempt-size %d..%d\n", TP_MIX_FRAME_MIN,
+                TP_MAX_FRAME_LEN);
+        return 1;
+    }
+
+    // Positional arguments (getopt moves them to the end)
+    char **pos = argv + optind;
+    if (argc - optind < 7) {
+        fprintf(stderr, "Usage: %s <interface> <dst_mac> <src_mac> <vlan_id> <tc_list> <pps> <duration> [--metrics <port|unix:path>]\n", argv[0]);
+        fprintf(stderr, "       [--frame-size <bytes>] [--prbs[=seed]] [--cpu <n>]\n");
+        fprintf(stderr, "       [--express <tc,...> [--preempt-size <bytes>] [--offsets <ns|alone,...>]]\n");
+        fprintf(stderr, "       %s --timeline <file> <interface> [duration] [--phase-ns <ns>]\n", argv[0]);
+        fprintf(stderr, "Example: %s enx00e04c681336 FA:AE:C9:26:A4:08 00:e0:4c:68:13:36 100 \"1,2,3,4,5,6,7\" 100 7\n", argv[0]);
+        return 1;
+    }
+
+    const char *ifname = pos[0];
+    const char *dst_mac_str = pos[1];
+    const char *src_mac_str = pos[2];
+    int vlan_id = atoi(pos[3]);
+    const char *tc_list_str = pos[4];
+    int pps = atoi(pos[5]);
+    int duration = atoi(pos[6]);
+
+    uint8_t dst_mac[6], src_mac[6];
+    if (tp_parse_mac(dst_mac_str, dst_mac) < 0 || tp_parse_mac(src_mac_str, src_mac) < 0) {
+        fprintf(stderr, "Invalid MAC address format\n");
         return 1;
     }
 
+    int tcs[MAX_TCS];
+    int num_tcs = parse_tc_list(tc_list_str, tcs);
+    if (num_tcs == 0) {
+        fprintf(stderr, "No TCs specified\n");
+        return 1;
+    }
+
+    unsigned long interval_ns = 1000000000UL / pps;
+    if (express) {
+        if (mix_setup(&mix, express, tcs, num_tcs) != 0) {
+            fprintf(stderr, "--express needs express and preemptable TCs in the TC list\n");
+            return 1;
+        }
+        mix.n_offsets = parse_offsets(offsets, mix.offsets);
+        for (int i = 0; i < mix.n_offsets; i++) {
+            if (mix.offsets[i] != TP_MIX_ALONE && mix.offsets[i] >= interval_ns) mix.n_offsets = 0;
+        }
+        if (mix.n_offsets == 0) {
+            fprintf(stderr, "Invalid --offsets %s (offsets must be below the %lu ns slot)\n", offsets, interval_ns);
+            return 1;
+        }
+    }
+
+    // Templates on 2 MB pages near the NIC, then real-time scheduling and locked memory
+    if (arena_setup(ifname, sizeof(*frames) * MAX_TCS) != 0 ||
+        !(frames = tp_arena_alloc(&arena, "templates", sizeof(*frames) * MAX_TCS))) {
+        fprintf(stderr, "Out of memory for frame templates\n");
+        return 1;
+    }
+    tp_setup_realtime(0, 1);
+    if (cpu >= 0 && tp_pin_thread(cpu) != 0) fprintf(stderr, "Warning: could not pin to CPU %d\n", cpu);
+
+    int sock = open_socket(ifname);
+    if (sock < 0) return 1;
+
+    // The mix gives every TC its own socket, so the qdisc sees the TC as priority
+    int socks[MAX_TCS];
+    for (int tc = 0; tc < MAX_TCS; tc++) socks[tc] = sock;
+    for (int i = 0; express && i < num_tcs; i++) {
+        int prio = tcs[i];
+        if (socks[prio] != sock) continue;
+        socks[prio] = open_socket(ifname);
+        if (socks[prio] < 0) return 1;
+        if (setsockopt(socks[prio], SOL_SOCKET, SO_PRIORITY, &prio, sizeof(prio)) != 0) {
+            fprintf(stderr, "Warning: could not set priority %d: %s\n", prio, strerror(errno));
+        }
+    }
+
     // Pre-build frames for each TC
     for (int i = 0; i < num_tcs; i++) {
-        frame_lens[tcs[i]] = build_frame(frames[tcs[i]], dst_mac, src_mac, vlan_id, tcs[i]);
+        tp_frame_spec_t spec;
+        tp_frame_spec_init(&spec, dst_mac, src_mac, vlan_id, tcs[i]);
+        int preemptable = 0;
+        for (int k = 0; k < mix.n_preempt; k++) preemptable |= mix.preempt[k] == tcs[i];
+        spec.payload_len = (preemptable ? mix.preempt_size : frame_size) - TP_PAYLOAD_OFFSET;
+        frame_lens[tcs[i]] = tp_frame_build(frames[tcs[i]], FRAME_SIZE, &spec);
+        if (prbs) {
+            tp_payload_fill(frames[tcs[i]] + TP_PAYLOAD_OFFSET, spec.payload_len,
+                            tp_payload_seed(prbs_seed, tcs[i]));
+        }
     }
 
-    // Calculate interval
-    unsigned long interval_ns = 1000000000UL / pps;
     unsigned long duration_ns = (unsigned long)duration * 1000000000UL;
 
-    fprintf(stderr, "Starting traffic: %d TCs, %d PPS, %d sec, interval=%lu ns\n",
-            num_tcs, pps, duration, interval_ns);
+    fprintf(stderr, "Starting traffic: %d TCs, %d PPS, %d sec, interval=%lu ns, %d-byte frames%s\n",
+            num_tcs, pps, duration, interval_ns, frame_size, prbs ? ", PRBS-31 payload" : "");
+    if (express) {
+        fprintf(stderr, "Preemption mix: %d express, %d preemptable TCs (%d-byte frames), offsets %s\n",
+                mix.n_express, mix.n_preempt, mix.preempt_size, offsets);
+    }
 
     // Initialize stats
     memset(tx_counts, 0, sizeof(tx_counts));
     total_tx = 0;
 
-    unsigned long start_time = get_time_ns();
+    tp_prof_init(&prof, "sender", sender_stages);
+
+    tp_metrics_server_t metrics_server = { .fd = -1 };
+    if (metrics_spec && tp_metrics_start(&metrics_server, metrics_spec, render_metrics, NULL) != 0) {
+        fprintf(stderr, "Warning: could not serve metrics on %s\n", metrics_spec);
+    }
+
+    unsigned long start_time = tp_mono_ns();
     unsigned long next_send = start_time;
     int tc_idx = 0;
 
-    while (get_time_ns() - start_time < duration_ns) {
-        // Wait for next send time
-        wait_until(next_send);
-
-        // Send packet
-        int tc = tcs[tc_idx % num_tcs];
-        ssize_t sent = send(sock, frames[tc], frame_lens[tc], 0);
-        if (sent > 0) {
-            tx_counts[tc]++;
-            total_tx++;
+    if (express) {
+        play_mix(socks, &mix, start_time, interval_ns, duration_ns);
+    } else {
+        while (tp_mono_ns() - start_time < duration_ns) {
+            // Wait for next send time
+            uint64_t t0 = tp_prof_begin();
+            uint64_t now = tp_mono_ns();
+            uint64_t late = now > next_send ? now - next_send : 0;
+            tp_spin_until_ns(next_send);
+            tp_prof_end(&prof, STAGE_WAIT, t0, 1);
+
+            // Send packet
+            int tc = tcs[tc_idx % num_tcs];
+            send_frame(sock, tc, frames[tc], frame_lens[tc], (uint32_t)tx_counts[tc], late);
+
+            tc_idx++;
+            next_send += interval_ns;
         }
-
-        tc_idx++;
-        next_send += interval_ns;
     }
 
-    unsigned long end_time = get_time_ns();
+    unsigned long end_time = tp_mono_ns();
+    tp_prof_thread_done(&prof);
     double actual_duration = (end_time - start_time) / 1e9;
-    double actual_pps = total_tx / actual_duration;
 
     // Print JSON result
-    printf("{\"success\":true,\"sent\":{");
-    int first = 1;
-    for (int i = 0; i < MAX_TCS; i++) {
-        if (tx_counts[i] > 0) {
-            if (!first) printf(",");
-            printf("\"%d\":%lu", i, tx_counts[i]);
-            first = 0;
+    tp_json_t j;
+    result_begin(&j, actual_duration);
+    tp_json_u64(&j, "frame_size", frame_size);
+    tp_json_bool(&j, "prbs", prbs);
+    if (express) {
+        tp_json_obj_begin(&j, "mix");
+        tp_json_arr_begin(&j, "express");
+        for (int i = 0; i < mix.n_express; i++) tp_json_u64(&j, NULL, mix.express[i]);
+        tp_json_arr_end(&j);
+        tp_json_arr_begin(&j, "preemptable");
+        for (int i = 0; i < mix.n_preempt; i++) tp_json_u64(&j, NULL, mix.preempt[i]);
+        tp_json_arr_end(&j);
+        tp_json_u64(&j, "preempt_size", mix.preempt_size);
+        tp_json_arr_begin(&j, "offsets_ns");
+        for (int i = 0; i < mix.n_offsets; i++) {
+            if (mix.offsets[i] == TP_MIX_ALONE) tp_json_str(&j, NULL, "alone");
+            else tp_json_u64(&j, NULL, mix.offsets[i]);
         }
+        tp_json_arr_end(&j);
+        tp_json_u64(&j, "slots", mix.slots);
+        tp_json_u64(&j, "contended", mix.contended);
+        tp_json_u64(&j, "alone", mix.slots - mix.contended);
+        tp_json_obj_end(&j);
     }
-    printf("},\"total\":%lu,\"duration\":%.3f,\"actual_pps\":%.1f}\n",
-           total_tx, actual_duration, actual_pps);
+    result_end(&j);
 
+    tp_metrics_stop(&metrics_server);
+    for (int tc = 0; tc < MAX_TCS; tc++) {
+        if (socks[tc] != sock) close(socks[tc]);
+    }
     close(sock);
+    tp_arena_destroy(&arena);
     return 0;
 }
@@ -2,12 +2,57 @@
 """
 Precision Traffic Sender for TSN Testing
 Sends UDP packets with VLAN tags using raw sockets
+
+Frames are built by libtsnperf (server/tsnperf, shared with traffic-sender.c)
+when the CMake build is present; the pure-Python builder below is the fallback.
 """
+import os
 import sys
 import time
 import json
 import socket
 import struct
+import ctypes
+
+PAYLOAD_MAGIC = 0x5453  # "TS": magic(2) + seq(4) + tx_ns(8), see tsnperf/frame.h
+PAYLOAD_HDR_LEN = 14
+PAYLOAD_OFFSET = 46
+
+
+class FrameSpec(ctypes.Structure):
+    """Mirror of tp_frame_spec_t"""
+    _fields_ = [
+        ('dst_mac', ctypes.c_uint8 * 6),
+        ('src_mac', ctypes.c_uint8 * 6),
+        ('vlan_id', ctypes.c_int),
+        ('pcp', ctypes.c_int),
+        ('src_ip', ctypes.c_uint32),
+        ('dst_ip', ctypes.c_uint32),
+        ('src_port', ctypes.c_uint16),
+        ('dst_port', ctypes.c_uint16),
+        ('payload_len', ctypes.c_int),
+    ]
+
+
+def load_tsnperf():
+    """Load libtsnperf.so from the CMake build directory, if built"""
+    here = os.path.dirname(os.path.abspath(__file__))
+    for d in (os.environ.get('TSNPERF_BIN_DIR'), os.path.join(here, 'build'), here):
+        if not d:
+            continue
+        path = os.path.join(d, 'libtsnperf.so')
+        if os.path.exists(path):
+            try:
+                lib = ctypes.CDLL(path)
+                lib.tp_frame_build.argtypes = [ctypes.c_char_p, ctypes.c_size_t, ctypes.POINTER(FrameSpec)]
+                lib.tp_frame_build.restype = ctypes.c_int
+                return lib
+            except OSError:
+                pass
+    return None
+
+
+TSNPERF = load_tsnperf()
 
 def calculate_checksum(data):
     """Calculate IP/UDP checksum"""
@@ -18,8 +63,26 @@ def calculate_checksum(data):
     s += s >> 16
     return ~s & 0xffff
 
-def build_udp_frame(dst_mac, src_mac, vlan_id, pcp, src_ip, dst_ip, src_port, dst_port, payload_size=10):
+def build_udp_frame(dst_mac, src_mac, vlan_id, pcp, src_ip, dst_ip, src_port, dst_port, payload_size=PAYLOAD_HDR_LEN):
     """Build Ethernet frame with VLAN tag containing UDP packet"""
+    payload_size = max(payload_size, PAYLOAD_HDR_LEN)
+
+    if TSNPERF:
+        spec = FrameSpec()
+        spec.dst_mac[:] = bytes.fromhex(dst_mac.replace(':', '').replace('-', ''))
+        spec.src_mac[:] = bytes.fromhex(src_mac.replace(':', '').replace('-', ''))
+        spec.vlan_id = vlan_id
+        spec.pcp = pcp
+        spec.src_ip = struct.unpack('>I', socket.inet_aton(src_ip))[0]
+        spec.dst_ip = struct.unpack('>I', socket.inet_aton(dst_ip))[0]
+        spec.src_port = src_port
+        spec.dst_port = dst_port
+        spec.payload_len = payload_size
+        buf = ctypes.create_string_buffer(1518)
+        n = TSNPERF.tp_frame_build(buf, len(buf), ctypes.byref(spec))
+        if n > 0:
+            return buf.raw[:n]
+
     # Ethernet header
     dst = bytes.fromhex(dst_mac.replace(':', '').replace('-', ''))
     src = bytes.fromhex(src_mac.replace(':', '').replace('-', ''))
@@ -31,8 +94,8 @@ def build_udp_frame(dst_mac, src_mac, vlan_id, pcp, src_ip, dst_ip, src_port, ds
     # EtherType for IPv4
     ethertype = struct.pack('>H', 0x0800)
 
-    # UDP payload
-    payload = bytes([i % 256 for i in range(payload_size)])
+    # UDP payload: seq/timestamp header, stamped per send
+    payload = struct.pack('>H', PAYLOAD_MAGIC) + bytes(payload_size - 2)
 
     # UDP header (8 bytes)
     udp_length = 8 + len(payload)
@@ -74,12 +137,17 @@ def build_udp_frame(dst_mac, src_mac, vlan_id, pcp, src_ip, dst_ip, src_port, ds
 
     return frame
 
+def stamp_frame(frame, seq):
+    """Write sequence number and CLOCK_REALTIME tx timestamp into the payload header"""
+    struct.pack_into('>IQ', frame, PAYLOAD_OFFSET + 2, seq & 0xFFFFFFFF, time.time_ns())
+
+
 def busy_wait_until(target_time):
     """Busy-wait for precise timing"""
     while time.monotonic() < target_time:
         pass
 
-def send_traffic(interface, dst_mac, src_mac, vlan_id, tc_list, pps, duration, payload_size=10):
+def send_traffic(interface, dst_mac, src_mac, vlan_id, tc_list, pps, duration, payload_size=PAYLOAD_HDR_LEN):
     """Send UDP traffic with VLAN tags"""
     try:
         sock = socket.socket(socket.AF_PACKET, socket.SOCK_RAW, socket.htons(0x0003))
@@ -92,12 +160,12 @@ def send_traffic(interface, dst_mac, src_mac, vlan_id, tc_list, pps, duration, p
     # Pre-build frames for each TC
     frames = {}
     for tc in tc_list:
-        frames[tc] = build_udp_frame(
+        frames[tc] = bytearray(build_udp_frame(
             dst_mac, src_mac, vlan_id, tc,
             '192.168.100.1', '192.168.100.2',  # Dummy IPs
             10000 + tc, 20000 + tc,  # Ports based on TC
             payload_size
-        )
+        ))
 
     stats = {tc: 0 for tc in tc_list}
     total = 0
@@ -122,6 +190,7 @@ def send_traffic(interface, dst_mac, src_mac, vlan_id, tc_list, pps, duration, p
 
             tc = tc_list[tc_idx % num_tcs]
             try:
+                stamp_frame(frames[tc], stats[tc])
                 sock.send(frames[tc])
                 stats[tc] += 1
                 total += 1
@@ -160,6 +229,6 @@ if __name__ == '__main__':
     tc_list = json.loads(sys.argv[5])
     pps = int(sys.argv[6])
     duration = int(sys.argv[7])
-    payload_size = int(sys.argv[8]) if len(sys.argv) > 8 else 10
+    payload_size = int(sys.argv[8]) if len(sys.argv) > 8 else PAYLOAD_HDR_LEN
 
     send_traffic(interface, dst_mac, src_mac, vlan_id, tc_list, pps, duration, payload_size)
@@ -3,6 +3,7 @@ import cors from 'cors';
 import { spawn, execSync } from 'child_process';
 import path from 'path';
 import { fileURLToPath } from 'url';
+import { resolveBinary } from './native-binaries.js';
 
 const __dirname = path.dirname(fileURLToPath(import.meta.url));
 const app = express();
@@ -44,7 +45,7 @@ app.get('/api/traffic/interfaces', (req, res) => {
 
 // Precision C sender endpoint
 app.post('/api/traffic/start-precision', (req, res) => {
-  const { interface: ifaceName, dstMac, srcMac, vlanId = 100, tcList = [1,2,3,4,5,6,7], packetsPerSecond = 100, duration = 7 } = req.body;
+  const { interface: ifaceName, dstMac, srcMac, vlanId = 100, tcList = [1,2,3,4,5,6,7], packetsPerSecond = 100, duration = 7, frameSize, prbs = false } = req.body;
 
   if (!ifaceName || !dstMac) return res.status(400).json({ error: 'Interface and dstMac required' });
 
@@ -56,12 +57,16 @@ app.post('/api/traffic/start-precision', (req, res) => {
 
   const sourceMac = srcMac || getInterfaceMac(ifaceName);
   const tcListStr = Array.isArray(tcList) ? tcList.join(',') : String(tcList);
-  const senderPath = path.join(__dirname, 'traffic-sender');
+  const senderPath = resolveBinary('traffic-sender');
 
-  console.log(`Starting C sender: sudo ${senderPath} ${ifaceName} ${dstMac} ${sourceMac} ${vlanId} "${tcListStr}" ${packetsPerSecond} ${duration}`);
+  const args = [ifaceName, dstMac, sourceMac, String(vlanId), tcListStr, String(packetsPerSecond), String(duration)];
+  if (frameSize) args.push('--frame-size', String(frameSize));
+  if (prbs) args.push(prbs === true ? '--prbs' : `--prbs=${Number(prbs)}`);
+
+  console.log(`Starting C sender: sudo ${senderPath} ${args.join(' ')}`);
 
   try {
-    cSenderProcess = spawn('sudo', [senderPath, ifaceName, dstMac, sourceMac, String(vlanId), tcListStr, String(packetsPerSecond), String(duration)], {
+    cSenderProcess = spawn('sudo', [senderPath, ...args], {
       stdio: ['ignore', 'pipe', 'pipe']
     });
 
@@ -85,7 +90,7 @@ app.post('/api/traffic/start-precision', (req, res) => {
       cSenderProcess = null;
     });
 
-    res.json({ success: true, message: 'Precision traffic started (C)', config: { interface: ifaceName, dstMac, srcMac: sourceMac, vlanId, tcList, packetsPerSecond, duration } });
+    res.json({ success: true, message: 'Precision traffic started (C)', config: { interface: ifaceName, dstMac, srcMac: sourceMac, vlanId, tcList, packetsPerSecond, duration, frameSize, prbs } });
   } catch (err) {
     res.status(500).json({ error: err.message });
   }
@@ -0,0 +1,141 @@
+/*
+ * Analytical TAS/CBS latency bounds (network calculus) for one egress port
+ * Build: cmake -S . -B build && cmake --build build   (see CMakeLists.txt)
+ * Run: ./tsn-bound [--link mbps] [--gcl gates:ns,...] [--cycle ns] [--no-guard]
+ *                  [--be-frame bytes] [--cbs tc:kbps]... [--stream tc:burst:kbps[:frame]]...
+ * Example: ./tsn-bound --gcl 0x80:125000,0x7f:875000 --stream 7:128:512:64 --cbs 6:20000
+ *
+ * Streams are token buckets: burst in bytes, rate in kbps, frame = largest
+ * frame in bytes as captured (default 1518). Prints one JSON line with a
+ * per-TC service curve, delay and backlog bound; see tsnperf/bound.h.
+ */
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tsnperf/bound.h"
+#include "tsnperf/frame.h"
+#include "tsnperf/gcl.h"
+#include "tsnperf/json.h"
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--link mbps] [--gcl gates:ns,...] [--cycle ns] [--no-guard] [--be-frame bytes]\n", prog);
+    fprintf(stderr, "          [--cbs tc:idle_kbps]... [--stream tc:burst_bytes:rate_kbps[:max_frame]]...\n");
+    fprintf(stderr, "Example: %s --gcl 0x80:125000,0x7f:875000 --stream 7:128:512:64 --cbs 6:20000\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        {"link", required_argument, NULL, 'l'},
+        {"gcl", required_argument, NULL, 'g'},
+        {"cycle", required_argument, NULL, 'c'},
+        {"no-guard", no_argument, NULL, 'n'},
+        {"be-frame", required_argument, NULL, 'b'},
+        {"cbs", required_argument, NULL, 'C'},
+        {"stream", required_argument, NULL, 's'},
+        {NULL, 0, NULL, 0}
+    };
+
+    tp_bound_cfg_t cfg;
+    tp_bound_cfg_init(&cfg, 1000);
+    const char *gcl_spec = NULL;
+    uint64_t cycle_ns = 0;
+
+    // Streams and CBS need the final link/frame settings; parse them after
+    char *streams[256];
+    char *slopes[TP_GCL_MAX_TC * 2];
+    int n_streams = 0, n_slopes = 0;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'l': cfg.link_mbps = (uint32_t)atoi(optarg); break;
+        case 'g': gcl_spec = optarg; break;
+        case 'c': cycle_ns = strtoull(optarg, NULL, 10); break;
+        case 'n': cfg.guard_band = 0; break;
+        case 'b': cfg.be_frame = (uint32_t)atoi(optarg); break;
+        case 'C': if (n_slopes < (int)(sizeof(slopes) / sizeof(slopes[0]))) slopes[n_slopes++] = optarg; break;
+        case 's': if (n_streams < (int)(sizeof(streams) / sizeof(streams[0]))) streams[n_streams++] = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (cfg.link_mbps == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    tp_gcl_t gcl;
+    if (gcl_spec) {
+        if (tp_gcl_parse(&gcl, gcl_spec, cycle_ns) != 0) {
+            fprintf(stderr, "Invalid GCL: %s\n", gcl_spec);
+            return 1;
+        }
+        cfg.gcl = &gcl;
+    }
+
+    for (int i = 0; i < n_slopes; i++) {
+        int tc;
+        double kbps;
+        if (sscanf(slopes[i], "%d:%lf", &tc, &kbps) != 2 || tc < 0 || tc >= TP_GCL_MAX_TC) {
+            fprintf(stderr, "Invalid CBS spec: %s\n", slopes[i]);
+            return 1;
+        }
+        cfg.idle_slope_mbps[tc] = kbps / 1000.0;
+    }
+
+    for (int i = 0; i < n_streams; i++) {
+        int tc;
+        double burst, kbps;
+        unsigned frame = TP_MAX_FRAME_LEN;
+        if (sscanf(streams[i], "%d:%lf:%lf:%u", &tc, &burst, &kbps, &frame) < 3 || tc < 0 || tc >= TP_GCL_MAX_TC) {
+            fprintf(stderr, "Invalid stream spec: %s\n", streams[i]);
+            return 1;
+        }
+        tp_bound_add_stream(&cfg, tc, burst, kbps / 1000.0, frame);
+    }
+
+    tp_bound_t bounds[TP_GCL_MAX_TC];
+    tp_bound_compute(&cfg, bounds);
+
+    tp_json_t j;
+    tp_json_init(&j);
+    tp_json_obj_begin(&j, NULL);
+    tp_json_u64(&j, "link_mbps", cfg.link_mbps);
+    if (cfg.gcl) tp_json_u64(&j, "cycle_ns", gcl.cycle_ns);
+    tp_json_bool(&j, "guard_band", cfg.guard_band);
+    tp_json_obj_begin(&j, "tc");
+    for (int tc = 0; tc < TP_GCL_MAX_TC; tc++) {
+        const tp_bound_t *b = &bounds[tc];
+        const tp_arrival_t *a = &cfg.arrival[tc];
+        tp_json_obj_begin_idx(&j, tc);
+        tp_json_bool(&j, "open", b->open);
+        if (b->open) {
+            tp_json_f64(&j, "gate_rate_mbps", b->gate_rate_mbps, 3);
+            tp_json_f64(&j, "gate_latency_us", b->gate_latency_ns / 1000.0, 3);
+            tp_json_f64(&j, "blocking_us", b->blocking_ns / 1000.0, 3);
+            tp_json_f64(&j, "rate_mbps", b->rate_mbps, 3);
+            if (isfinite(b->latency_ns)) tp_json_f64(&j, "latency_us", b->latency_ns / 1000.0, 3);
+        }
+        if (cfg.idle_slope_mbps[tc] > 0) tp_json_f64(&j, "idle_slope_mbps", cfg.idle_slope_mbps[tc], 3);
+        if (a->streams) {
+            tp_json_u64(&j, "streams", a->streams);
+            tp_json_f64(&j, "burst_bytes", a->burst_bytes, 0);
+            tp_json_f64(&j, "rate_mbps_wire", a->rate_mbps, 3);
+            if (isfinite(b->utilization)) tp_json_f64(&j, "utilization", b->utilization, 4);
+        }
+        tp_json_bool(&j, "stable", b->stable);
+        if (b->stable) {
+            tp_json_f64(&j, "delay_us", b->delay_ns / 1000.0, 3);
+            tp_json_f64(&j, "backlog_bytes", b->backlog_bytes, 0);
+        }
+        tp_json_obj_end(&j);
+    }
+    tp_json_obj_end(&j);
+    tp_json_obj_end(&j);
+    tp_json_flush(&j, stdout);
+    tp_json_free(&j);
+    return 0;
+}
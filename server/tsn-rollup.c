@@ -0,0 +1,185 @@
+/*
+ * Read a capture rollup store (see tsnperf/rollup.h)
+ * Build: cmake -S . -B build && cmake --build build   (see CMakeLists.txt)
+ * Run: ./tsn-rollup <store dir> [--from unix_s] [--to unix_s] [--points n] [--tier auto|1s|1m|1h]
+ *
+ * Picks the finest tier that covers the range in at most --points buckets
+ * (auto), merges its records into display bins of a whole number of
+ * tier buckets and prints one JSON line: tier, bin size, store extent and
+ * per-TC series (only bins holding data; arrays share the "t" index).
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tsnperf/json.h"
+#include "tsnperf/rollup.h"
+
+#define NSEC 1000000000ULL
+#define DEFAULT_POINTS 1000
+#define MAX_POINTS 20000
+
+typedef struct {
+    uint64_t from_ns;
+    uint64_t bin_ns;
+    int n_bins;
+    tp_rollup_rec_t *bins[TP_ROLLUP_MAX_TC];
+} bin_ctx_t;
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <store dir> [--from unix_s] [--to unix_s] [--points n] [--tier auto|1s|1m|1h]\n", prog);
+}
+
+static void add_record(const tp_rollup_rec_t *rec, void *arg) {
+    bin_ctx_t *c = arg;
+    int k = (int)((rec->t_ns - c->from_ns) / c->bin_ns);
+    if (rec->tc >= TP_ROLLUP_MAX_TC || k < 0 || k >= c->n_bins) return;
+    if (!c->bins[rec->tc]) {
+        c->bins[rec->tc] = calloc(c->n_bins, sizeof(tp_rollup_rec_t));
+        if (!c->bins[rec->tc]) return;
+    }
+    tp_rollup_merge(&c->bins[rec->tc][k], rec);
+}
+
+// Series of one TC over bins that hold data
+static void json_series(tp_json_t *j, const bin_ctx_t *c, const tp_rollup_rec_t *bins) {
+#define SERIES(key, expr, prec)                                            \
+    tp_json_arr_begin(j, key);                                             \
+    for (int k = 0; k < c->n_bins; k++) {                                  \
+        const tp_rollup_rec_t *b = &bins[k];                               \
+        if (b->seconds > 0) tp_json_f64(j, NULL, (double)(expr), prec);    \
+    }                                                                      \
+    tp_json_arr_end(j)
+
+    SERIES("t", (c->from_ns + k * c->bin_ns) / NSEC, 0);
+    SERIES("seconds", b->seconds, 0);
+    SERIES("frames", b->frames, 0);
+    SERIES("kbps", b->bytes * 8.0 / b->seconds / 1000.0, 1);
+    SERIES("lost", b->lost, 0);
+    SERIES("ooo", b->ooo, 0);
+    SERIES("gate_in", b->gate_in, 0);
+    SERIES("gate_out", b->gate_out, 0);
+    SERIES("lat_avg_us", b->lat_count ? b->lat_sum_ns / 1000.0 / b->lat_count : 0, 2);
+    SERIES("lat_p50_us", tp_rollup_quantile(b->lat, 0.50) / 1000.0, 2);
+    SERIES("lat_p99_us", tp_rollup_quantile(b->lat, 0.99) / 1000.0, 2);
+    SERIES("lat_max_us", tp_rollup_quantile(b->lat, 1.0) / 1000.0, 2);
+    SERIES("interval_avg_us", b->frames > 1 ? b->interval_sum_ns / 1000.0 / (b->frames - 1) : 0, 2);
+    SERIES("interval_p99_us", tp_rollup_quantile(b->interval, 0.99) / 1000.0, 2);
+#undef SERIES
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        {"from", required_argument, NULL, 'f'},
+        {"to", required_argument, NULL, 't'},
+        {"points", required_argument, NULL, 'p'},
+        {"tier", required_argument, NULL, 'T'},
+        {NULL, 0, NULL, 0}
+    };
+
+    uint64_t from_ns = 0, to_ns = 0;
+    int points = DEFAULT_POINTS;
+    int tier = -1;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'f': from_ns = (uint64_t)(strtod(optarg, NULL) * NSEC); break;
+        case 't': to_ns = (uint64_t)(strtod(optarg, NULL) * NSEC); break;
+        case 'p': points = atoi(optarg); break;
+        case 'T':
+            if (strcmp(optarg, "auto") != 0 && (tier = tp_rollup_tier(optarg)) < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind >= argc || points < 1 || points > MAX_POINTS) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *dir = argv[optind];
+
+    uint64_t first[TP_ROLLUP_TIERS], last[TP_ROLLUP_TIERS];
+    int have[TP_ROLLUP_TIERS], any = 0;
+    uint64_t store_first = UINT64_MAX, store_last = 0;
+    for (int t = 0; t < TP_ROLLUP_TIERS; t++) {
+        have[t] = tp_rollup_extent(dir, t, &first[t], &last[t]) == 0;
+        if (!have[t]) continue;
+        any = 1;
+        // A coarse bucket spans more than its data; it only extends the
+        // store back when a finer tier has already expired that far, and
+        // the finest tier holds the newest second
+        uint64_t res = tp_rollup_resolution_s[t] * NSEC;
+        if (store_first == UINT64_MAX || first[t] + res <= store_first) store_first = first[t];
+        if (store_last == 0) store_last = last[t] + res;
+    }
+    if (!any) {
+        fprintf(stderr, "No rollup records in %s\n", dir);
+        return 1;
+    }
+    if (from_ns == 0) from_ns = store_first;
+    if (to_ns == 0) to_ns = store_last;
+    if (to_ns <= from_ns) {
+        fprintf(stderr, "Empty time range\n");
+        return 1;
+    }
+
+    // Finest tier with few enough buckets that still holds the range start
+    if (tier < 0) {
+        for (int t = 0; t < TP_ROLLUP_TIERS; t++) {
+            uint64_t res = tp_rollup_resolution_s[t] * NSEC;
+            if (!have[t] || (to_ns - from_ns) / res > (uint64_t)points) continue;
+            if (first[t] <= from_ns + res || t == TP_ROLLUP_TIERS - 1) {
+                tier = t;
+                break;
+            }
+        }
+        for (int t = TP_ROLLUP_TIERS - 1; tier < 0 && t >= 0; t--) {
+            if (have[t]) tier = t;
+        }
+    }
+
+    uint64_t res = tp_rollup_resolution_s[tier] * NSEC;
+    from_ns -= from_ns % res;
+    uint64_t span = to_ns - from_ns;
+    uint64_t per_bin = (span / res + points - 1) / points;
+    bin_ctx_t c = { .from_ns = from_ns, .bin_ns = (per_bin ? per_bin : 1) * res };
+    c.n_bins = (int)((span + c.bin_ns - 1) / c.bin_ns);
+
+    long n = tp_rollup_scan(dir, tier, from_ns, to_ns, add_record, &c);
+
+    tp_json_t j;
+    tp_json_init(&j);
+    tp_json_obj_begin(&j, NULL);
+    tp_json_str(&j, "tier", tp_rollup_tier_names[tier]);
+    tp_json_u64(&j, "resolution_s", tp_rollup_resolution_s[tier]);
+    tp_json_u64(&j, "bin_s", c.bin_ns / NSEC);
+    tp_json_f64(&j, "from", from_ns / 1e9, 0);
+    tp_json_f64(&j, "to", to_ns / 1e9, 0);
+    tp_json_i64(&j, "records", n);
+    tp_json_obj_begin(&j, "extent");
+    tp_json_u64(&j, "first", store_first / NSEC);
+    tp_json_u64(&j, "last", store_last / NSEC);
+    for (int t = 0; t < TP_ROLLUP_TIERS; t++) {
+        if (have[t]) tp_json_u64(&j, tp_rollup_tier_names[t], first[t] / NSEC);
+    }
+    tp_json_obj_end(&j);
+    tp_json_obj_begin(&j, "tc");
+    for (int tc = 0; tc < TP_ROLLUP_MAX_TC; tc++) {
+        if (!c.bins[tc]) continue;
+        tp_json_obj_begin_idx(&j, tc);
+        json_series(&j, &c, c.bins[tc]);
+        tp_json_obj_end(&j);
+        free(c.bins[tc]);
+    }
+    tp_json_obj_end(&j);
+    tp_json_obj_end(&j);
+    tp_json_flush(&j, stdout);
+    tp_json_free(&j);
+    return 0;
+}
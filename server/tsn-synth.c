@@ -0,0 +1,187 @@
+/*
+ * GCL synthesis from stream requirements (see tsnperf/synth.h)
+ * Build: cmake -S . -B build && cmake --build build   (see CMakeLists.txt)
+ * Run: ./tsn-synth [--link mbps] [--hop-ns ns] [--guard bytes] [--max-entries n]
+ *                  [--objective be|cycle] [--cycle ns] [--file streams.txt]
+ *
+ * Streams are read from --file or stdin, one per line:
+ *   <id> <period_ns> <frame_bytes> <max_latency_ns> <tc> <port>[,<port>...]
+ * Ports are free-form names (e.g. "sw1/2"), listed talker side first;
+ * max_latency 0 = period. '#' starts a comment.
+ *
+ * Prints one JSON line: cycle, per-port GCL entries ({gates, time} as taken
+ * by /api/capture and the TAS patch), best-effort share and per-stream
+ * talker offset and worst latency.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tsnperf/json.h"
+#include "tsnperf/synth.h"
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--link mbps] [--hop-ns ns] [--guard bytes] [--max-entries n]\n", prog);
+    fprintf(stderr, "          [--objective be|cycle] [--cycle ns] [--file streams.txt]\n");
+    fprintf(stderr, "Stream lines: <id> <period_ns> <frame_bytes> <max_latency_ns> <tc> <port>[,<port>...]\n");
+}
+
+static int read_streams(tp_synth_cfg_t *cfg, FILE *in) {
+    int cap = 0;
+    char line[1024];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), in)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char id[TP_SYNTH_NAME_LEN], path[512];
+        unsigned long long period, latency;
+        unsigned frame;
+        int tc;
+        int n = sscanf(line, "%31s %llu %u %llu %d %511s", id, &period, &frame, &latency, &tc, path);
+        if (n <= 0) continue;
+        if (n != 6 || period == 0 || tc < 0 || tc >= TP_GCL_MAX_TC) {
+            fprintf(stderr, "Invalid stream at line %d\n", lineno);
+            return -1;
+        }
+
+        if (cfg->n_streams == cap) {
+            cap = cap ? cap * 2 : 256;
+            cfg->streams = realloc(cfg->streams, sizeof(*cfg->streams) * cap);
+        }
+        tp_synth_stream_t *st = &cfg->streams[cfg->n_streams];
+        memset(st, 0, sizeof(*st));
+        snprintf(st->id, sizeof(st->id), "%s", id);
+        st->period_ns = period;
+        st->frame = frame;
+        st->max_latency_ns = latency;
+        st->tc = tc;
+
+        for (char *save, *port = strtok_r(path, ",", &save); port; port = strtok_r(NULL, ",", &save)) {
+            int idx = tp_synth_port(cfg, port);
+            if (idx < 0 || st->n_hops >= TP_SYNTH_MAX_HOPS) {
+                fprintf(stderr, "Too many ports or hops at line %d\n", lineno);
+                return -1;
+            }
+            st->hops[st->n_hops++] = idx;
+        }
+        cfg->n_streams++;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        {"link", required_argument, NULL, 'l'},
+        {"hop-ns", required_argument, NULL, 'h'},
+        {"guard", required_argument, NULL, 'g'},
+        {"max-entries", required_argument, NULL, 'm'},
+        {"objective", required_argument, NULL, 'o'},
+        {"cycle", required_argument, NULL, 'c'},
+        {"file", required_argument, NULL, 'f'},
+        {NULL, 0, NULL, 0}
+    };
+
+    tp_synth_cfg_t cfg;
+    tp_synth_cfg_init(&cfg, 1000);
+    const char *file = NULL;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'l': cfg.link_mbps = (uint32_t)atoi(optarg); break;
+        case 'h': cfg.hop_ns = strtoull(optarg, NULL, 10); break;
+        case 'g': cfg.guard_frame = (uint32_t)atoi(optarg); break;
+        case 'm': cfg.max_entries = atoi(optarg); break;
+        case 'o':
+            if (strcmp(optarg, "be") == 0) cfg.objective = TP_SYNTH_BE;
+            else if (strcmp(optarg, "cycle") == 0) cfg.objective = TP_SYNTH_CYCLE;
+            else { usage(argv[0]); return 1; }
+            break;
+        case 'c': cfg.cycle_ns = strtoull(optarg, NULL, 10); break;
+        case 'f': file = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (cfg.link_mbps == 0 || cfg.max_entries <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE *in = file ? fopen(file, "r") : stdin;
+    if (!in) {
+        perror(file);
+        return 1;
+    }
+    int rc = read_streams(&cfg, in);
+    if (file) fclose(in);
+    if (rc != 0) return 1;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    tp_synth_t sol;
+    if (tp_synth_solve(&cfg, &sol) != 0) {
+        fprintf(stderr, "No schedule: need streams and a cycle (<= 1 s) that every period divides or is a multiple of\n");
+        free(cfg.streams);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double solve_ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+
+    tp_json_t j;
+    tp_json_init(&j);
+    tp_json_obj_begin(&j, NULL);
+    tp_json_str(&j, "objective", cfg.objective == TP_SYNTH_CYCLE ? "cycle" : "be");
+    tp_json_u64(&j, "cycle_ns", sol.cycle_ns);
+    tp_json_u64(&j, "hyperperiod_ns", sol.hyperperiod_ns);
+    tp_json_bool(&j, "feasible", sol.feasible);
+    tp_json_u64(&j, "scheduled", sol.n_scheduled);
+    tp_json_u64(&j, "streams_total", cfg.n_streams);
+    tp_json_u64(&j, "candidates", sol.candidates);
+    tp_json_f64(&j, "solve_ms", solve_ms, 1);
+
+    tp_json_obj_begin(&j, "ports");
+    for (int p = 0; p < cfg.n_ports; p++) {
+        const tp_synth_port_t *port = &sol.ports[p];
+        tp_json_obj_begin(&j, cfg.ports[p]);
+        tp_json_u64(&j, "tc_mask", port->tc_mask);
+        tp_json_u64(&j, "protected_ns", port->protected_ns);
+        tp_json_u64(&j, "be_ns", port->be_ns);
+        tp_json_f64(&j, "be_fraction", (double)port->be_ns / sol.cycle_ns, 4);
+        tp_json_bool(&j, "fits", port->n_entries <= cfg.max_entries);
+        tp_json_arr_begin(&j, "entries");
+        for (int e = 0; e < port->n_entries; e++) {
+            tp_json_obj_begin(&j, NULL);
+            tp_json_u64(&j, "gates", port->entries[e].gates);
+            tp_json_u64(&j, "time", port->entries[e].interval_ns);
+            tp_json_obj_end(&j);
+        }
+        tp_json_arr_end(&j);
+        tp_json_obj_end(&j);
+    }
+    tp_json_obj_end(&j);
+
+    tp_json_obj_begin(&j, "streams");
+    for (int i = 0; i < cfg.n_streams; i++) {
+        const tp_synth_result_t *r = &sol.streams[i];
+        tp_json_obj_begin(&j, cfg.streams[i].id);
+        tp_json_bool(&j, "scheduled", r->scheduled);
+        if (r->scheduled) {
+            tp_json_u64(&j, "offset_ns", r->offset_ns);
+            tp_json_u64(&j, "latency_ns", r->latency_ns);
+        }
+        tp_json_obj_end(&j);
+    }
+    tp_json_obj_end(&j);
+    tp_json_obj_end(&j);
+    tp_json_flush(&j, stdout);
+    tp_json_free(&j);
+
+    tp_synth_free(&sol);
+    free(cfg.streams);
+    return 0;
+}
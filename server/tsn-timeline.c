@@ -0,0 +1,245 @@
+/*
+ * Ahead-of-time send schedule compiler (see tsnperf/timeline.h)
+ * Build: cmake -S . -B build && cmake --build build   (see CMakeLists.txt)
+ * Run: ./tsn-timeline --out <file> --dst <mac> [--src mac] [--link mbps] [--gcl spec] [--cycle ns]
+ *                     [--length ns] [--once] [--file streams.txt]
+ *      ./tsn-timeline --dump <file> [--limit n]
+ *
+ * Streams are read from --file or stdin, one per line:
+ *   <id> <tc> <period_ns> [frame=<bytes>] [burst=<n>] [gap=<ns>] [offset=<ns>]
+ *        [vid=<id>] [prbs=<0|1|seed>] [start=<ns>] [stop=<ns>] [on=<ns> off=<ns>] [align=1]
+ * '#' starts a comment. align=1 takes the offset from the TC's first gate
+ * window in --gcl ("<gates>:<ns>,...", as for traffic-capture).
+ *
+ * Compiling prints one JSON line: digest, records, pass length, loop,
+ * link load, closest launch spacing, overlaps and per-stream frames and
+ * frames outside their gate window. A load above 1 fails to compile. --dump prints the header and one line
+ * per record (launch_ns stream tc seq) for diffing two timelines.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tsnperf/json.h"
+#include "tsnperf/payload.h"
+#include "tsnperf/timeline.h"
+
+#define PRBS_DEFAULT_SEED 0x5EED
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --out <file> --dst <mac> [--src mac] [--link mbps] [--gcl spec] [--cycle ns]\n", prog);
+    fprintf(stderr, "          [--length ns] [--once] [--file streams.txt]\n");
+    fprintf(stderr, "       %s --dump <file> [--limit n]\n", prog);
+    fprintf(stderr, "Stream lines: <id> <tc> <period_ns> [frame= burst= gap= offset= vid= prbs= start= stop= on= off= align=]\n");
+}
+
+static int parse_option(tp_tl_stream_t *st, const char *kv) {
+    const char *eq = strchr(kv, '=');
+    if (!eq) return -1;
+    size_t klen = (size_t)(eq - kv);
+    const char *v = eq + 1;
+    char *end;
+    unsigned long long n = strtoull(v, &end, 0);
+    if (*end || end == v) return -1;
+
+#define KEY(name) (klen == sizeof(name) - 1 && strncmp(kv, name, klen) == 0)
+    if (KEY("frame")) st->frame = (uint32_t)n;
+    else if (KEY("burst")) st->burst = (uint32_t)n;
+    else if (KEY("gap")) st->gap_ns = n;
+    else if (KEY("offset")) st->offset_ns = n;
+    else if (KEY("vid")) st->vlan_id = (int)n;
+    else if (KEY("prbs")) {
+        st->prbs = n != 0;
+        st->prbs_seed = n > 1 ? (uint32_t)n : PRBS_DEFAULT_SEED;
+    }
+    else if (KEY("start")) st->start_ns = n;
+    else if (KEY("stop")) st->stop_ns = n;
+    else if (KEY("on")) st->on_ns = n;
+    else if (KEY("off")) st->off_ns = n;
+    else if (KEY("align")) st->align = n != 0;
+    else return -1;
+#undef KEY
+    return 0;
+}
+
+static int read_streams(tp_tl_cfg_t *cfg, FILE *in) {
+    int cap = 0;
+    char line[1024];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), in)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char *save;
+        char *id = strtok_r(line, " \t\r\n", &save);
+        if (!id) continue;
+        char *tc = strtok_r(NULL, " \t\r\n", &save);
+        char *period = strtok_r(NULL, " \t\r\n", &save);
+        if (!tc || !period) {
+            fprintf(stderr, "Invalid stream at line %d\n", lineno);
+            return -1;
+        }
+
+        if (cfg->n_streams == cap) {
+            cap = cap ? cap * 2 : 64;
+            cfg->streams = realloc(cfg->streams, sizeof(*cfg->streams) * cap);
+        }
+        tp_tl_stream_t *st = &cfg->streams[cfg->n_streams];
+        tp_tl_stream_init(st);
+        snprintf(st->id, sizeof(st->id), "%s", id);
+        st->tc = atoi(tc);
+        st->period_ns = strtoull(period, NULL, 10);
+
+        for (char *kv = strtok_r(NULL, " \t\r\n", &save); kv; kv = strtok_r(NULL, " \t\r\n", &save)) {
+            if (parse_option(st, kv) < 0) {
+                fprintf(stderr, "Invalid option '%s' at line %d\n", kv, lineno);
+                return -1;
+            }
+        }
+        cfg->n_streams++;
+    }
+    return 0;
+}
+
+static int dump(const char *path, uint64_t limit) {
+    tp_tl_file_t f;
+    char err[256];
+    if (tp_tl_open(&f, path, err, sizeof(err)) != 0) {
+        fprintf(stderr, "%s\n", err);
+        return 1;
+    }
+    const tp_tl_hdr_t *h = f.hdr;
+    printf("# digest %08x records %llu length_ns %llu align_ns %llu loop %u link_mbps %u\n", h->digest,
+           (unsigned long long)h->n_records, (unsigned long long)h->length_ns,
+           (unsigned long long)h->align_ns, h->loop, h->link_mbps);
+    for (uint32_t i = 0; i < h->n_templates; i++) {
+        const tp_tl_tpl_t *t = &f.tpls[i];
+        printf("# stream %u %s tc %u len %u flow %u frames/pass %u crc %08x\n", i, t->id, t->tc, t->len,
+               t->flow, f.flows[t->flow], tp_crc32c(0, t->frame, t->len));
+    }
+    uint64_t n = limit && limit < h->n_records ? limit : h->n_records;
+    for (uint64_t i = 0; i < n; i++) {
+        const tp_tl_rec_t *r = &f.recs[i];
+        printf("%llu %s %u %u\n", (unsigned long long)r->launch_ns, f.tpls[r->tpl].id, f.tpls[r->tpl].tc, r->seq);
+    }
+    tp_tl_close(&f);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        {"out", required_argument, NULL, 'o'},
+        {"dst", required_argument, NULL, 'd'},
+        {"src", required_argument, NULL, 's'},
+        {"link", required_argument, NULL, 'l'},
+        {"gcl", required_argument, NULL, 'g'},
+        {"cycle", required_argument, NULL, 'c'},
+        {"length", required_argument, NULL, 'L'},
+        {"once", no_argument, NULL, '1'},
+        {"file", required_argument, NULL, 'f'},
+        {"dump", required_argument, NULL, 'D'},
+        {"limit", required_argument, NULL, 'n'},
+        {NULL, 0, NULL, 0}
+    };
+
+    tp_tl_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.link_mbps = 1000;
+    const char *out = NULL, *dst = NULL, *src = "00:00:00:00:00:00", *gcl_spec = NULL;
+    const char *file = NULL, *dump_path = NULL;
+    uint64_t cycle_ns = 0, limit = 0;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'o': out = optarg; break;
+        case 'd': dst = optarg; break;
+        case 's': src = optarg; break;
+        case 'l': cfg.link_mbps = (uint32_t)atoi(optarg); break;
+        case 'g': gcl_spec = optarg; break;
+        case 'c': cycle_ns = strtoull(optarg, NULL, 10); break;
+        case 'L': cfg.length_ns = strtoull(optarg, NULL, 10); break;
+        case '1': cfg.once = 1; break;
+        case 'f': file = optarg; break;
+        case 'D': dump_path = optarg; break;
+        case 'n': limit = strtoull(optarg, NULL, 10); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (dump_path) return dump(dump_path, limit);
+
+    if (!out || !dst || tp_parse_mac(dst, cfg.dst_mac) < 0 || tp_parse_mac(src, cfg.src_mac) < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    tp_gcl_t gcl;
+    if (gcl_spec) {
+        if (tp_gcl_parse(&gcl, gcl_spec, cycle_ns) != 0) {
+            fprintf(stderr, "Invalid --gcl %s\n", gcl_spec);
+            return 1;
+        }
+        cfg.gcl = &gcl;
+    }
+
+    FILE *in = file ? fopen(file, "r") : stdin;
+    if (!in) {
+        perror(file);
+        return 1;
+    }
+    int rc = read_streams(&cfg, in);
+    if (file) fclose(in);
+    if (rc != 0) return 1;
+
+    tp_tl_summary_t sum;
+    sum.streams = calloc(cfg.n_streams ? cfg.n_streams : 1, sizeof(*sum.streams));
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (tp_tl_compile(&cfg, out, &sum) != 0) {
+        fprintf(stderr, "%s\n", sum.error);
+        free(sum.streams);
+        free(cfg.streams);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double compile_ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+
+    char digest[16];
+    snprintf(digest, sizeof(digest), "%08x", sum.digest);
+
+    tp_json_t j;
+    tp_json_init(&j);
+    tp_json_obj_begin(&j, NULL);
+    tp_json_str(&j, "path", out);
+    tp_json_str(&j, "digest", digest);
+    tp_json_u64(&j, "records", sum.n_records);
+    tp_json_u64(&j, "length_ns", sum.length_ns);
+    tp_json_bool(&j, "loop", sum.loop);
+    tp_json_u64(&j, "align_ns", cfg.gcl ? cfg.gcl->cycle_ns : 0);
+    tp_json_u64(&j, "flows", sum.n_flows);
+    tp_json_f64(&j, "load", sum.load, 4);
+    if (sum.n_records > 1) tp_json_u64(&j, "min_gap_ns", sum.min_gap_ns);
+    tp_json_u64(&j, "overlaps", sum.overlaps);
+    tp_json_f64(&j, "compile_ms", compile_ms, 1);
+    tp_json_obj_begin(&j, "streams");
+    for (int i = 0; i < cfg.n_streams; i++) {
+        tp_json_obj_begin(&j, cfg.streams[i].id);
+        tp_json_u64(&j, "tc", cfg.streams[i].tc);
+        tp_json_u64(&j, "frames", sum.streams[i].frames);
+        if (cfg.gcl) tp_json_u64(&j, "outside", sum.streams[i].outside);
+        tp_json_obj_end(&j);
+    }
+    tp_json_obj_end(&j);
+    tp_json_obj_end(&j);
+    tp_json_flush(&j, stdout);
+    tp_json_free(&j);
+
+    free(sum.streams);
+    free(cfg.streams);
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * anomaly.c - EWMA baseline and dip windows over per-cycle gate accuracy
+ */
+
+#include <string.h>
+
+#include "anomaly.h"
+#include "guard.h"
+
+void tp_anomaly_init(tp_anomaly_t *a, const tp_gcl_t *gcl, double dip, int merge_cycles) {
+    memset(a, 0, sizeof(*a));
+    a->gcl = gcl;
+    a->dip = dip > 0 ? dip : TP_ANOMALY_DIP;
+    a->merge_cycles = merge_cycles >= 0 ? merge_cycles : TP_ANOMALY_MERGE;
+}
+
+static int end_window(tp_anomaly_t *a, tp_dip_t *out) {
+    if (!a->open) return 0;
+    *out = a->cur;
+    a->open = 0;
+    a->dips++;
+    return 1;
+}
+
+int tp_anomaly_cycle(tp_anomaly_t *a, const tp_score_rec_t *rec, tp_dip_t *out) {
+    uint64_t frames = 0, wrong = 0;
+    for (int tc = 0; tc < TP_GCL_MAX_TC; tc++) {
+        if (!tp_guard_gated(a->gcl, tc)) continue;
+        frames += rec->frames[tc];
+        wrong += rec->wrong[tc];
+    }
+
+    int ended = 0;
+    // Too many good cycles since the last dip cycle (or an empty stretch)
+    if (a->open && rec->cycle - a->cur.last_cycle > a->merge_cycles + 1) ended = end_window(a, out);
+    if (frames == 0) return ended;
+
+    double acc = 1.0 - (double)wrong / (double)frames;
+    if (a->warm >= TP_ANOMALY_WARMUP && acc < a->baseline - a->dip) {
+        if (!a->open) {
+            a->cur = (tp_dip_t){ .first_cycle = rec->cycle, .min_accuracy = acc, .baseline = a->baseline };
+            a->open = 1;
+        }
+        a->cur.last_cycle = rec->cycle;
+        a->cur.cycles++;
+        a->cur.frames += frames;
+        a->cur.wrong += wrong;
+        if (acc < a->cur.min_accuracy) a->cur.min_accuracy = acc;
+        return ended;
+    }
+
+    // Dip cycles stay out of the baseline; the warm-up is a plain mean
+    a->warm++;
+    uint64_t n = a->warm < TP_ANOMALY_EWMA ? a->warm : TP_ANOMALY_EWMA;
+    a->baseline += (acc - a->baseline) / (double)n;
+    return ended;
+}
+
+int tp_anomaly_flush(tp_anomaly_t *a, tp_dip_t *out) {
+    return end_window(a, out);
+}
@@ -0,0 +1,57 @@
+/*
+ * anomaly.h - Gate accuracy dips in the per-cycle scorecards
+ *
+ * Each closed cycle (tsnperf/score.h) has an accuracy over its gated TCs:
+ * the share of their frames inside a window. TCs whose gate never closes
+ * are left out; they cannot be in the wrong slot. The baseline is an EWMA
+ * (weight 1/TP_ANOMALY_EWMA) of the cycles that are not in a dip, used
+ * after TP_ANOMALY_WARMUP of them. A cycle below baseline - dip is in a
+ * dip; dip cycles separated by at most merge_cycles good cycles make one
+ * window. A window is reported once a later cycle ends it (or on flush).
+ *
+ * Single writer: the capture stats thread, as the scorecards come in.
+ */
+
+#ifndef TSNPERF_ANOMALY_H
+#define TSNPERF_ANOMALY_H
+
+#include <stdint.h>
+
+#include "gcl.h"
+#include "score.h"
+
+#define TP_ANOMALY_EWMA      64
+#define TP_ANOMALY_WARMUP    16
+#define TP_ANOMALY_DIP       0.05       // Accuracy drop below baseline
+#define TP_ANOMALY_MERGE     2          // Good cycles that still join two dips
+
+typedef struct {
+    int64_t first_cycle;
+    int64_t last_cycle;
+    uint32_t cycles;            // Dip cycles in the window
+    uint64_t frames;            // Gated frames in the dip cycles
+    uint64_t wrong;
+    double min_accuracy;
+    double baseline;            // Before the window opened
+} tp_dip_t;
+
+typedef struct {
+    const tp_gcl_t *gcl;
+    double dip;
+    int merge_cycles;
+    double baseline;
+    uint64_t warm;              // Cycles in the baseline so far
+    int open;                   // cur holds a window
+    tp_dip_t cur;
+    uint64_t dips;              // Windows reported
+} tp_anomaly_t;
+
+void tp_anomaly_init(tp_anomaly_t *a, const tp_gcl_t *gcl, double dip, int merge_cycles);
+
+// Feed one closed cycle in order. Returns 1 and fills *out when it ends a window.
+int tp_anomaly_cycle(tp_anomaly_t *a, const tp_score_rec_t *rec, tp_dip_t *out);
+
+// End the open window, if any. Returns 1 and fills *out if there was one.
+int tp_anomaly_flush(tp_anomaly_t *a, tp_dip_t *out);
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ * arena.c - Hugepage mapping, NUMA binding, block carving and reuse
+ */
+
+#define _GNU_SOURCE
+#include <linux/mempolicy.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "arena.h"
+
+#define HDR 64
+#define ALIGN(n) (((n) + HDR - 1) & ~(size_t)(HDR - 1))
+#define MAX_NODES 64
+
+typedef struct tp_arena_block {
+    size_t size;                        // Payload bytes
+    struct tp_arena_block *next;        // Free list
+    int heap;
+    int usage;                          // Index into usage[], -1 = not tracked
+} tp_arena_block_t;
+
+_Static_assert(sizeof(tp_arena_block_t) <= HDR, "block header exceeds a cache line");
+
+static const char *page_names[] = { "heap", "normal", "thp", "hugetlb" };
+
+const char *tp_arena_page_name(int page) {
+    return page >= 0 && page <= TP_ARENA_HUGETLB ? page_names[page] : "?";
+}
+
+int tp_numa_node_of_if(const char *ifname) {
+    if (!ifname || strchr(ifname, '/')) return -1;
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/class/net/%s/device/numa_node", ifname);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int node = -1;
+    if (fscanf(f, "%d", &node) != 1) node = -1;
+    fclose(f);
+    return node;
+}
+
+// THP advice is a no-op when the system setting is "never"
+static int thp_enabled(void) {
+    FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (!f) return 0;
+    char buf[128] = { 0 };
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    return n > 0 && !strstr(buf, "[never]");
+}
+
+// Anonymous mapping aligned to 2 MB, so THP can back it with huge pages
+static void *map_aligned(size_t size) {
+    uint8_t *p = mmap(NULL, size + TP_HUGEPAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    uint8_t *base = (uint8_t *)(((uintptr_t)p + TP_HUGEPAGE_SIZE - 1) & ~(uintptr_t)(TP_HUGEPAGE_SIZE - 1));
+    if (base > p) munmap(p, base - p);
+    munmap(base + size, p + TP_HUGEPAGE_SIZE - base);
+    return base;
+}
+
+int tp_arena_init(tp_arena_t *a, size_t size, const char *ifname) {
+    memset(a, 0, sizeof(*a));
+    pthread_mutex_init(&a->lock, NULL);
+    a->page = TP_ARENA_HEAP;
+    a->nic_node = tp_numa_node_of_if(ifname);
+    a->node = -1;
+    if (size == 0) return -1;
+    size = (size + TP_HUGEPAGE_SIZE - 1) & ~(TP_HUGEPAGE_SIZE - 1);
+
+    // The thread policy covers pages populated by mmap itself (mlockall
+    // MCL_FUTURE); mbind covers pages faulted later
+    unsigned long mask = 0;
+    int policy = 0;
+    if (a->nic_node >= 0 && a->nic_node < MAX_NODES) {
+        mask = 1UL << a->nic_node;
+        policy = syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, MAX_NODES) == 0;
+    }
+
+    uint8_t *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        a->page = TP_ARENA_HUGETLB;
+    } else if ((p = map_aligned(size)) != NULL) {
+        a->page = madvise(p, size, MADV_HUGEPAGE) == 0 && thp_enabled() ? TP_ARENA_THP : TP_ARENA_NORMAL;
+    }
+
+    if (policy) {
+        if (p) a->bound = syscall(SYS_mbind, p, size, MPOL_PREFERRED, &mask, MAX_NODES, 0) == 0;
+        syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0);
+    }
+    if (!p) {
+        a->page = TP_ARENA_HEAP;
+        return -1;
+    }
+
+    // Faults the first page in if needed; ENOSYS without NUMA support
+    int node;
+    if (syscall(SYS_get_mempolicy, &node, NULL, 0, p, MPOL_F_NODE | MPOL_F_ADDR) == 0) a->node = node;
+
+    a->base = p;
+    a->size = size;
+    return 0;
+}
+
+void tp_arena_destroy(tp_arena_t *a) {
+    if (a->base) munmap(a->base, a->size);
+    a->base = NULL;
+    a->size = a->used = 0;
+    a->free_list = NULL;
+    pthread_mutex_destroy(&a->lock);
+}
+
+static int usage_index(tp_arena_t *a, const char *name) {
+    for (int i = 0; i < a->n_usage; i++) {
+        if (a->usage[i].name == name || strcmp(a->usage[i].name, name) == 0) return i;
+    }
+    if (a->n_usage == TP_ARENA_NAMES) return -1;
+    a->usage[a->n_usage].name = name;
+    return a->n_usage++;
+}
+
+void *tp_arena_alloc(tp_arena_t *a, const char *name, size_t size) {
+    size_t need = ALIGN(size ? size : 1);
+    if (!a) {
+        void *p = aligned_alloc(HDR, need);
+        if (p) memset(p, 0, need);
+        return p;
+    }
+
+    pthread_mutex_lock(&a->lock);
+    // Best fit among freed blocks, then carve, then the heap
+    tp_arena_block_t *b = NULL, **link = NULL;
+    for (tp_arena_block_t **l = &a->free_list; *l; l = &(*l)->next) {
+        if ((*l)->size >= need && (!b || (*l)->size < b->size)) {
+            b = *l;
+            link = l;
+        }
+    }
+    if (b) {
+        *link = b->next;
+    } else if (a->base && a->used + HDR + need <= a->size) {
+        b = (tp_arena_block_t *)(a->base + a->used);
+        a->used += HDR + need;
+        b->size = need;
+        b->heap = 0;
+    } else {
+        b = aligned_alloc(HDR, HDR + need);
+        if (!b) {
+            pthread_mutex_unlock(&a->lock);
+            return NULL;
+        }
+        b->size = need;
+        b->heap = 1;
+    }
+    b->next = NULL;
+
+    b->usage = usage_index(a, name);
+    if (b->usage >= 0) {
+        tp_arena_usage_t *u = &a->usage[b->usage];
+        u->bytes += b->size;
+        if (b->heap) u->heap_bytes += b->size;
+        u->blocks++;
+    }
+    if (!b->heap) {
+        a->live += HDR + b->size;
+        if (a->live > a->peak) a->peak = a->live;
+    }
+    pthread_mutex_unlock(&a->lock);
+
+    // Zeroing places fresh pages on the arena's node
+    uint8_t *p = (uint8_t *)b + HDR;
+    memset(p, 0, b->size);
+    return p;
+}
+
+void tp_arena_free(tp_arena_t *a, void *p) {
+    if (!p) return;
+    if (!a) {
+        free(p);
+        return;
+    }
+
+    tp_arena_block_t *b = (tp_arena_block_t *)((uint8_t *)p - HDR);
+    pthread_mutex_lock(&a->lock);
+    if (b->usage >= 0) {
+        tp_arena_usage_t *u = &a->usage[b->usage];
+        u->bytes -= b->size;
+        if (b->heap) u->heap_bytes -= b->size;
+        u->blocks--;
+    }
+    if (b->heap) {
+        free(b);
+    } else {
+        a->live -= HDR + b->size;
+        b->next = a->free_list;
+        a->free_list = b;
+    }
+    pthread_mutex_unlock(&a->lock);
+}
+
+void tp_arena_json(tp_arena_t *a, tp_json_t *j, const char *key) {
+    pthread_mutex_lock(&a->lock);
+    uint64_t heap = 0;
+    for (int i = 0; i < a->n_usage; i++) heap += a->usage[i].heap_bytes;
+
+    tp_json_obj_begin(j, key);
+    tp_json_str(j, "page", tp_arena_page_name(a->page));
+    tp_json_u64(j, "size", a->size);
+    tp_json_u64(j, "used", a->used);
+    tp_json_u64(j, "peak", a->peak);
+    tp_json_i64(j, "nic_node", a->nic_node);
+    tp_json_i64(j, "node", a->node);
+    tp_json_bool(j, "bound", a->bound);
+    tp_json_u64(j, "heap_bytes", heap);
+    tp_json_obj_begin(j, "blocks");
+    for (int i = 0; i < a->n_usage; i++) {
+        if (a->usage[i].blocks) tp_json_u64(j, a->usage[i].name, a->usage[i].bytes);
+    }
+    tp_json_obj_end(j);
+    tp_json_obj_end(j);
+    pthread_mutex_unlock(&a->lock);
+}
@@ -0,0 +1,84 @@
+/*
+ * arena.h - Hugepage-backed, NUMA-placed memory arena for hot structures
+ *
+ * Rings, session tables and frame templates are touched on every packet.
+ * Carved from one arena they share a handful of 2 MB TLB entries instead of
+ * hundreds of 4 KB ones, and on a multi-socket host they sit on the NUMA
+ * node of the NIC the packets come from.
+ *
+ * tp_arena_init() maps the whole arena once at startup, preferring:
+ *   hugetlb  explicit 2 MB pages (vm.nr_hugepages reserved by the admin)
+ *   thp      normal pages advised for transparent hugepages
+ *   normal   normal pages (THP disabled)
+ * and binds it to the NIC's node (/sys/class/net/<if>/device/numa_node;
+ * preferred, not strict, so a full node spills over instead of failing).
+ * Pages are placed when first touched, which is on allocation since blocks
+ * come back zeroed, or at map time under mlockall(MCL_FUTURE). The node of
+ * the first page is read back for the placement report.
+ *
+ * Blocks are cache-line aligned and carry a 64-byte header. Freed blocks go
+ * to a free list and are reused best-fit, so sessions that come and go
+ * recycle the same memory. Once the arena is full, blocks come from the
+ * heap and are reported as such. A NULL arena means the heap throughout.
+ *
+ * Allocation takes a mutex; it belongs to setup paths, not the packet path.
+ */
+
+#ifndef TSNPERF_ARENA_H
+#define TSNPERF_ARENA_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "json.h"
+
+#define TP_HUGEPAGE_SIZE (2UL << 20)
+#define TP_ARENA_NAMES   16             // Distinct block names in the report
+
+enum { TP_ARENA_HEAP, TP_ARENA_NORMAL, TP_ARENA_THP, TP_ARENA_HUGETLB };
+
+typedef struct {
+    const char *name;
+    uint64_t bytes;                     // Live, arena and heap
+    uint64_t heap_bytes;                // Live, of them from the heap
+    uint32_t blocks;
+} tp_arena_usage_t;
+
+struct tp_arena_block;
+
+typedef struct tp_arena {
+    uint8_t *base;
+    size_t size;
+    size_t used;                        // Bump pointer
+    int page;                           // TP_ARENA_*
+    int nic_node;                       // -1 = unknown or not NUMA
+    int node;                           // Node of the first page, -1 = unknown
+    int bound;                          // Node policy applied
+    size_t peak;                        // Highest live arena bytes
+    size_t live;
+    struct tp_arena_block *free_list;
+    tp_arena_usage_t usage[TP_ARENA_NAMES];
+    int n_usage;
+    pthread_mutex_t lock;
+} tp_arena_t;
+
+// NUMA node of a network interface, -1 if unknown
+int tp_numa_node_of_if(const char *ifname);
+
+// Map size bytes (rounded up to 2 MB) near ifname's node (NULL = no
+// preference). Returns 0, or -1 with the arena left heap-only.
+int tp_arena_init(tp_arena_t *a, size_t size, const char *ifname);
+void tp_arena_destroy(tp_arena_t *a);
+
+// Zeroed, 64-byte aligned block accounted under name (a string literal).
+// NULL only if the heap is exhausted too.
+void *tp_arena_alloc(tp_arena_t *a, const char *name, size_t size);
+void tp_arena_free(tp_arena_t *a, void *p);
+
+const char *tp_arena_page_name(int page);
+
+// Placement report: {"page","size","used","peak","nic_node","node","bound","heap_bytes","blocks":{name:bytes}}
+void tp_arena_json(tp_arena_t *a, tp_json_t *j, const char *key);
+
+#endif
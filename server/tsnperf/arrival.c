@@ -0,0 +1,94 @@
+/*
+ * arrival.c - Sliding-window arrival curves and token-bucket envelopes
+ */
+
+#include <string.h>
+
+#include "arrival.h"
+
+double tp_arrival_sigma(const uint64_t *ts_ns, const uint16_t *len, int n, double rate) {
+    if (n <= 0) return 0;
+
+    // bytes(i..j) - rate * (ts_j - ts_i) = (P[j+1] - rate ts_j) - (P[i] - rate ts_i)
+    double base = (double)ts_ns[0];
+    double prefix = 0, min_start = 0, sigma = 0;
+    for (int j = 0; j < n; j++) {
+        double t = (double)ts_ns[j] - base;
+        double start = prefix - rate * t;
+        if (j == 0 || start < min_start) min_start = start;
+        prefix += tp_arrival_wire(len[j]);
+        double v = prefix - rate * t - min_start;
+        if (v > sigma) sigma = v;
+    }
+    return sigma;
+}
+
+void tp_arrival_fit(tp_arrival_curve_t *c, const uint64_t *ts_ns, const uint16_t *len, int n,
+                    uint64_t min_window_ns) {
+    memset(c, 0, sizeof(*c));
+    if (n <= 0) return;
+    if (min_window_ns == 0) min_window_ns = 1;
+
+    for (int i = 0; i < n; i++) {
+        uint32_t w = tp_arrival_wire(len[i]);
+        c->total_bytes += w;
+        if (w > c->max_frame) c->max_frame = w;
+    }
+    uint64_t span = ts_ns[n - 1] - ts_ns[0];
+
+    // Bytes sent over the span: the last frame only starts at its end
+    c->rate = span > 0 ? (double)(c->total_bytes - tp_arrival_wire(len[n - 1])) / span : 0;
+    c->burst = tp_arrival_sigma(ts_ns, len, n, c->rate);
+
+    for (uint64_t w = min_window_ns; c->n_points < TP_ARRIVAL_POINTS; w *= 2) {
+        // Windows start at a frame; the right edge moves monotonically
+        uint64_t best = 0, bytes = 0;
+        int j = 0;
+        for (int i = 0; i < n; i++) {
+            while (j < n && ts_ns[j] - ts_ns[i] < w) bytes += tp_arrival_wire(len[j++]);
+            if (bytes > best) best = bytes;
+            bytes -= tp_arrival_wire(len[i]);
+        }
+        c->window_ns[c->n_points] = w;
+        c->bytes[c->n_points] = best;
+        c->n_points++;
+        if (w > span) break;
+    }
+}
+
+double tp_arrival_gate_rate(const tp_gcl_t *g, int tc, uint32_t link_mbps) {
+    double link = link_mbps / 8000.0;
+    uint64_t open = 0;
+    for (int k = 0; k < g->n_windows[tc]; k++) open += g->windows[tc][k].len_ns;
+    return g->cycle_ns ? link * open / g->cycle_ns : 0;
+}
+
+double tp_arrival_gate_sigma(const tp_gcl_t *g, int tc, uint32_t link_mbps, uint32_t max_frame) {
+    int n = g->n_windows[tc];
+    if (n == 0) return max_frame;
+
+    double link = link_mbps / 8000.0;
+    double rate = tp_arrival_gate_rate(g, tc, link_mbps);
+    double sigma = 0;
+
+    // Worst window run: starts at a window open, ends at a later window close
+    for (int k = 0; k < n; k++) {
+        double open = 0;
+        for (int step = 0; step < n; step++) {
+            int j = (k + step) % n;
+            const tp_gate_window_t *w = &g->windows[tc][j];
+            double start = (double)w->open_ns + (k + step >= n ? (double)g->cycle_ns : 0);
+            open += (double)w->len_ns;
+            double v = link * open - rate * (start + w->len_ns - g->windows[tc][k].open_ns);
+            if (v > sigma) sigma = v;
+        }
+    }
+    return sigma + max_frame;
+}
+
+double tp_arrival_cbs_sigma(double idle_slope, uint32_t link_mbps, uint32_t max_frame, uint32_t be_frame) {
+    double link = link_mbps / 8000.0;
+    if (idle_slope <= 0 || idle_slope >= link) return max_frame;
+    double hi_credit = be_frame * idle_slope / link;
+    return max_frame + hi_credit * link / (link - idle_slope);
+}
@@ -0,0 +1,63 @@
+/*
+ * arrival.h - Empirical arrival curves and token-bucket fitting
+ *
+ * The arrival curve of a trace is alpha(t) = the most bytes seen in any
+ * window [s, s + t). It is sampled at log-spaced t (doubling from a
+ * minimum window) with one two-pointer sweep per window size, O(n) each.
+ *
+ * A token bucket (sigma, rho) bounds the trace when every window holds at
+ * most sigma + rho * t bytes. For a given rho the smallest sigma is
+ *   sigma(rho) = max over i <= j of bytes(i..j) - rho * (ts_j - ts_i)
+ * found exactly in one pass (running minimum of prefix - rho * ts).
+ *
+ * Shaper envelopes give the sigma a correctly shaped TC should not exceed:
+ *   TAS  output confined to the TC's gate windows at line rate, plus one
+ *        frame spilling past a window end
+ *   CBS  max frame + hiCredit * link / (link - idleSlope), hiCredit being
+ *        the credit built while one best-effort frame blocks the class
+ *
+ * All byte counts are wire bytes (frame + preamble, FCS and IFG).
+ */
+
+#ifndef TSNPERF_ARRIVAL_H
+#define TSNPERF_ARRIVAL_H
+
+#include <stdint.h>
+
+#include "gcl.h"
+
+#define TP_ARRIVAL_POINTS 32
+
+typedef struct {
+    int n_points;
+    uint64_t window_ns[TP_ARRIVAL_POINTS];
+    uint64_t bytes[TP_ARRIVAL_POINTS];
+    double rate;            // Mean over the trace, bytes/ns
+    double burst;           // sigma(rate), bytes
+    uint32_t max_frame;     // Wire bytes
+    uint64_t total_bytes;
+} tp_arrival_curve_t;
+
+// Wire bytes of a frame of len bytes as captured (no FCS)
+static inline uint32_t tp_arrival_wire(uint32_t len) {
+    if (len < TP_WIRE_MIN_FRAME) len = TP_WIRE_MIN_FRAME;
+    return len + TP_WIRE_OVERHEAD;
+}
+
+// Curve and (sigma, mean rate) fit of n frames with ascending timestamps;
+// len holds captured lengths. Windows double from min_window_ns.
+void tp_arrival_fit(tp_arrival_curve_t *c, const uint64_t *ts_ns, const uint16_t *len, int n,
+                    uint64_t min_window_ns);
+
+// Smallest sigma of a token bucket with rate (bytes/ns) bounding the trace
+double tp_arrival_sigma(const uint64_t *ts_ns, const uint16_t *len, int n, double rate);
+
+// Long-term rate (bytes/ns) and envelope sigma of tc's gate windows on a
+// link of link_mbps; 0 rate if the gate never opens
+double tp_arrival_gate_rate(const tp_gcl_t *g, int tc, uint32_t link_mbps);
+double tp_arrival_gate_sigma(const tp_gcl_t *g, int tc, uint32_t link_mbps, uint32_t max_frame);
+
+// Envelope sigma of a CBS class with idle_slope (bytes/ns)
+double tp_arrival_cbs_sigma(double idle_slope, uint32_t link_mbps, uint32_t max_frame, uint32_t be_frame);
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * bound.c - Rate-latency service curves and token-bucket bounds per TC
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "bound.h"
+#include "frame.h"
+
+static double wire_bytes(uint32_t len) {
+    if (len < TP_WIRE_MIN_FRAME) len = TP_WIRE_MIN_FRAME;
+    return (double)len + TP_WIRE_OVERHEAD;
+}
+
+void tp_bound_cfg_init(tp_bound_cfg_t *cfg, uint32_t link_mbps) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->link_mbps = link_mbps ? link_mbps : 1000;
+    cfg->guard_band = 1;
+    cfg->be_frame = TP_MAX_FRAME_LEN;
+}
+
+void tp_bound_add_stream(tp_bound_cfg_t *cfg, int tc, double burst_bytes, double rate_mbps, uint32_t max_frame) {
+    if (tc < 0 || tc >= TP_GCL_MAX_TC) return;
+    if (max_frame == 0) max_frame = TP_MAX_FRAME_LEN;
+    if (burst_bytes < max_frame) burst_bytes = max_frame;
+
+    double scale = wire_bytes(max_frame) / max_frame;
+    tp_arrival_t *a = &cfg->arrival[tc];
+    a->burst_bytes += ceil(burst_bytes / max_frame) * wire_bytes(max_frame);
+    a->rate_mbps += rate_mbps * scale;
+    if (max_frame > a->max_frame) a->max_frame = max_frame;
+    a->streams++;
+}
+
+// Largest frame a TC may put on the wire, 0 if it carries nothing
+static uint32_t tc_frame(const tp_bound_cfg_t *cfg, int tc) {
+    return cfg->arrival[tc].streams ? cfg->arrival[tc].max_frame : cfg->be_frame;
+}
+
+// Gates of a and b are open at the same time somewhere in the cycle
+static int gates_overlap(const tp_gcl_t *g, int a, int b) {
+    if (!g) return 1;
+    uint8_t both = (1U << a) | (1U << b);
+    for (int i = 0; i < g->n_entries; i++) {
+        if ((g->entries[i].gates & both) == both) return 1;
+    }
+    return 0;
+}
+
+static int gate_ever_open(const tp_gcl_t *g, int tc) {
+    return !g || g->n_windows[tc] > 0;
+}
+
+/*
+ * Tightest rate-latency curve under the TC's gate service. The worst start
+ * is the instant a window closes; the deficit against the long-term rate
+ * peaks when a later window opens, so only those points are checked.
+ */
+static void gate_service(const tp_bound_cfg_t *cfg, int tc, double link, double *rate, double *latency) {
+    const tp_gcl_t *g = cfg->gcl;
+    *rate = 0;
+    *latency = 0;
+    if (!g) {
+        *rate = link;
+        return;
+    }
+
+    int n = g->n_windows[tc];
+    if (n == 0) return;
+    double cycle = (double)g->cycle_ns;
+    if (n == 1 && g->windows[tc][0].len_ns >= g->cycle_ns) {
+        *rate = link;
+        return;
+    }
+
+    double guard = 0;
+    uint32_t own = tc_frame(cfg, tc);
+    if (cfg->guard_band) guard = wire_bytes(own ? own : TP_MAX_FRAME_LEN) / link;
+
+    double open[TP_GCL_MAX_ENTRIES], eff[TP_GCL_MAX_ENTRIES];
+    double total = 0;
+    for (int k = 0; k < n; k++) {
+        open[k] = (double)g->windows[tc][k].open_ns;
+        eff[k] = (double)g->windows[tc][k].len_ns - guard;
+        if (eff[k] < 0) eff[k] = 0;
+        total += eff[k];
+    }
+    if (total <= 0) return;
+
+    *rate = link * total / cycle;
+    double worst = 0;
+    for (int k = 0; k < n; k++) {
+        double end = open[k] + eff[k];
+        double served = 0;
+        for (int step = 1; step <= n; step++) {
+            int j = (k + step) % n;
+            double start = open[j] + (k + step >= n ? cycle : 0);
+            double t = start - end;
+            double deficit = t - served * cycle / total;
+            if (deficit > worst) worst = deficit;
+            served += eff[j];
+        }
+    }
+    *latency = worst;
+}
+
+void tp_bound_compute(const tp_bound_cfg_t *cfg, tp_bound_t out[TP_GCL_MAX_TC]) {
+    const tp_gcl_t *g = cfg->gcl;
+    double link = cfg->link_mbps / 8000.0;     // Bytes per ns
+
+    memset(out, 0, sizeof(tp_bound_t) * TP_GCL_MAX_TC);
+
+    for (int tc = 0; tc < TP_GCL_MAX_TC; tc++) {
+        tp_bound_t *b = &out[tc];
+        double R, T;
+        gate_service(cfg, tc, link, &R, &T);
+        b->gate_rate_mbps = R * 8000.0;
+        b->gate_latency_ns = T;
+        b->open = R > 0;
+        if (!b->open) continue;
+
+        // Non-preemptable frame already on the wire when service starts
+        double blocking = 0;
+        for (int j = 0; j < TP_GCL_MAX_TC; j++) {
+            if (j == tc || !gate_ever_open(g, j)) continue;
+            uint32_t frame = tc_frame(cfg, j);
+            if (!frame) continue;
+            int may_block = cfg->guard_band ? (j < tc && gates_overlap(g, tc, j)) : 1;
+            if (may_block && wire_bytes(frame) > blocking) blocking = wire_bytes(frame);
+        }
+        b->blocking_ns = blocking / link;
+
+        // Strict priority: higher TCs sharing open time go first
+        double burst_h = 0, rate_h = 0;
+        for (int j = tc + 1; j < TP_GCL_MAX_TC; j++) {
+            if (!cfg->arrival[j].streams || !gates_overlap(g, tc, j)) continue;
+            burst_h += cfg->arrival[j].burst_bytes;
+            rate_h += cfg->arrival[j].rate_mbps / 8000.0;
+        }
+        double R2 = R - rate_h;
+        double T2 = R2 > 0 ? (R * T + burst_h + blocking) / R2 : INFINITY;
+
+        // CBS: the idle slope caps the rate; higher classes may overdraw by
+        // hiCredit = idle_j * max_other / link bytes, served at that rate
+        double idle = cfg->idle_slope_mbps[tc] / 8000.0;
+        if (idle > 0 && R2 > 0) {
+            double hi_credit = 0;
+            for (int j = tc + 1; j < TP_GCL_MAX_TC; j++) {
+                double idle_j = cfg->idle_slope_mbps[j] / 8000.0;
+                if (idle_j <= 0 || !gates_overlap(g, tc, j)) continue;
+                double max_other = 0;
+                for (int k = 0; k < TP_GCL_MAX_TC; k++) {
+                    if (k != j && tc_frame(cfg, k) && wire_bytes(tc_frame(cfg, k)) > max_other) {
+                        max_other = wire_bytes(tc_frame(cfg, k));
+                    }
+                }
+                hi_credit += idle_j * max_other / link;
+            }
+            if (idle < R2) R2 = idle;
+            T2 += hi_credit / R2;
+        }
+
+        b->rate_mbps = R2 > 0 ? R2 * 8000.0 : 0;
+        b->latency_ns = T2;
+
+        const tp_arrival_t *a = &cfg->arrival[tc];
+        double burst = a->streams ? a->burst_bytes : wire_bytes(cfg->be_frame ? cfg->be_frame : TP_MAX_FRAME_LEN);
+        double rate = a->streams ? a->rate_mbps / 8000.0 : 0;
+
+        b->utilization = R2 > 0 ? rate / R2 : INFINITY;
+        b->stable = R2 > 0 && rate <= R2;
+        if (b->stable) {
+            b->delay_ns = T2 + burst / R2;
+            b->backlog_bytes = burst + rate * T2;
+        } else {
+            b->delay_ns = INFINITY;
+            b->backlog_bytes = INFINITY;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * bound.h - Network-calculus delay/backlog bounds for a TAS/CBS egress port
+ *
+ * Each TC's service is reduced to a rate-latency curve beta(t) = R [t - T]+:
+ *
+ *   gate     R = link * effective open time / cycle, T = the tightest latency
+ *            over all worst-case start points (the instant a window closes);
+ *            with a guard band each window loses one own max-frame time
+ *   blocking one non-preemptable frame of a TC that may be on the wire when
+ *            service starts (lower-priority TCs sharing the window; any
+ *            other TC without a guard band)
+ *   priority higher TCs sharing open time take their arrival curves off the
+ *            top: R' = R - r_H, T' = (R T + b_H) / (R - r_H)
+ *   CBS      an idle slope caps the rate and adds the hiCredit of higher
+ *            CBS classes (idle_j * max frame / link bytes) at that rate:
+ *            T'' = T' + sum(hiCredit_j) / min(R', idleSlope)
+ *
+ * Arrivals are token buckets (burst, rate) per TC, aggregated over streams.
+ * A token bucket through a rate-latency server gives
+ *   delay <= T + b / R,  backlog <= b + r T   (when r <= R)
+ *
+ * All lengths are wire bytes (frame + preamble, FCS and IFG).
+ */
+
+#ifndef TSNPERF_BOUND_H
+#define TSNPERF_BOUND_H
+
+#include <stdint.h>
+
+#include "gcl.h"
+
+// Aggregate of a TC's streams, already in wire bytes
+typedef struct {
+    double burst_bytes;
+    double rate_mbps;
+    uint32_t max_frame;     // Largest frame (bytes as captured, no FCS)
+    int streams;
+} tp_arrival_t;
+
+typedef struct {
+    uint32_t link_mbps;
+    const tp_gcl_t *gcl;    // NULL = gates always open
+    int guard_band;         // Length-aware gate closing (802.1Qbv guard band)
+    uint32_t be_frame;      // Blocking frame of TCs without streams (0 = idle)
+    double idle_slope_mbps[TP_GCL_MAX_TC];  // 0 = no CBS on that TC
+    tp_arrival_t arrival[TP_GCL_MAX_TC];
+} tp_bound_cfg_t;
+
+typedef struct {
+    int open;               // TC gets any service
+    double gate_rate_mbps;
+    double gate_latency_ns;
+    double blocking_ns;
+    double rate_mbps;       // Final rate-latency service curve
+    double latency_ns;
+    double delay_ns;        // Worst-case delay (one max frame if no streams)
+    double backlog_bytes;
+    double utilization;     // r / R
+    int stable;             // r <= R, bounds are finite
+} tp_bound_t;
+
+void tp_bound_cfg_init(tp_bound_cfg_t *cfg, uint32_t link_mbps);
+
+// Add a stream to tc. burst/rate count frame bytes as captured and are
+// converted to wire bytes assuming max_frame-sized frames.
+void tp_bound_add_stream(tp_bound_cfg_t *cfg, int tc, double burst_bytes, double rate_mbps, uint32_t max_frame);
+
+void tp_bound_compute(const tp_bound_cfg_t *cfg, tp_bound_t out[TP_GCL_MAX_TC]);
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * classify.h - Compile-time specialized frame classifier
+ *
+ * tp_classify_frame() is written against constant configuration arguments
+ * and forced inline, so every call site with literal arguments becomes its
+ * own branch-free variant. traffic-capture.c instantiates one pcap handler
+ * per supported configuration and picks it once at startup.
+ */
+
+#ifndef TSNPERF_CLASSIFY_H
+#define TSNPERF_CLASSIFY_H
+
+#include <stdint.h>
+
+#include "frame.h"
+
+// VLAN filter variants
+enum { TP_VLAN_ONE = 0, TP_VLAN_SET = 1, TP_VLAN_ANY = 2, TP_VLAN_MODES };
+
+// Payload variants
+enum { TP_PROTO_UDP = 0, TP_PROTO_PTP = 1, TP_PROTO_MODES };
+
+#define TP_ALWAYS_INLINE static inline __attribute__((always_inline))
+
+typedef struct {
+    int pcp;
+    int vid;            // -1 if untagged
+    int has_seq;
+    uint32_t seq;
+    uint64_t tx_ns;
+    uint32_t payload_off;   // Payload header offset when has_seq
+} tp_pkt_info_t;
+
+// Filter configuration shared by all variants
+typedef struct {
+    int vlan;                   // TP_VLAN_ONE target
+    uint64_t vlan_set[64];      // TP_VLAN_SET bitmap (4096 bits)
+} tp_classify_cfg_t;
+
+static inline void tp_classify_vlan_set_add(tp_classify_cfg_t *cfg, int vid) {
+    cfg->vlan_set[(vid & 0xFFF) >> 6] |= 1ULL << (vid & 63);
+}
+
+TP_ALWAYS_INLINE int tp_classify_vlan_match(const tp_classify_cfg_t *cfg, int vid, const int vlan_mode) {
+    if (vlan_mode == TP_VLAN_ONE) return vid == cfg->vlan;
+    if (vlan_mode == TP_VLAN_SET) return (cfg->vlan_set[vid >> 6] >> (vid & 63)) & 1;
+    return 1;
+}
+
+// Sequence header of an IPv4/UDP test frame; runts and bad IHLs are left unparsed
+TP_ALWAYS_INLINE void tp_classify_seq(const uint8_t *pkt, uint32_t caplen, tp_pkt_info_t *out) {
+    if (caplen < TP_ETH_HLEN + TP_VLAN_HLEN + TP_IPV4_HLEN) return;
+    const uint8_t *ip = pkt + TP_ETH_HLEN + TP_VLAN_HLEN;
+    uint32_t ihl = (ip[0] & 0x0F) * 4;
+    if (ihl < TP_IPV4_HLEN) return;
+    uint32_t off = TP_ETH_HLEN + TP_VLAN_HLEN + ihl + TP_UDP_HLEN;
+    if (ip[9] == TP_IP_PROTO_UDP && caplen >= off + TP_PAYLOAD_HDR_LEN &&
+        tp_rd16(pkt + off) == TP_PAYLOAD_MAGIC) {
+        out->has_seq = 1;
+        out->seq = tp_rd32(pkt + off + 2);
+        out->tx_ns = tp_rd64(pkt + off + 6);
+        out->payload_off = off;
+    }
+}
+
+/*
+ * Classify one frame. Returns 1 and fills *out if the frame belongs to the
+ * configured traffic, 0 otherwise. vlan_mode, proto and parse_seq must be
+ * compile-time constants at the call site.
+ */
+TP_ALWAYS_INLINE int tp_classify_frame(const tp_classify_cfg_t *cfg, const uint8_t *pkt,
+                                       uint32_t caplen, tp_pkt_info_t *out,
+                                       const int vlan_mode, const int proto, const int parse_seq) {
+    if (caplen < TP_ETH_HLEN + TP_VLAN_HLEN) return 0;
+
+    uint16_t ethertype = tp_rd16(pkt + 12);
+    out->has_seq = 0;
+
+    if (proto == TP_PROTO_PTP) {
+        // gPTP is normally untagged link-local; accept tagged PTP too
+        if (ethertype == TP_ETH_TYPE_PTP) {
+            out->pcp = 0;
+            out->vid = -1;
+            return 1;
+        }
+        if (ethertype != TP_ETH_TYPE_VLAN || tp_rd16(pkt + 16) != TP_ETH_TYPE_PTP) return 0;
+        uint16_t tci = tp_rd16(pkt + 14);
+        out->pcp = tci >> 13;
+        out->vid = tci & 0x0FFF;
+        return 1;
+    }
+
+    // IPv4 UDP inside a single 802.1Q tag
+    if (ethertype != TP_ETH_TYPE_VLAN) return 0;
+
+    uint16_t tci = tp_rd16(pkt + 14);
+    int vid = tci & 0x0FFF;
+    if (!tp_classify_vlan_match(cfg, vid, vlan_mode)) return 0;
+    if (tp_rd16(pkt + 16) != TP_ETH_TYPE_IPV4) return 0;
+
+    out->pcp = tci >> 13;
+    out->vid = vid;
+
+    if (parse_seq) tp_classify_seq(pkt, caplen, out);
+
+    return 1;
+}
+
+/*
+ * Reference classifier with the configuration read at runtime on every frame.
+ * Kept for benchmarking against the specialized variants.
+ */
+static inline int tp_classify_frame_generic(const tp_classify_cfg_t *cfg, const uint8_t *pkt,
+                                            uint32_t caplen, tp_pkt_info_t *out,
+                                            int vlan_mode, int proto, int parse_seq) {
+    if (caplen < TP_ETH_HLEN + TP_VLAN_HLEN) return 0;
+
+    uint16_t ethertype = tp_rd16(pkt + 12);
+    out->has_seq = 0;
+    if (proto == TP_PROTO_PTP) {
+        if (ethertype == TP_ETH_TYPE_PTP) {
+            out->pcp = 0; out->vid = -1;
+            return 1;
+        }
+        if (ethertype != TP_ETH_TYPE_VLAN || tp_rd16(pkt + 16) != TP_ETH_TYPE_PTP) return 0;
+    } else if (ethertype != TP_ETH_TYPE_VLAN) {
+        return 0;
+    }
+
+    uint16_t tci = tp_rd16(pkt + 14);
+    int vid = tci & 0x0FFF;
+    if (proto == TP_PROTO_UDP) {
+        if (vlan_mode == TP_VLAN_ONE && vid != cfg->vlan) return 0;
+        if (vlan_mode == TP_VLAN_SET && !((cfg->vlan_set[vid >> 6] >> (vid & 63)) & 1)) return 0;
+        if (tp_rd16(pkt + 16) != TP_ETH_TYPE_IPV4) return 0;
+    }
+
+    out->pcp = tci >> 13;
+    out->vid = vid;
+
+    if (proto == TP_PROTO_UDP && parse_seq && caplen >= TP_ETH_HLEN + TP_VLAN_HLEN + TP_IPV4_HLEN) {
+        const uint8_t *ip = pkt + TP_ETH_HLEN + TP_VLAN_HLEN;
+        uint32_t ihl = (ip[0] & 0x0F) * 4;
+        uint32_t off = TP_ETH_HLEN + TP_VLAN_HLEN + ihl + TP_UDP_HLEN;
+        if (ihl >= TP_IPV4_HLEN && ip[9] == TP_IP_PROTO_UDP && caplen >= off + TP_PAYLOAD_HDR_LEN &&
+            tp_rd16(pkt + off) == TP_PAYLOAD_MAGIC) {
+            out->has_seq = 1;
+            out->seq = tp_rd32(pkt + off + 2);
+            out->tx_ns = tp_rd64(pkt + off + 6);
+        }
+    }
+
+    return 1;
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ * clock.h - Clock helpers shared by the sender and capture engines
+ */
+
+#ifndef TSNPERF_CLOCK_H
+#define TSNPERF_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+#define TP_NSEC_PER_SEC  1000000000ULL
+#define TP_NSEC_PER_USEC 1000ULL
+
+static inline uint64_t tp_clock_ns(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * TP_NSEC_PER_SEC + ts.tv_nsec;
+}
+
+// Loop/scheduling clock
+static inline uint64_t tp_mono_ns(void) {
+    return tp_clock_ns(CLOCK_MONOTONIC);
+}
+
+static inline uint64_t tp_mono_us(void) {
+    return tp_mono_ns() / TP_NSEC_PER_USEC;
+}
+
+// Wall clock, same domain as pcap timestamps (used for payload tx stamps)
+static inline uint64_t tp_real_ns(void) {
+    return tp_clock_ns(CLOCK_REALTIME);
+}
+
+// Busy wait until target CLOCK_MONOTONIC time
+static inline void tp_spin_until_ns(uint64_t target_ns) {
+    while (tp_mono_ns() < target_ns) {
+        // Spin
+    }
+}
+
+static inline uint64_t tp_timeval_ns(long sec, long usec) {
+    return (uint64_t)sec * TP_NSEC_PER_SEC + (uint64_t)usec * TP_NSEC_PER_USEC;
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * frame.c - Test frame template builder
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "frame.h"
+
+int tp_parse_mac(const char *str, uint8_t *mac) {
+    return sscanf(str, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+                  &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) == 6 ? 0 : -1;
+}
+
+uint16_t tp_ip_checksum(const void *buf, int len) {
+    const uint8_t *p = buf;
+    uint32_t sum = 0;
+    while (len > 1) {
+        sum += (p[0] << 8) | p[1];
+        p += 2;
+        len -= 2;
+    }
+    if (len == 1)
+        sum += p[0] << 8;
+    sum = (sum >> 16) + (sum & 0xFFFF);
+    sum += (sum >> 16);
+    return (uint16_t)(~sum);
+}
+
+void tp_frame_spec_init(tp_frame_spec_t *spec, const uint8_t *dst_mac, const uint8_t *src_mac,
+                        int vlan_id, int pcp) {
+    memset(spec, 0, sizeof(*spec));
+    memcpy(spec->dst_mac, dst_mac, 6);
+    memcpy(spec->src_mac, src_mac, 6);
+    spec->vlan_id = vlan_id;
+    spec->pcp = pcp;
+    spec->src_ip = TP_DEFAULT_SRC_IP;
+    spec->dst_ip = TP_DEFAULT_DST_IP;
+    spec->src_port = TP_DEFAULT_SRC_PORT + pcp;
+    spec->dst_port = TP_DEFAULT_DST_PORT + pcp;
+    spec->payload_len = TP_PAYLOAD_HDR_LEN;
+}
+
+int tp_frame_build(uint8_t *frame, size_t cap, const tp_frame_spec_t *spec) {
+    int payload_len = spec->payload_len < TP_PAYLOAD_HDR_LEN ? TP_PAYLOAD_HDR_LEN : spec->payload_len;
+    int len = TP_PAYLOAD_OFFSET + payload_len;
+    if (len < TP_MIN_FRAME_LEN) len = TP_MIN_FRAME_LEN;
+    if ((size_t)len > cap) return -1;
+
+    memset(frame, 0, len);
+
+    // Ethernet header + 802.1Q tag
+    memcpy(frame, spec->dst_mac, 6);
+    memcpy(frame + 6, spec->src_mac, 6);
+    tp_wr16(frame + 12, TP_ETH_TYPE_VLAN);
+    tp_wr16(frame + 14, tp_tci(spec->pcp, spec->vlan_id));
+    tp_wr16(frame + 16, TP_ETH_TYPE_IPV4);
+
+    // IPv4 header
+    uint8_t *ip = frame + TP_ETH_HLEN + TP_VLAN_HLEN;
+    ip[0] = 0x45;                           // Version + IHL
+    ip[1] = (spec->pcp & 0x7) << 5;         // DSCP = PCP, ECN = 0
+    tp_wr16(ip + 2, TP_IPV4_HLEN + TP_UDP_HLEN + payload_len);
+    ip[8] = 64;                             // TTL
+    ip[9] = TP_IP_PROTO_UDP;
+    tp_wr32(ip + 12, spec->src_ip);
+    tp_wr32(ip + 16, spec->dst_ip);
+    tp_wr16(ip + 10, tp_ip_checksum(ip, TP_IPV4_HLEN));
+
+    // UDP header, checksum optional for IPv4
+    uint8_t *udp = ip + TP_IPV4_HLEN;
+    tp_wr16(udp, spec->src_port);
+    tp_wr16(udp + 2, spec->dst_port);
+    tp_wr16(udp + 4, TP_UDP_HLEN + payload_len);
+
+    // Payload header; seq/tx_ns are stamped per send
+    tp_wr16(frame + TP_PAYLOAD_OFFSET, TP_PAYLOAD_MAGIC);
+
+    return len;
+}
@@ -0,0 +1,97 @@
+/*
+ * frame.h - VLAN/PCP test frame layout, templates and payload stamping
+ *
+ * Test frames are Ethernet + 802.1Q + IPv4 + UDP with a 14-byte payload
+ * header: magic(2) + seq(4) + tx_ns(8), all big-endian.
+ */
+
+#ifndef TSNPERF_FRAME_H
+#define TSNPERF_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TP_ETH_TYPE_VLAN 0x8100
+#define TP_ETH_TYPE_IPV4 0x0800
+#define TP_ETH_TYPE_PTP  0x88F7
+#define TP_IP_PROTO_UDP  17
+
+#define TP_ETH_HLEN      14
+#define TP_VLAN_HLEN     4
+#define TP_IPV4_HLEN     20
+#define TP_UDP_HLEN      8
+#define TP_MIN_FRAME_LEN 60     // Without FCS
+#define TP_MAX_FRAME_LEN 1518
+
+#define TP_PAYLOAD_OFFSET  (TP_ETH_HLEN + TP_VLAN_HLEN + TP_IPV4_HLEN + TP_UDP_HLEN)
+#define TP_PAYLOAD_MAGIC   0x5453  // "TS"
+#define TP_PAYLOAD_HDR_LEN 14
+
+// Default test addressing: 192.168.100.1:10000+pcp -> 192.168.100.2:20000+pcp
+#define TP_DEFAULT_SRC_IP   0xC0A86401
+#define TP_DEFAULT_DST_IP   0xC0A86402
+#define TP_DEFAULT_SRC_PORT 10000
+#define TP_DEFAULT_DST_PORT 20000
+
+typedef struct {
+    uint8_t dst_mac[6];
+    uint8_t src_mac[6];
+    int vlan_id;
+    int pcp;
+    uint32_t src_ip;
+    uint32_t dst_ip;
+    uint16_t src_port;
+    uint16_t dst_port;
+    int payload_len;        // >= TP_PAYLOAD_HDR_LEN
+} tp_frame_spec_t;
+
+static inline uint16_t tp_rd16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t tp_rd32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint64_t tp_rd64(const uint8_t *p) {
+    return ((uint64_t)tp_rd32(p) << 32) | tp_rd32(p + 4);
+}
+
+static inline void tp_wr16(uint8_t *p, uint16_t v) {
+    p[0] = v >> 8; p[1] = v;
+}
+
+static inline void tp_wr32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static inline void tp_wr64(uint8_t *p, uint64_t v) {
+    tp_wr32(p, v >> 32);
+    tp_wr32(p + 4, (uint32_t)v);
+}
+
+static inline uint16_t tp_tci(int pcp, int vid) {
+    return (uint16_t)(((pcp & 0x7) << 13) | (vid & 0xFFF));
+}
+
+// Parse "aa:bb:cc:dd:ee:ff". Returns 0 on success, -1 on error.
+int tp_parse_mac(const char *str, uint8_t *mac);
+
+// RFC 1071 checksum over len bytes
+uint16_t tp_ip_checksum(const void *buf, int len);
+
+// Fill spec with default addressing for a PCP
+void tp_frame_spec_init(tp_frame_spec_t *spec, const uint8_t *dst_mac, const uint8_t *src_mac,
+                        int vlan_id, int pcp);
+
+// Build a frame template. Returns frame length, or -1 if cap is too small.
+int tp_frame_build(uint8_t *frame, size_t cap, const tp_frame_spec_t *spec);
+
+// Stamp sequence number and tx timestamp into a built template
+static inline void tp_frame_stamp(uint8_t *frame, uint32_t seq, uint64_t tx_ns) {
+    uint8_t *p = frame + TP_PAYLOAD_OFFSET + 2;
+    tp_wr32(p, seq);
+    tp_wr64(p + 4, tx_ns);
+}
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * gcl.c - Gate control list parsing and window lookup
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gcl.h"
+
+static void build_windows(tp_gcl_t *g) {
+    memset(g->n_windows, 0, sizeof(g->n_windows));
+
+    for (int tc = 0; tc < TP_GCL_MAX_TC; tc++) {
+        uint8_t bit = 1U << tc;
+        uint64_t offset = 0;
+
+        int open_entries = 0;
+        for (int i = 0; i < g->n_entries; i++) open_entries += !!(g->entries[i].gates & bit);
+        if (open_entries == g->n_entries) {
+            // Always open: one window covering the whole cycle
+            g->windows[tc][0] = (tp_gate_window_t){ .open_ns = 0, .len_ns = g->cycle_ns };
+            g->n_windows[tc] = 1;
+            continue;
+        }
+
+        for (int i = 0; i < g->n_entries; i++) {
+            int open = g->entries[i].gates & bit;
+            int prev_open = g->entries[(i + g->n_entries - 1) % g->n_entries].gates & bit;
+
+            if (open && !prev_open) {
+                // New window; extend over following open entries (wrapping)
+                tp_gate_window_t *w = &g->windows[tc][g->n_windows[tc]++];
+                w->open_ns = offset;
+                w->len_ns = 0;
+                for (int k = 0; k < g->n_entries; k++) {
+                    const tp_gcl_entry_t *e = &g->entries[(i + k) % g->n_entries];
+                    if (!(e->gates & bit)) break;
+                    w->len_ns += e->interval_ns;
+                }
+            }
+            offset += g->entries[i].interval_ns;
+        }
+    }
+}
+
+int tp_gcl_parse(tp_gcl_t *g, const char *spec, uint64_t cycle_ns) {
+    memset(g, 0, sizeof(*g));
+
+    const char *p = spec;
+    uint64_t sum = 0;
+    while (*p && g->n_entries < TP_GCL_MAX_ENTRIES) {
+        char *end;
+        unsigned long gates = strtoul(p, &end, 0);
+        if (end == p || *end != ':' || gates > 0xFF) return -1;
+        p = end + 1;
+        unsigned long interval = strtoul(p, &end, 10);
+        if (end == p || interval == 0 || interval > UINT32_MAX) return -1;
+        p = *end == ',' ? end + 1 : end;
+
+        g->entries[g->n_entries].gates = (uint8_t)gates;
+        g->entries[g->n_entries].interval_ns = (uint32_t)interval;
+        g->n_entries++;
+        sum += interval;
+    }
+    if (*p || g->n_entries == 0) return -1;
+
+    // An explicit cycle longer than the list keeps the last entry's gates;
+    // the stretched entry must still fit its 32-bit interval
+    g->cycle_ns = cycle_ns > sum ? cycle_ns : sum;
+    if (g->cycle_ns > sum) {
+        tp_gcl_entry_t *last = &g->entries[g->n_entries - 1];
+        if (g->cycle_ns - sum > UINT32_MAX - last->interval_ns) return -1;
+        last->interval_ns += (uint32_t)(g->cycle_ns - sum);
+    }
+
+    build_windows(g);
+    return 0;
+}
+
+int tp_gcl_nearest_open(const tp_gcl_t *g, int tc, uint64_t pos, int64_t *err_ns) {
+    int best = -1;
+    int64_t best_err = 0;
+    int64_t half = (int64_t)(g->cycle_ns / 2);
+
+    for (int w = 0; w < g->n_windows[tc]; w++) {
+        int64_t err = (int64_t)pos - (int64_t)g->windows[tc][w].open_ns;
+        if (err >= half) err -= (int64_t)g->cycle_ns;
+        else if (err < -half) err += (int64_t)g->cycle_ns;
+        if (best < 0 || llabs(err) < llabs(best_err)) {
+            best = w;
+            best_err = err;
+        }
+    }
+    if (err_ns) *err_ns = best_err;
+    return best;
+}
+
+int tp_gcl_window_of(const tp_gcl_t *g, int tc, uint64_t pos, uint64_t tx_ns, uint64_t tol_ns,
+                     uint64_t *excess_ns) {
+    uint64_t best = UINT64_MAX;
+
+    for (int w = 0; w < g->n_windows[tc]; w++) {
+        const tp_gate_window_t *win = &g->windows[tc][w];
+        if (win->len_ns >= g->cycle_ns) return w;
+        uint64_t rel = (pos + g->cycle_ns - win->open_ns) % g->cycle_ns;
+        // Either ends past the close or starts before the next open
+        uint64_t late = rel + tx_ns > win->len_ns ? rel + tx_ns - win->len_ns : 0;
+        uint64_t early = g->cycle_ns - rel;
+        uint64_t excess = late < early ? late : early;
+        if (excess <= tol_ns) return w;
+        if (excess < best) best = excess;
+    }
+    if (excess_ns) *excess_ns = best == UINT64_MAX ? 0 : best;
+    return -1;
+}
@@ -0,0 +1,75 @@
+/*
+ * gcl.h - Gate control list (802.1Qbv) model and wire-time helpers
+ *
+ * A GCL is parsed from "<gates>:<interval_ns>,<gates>:<interval_ns>,..."
+ * (gates as decimal or 0x hex bitmask, bit n = TC n). Consecutive entries
+ * that keep a TC's gate open, including across the cycle wrap, are merged
+ * into one open window per TC.
+ */
+
+#ifndef TSNPERF_GCL_H
+#define TSNPERF_GCL_H
+
+#include <stdint.h>
+
+#define TP_GCL_MAX_TC      8
+#define TP_GCL_MAX_ENTRIES 64
+
+// Preamble + SFD (8), FCS (4), inter-frame gap (12)
+#define TP_WIRE_OVERHEAD   24
+#define TP_WIRE_IFG        12
+#define TP_WIRE_MIN_FRAME  60
+
+typedef struct {
+    uint8_t gates;
+    uint32_t interval_ns;
+} tp_gcl_entry_t;
+
+typedef struct {
+    uint64_t open_ns;       // Offset of the gate-open instant within the cycle
+    uint64_t len_ns;
+} tp_gate_window_t;
+
+typedef struct {
+    int n_entries;
+    tp_gcl_entry_t entries[TP_GCL_MAX_ENTRIES];
+    uint64_t cycle_ns;
+    int n_windows[TP_GCL_MAX_TC];
+    tp_gate_window_t windows[TP_GCL_MAX_TC][TP_GCL_MAX_ENTRIES];
+} tp_gcl_t;
+
+// Parse a GCL spec. cycle_ns 0 = sum of intervals. Returns 0 on success, -1 on
+// syntax errors, gates > 0xFF, intervals beyond 32 bits or a cycle_ns that
+// would stretch the last interval beyond 32 bits.
+int tp_gcl_parse(tp_gcl_t *g, const char *spec, uint64_t cycle_ns);
+
+// Position of t within the cycle that starts at phase_ns
+static inline uint64_t tp_gcl_cycle_pos(const tp_gcl_t *g, uint64_t t, int64_t phase_ns) {
+    int64_t rel = ((int64_t)t - phase_ns) % (int64_t)g->cycle_ns;
+    return (uint64_t)(rel < 0 ? rel + (int64_t)g->cycle_ns : rel);
+}
+
+// Window of tc whose open instant is nearest to cycle position pos.
+// *err_ns gets the signed distance (pos - open), wrapped to half a cycle.
+// Returns the window index or -1 if tc never opens.
+int tp_gcl_nearest_open(const tp_gcl_t *g, int tc, uint64_t pos, int64_t *err_ns);
+
+// Window of tc that holds a transmission of tx_ns starting at cycle
+// position pos, allowing tol_ns on either edge. Returns the window index,
+// or -1 with *excess_ns = how far the frame sticks out of the closest one.
+int tp_gcl_window_of(const tp_gcl_t *g, int tc, uint64_t pos, uint64_t tx_ns, uint64_t tol_ns,
+                     uint64_t *excess_ns);
+
+// Time one frame of len bytes (no FCS, as captured) occupies the wire
+static inline uint64_t tp_wire_ns(uint32_t len, uint32_t link_mbps) {
+    if (len < TP_WIRE_MIN_FRAME) len = TP_WIRE_MIN_FRAME;
+    return (uint64_t)(len + TP_WIRE_OVERHEAD) * 8000ULL / link_mbps;
+}
+
+// First preamble bit to last FCS bit of one frame (tp_wire_ns without the IFG)
+static inline uint64_t tp_tx_ns(uint32_t len, uint32_t link_mbps) {
+    if (len < TP_WIRE_MIN_FRAME) len = TP_WIRE_MIN_FRAME;
+    return (uint64_t)(len + TP_WIRE_OVERHEAD - TP_WIRE_IFG) * 8000ULL / link_mbps;
+}
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * guard.c - Gate-close guard band and leakage checks
+ */
+
+#include <string.h>
+
+#include "guard.h"
+
+static const char *kind_names[TP_GUARD_KINDS] = { "ok", "guard", "straddle", "closed" };
+
+const char *tp_guard_kind_name(int kind) {
+    return kind >= 0 && kind < TP_GUARD_KINDS ? kind_names[kind] : "?";
+}
+
+void tp_guard_init(tp_guard_t *g, const tp_gcl_t *gcl, int64_t phase_ns, uint32_t link_mbps,
+                   uint32_t guard_bytes, uint64_t tol_ns) {
+    memset(g, 0, sizeof(*g));
+    g->gcl = gcl;
+    g->phase_ns = phase_ns;
+    g->link_mbps = link_mbps ? link_mbps : 1000;
+    g->guard_ns = guard_bytes ? tp_tx_ns(guard_bytes, g->link_mbps) : 0;
+    g->tol_ns = tol_ns;
+    for (int tc = 0; tc < TP_GCL_MAX_TC; tc++) {
+        g->tc[tc].min_margin_ns = UINT64_MAX;
+        g->tc[tc].cur_cycle = INT64_MIN;
+    }
+}
+
+static int64_t cycle_index(const tp_guard_t *g, uint64_t t_ns) {
+    int64_t cyc = (int64_t)g->gcl->cycle_ns;
+    int64_t d = (int64_t)t_ns - g->phase_ns;
+    return d / cyc - (d % cyc < 0);
+}
+
+// Worst first: closed, then straddle, then guard; larger severity first
+static int worse(const tp_guard_event_t *a, const tp_guard_event_t *b) {
+    if (a->kind != b->kind) return a->kind > b->kind;
+    return a->severity_ns > b->severity_ns;
+}
+
+static void keep_worst(tp_guard_t *g, const tp_guard_event_t *ev) {
+    int n = g->n_worst;
+    if (n == TP_GUARD_WORST && !worse(ev, &g->worst[n - 1])) return;
+    if (n < TP_GUARD_WORST) n = ++g->n_worst;
+
+    int i = n - 1;
+    while (i > 0 && worse(ev, &g->worst[i - 1])) {
+        g->worst[i] = g->worst[i - 1];
+        i--;
+    }
+    g->worst[i] = *ev;
+}
+
+static void count_violation(tp_guard_tc_t *t, int64_t cycle) {
+    if (cycle != t->cur_cycle) {
+        if (t->cur_count) {
+            uint32_t b = t->cur_count < TP_GUARD_PER_CYCLE ? t->cur_count : TP_GUARD_PER_CYCLE;
+            t->per_cycle[b - 1]++;
+        }
+        t->cur_cycle = cycle;
+        t->cur_count = 0;
+    }
+    if (++t->cur_count > t->max_per_cycle) t->max_per_cycle = t->cur_count;
+}
+
+int tp_guard_frame(tp_guard_t *g, int tc, uint64_t t_ns, uint32_t len, uint32_t seq) {
+    const tp_gcl_t *gcl = g->gcl;
+    if (tc < 0 || tc >= TP_GCL_MAX_TC) return TP_GUARD_OK;
+
+    tp_guard_tc_t *t = &g->tc[tc];
+    uint64_t cyc = gcl->cycle_ns;
+    uint64_t pos = tp_gcl_cycle_pos(gcl, t_ns, g->phase_ns);
+    uint64_t tx = tp_tx_ns(len, g->link_mbps);
+
+    if (!tp_guard_gated(gcl, tc)) {
+        t->frames[TP_GUARD_OK]++;
+        return TP_GUARD_OK;
+    }
+
+    int in_window = 0;
+    uint64_t margin = 0;
+    uint64_t closed = UINT64_MAX;
+    for (int w = 0; w < gcl->n_windows[tc]; w++) {
+        const tp_gate_window_t *win = &gcl->windows[tc][w];
+        uint64_t rel = (pos + cyc - win->open_ns) % cyc;
+        if (rel + g->tol_ns >= cyc) rel = 0;                 // Early by no more than tol
+        if (rel < win->len_ns + g->tol_ns) {                // Late starts within tol straddle
+            in_window = 1;
+            margin = rel < win->len_ns ? win->len_ns - rel : 0;
+            break;
+        }
+        uint64_t after = rel - win->len_ns, before = cyc - rel;
+        uint64_t d = after < before ? after : before;
+        if (d < closed) closed = d;
+    }
+
+    tp_guard_event_t ev = { .tc = (uint8_t)tc, .seq = seq, .len = len, .t_ns = t_ns,
+                            .pos_ns = pos, .margin_ns = margin };
+    if (!in_window) {
+        ev.kind = TP_GUARD_CLOSED;
+        ev.severity_ns = closed == UINT64_MAX ? cyc : closed;     // No window at all: a whole cycle
+        if (ev.severity_ns > t->max_closed_ns) t->max_closed_ns = ev.severity_ns;
+    } else if (tx > margin + g->tol_ns) {
+        ev.kind = TP_GUARD_STRADDLE;
+        ev.severity_ns = tx - margin;
+        if (ev.severity_ns > t->max_overrun_ns) t->max_overrun_ns = ev.severity_ns;
+    } else {
+        if (margin < t->min_margin_ns) t->min_margin_ns = margin;
+        if (margin >= g->guard_ns) ev.kind = TP_GUARD_OK;
+        else {
+            ev.kind = TP_GUARD_BAND;
+            ev.severity_ns = g->guard_ns - margin;
+        }
+    }
+
+    int64_t cycle = cycle_index(g, t_ns);
+    if (g->checked++ == 0) g->first_cycle = g->last_cycle = cycle;
+    else if (cycle < g->first_cycle) g->first_cycle = cycle;
+    else if (cycle > g->last_cycle) g->last_cycle = cycle;
+
+    t->frames[ev.kind]++;
+    if (ev.kind == TP_GUARD_OK) return TP_GUARD_OK;
+
+    ev.cycle = cycle;
+    t->bins[pos * TP_GUARD_BINS / cyc]++;
+    count_violation(t, cycle);
+    keep_worst(g, &ev);
+    return ev.kind;
+}
+
+uint64_t tp_guard_cycles(const tp_guard_t *g) {
+    return g->checked ? (uint64_t)(g->last_cycle - g->first_cycle + 1) : 0;
+}
+
+void tp_guard_per_cycle(const tp_guard_tc_t *t, uint64_t out[TP_GUARD_PER_CYCLE]) {
+    memcpy(out, t->per_cycle, sizeof(t->per_cycle));
+    if (t->cur_count) {
+        uint32_t b = t->cur_count < TP_GUARD_PER_CYCLE ? t->cur_count : TP_GUARD_PER_CYCLE;
+        out[b - 1]++;
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * guard.h - Gate-close guard band and leakage checks (802.1Qbv)
+ *
+ * The slot check ("gate" in traffic-capture) only asks whether a frame fits
+ * a window of its TC. Qualification also needs to know how close to the
+ * gate close frames start. Each frame's transmission is rebuilt from its
+ * timestamp (taken as the frame start) and length: it is on the wire for
+ * preamble + frame + FCS at the link speed (tp_tx_ns). Against the GCL in a
+ * known cycle phase a frame of TC t is
+ *   ok        started in a window of t, more than the guard band before it closes
+ *   guard     started within the guard band (the last max-frame time before
+ *             the close) and left the wire in time
+ *   straddle  started in the window but was still on the wire when it closed
+ *   closed    started while t's gate was closed (leakage)
+ * Timestamp jitter up to tol_ns is forgiven at both window edges. Windows
+ * that never close are not checked.
+ *
+ * Violations (guard, straddle, closed) are histogrammed by the cycle
+ * position of their start and by count per cycle, and the worst
+ * TP_GUARD_WORST are kept with their timestamp, cycle and sequence number.
+ */
+
+#ifndef TSNPERF_GUARD_H
+#define TSNPERF_GUARD_H
+
+#include <stdint.h>
+
+#include "gcl.h"
+
+#define TP_GUARD_BINS       64      // Cycle position bins
+#define TP_GUARD_PER_CYCLE  8       // Cycles with 1..7 and >= 8 violations
+#define TP_GUARD_WORST      16
+
+enum { TP_GUARD_OK, TP_GUARD_BAND, TP_GUARD_STRADDLE, TP_GUARD_CLOSED, TP_GUARD_KINDS };
+
+typedef struct {
+    uint64_t frames[TP_GUARD_KINDS];
+    uint64_t min_margin_ns;         // Closest start to a close among frames that fit (UINT64_MAX = none)
+    uint64_t max_overrun_ns;        // Straddle: on the wire past the close
+    uint64_t max_closed_ns;         // Closed: distance to the nearest window edge
+    uint64_t bins[TP_GUARD_BINS];   // Violations by cycle position of the start
+    uint64_t per_cycle[TP_GUARD_PER_CYCLE];    // Finished cycles by violation count
+    uint32_t max_per_cycle;
+    int64_t cur_cycle;              // Cycle of the last violation
+    uint32_t cur_count;             // Violations in it (not yet in per_cycle)
+} tp_guard_tc_t;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t tc;
+    uint32_t seq;                   // 0 without a sender sequence number
+    uint32_t len;
+    uint64_t t_ns;                  // Frame start (checked time domain)
+    int64_t cycle;
+    uint64_t pos_ns;                // Start within the cycle
+    uint64_t margin_ns;             // Start to the close (0 = closed)
+    uint64_t severity_ns;           // guard: into the band; straddle: overrun; closed: distance
+} tp_guard_event_t;
+
+typedef struct {
+    const tp_gcl_t *gcl;
+    int64_t phase_ns;               // Time of a cycle start
+    uint32_t link_mbps;
+    uint64_t guard_ns;              // 0 = no band check
+    uint64_t tol_ns;
+    int64_t first_cycle;
+    int64_t last_cycle;
+    uint64_t checked;               // Frames of TCs with a closing gate
+    tp_guard_tc_t tc[TP_GCL_MAX_TC];
+    int n_worst;
+    tp_guard_event_t worst[TP_GUARD_WORST];
+} tp_guard_t;
+
+// TCs whose gate closes at some point in the cycle (the others are not checked)
+static inline int tp_guard_gated(const tp_gcl_t *gcl, int tc) {
+    return gcl->n_windows[tc] == 0 || gcl->windows[tc][0].len_ns < gcl->cycle_ns;
+}
+
+// guard_bytes: frame length (no FCS) whose transmission time is the guard band
+void tp_guard_init(tp_guard_t *g, const tp_gcl_t *gcl, int64_t phase_ns, uint32_t link_mbps,
+                   uint32_t guard_bytes, uint64_t tol_ns);
+
+// Check one frame starting at t_ns. Returns its TP_GUARD_* kind.
+int tp_guard_frame(tp_guard_t *g, int tc, uint64_t t_ns, uint32_t len, uint32_t seq);
+
+// Cycles spanned by the checked frames
+uint64_t tp_guard_cycles(const tp_guard_t *g);
+
+// per_cycle including the cycle in progress
+void tp_guard_per_cycle(const tp_guard_tc_t *t, uint64_t out[TP_GUARD_PER_CYCLE]);
+
+const char *tp_guard_kind_name(int kind);
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ * hist.c - Log-linear histogram
+ */
+
+#include <string.h>
+
+#include "hist.h"
+
+void tp_hist_reset(tp_hist_t *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void tp_hist_merge(tp_hist_t *dst, const tp_hist_t *src) {
+    if (src->count == 0) return;
+    if (dst->count == 0 || src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+    dst->count += src->count;
+    dst->sum += src->sum;
+    for (int i = 0; i < TP_HIST_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+}
+
+uint64_t tp_hist_bucket_lower(int b) {
+    if (b < TP_HIST_SUB) return (uint64_t)b;
+    int g = b / TP_HIST_SUB;
+    int m = b % TP_HIST_SUB;
+    int e = g + TP_HIST_SUB_BITS - 1;
+    return (uint64_t)(TP_HIST_SUB + m) << (e - TP_HIST_SUB_BITS);
+}
+
+uint64_t tp_hist_bucket_upper(int b) {
+    if (b >= TP_HIST_BUCKETS - 1) return UINT64_MAX;
+    return tp_hist_bucket_lower(b + 1) - 1;
+}
+
+uint64_t tp_hist_quantile(const tp_hist_t *h, double q) {
+    if (h->count == 0) return 0;
+    if (q <= 0) return h->min;
+    if (q >= 1) return h->max;
+
+    uint64_t rank = (uint64_t)(q * h->count);
+    if (rank >= h->count) rank = h->count - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < TP_HIST_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen > rank) {
+            uint64_t v = tp_hist_bucket_upper(i);
+            return v > h->max ? h->max : v;
+        }
+    }
+    return h->max;
+}
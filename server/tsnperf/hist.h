@@ -0,0 +1,55 @@
+/*
+ * hist.h - Log-linear histogram for intervals and latencies
+ *
+ * Values below 16 get exact buckets; above that each power of two is split
+ * into 16 linear sub-buckets (~6% relative resolution) up to 2^64.
+ */
+
+#ifndef TSNPERF_HIST_H
+#define TSNPERF_HIST_H
+
+#include <stdint.h>
+
+#define TP_HIST_SUB_BITS 4
+#define TP_HIST_SUB      (1 << TP_HIST_SUB_BITS)
+#define TP_HIST_BUCKETS  ((64 - TP_HIST_SUB_BITS + 1) * TP_HIST_SUB)
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[TP_HIST_BUCKETS];
+} tp_hist_t;
+
+static inline int tp_hist_bucket(uint64_t v) {
+    if (v < TP_HIST_SUB) return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    return (e - TP_HIST_SUB_BITS + 1) * TP_HIST_SUB + (int)((v >> (e - TP_HIST_SUB_BITS)) & (TP_HIST_SUB - 1));
+}
+
+static inline void tp_hist_add(tp_hist_t *h, uint64_t v) {
+    if (h->count == 0 || v < h->min) h->min = v;
+    if (v > h->max) h->max = v;
+    h->count++;
+    h->sum += v;
+    h->buckets[tp_hist_bucket(v)]++;
+}
+
+void tp_hist_reset(tp_hist_t *h);
+void tp_hist_merge(tp_hist_t *dst, const tp_hist_t *src);
+
+// Smallest value that falls in bucket b
+uint64_t tp_hist_bucket_lower(int b);
+
+// Largest value that falls in bucket b
+uint64_t tp_hist_bucket_upper(int b);
+
+// Value at quantile q (0..1), reported as the bucket upper bound clamped to max
+uint64_t tp_hist_quantile(const tp_hist_t *h, double q);
+
+static inline double tp_hist_mean(const tp_hist_t *h) {
+    return h->count ? (double)h->sum / h->count : 0;
+}
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * json.c - Buffered JSON line writer
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+#include "json.h"
+
+void tp_json_init(tp_json_t *j) {
+    memset(j, 0, sizeof(*j));
+    j->cap = 4096;
+    j->buf = malloc(j->cap);
+}
+
+void tp_json_free(tp_json_t *j) {
+    free(j->buf);
+    j->buf = NULL;
+}
+
+void tp_json_reset(tp_json_t *j) {
+    j->len = 0;
+    j->depth = 0;
+    j->need_comma[0] = 0;
+}
+
+static void reserve(tp_json_t *j, size_t n) {
+    if (j->len + n + 1 <= j->cap) return;
+    while (j->len + n + 1 > j->cap) j->cap *= 2;
+    j->buf = realloc(j->buf, j->cap);
+}
+
+static void append(tp_json_t *j, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    reserve(j, n);
+    va_start(ap, fmt);
+    vsnprintf(j->buf + j->len, j->cap - j->len, fmt, ap);
+    va_end(ap);
+    j->len += n;
+}
+
+static void key_prefix(tp_json_t *j, const char *key) {
+    if (j->need_comma[j->depth]) append(j, ",");
+    j->need_comma[j->depth] = 1;
+    if (key) append(j, "\"%s\":", key);
+}
+
+static void open_container(tp_json_t *j, const char *key, char c) {
+    key_prefix(j, key);
+    append(j, "%c", c);
+    if (j->depth < TP_JSON_MAX_DEPTH - 1) j->depth++;
+    j->need_comma[j->depth] = 0;
+}
+
+static void close_container(tp_json_t *j, char c) {
+    append(j, "%c", c);
+    if (j->depth > 0) j->depth--;
+}
+
+void tp_json_obj_begin(tp_json_t *j, const char *key) { open_container(j, key, '{'); }
+void tp_json_obj_end(tp_json_t *j) { close_container(j, '}'); }
+void tp_json_arr_begin(tp_json_t *j, const char *key) { open_container(j, key, '['); }
+void tp_json_arr_end(tp_json_t *j) { close_container(j, ']'); }
+
+void tp_json_obj_begin_idx(tp_json_t *j, int idx) {
+    char key[16];
+    snprintf(key, sizeof(key), "%d", idx);
+    open_container(j, key, '{');
+}
+
+void tp_json_u64(tp_json_t *j, const char *key, uint64_t v) {
+    key_prefix(j, key);
+    append(j, "%lu", (unsigned long)v);
+}
+
+void tp_json_i64(tp_json_t *j, const char *key, int64_t v) {
+    key_prefix(j, key);
+    append(j, "%ld", (long)v);
+}
+
+void tp_json_f64(tp_json_t *j, const char *key, double v, int precision) {
+    key_prefix(j, key);
+    if (isfinite(v)) append(j, "%.*f", precision, v);
+    else append(j, "null");
+}
+
+void tp_json_bool(tp_json_t *j, const char *key, int v) {
+    key_prefix(j, key);
+    append(j, v ? "true" : "false");
+}
+
+void tp_json_str(tp_json_t *j, const char *key, const char *v) {
+    key_prefix(j, key);
+    append(j, "\"");
+    for (const char *p = v; *p; p++) {
+        if (*p == '"' || *p == '\\') append(j, "\\%c", *p);
+        else if ((unsigned char)*p < 0x20) append(j, "\\u%04x", *p);
+        else append(j, "%c", *p);
+    }
+    append(j, "\"");
+}
+
+void tp_json_flush(tp_json_t *j, FILE *out) {
+    reserve(j, 1);
+    j->buf[j->len++] = '\n';
+    fwrite(j->buf, 1, j->len, out);
+    fflush(out);
+    tp_json_reset(j);
+}
@@ -0,0 +1,46 @@
+/*
+ * json.h - Buffered JSON line writer for engine output
+ *
+ * Builds one JSON document in memory and writes it with a single fwrite,
+ * so output from the stats thread never interleaves with other lines.
+ */
+
+#ifndef TSNPERF_JSON_H
+#define TSNPERF_JSON_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define TP_JSON_MAX_DEPTH 16
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+    int depth;
+    int need_comma[TP_JSON_MAX_DEPTH];
+} tp_json_t;
+
+void tp_json_init(tp_json_t *j);
+void tp_json_free(tp_json_t *j);
+void tp_json_reset(tp_json_t *j);
+
+// Containers; key is NULL inside arrays and for the root
+void tp_json_obj_begin(tp_json_t *j, const char *key);
+void tp_json_obj_end(tp_json_t *j);
+void tp_json_arr_begin(tp_json_t *j, const char *key);
+void tp_json_arr_end(tp_json_t *j);
+
+void tp_json_u64(tp_json_t *j, const char *key, uint64_t v);
+void tp_json_i64(tp_json_t *j, const char *key, int64_t v);
+void tp_json_f64(tp_json_t *j, const char *key, double v, int precision);
+void tp_json_bool(tp_json_t *j, const char *key, int v);
+void tp_json_str(tp_json_t *j, const char *key, const char *v);
+
+// Object key formatted from an integer (e.g. per-TC maps)
+void tp_json_obj_begin_idx(tp_json_t *j, int idx);
+
+// Write the document followed by a newline and flush. Resets the writer.
+void tp_json_flush(tp_json_t *j, FILE *out);
+
+#endif
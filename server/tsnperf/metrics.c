@@ -0,0 +1,278 @@
+/*
+ * metrics.c - OpenMetrics text exporter
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "metrics.h"
+
+#define CONTENT_TYPE "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+static void append(tp_metrics_t *m, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    if (m->len + n + 1 > m->cap) {
+        while (m->len + n + 1 > m->cap) m->cap = m->cap ? m->cap * 2 : 16384;
+        m->buf = realloc(m->buf, m->cap);
+    }
+    va_start(ap, fmt);
+    vsnprintf(m->buf + m->len, m->cap - m->len, fmt, ap);
+    va_end(ap);
+    m->len += n;
+}
+
+void tp_metrics_family(tp_metrics_t *m, const char *name, const char *type, const char *help) {
+    append(m, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+void tp_metrics_escape(char *dst, size_t size, const char *src) {
+    size_t o = 0;
+    for (; *src && o + 3 < size; src++) {
+        if (*src == '\\' || *src == '"') dst[o++] = '\\';
+        if (*src == '\n') {
+            dst[o++] = '\\';
+            dst[o++] = 'n';
+            continue;
+        }
+        dst[o++] = *src;
+    }
+    dst[o] = '\0';
+}
+
+void tp_metrics_u64(tp_metrics_t *m, const char *name, const char *labels, uint64_t v) {
+    if (labels) append(m, "%s{%s} %llu\n", name, labels, (unsigned long long)v);
+    else append(m, "%s %llu\n", name, (unsigned long long)v);
+}
+
+void tp_metrics_f64(tp_metrics_t *m, const char *name, const char *labels, double v) {
+    if (labels) append(m, "%s{%s} %.9g\n", name, labels, v);
+    else append(m, "%s %.9g\n", name, v);
+}
+
+void tp_metrics_hist(tp_metrics_t *m, const char *name, const char *labels, const tp_hist_t *h, double unit) {
+    const char *sep = labels && *labels ? "," : "";
+    if (!labels) labels = "";
+
+    // Exported range: first non-empty group up to the group holding max
+    int last = tp_hist_bucket(h->max) / TP_METRICS_HIST_STEP;
+    int first = -1;
+    for (int b = 0; b < TP_HIST_BUCKETS; b++) {
+        if (h->buckets[b]) {
+            first = b / TP_METRICS_HIST_STEP;
+            break;
+        }
+    }
+    if (first > last) last = first;
+
+    uint64_t cum = 0;
+    if (first >= 0) {
+        for (int b = 0; b < first * TP_METRICS_HIST_STEP; b++) cum += h->buckets[b];
+        for (int g = first; g <= last; g++) {
+            int top = g * TP_METRICS_HIST_STEP + TP_METRICS_HIST_STEP - 1;
+            if (top >= TP_HIST_BUCKETS) top = TP_HIST_BUCKETS - 1;
+            uint64_t in = 0;
+            for (int b = g * TP_METRICS_HIST_STEP; b <= top; b++) in += h->buckets[b];
+            cum += in;
+
+            // Empty runs collapse to the bound just below the next filled group
+            uint64_t next = 0;
+            for (int b = top + 1; b <= top + TP_METRICS_HIST_STEP && b < TP_HIST_BUCKETS; b++) next += h->buckets[b];
+            if (!in && !next && g != last) continue;
+
+            append(m, "%s_bucket{%s%sle=\"%.9g\"} %llu\n", name, labels, sep,
+                   tp_hist_bucket_upper(top) * unit, (unsigned long long)cum);
+        }
+        for (int b = (last + 1) * TP_METRICS_HIST_STEP; b < TP_HIST_BUCKETS; b++) cum += h->buckets[b];
+    }
+    append(m, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels, sep, (unsigned long long)cum);
+    append(m, "%s_count{%s} %llu\n", name, labels, (unsigned long long)cum);
+    append(m, "%s_sum{%s} %.9g\n", name, labels, h->sum * unit);
+}
+
+// VmLck from /proc/self/status, in bytes
+static uint64_t locked_bytes(void) {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return 0;
+    char line[256];
+    unsigned long long kb = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmLck: %llu kB", &kb) == 1) break;
+    }
+    fclose(f);
+    return kb * 1024;
+}
+
+void tp_metrics_rt(tp_metrics_t *m, const char *prefix) {
+    char name[128];
+
+    // Main thread (tid == pid); the exporter thread itself runs SCHED_OTHER
+    int policy = sched_getscheduler(getpid());
+    struct sched_param sp = {0};
+    sched_getparam(getpid(), &sp);
+
+    snprintf(name, sizeof(name), "%s_rt_fifo", prefix);
+    tp_metrics_family(m, name, "gauge", "1 if the engine runs SCHED_FIFO");
+    tp_metrics_u64(m, name, NULL, policy == SCHED_FIFO);
+    snprintf(name, sizeof(name), "%s_rt_priority", prefix);
+    tp_metrics_family(m, name, "gauge", "Real-time priority of the engine");
+    tp_metrics_u64(m, name, NULL, (uint64_t)sp.sched_priority);
+    snprintf(name, sizeof(name), "%s_locked_bytes", prefix);
+    tp_metrics_family(m, name, "gauge", "Memory locked with mlockall");
+    tp_metrics_u64(m, name, NULL, locked_bytes());
+
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        snprintf(name, sizeof(name), "%s_context_switches", prefix);
+        tp_metrics_family(m, name, "counter", "Context switches of all engine threads");
+        snprintf(name, sizeof(name), "%s_context_switches_total", prefix);
+        tp_metrics_u64(m, name, "kind=\"voluntary\"", (uint64_t)ru.ru_nvcsw);
+        tp_metrics_u64(m, name, "kind=\"involuntary\"", (uint64_t)ru.ru_nivcsw);
+        snprintf(name, sizeof(name), "%s_page_faults", prefix);
+        tp_metrics_family(m, name, "counter", "Page faults of the engine");
+        snprintf(name, sizeof(name), "%s_page_faults_total", prefix);
+        tp_metrics_u64(m, name, "kind=\"minor\"", (uint64_t)ru.ru_minflt);
+        tp_metrics_u64(m, name, "kind=\"major\"", (uint64_t)ru.ru_majflt);
+    }
+}
+
+static int open_listener(tp_metrics_server_t *srv, const char *spec) {
+    if (strncmp(spec, "unix:", 5) == 0) {
+        struct sockaddr_un sun = { .sun_family = AF_UNIX };
+        snprintf(sun.sun_path, sizeof(sun.sun_path), "%s", spec + 5);
+        snprintf(srv->unix_path, sizeof(srv->unix_path), "%s", spec + 5);
+        unlink(sun.sun_path);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        if (bind(fd, (struct sockaddr *)&sun, sizeof(sun)) < 0 || listen(fd, 8) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    struct sockaddr_in sin = { .sin_family = AF_INET };
+    const char *colon = strrchr(spec, ':');
+    char addr[64] = "127.0.0.1";
+    if (colon) snprintf(addr, sizeof(addr), "%.*s", (int)(colon - spec), spec);
+    int port = atoi(colon ? colon + 1 : spec);
+    if (port <= 0 || port > 65535 || inet_pton(AF_INET, addr, &sin.sin_addr) != 1) return -1;
+    sin.sin_port = htons(port);
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0 || listen(fd, 8) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        buf += n;
+        len -= n;
+    }
+}
+
+static void serve(tp_metrics_server_t *srv, tp_metrics_t *m, int fd) {
+    struct timeval tv = { .tv_sec = 1 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    // Only the request line matters
+    char req[2048];
+    size_t len = 0;
+    while (len < sizeof(req) - 1) {
+        ssize_t n = read(fd, req + len, sizeof(req) - 1 - len);
+        if (n <= 0) break;
+        len += n;
+        req[len] = '\0';
+        if (strstr(req, "\r\n\r\n") || strstr(req, "\n\n")) break;
+    }
+    req[len] = '\0';
+
+    char head[256];
+    if (strncmp(req, "GET /metrics", 12) != 0 && strncmp(req, "GET / ", 6) != 0) {
+        int n = snprintf(head, sizeof(head),
+                         "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        write_all(fd, head, n);
+        return;
+    }
+
+    m->len = 0;
+    srv->render(m, srv->ctx);
+    append(m, "# EOF\n");
+
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.1 200 OK\r\nContent-Type: " CONTENT_TYPE "\r\n"
+                     "Content-Length: %zu\r\nConnection: close\r\n\r\n", m->len);
+    write_all(fd, head, n);
+    write_all(fd, m->buf, m->len);
+}
+
+static void *server_thread(void *arg) {
+    tp_metrics_server_t *srv = arg;
+
+    // Scrapes must never compete with the real-time threads
+    struct sched_param sp = { .sched_priority = 0 };
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &sp);
+
+    tp_metrics_t m = {0};
+    struct pollfd pfd = { .fd = srv->fd, .events = POLLIN };
+    while (srv->running) {
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        int fd = accept4(srv->fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        serve(srv, &m, fd);
+        close(fd);
+    }
+    free(m.buf);
+    return NULL;
+}
+
+int tp_metrics_start(tp_metrics_server_t *srv, const char *spec, tp_metrics_render_fn render, void *ctx) {
+    memset(srv, 0, sizeof(*srv));
+    srv->render = render;
+    srv->ctx = ctx;
+    srv->fd = open_listener(srv, spec);
+    if (srv->fd < 0) return -1;
+
+    srv->running = 1;
+    if (pthread_create(&srv->tid, NULL, server_thread, srv) != 0) {
+        close(srv->fd);
+        srv->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void tp_metrics_stop(tp_metrics_server_t *srv) {
+    if (srv->fd < 0 || !srv->running) return;
+    srv->running = 0;
+    pthread_join(srv->tid, NULL);
+    close(srv->fd);
+    if (srv->unix_path[0]) unlink(srv->unix_path);
+    srv->fd = -1;
+}
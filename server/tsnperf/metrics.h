@@ -0,0 +1,66 @@
+/*
+ * metrics.h - OpenMetrics text exporter for the engines
+ *
+ * A background thread serves "GET /metrics" on a local TCP port or Unix
+ * socket. Each scrape calls the engine's render callback, which reads
+ * seqlock snapshots and monotonic histogram buckets, so scrapes never
+ * take a lock the packet path waits on.
+ *
+ * Histograms are exported as classic cumulative buckets (seconds) built
+ * from the log-linear tp_hist_t buckets, four per power of two (~19%).
+ */
+
+#ifndef TSNPERF_METRICS_H
+#define TSNPERF_METRICS_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hist.h"
+
+// tp_hist_t sub-buckets merged into one exported bucket
+#define TP_METRICS_HIST_STEP 4
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+} tp_metrics_t;
+
+typedef void (*tp_metrics_render_fn)(tp_metrics_t *m, void *ctx);
+
+typedef struct {
+    int fd;
+    char unix_path[108];
+    volatile int running;
+    pthread_t tid;
+    tp_metrics_render_fn render;
+    void *ctx;
+} tp_metrics_server_t;
+
+// Listen on "<port>", "<addr>:<port>" or "unix:<path>" (bare ports bind
+// 127.0.0.1) and serve scrapes from a thread. Returns 0 on success.
+int tp_metrics_start(tp_metrics_server_t *srv, const char *spec, tp_metrics_render_fn render, void *ctx);
+void tp_metrics_stop(tp_metrics_server_t *srv);
+
+// "# TYPE" / "# HELP" header of a metric family (name without _total)
+void tp_metrics_family(tp_metrics_t *m, const char *name, const char *type, const char *help);
+
+// Copy src into a label value, escaping backslash, quote and newline
+void tp_metrics_escape(char *dst, size_t size, const char *src);
+
+// One sample; labels is the inner label list ("tc=\"3\"") or NULL
+void tp_metrics_u64(tp_metrics_t *m, const char *name, const char *labels, uint64_t v);
+void tp_metrics_f64(tp_metrics_t *m, const char *name, const char *labels, double v);
+
+// _bucket/_count/_sum samples of h; values are scaled by unit (e.g. 1e-9 for ns -> s).
+// Buckets are read without a lock; counts are monotonic, so a scrape racing
+// the writer is off by at most the frames in flight.
+void tp_metrics_hist(tp_metrics_t *m, const char *name, const char *labels, const tp_hist_t *h, double unit);
+
+// Process real-time health: scheduling policy/priority, locked memory,
+// context switches and page faults (family prefix e.g. "tsn_capture")
+void tp_metrics_rt(tp_metrics_t *m, const char *prefix);
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * payload.c - PRBS-31 payload generation, CRC32C and payload verification
+ */
+
+#include <string.h>
+
+#include "payload.h"
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#define CRC32C_POLY 0x82F63B78u     // Reflected Castagnoli
+
+static uint32_t crc_table[8][256];
+static int crc_table_ready;
+
+// Slicing-by-8 tables for CPUs without a CRC32C instruction
+static void crc_table_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = c & 1 ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+        crc_table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int t = 1; t < 8; t++) crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^ crc_table[0][crc_table[t - 1][i] & 0xFF];
+    }
+    crc_table_ready = 1;
+}
+
+static uint32_t crc32c_sw(uint32_t c, const uint8_t *p, size_t len) {
+    if (!crc_table_ready) crc_table_init();
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        v ^= c;
+        c = crc_table[7][v & 0xFF] ^ crc_table[6][(v >> 8) & 0xFF] ^
+            crc_table[5][(v >> 16) & 0xFF] ^ crc_table[4][(v >> 24) & 0xFF] ^
+            crc_table[3][(v >> 32) & 0xFF] ^ crc_table[2][(v >> 40) & 0xFF] ^
+            crc_table[1][(v >> 48) & 0xFF] ^ crc_table[0][v >> 56];
+        p += 8;
+        len -= 8;
+    }
+    while (len--) c = (c >> 8) ^ crc_table[0][(c ^ *p++) & 0xFF];
+    return c;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t c, const uint8_t *p, size_t len) {
+    uint64_t c64 = c;
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        c64 = __builtin_ia32_crc32di(c64, v);
+        p += 8;
+        len -= 8;
+    }
+    c = (uint32_t)c64;
+    while (len--) c = __builtin_ia32_crc32qi(c, *p++);
+    return c;
+}
+
+static int crc_hw = -1;
+#endif
+
+uint32_t tp_crc32c(uint32_t crc, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    uint32_t c = ~crc;
+#if defined(__x86_64__)
+    if (crc_hw < 0) crc_hw = __builtin_cpu_supports("sse4.2");
+    c = crc_hw ? crc32c_hw(c, p, len) : crc32c_sw(c, p, len);
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        c = __crc32cd(c, v);
+        p += 8;
+        len -= 8;
+    }
+    while (len--) c = __crc32cb(c, *p++);
+#else
+    c = crc32c_sw(c, p, len);
+#endif
+    return ~c;
+}
+
+// Eight steps of the x^31 + x^28 + 1 register at once: the next eight
+// output bits only depend on register bits 30..20
+static inline uint8_t prbs31_next(uint32_t *s) {
+    uint8_t b = (uint8_t)((*s >> 23) ^ (*s >> 20));
+    *s = ((*s << 8) | b) & 0x7FFFFFFF;
+    return b;
+}
+
+void tp_prbs31_fill(uint8_t *buf, size_t len, uint32_t seed) {
+    uint32_t s = seed & 0x7FFFFFFF;
+    if (!s) s = 1;
+    for (size_t i = 0; i < len; i++) buf[i] = prbs31_next(&s);
+}
+
+uint32_t tp_prbs31_errors(const uint8_t *buf, size_t len, uint32_t seed) {
+    uint32_t s = seed & 0x7FFFFFFF;
+    if (!s) s = 1;
+    uint32_t errors = 0;
+    for (size_t i = 0; i < len; i++) errors += __builtin_popcount(buf[i] ^ prbs31_next(&s));
+    return errors;
+}
+
+int tp_payload_fill(uint8_t *payload, int payload_len, uint32_t seed) {
+    if (payload_len < TP_PAYLOAD_CHECK_MIN) return -1;
+
+    uint8_t *h = payload + TP_PAYLOAD_HDR_LEN;
+    uint8_t *body = h + TP_PAYLOAD_CHECK_LEN;
+    uint16_t body_len = (uint16_t)(payload_len - TP_PAYLOAD_CHECK_MIN);
+
+    tp_prbs31_fill(body, body_len, seed);
+    tp_wr16(h, TP_PAYLOAD_CHECK_MAGIC);
+    tp_wr16(h + 2, body_len);
+    tp_wr32(h + 4, seed);
+    tp_wr32(h + 8, tp_crc32c(0, body, body_len));
+    return 0;
+}
+
+int tp_payload_check(const uint8_t *payload, uint32_t declared_len, uint32_t captured_len,
+                     uint32_t wire_len, uint32_t *bit_errors) {
+    *bit_errors = 0;
+    if (wire_len < declared_len) return TP_CHECK_TRUNCATED;
+    if (captured_len < TP_PAYLOAD_CHECK_MIN) return TP_CHECK_NONE;
+
+    const uint8_t *h = payload + TP_PAYLOAD_HDR_LEN;
+    if (tp_rd16(h) != TP_PAYLOAD_CHECK_MAGIC) return TP_CHECK_NONE;
+
+    uint32_t body_len = tp_rd16(h + 2);
+    if (TP_PAYLOAD_CHECK_MIN + body_len > declared_len) return TP_CHECK_CORRUPT;     // Header hit
+    if (TP_PAYLOAD_CHECK_MIN + body_len > captured_len) return TP_CHECK_SHORT;
+
+    const uint8_t *body = h + TP_PAYLOAD_CHECK_LEN;
+    if (tp_crc32c(0, body, body_len) == tp_rd32(h + 8)) return TP_CHECK_OK;
+
+    // Slow path: count flipped bits against the expected sequence
+    *bit_errors = tp_prbs31_errors(body, body_len, tp_rd32(h + 4));
+    return TP_CHECK_CORRUPT;
+}
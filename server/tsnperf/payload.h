@@ -0,0 +1,70 @@
+/*
+ * payload.h - PRBS-31 test payloads and their integrity check
+ *
+ * A checked payload follows the 14-byte seq/timestamp header with a
+ * 12-byte check header and a body:
+ *
+ *   magic(2) "PC" + body_len(2) + seed(4) + crc32c(body)(4) + body
+ *
+ * The body is the PRBS-31 sequence (x^31 + x^28 + 1, ITU-T O.150) started
+ * from the stream's seed, so it is fixed per stream and built once into the
+ * frame template; the sender's per-frame cost is unchanged. The receiver
+ * checks the body against the carried CRC32C (SSE4.2 / ARMv8 CRC
+ * instructions, table fallback) and only on a mismatch regenerates the
+ * sequence to count the flipped bits.
+ *
+ * Truncation is judged against the UDP length and body_len, so a frame cut
+ * short on the wire counts as truncated even when the cut part was padding
+ * the capture could not see.
+ */
+
+#ifndef TSNPERF_PAYLOAD_H
+#define TSNPERF_PAYLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "frame.h"
+
+#define TP_PAYLOAD_CHECK_MAGIC 0x5043  // "PC"
+#define TP_PAYLOAD_CHECK_LEN   12
+#define TP_PAYLOAD_CHECK_MIN   (TP_PAYLOAD_HDR_LEN + TP_PAYLOAD_CHECK_LEN)
+
+// Outcome of tp_payload_check()
+enum {
+    TP_CHECK_NONE = 0,      // No check header (plain payload)
+    TP_CHECK_OK,
+    TP_CHECK_CORRUPT,       // CRC mismatch; bit errors counted against the PRBS
+    TP_CHECK_TRUNCATED,     // Fewer bytes on the wire than the headers declare
+    TP_CHECK_SHORT,         // Intact on the wire but beyond the capture snaplen
+};
+
+// Per-stream seed: the configured base mixed with the PCP, never zero
+static inline uint32_t tp_payload_seed(uint32_t base, int pcp) {
+    uint32_t s = (base ^ ((uint32_t)pcp * 0x9E3779B9u)) & 0x7FFFFFFF;
+    return s ? s : 1;
+}
+
+// CRC32C (Castagnoli), hardware-accelerated where the CPU supports it
+uint32_t tp_crc32c(uint32_t crc, const void *buf, size_t len);
+
+// Fill len bytes with PRBS-31 from seed (MSB first)
+void tp_prbs31_fill(uint8_t *buf, size_t len, uint32_t seed);
+
+// Bits of buf that differ from the PRBS-31 sequence of seed
+uint32_t tp_prbs31_errors(const uint8_t *buf, size_t len, uint32_t seed);
+
+// Write check header and PRBS body into the payload of a built template
+// (frame + TP_PAYLOAD_OFFSET). Returns 0, or -1 if payload_len is too short.
+int tp_payload_fill(uint8_t *payload, int payload_len, uint32_t seed);
+
+/*
+ * Check one received payload. declared_len is the payload length from the
+ * UDP header, captured_len the bytes captured from payload on and wire_len
+ * the bytes that were on the wire from payload on. Returns a TP_CHECK_*
+ * result; *bit_errors is set for TP_CHECK_CORRUPT.
+ */
+int tp_payload_check(const uint8_t *payload, uint32_t declared_len, uint32_t captured_len,
+                     uint32_t wire_len, uint32_t *bit_errors);
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * preempt.c - Express latency split and overtake detection of the preemption mix
+ */
+
+#include <string.h>
+
+#include "gcl.h"
+#include "preempt.h"
+
+void tp_preempt_init(tp_preempt_t *p, uint32_t link_mbps) {
+    memset(p, 0, sizeof(*p));
+    p->link_mbps = link_mbps ? link_mbps : 1000;
+    p->pending_bin = -1;
+}
+
+static int offset_bin(tp_preempt_t *p, uint32_t offset_ns) {
+    for (int i = 0; i < p->n_bins; i++) {
+        if (p->bins[i].offset_ns == offset_ns) return i;
+    }
+    if (p->n_bins == TP_PREEMPT_OFFSETS) return -1;
+
+    // Kept sorted by offset for the report
+    int i = p->n_bins++;
+    while (i > 0 && p->bins[i - 1].offset_ns > offset_ns) {
+        p->bins[i] = p->bins[i - 1];
+        if (p->pending_bin == i - 1) p->pending_bin = i;
+        i--;
+    }
+    memset(&p->bins[i], 0, sizeof(p->bins[i]));
+    p->bins[i].offset_ns = offset_ns;
+    return i;
+}
+
+static void bin_add(tp_preempt_bin_t *b, int64_t lat_ns) {
+    b->frames++;
+    if (lat_ns < 0) return;
+    uint64_t lat = (uint64_t)lat_ns;
+    if (b->lat_count == 0 || lat < b->lat_min_ns) b->lat_min_ns = lat;
+    if (lat > b->lat_max_ns) b->lat_max_ns = lat;
+    b->lat_sum_ns += lat;
+    b->lat_count++;
+}
+
+void tp_preempt_frame(tp_preempt_t *p, const tp_mix_tag_t *t, uint32_t len, int64_t lat_ns) {
+    if (t->cls == TP_MIX_PREEMPTABLE) {
+        p->preemptable++;
+        if (len > p->preempt_len) p->preempt_len = len;
+        if (p->pending && t->slot == p->pending_slot) {
+            p->contended.overtakes++;
+            if (p->pending_bin >= 0) p->bins[p->pending_bin].overtakes++;
+        }
+        p->pending = 0;
+        if (!p->slot_seen || (int32_t)(t->slot - p->last_slot) > 0) p->last_slot = t->slot;
+        p->slot_seen = 1;
+        return;
+    }
+
+    if (t->offset_ns == TP_MIX_ALONE) {
+        bin_add(&p->alone, lat_ns);
+        return;
+    }
+    int bin = offset_bin(p, t->offset_ns);
+    bin_add(&p->contended, lat_ns);
+    if (bin >= 0) bin_add(&p->bins[bin], lat_ns);
+
+    // Its preemptable frame not in yet: confirmed as an overtake when it
+    // arrives, forgotten if it never does
+    if (!p->slot_seen || (int32_t)(t->slot - p->last_slot) > 0) {
+        p->pending = 1;
+        p->pending_slot = t->slot;
+        p->pending_bin = bin;
+    }
+}
+
+uint64_t tp_preempt_block_ns(const tp_preempt_t *p, uint32_t offset_ns) {
+    if (!p->preempt_len) return 0;
+    uint64_t tx = tp_tx_ns(p->preempt_len, p->link_mbps);
+    return tx > offset_ns ? tx - offset_ns : 0;
+}
+
+uint64_t tp_preempt_hold_ns(const tp_preempt_t *p, uint32_t offset_ns) {
+    uint64_t block = tp_preempt_block_ns(p, offset_ns);
+    uint64_t hold = tp_wire_ns(TP_PREEMPT_HOLD_BYTES, p->link_mbps);
+    return block < hold ? block : hold;
+}
+
+void tp_preempt_overlap(const tp_preempt_t *p, uint64_t *frames, uint64_t *overtakes) {
+    *frames = *overtakes = 0;
+    for (int i = 0; i < p->n_bins; i++) {
+        if (tp_preempt_block_ns(p, p->bins[i].offset_ns) == 0) continue;
+        *frames += p->bins[i].frames;
+        *overtakes += p->bins[i].overtakes;
+    }
+}
+
+const char *tp_preempt_verdict(const tp_preempt_t *p) {
+    uint64_t frames, overtakes;
+    tp_preempt_overlap(p, &frames, &overtakes);
+    if (frames == 0) return "unknown";
+    if (overtakes * 2 >= frames) return "active";
+    return overtakes ? "partial" : "off";
+}
@@ -0,0 +1,115 @@
+/*
+ * preempt.h - Frame preemption (802.1Qbu / 802.3br) traffic mix and analysis
+ *
+ * The sender's preemption mix (traffic-sender --express) runs in slots. A
+ * contended slot launches a large frame of a preemptable TC and, offset_ns
+ * later, a small frame of an express TC; an alone slot launches only the
+ * express frame, as the uncontended reference. Offsets are cycled from a
+ * list, so one run sweeps the express launch across the preemptable frame.
+ * Each mix frame carries a tag after the seq/timestamp header, in place of
+ * a PRBS check header (tsnperf/payload.h):
+ *
+ *   magic(2) "FP" + class(1) + reserved(1) + offset_ns(4) + slot(4)
+ *
+ * slot numbers the contended slots; an express frame names the preemptable
+ * frame it was launched against. offset_ns is TP_MIX_ALONE in alone slots.
+ *
+ * The receiver (tp_preempt_frame) splits express latency from the embedded
+ * timestamps into alone and contended, and per offset. Without preemption
+ * an express frame launched at offset o waits for the rest of the
+ * preemptable frame, about tx(len) - o; with preemption it waits at most
+ * for the fragment in flight (TP_PREEMPT_HOLD_BYTES) and reaches the
+ * capture port before the preemptable frame is reassembled. Such overtakes
+ * give the verdict: active, partial or off. Links without MAC merge
+ * (software bench, veth) come out "off" with the express frames queued
+ * behind the preemptable ones, so the analysis still runs end to end.
+ */
+
+#ifndef TSNPERF_PREEMPT_H
+#define TSNPERF_PREEMPT_H
+
+#include <stdint.h>
+
+#include "frame.h"
+
+#define TP_MIX_MAGIC          0x4650  // "FP"
+#define TP_MIX_TAG_LEN        12
+#define TP_MIX_FRAME_MIN      (TP_PAYLOAD_OFFSET + TP_PAYLOAD_HDR_LEN + TP_MIX_TAG_LEN)
+#define TP_MIX_ALONE          UINT32_MAX
+#define TP_PREEMPT_OFFSETS    16      // Distinct express offsets tracked
+#define TP_PREEMPT_HOLD_BYTES 123     // Longest non-preemptable remainder (min fragment + 59)
+
+enum { TP_MIX_NONE = 0, TP_MIX_EXPRESS, TP_MIX_PREEMPTABLE };
+
+typedef struct {
+    uint8_t cls;            // TP_MIX_*
+    uint32_t offset_ns;     // Express launch after its preemptable frame
+    uint32_t slot;
+} tp_mix_tag_t;
+
+// Write a tag into a built template (frame + TP_PAYLOAD_OFFSET)
+static inline void tp_mix_tag_write(uint8_t *payload, const tp_mix_tag_t *t) {
+    uint8_t *p = payload + TP_PAYLOAD_HDR_LEN;
+    tp_wr16(p, TP_MIX_MAGIC);
+    p[2] = t->cls;
+    p[3] = 0;
+    tp_wr32(p + 4, t->offset_ns);
+    tp_wr32(p + 8, t->slot);
+}
+
+// Read the tag of a sequenced payload with avail bytes captured. Returns
+// 1 if it is a mix frame.
+static inline int tp_mix_tag_read(const uint8_t *payload, uint32_t avail, tp_mix_tag_t *t) {
+    const uint8_t *p = payload + TP_PAYLOAD_HDR_LEN;
+    if (avail < TP_PAYLOAD_HDR_LEN + TP_MIX_TAG_LEN || tp_rd16(p) != TP_MIX_MAGIC) return 0;
+    if (p[2] != TP_MIX_EXPRESS && p[2] != TP_MIX_PREEMPTABLE) return 0;
+    t->cls = p[2];
+    t->offset_ns = tp_rd32(p + 4);
+    t->slot = tp_rd32(p + 8);
+    return 1;
+}
+
+// Express frame latency of one group (alone, contended or one offset)
+typedef struct {
+    uint32_t offset_ns;
+    uint64_t frames;
+    uint64_t overtakes;     // Seen before their preemptable frame
+    uint64_t lat_count;     // Frames with a latency (rx not before tx)
+    uint64_t lat_sum_ns;
+    uint64_t lat_min_ns;
+    uint64_t lat_max_ns;
+} tp_preempt_bin_t;
+
+typedef struct {
+    uint32_t link_mbps;
+    uint64_t preemptable;
+    uint32_t preempt_len;   // Longest preemptable frame
+    tp_preempt_bin_t alone;
+    tp_preempt_bin_t contended;
+    int n_bins;
+    tp_preempt_bin_t bins[TP_PREEMPT_OFFSETS];
+    uint32_t last_slot;     // Newest preemptable slot seen
+    int slot_seen;
+    uint32_t pending_slot;  // Express frame ahead of its preemptable frame
+    int pending_bin;        // Its bin, -1 = none
+    int pending;
+} tp_preempt_t;
+
+void tp_preempt_init(tp_preempt_t *p, uint32_t link_mbps);
+
+// Account one mix frame of len bytes; lat_ns < 0 if it has no latency
+void tp_preempt_frame(tp_preempt_t *p, const tp_mix_tag_t *t, uint32_t len, int64_t lat_ns);
+
+// Express wait behind a preemptable frame launched offset_ns earlier:
+// without preemption (the rest of it) and with (one fragment at most)
+uint64_t tp_preempt_block_ns(const tp_preempt_t *p, uint32_t offset_ns);
+uint64_t tp_preempt_hold_ns(const tp_preempt_t *p, uint32_t offset_ns);
+
+// Contended express frames launched while their preemptable frame was
+// still on the wire, and how many of them overtook it
+void tp_preempt_overlap(const tp_preempt_t *p, uint64_t *frames, uint64_t *overtakes);
+
+// "active", "partial", "off", or "unknown" without overlapping frames
+const char *tp_preempt_verdict(const tp_preempt_t *p);
+
+#endif
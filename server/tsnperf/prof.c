@@ -0,0 +1,91 @@
+/*
+ * prof.c - Stage profile bookkeeping and report
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "prof.h"
+
+// Clock reference for cycle -> ns conversion, taken at the first init
+static pthread_once_t ref_once = PTHREAD_ONCE_INIT;
+static uint64_t ref_cycles;
+static uint64_t ref_ns;
+
+static void take_reference(void) {
+    ref_cycles = tp_prof_now();
+    ref_ns = tp_clock_ns(CLOCK_MONOTONIC_RAW);
+}
+
+static double ns_per_cycle(void) {
+    if (!TP_PROF_TSC) return 1.0;
+    uint64_t cycles = tp_prof_now() - ref_cycles;
+    uint64_t ns = tp_clock_ns(CLOCK_MONOTONIC_RAW) - ref_ns;
+    return cycles ? (double)ns / cycles : 0;
+}
+
+void tp_prof_init(tp_prof_t *p, const char *thread, const char *const *stages) {
+    pthread_once(&ref_once, take_reference);
+
+    memset(p, 0, sizeof(*p));
+    p->thread = thread;
+    while (stages[p->n_stages] && p->n_stages < TP_PROF_MAX_STAGES) {
+        p->stage[p->n_stages].name = stages[p->n_stages];
+        p->n_stages++;
+    }
+}
+
+void tp_prof_thread_done(tp_prof_t *p) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+        p->ctx_voluntary = ru.ru_nvcsw;
+        p->ctx_involuntary = ru.ru_nivcsw;
+        p->minor_faults = ru.ru_minflt;
+    }
+    p->done = 1;
+}
+
+static void stage_json(tp_json_t *j, const tp_prof_stage_t *s, double ns_cycle) {
+    const tp_hist_t *h = &s->cycles;
+    tp_json_obj_begin(j, s->name);
+    tp_json_u64(j, "ops", h->count);
+    tp_json_u64(j, "packets", s->items);
+    tp_json_f64(j, "cycles_per_pkt", s->items ? (double)h->sum / s->items : 0, 1);
+    tp_json_f64(j, "cycles_per_op", tp_hist_mean(h), 1);
+    tp_json_u64(j, "p50_cycles", tp_hist_quantile(h, 0.50));
+    tp_json_u64(j, "p99_cycles", tp_hist_quantile(h, 0.99));
+    tp_json_u64(j, "max_cycles", h->max);
+    tp_json_f64(j, "max_stall_us", h->max * ns_cycle / 1000.0, 2);
+    tp_json_f64(j, "total_ms", h->sum * ns_cycle / 1e6, 2);
+    tp_json_u64(j, "max_batch", s->max_items);
+    tp_json_obj_end(j);
+}
+
+void tp_prof_json(tp_json_t *j, const char *key, tp_prof_t *const *profs, int n) {
+    double ns_cycle = ns_per_cycle();
+
+    tp_json_obj_begin(j, key);
+    tp_json_str(j, "clock", TP_PROF_TSC ? "tsc" : "monotonic_raw");
+    tp_json_f64(j, "cycles_per_ns", ns_cycle > 0 ? 1.0 / ns_cycle : 0, 3);
+    tp_json_arr_begin(j, "threads");
+    for (int i = 0; i < n; i++) {
+        const tp_prof_t *p = profs[i];
+        tp_json_obj_begin(j, NULL);
+        tp_json_str(j, "thread", p->thread);
+        if (p->done) {
+            tp_json_i64(j, "ctx_voluntary", p->ctx_voluntary);
+            tp_json_i64(j, "ctx_involuntary", p->ctx_involuntary);
+            tp_json_i64(j, "minor_faults", p->minor_faults);
+        }
+        tp_json_obj_begin(j, "stages");
+        for (int s = 0; s < p->n_stages; s++) {
+            if (p->stage[s].cycles.count) stage_json(j, &p->stage[s], ns_cycle);
+        }
+        tp_json_obj_end(j);
+        tp_json_obj_end(j);
+    }
+    tp_json_arr_end(j);
+    tp_json_obj_end(j);
+}
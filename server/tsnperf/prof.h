@@ -0,0 +1,86 @@
+/*
+ * prof.h - Hot-path stage profiling for the engines
+ *
+ * Each thread owns a tp_prof_t and brackets its stages (spin wait, send(),
+ * pcap_dispatch(), ring hand-off, ...) with tp_prof_begin()/tp_prof_end().
+ * Stages keep a cycle histogram per timed section plus the number of
+ * packets it covered, so the report gives cycles/packet, tail and the
+ * longest stall. Nothing is shared between threads on the hot path.
+ *
+ * The clock is the TSC on x86 and CLOCK_MONOTONIC_RAW elsewhere; cycles
+ * are converted to time from the TSC rate measured over the run.
+ *
+ * Built with TP_PROFILE=0 (cmake -DTSNPERF_PROFILE=OFF) begin/end fold to
+ * nothing and the engines skip the report.
+ */
+
+#ifndef TSNPERF_PROF_H
+#define TSNPERF_PROF_H
+
+#include <stdint.h>
+
+#include "clock.h"
+#include "hist.h"
+#include "json.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TP_PROF_TSC 1
+#else
+#define TP_PROF_TSC 0
+#endif
+
+#ifndef TP_PROFILE
+#define TP_PROFILE 1
+#endif
+
+#define TP_PROF_MAX_STAGES 8
+
+typedef struct {
+    const char *name;
+    uint64_t items;         // Packets covered by the timed sections
+    uint64_t max_items;     // Largest single section (batch size)
+    tp_hist_t cycles;       // Cycles per timed section
+} tp_prof_stage_t;
+
+typedef struct {
+    const char *thread;
+    int n_stages;
+    tp_prof_stage_t stage[TP_PROF_MAX_STAGES];
+    long ctx_voluntary;     // From getrusage(RUSAGE_THREAD) at tp_prof_thread_done
+    long ctx_involuntary;
+    long minor_faults;
+    int done;
+} tp_prof_t;
+
+static inline uint64_t tp_prof_now(void) {
+#if TP_PROF_TSC
+    return __rdtsc();
+#else
+    return tp_clock_ns(CLOCK_MONOTONIC_RAW);
+#endif
+}
+
+static inline uint64_t tp_prof_begin(void) {
+    return TP_PROFILE ? tp_prof_now() : 0;
+}
+
+// Close a section started at t0 that handled items packets
+static inline void tp_prof_end(tp_prof_t *p, int stage, uint64_t t0, uint64_t items) {
+    if (!TP_PROFILE) return;
+    tp_prof_stage_t *s = &p->stage[stage];
+    tp_hist_add(&s->cycles, tp_prof_now() - t0);
+    s->items += items;
+    if (items > s->max_items) s->max_items = items;
+}
+
+// stages: NULL-terminated stage names, indexed by the caller's stage ids
+void tp_prof_init(tp_prof_t *p, const char *thread, const char *const *stages);
+
+// Record the calling thread's context switches; call on the owning thread
+void tp_prof_thread_done(tp_prof_t *p);
+
+// "profile":{...} for n threads (only those marked done report rusage)
+void tp_prof_json(tp_json_t *j, const char *key, tp_prof_t *const *profs, int n);
+
+#endif
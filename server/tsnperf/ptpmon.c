@@ -0,0 +1,133 @@
+/*
+ * ptpmon.c - Sync gaps, interval and correction jumps, GM changes, clock steps
+ */
+
+#include <string.h>
+
+#include "frame.h"
+#include "ptpmon.h"
+
+#define SEQ_RESTART 1000            // Larger sequenceId jumps are a restarted sender
+
+static const char *names[TP_PTP_EV_KINDS] = {
+    "sync_gap", "sync_interval", "correction", "gm_change", "step",
+};
+
+const char *tp_ptp_event_name(int kind) {
+    return kind >= 0 && kind < TP_PTP_EV_KINDS ? names[kind] : "?";
+}
+
+void tp_ptpmon_init(tp_ptpmon_t *m, tp_ring_t *out) {
+    memset(m, 0, sizeof(*m));
+    m->out = out;
+}
+
+static void emit(tp_ptpmon_t *m, int kind, int64_t value, uint64_t host_ns, uint64_t ptp_ns) {
+    m->events[kind]++;
+    tp_ptp_event_t ev = { .kind = (uint8_t)kind, .value = value, .host_ns = host_ns, .ptp_ns = ptp_ns };
+    if (m->out) tp_ring_push(m->out, &ev);
+}
+
+// Announce: grandmasterIdentity and stepsRemoved of the given source port
+static int parse_announce(const uint8_t *pkt, uint32_t caplen, uint8_t source[10], uint8_t gm[8],
+                          uint16_t *steps) {
+    if (caplen < TP_ETH_HLEN + TP_VLAN_HLEN) return -1;
+
+    uint32_t off = TP_ETH_HLEN;
+    uint16_t ethertype = tp_rd16(pkt + 12);
+    if (ethertype == TP_ETH_TYPE_VLAN) {
+        ethertype = tp_rd16(pkt + 16);
+        off += TP_VLAN_HLEN;
+    }
+    // Header, originTimestamp, utcOffset, reserved, priority1, clockQuality,
+    // priority2, grandmasterIdentity, stepsRemoved
+    if (ethertype != TP_ETH_TYPE_PTP || caplen < off + TP_PTP_HDR_LEN + 29) return -1;
+
+    const uint8_t *h = pkt + off;
+    if ((h[0] & 0x0F) != TP_PTP_ANNOUNCE || (h[1] & 0x0F) != 2) return -1;
+    memcpy(source, h + 20, 10);
+    memcpy(gm, h + TP_PTP_HDR_LEN + 19, 8);
+    *steps = tp_rd16(h + TP_PTP_HDR_LEN + 27);
+    return 0;
+}
+
+static void announce(tp_ptpmon_t *m, const uint8_t *pkt, uint32_t caplen, uint64_t host_ns, uint64_t ptp_ns) {
+    uint8_t source[10], gm[8];
+    uint16_t steps;
+    if (parse_announce(pkt, caplen, source, gm, &steps) != 0) return;
+    // Only the port whose Syncs the timebase follows
+    if (!m->have_sync || memcmp(source, m->source, sizeof(source)) != 0) return;
+
+    if (m->have_gm && memcmp(gm, m->gm, sizeof(gm)) != 0) emit(m, TP_PTP_EV_GM_CHANGE, steps, host_ns, ptp_ns);
+    memcpy(m->gm, gm, sizeof(gm));
+    m->have_gm = 1;
+}
+
+void tp_ptpmon_frame(tp_ptpmon_t *m, const tp_timebase_t *tb, const uint8_t *pkt, uint32_t caplen,
+                     uint64_t host_ns) {
+    // PTP time of this frame: the fit, or the last offset while it restarts
+    uint64_t ptp_ns = 0;
+    if (tb->valid) {
+        ptp_ns = tp_timebase_map(tb, host_ns);
+        m->offset_ns = (int64_t)(ptp_ns - host_ns);
+        m->have_offset = 1;
+    } else if (m->have_offset) {
+        ptp_ns = host_ns + (uint64_t)m->offset_ns;
+    }
+
+    if (tb->status.resets > m->resets) {
+        m->resets = tb->status.resets;
+        emit(m, TP_PTP_EV_STEP, (int64_t)m->resets, host_ns, ptp_ns);
+    }
+
+    tp_ptp_msg_t msg;
+    if (tp_ptp_parse(pkt, caplen, &msg) != 0) {
+        announce(m, pkt, caplen, host_ns, ptp_ns);
+        return;
+    }
+    if (!tb->have_source || msg.domain != tb->domain || memcmp(msg.source, tb->source, sizeof(msg.source)) != 0) {
+        return;
+    }
+    // The timebase moved to another source: start over, no events across the switch
+    if (m->have_sync && memcmp(m->source, tb->source, sizeof(m->source)) != 0) {
+        m->have_sync = 0;
+        m->have_corr[0] = m->have_corr[1] = 0;
+        m->have_gm = 0;
+    }
+
+    int k = msg.type == TP_PTP_SYNC ? 0 : 1;
+    if (m->have_corr[k]) {
+        int64_t jump = msg.correction_ns - m->last_corr_ns[k];
+        if (jump > TP_PTPMON_CORR_JUMP_NS || jump < -TP_PTPMON_CORR_JUMP_NS) {
+            emit(m, TP_PTP_EV_CORRECTION, jump, host_ns, ptp_ns);
+        }
+    }
+    m->last_corr_ns[k] = msg.correction_ns;
+    m->have_corr[k] = 1;
+
+    if (msg.type != TP_PTP_SYNC) return;
+
+    if (m->have_sync) {
+        uint16_t diff = (uint16_t)(msg.seq_id - m->last_seq);
+        if (diff == 0) return;                                  // Duplicate
+
+        int known = msg.log_interval >= -8 && msg.log_interval <= 4;
+        int64_t nominal = !known ? 0 : msg.log_interval >= 0 ? 1000000000LL << msg.log_interval
+                                                             : 1000000000LL >> -msg.log_interval;
+        if (diff > 1 && diff < SEQ_RESTART) {
+            // Dated when the first missing Sync was due, not when the gap showed
+            uint64_t due = m->last_sync_ns + (uint64_t)nominal;
+            if (due > host_ns) due = host_ns;
+            emit(m, TP_PTP_EV_SYNC_GAP, diff - 1, due, ptp_ns ? ptp_ns - (host_ns - due) : 0);
+        }
+        // Spacing against the advertised interval, between consecutive Syncs only
+        if (diff == 1 && known) {
+            int64_t dev = (int64_t)(host_ns - m->last_sync_ns) - nominal;
+            if (dev > nominal / 4 || dev < -nominal / 4) emit(m, TP_PTP_EV_SYNC_INTERVAL, dev, host_ns, ptp_ns);
+        }
+    }
+    memcpy(m->source, tb->source, sizeof(m->source));
+    m->last_seq = msg.seq_id;
+    m->last_sync_ns = host_ns;
+    m->have_sync = 1;
+}
@@ -0,0 +1,77 @@
+/*
+ * ptpmon.h - PTP events visible on the wire
+ *
+ * When gate accuracy dips, the first suspect is time sync. The capture
+ * already sees the PTP frames the switch sends on the TAP (the timebase
+ * fit decodes them); this monitor turns the same stream into discrete
+ * events:
+ *   sync_gap       Sync sequenceIds skipped (value: missing Syncs), dated
+ *                  when the first missing one was due
+ *   sync_interval  Sync spacing off the advertised logMessageInterval by
+ *                  more than a quarter (value: deviation in ns)
+ *   correction     correctionField of Sync or Follow_Up jumped by more than
+ *                  TP_PTPMON_CORR_JUMP_NS against the previous one of its
+ *                  type (value: jump in ns)
+ *   gm_change      Announce names another grandmasterIdentity (value:
+ *                  stepsRemoved)
+ *   step           the timebase fit restarted: the PTP clock stepped
+ *                  (value: fit resets so far)
+ * Syncs are followed from one source like the timebase does. Each event
+ * carries its capture time and the PTP time the fit mapped it to (or the
+ * last known offset while the fit is invalid), and goes to an SPSC ring.
+ *
+ * Single writer: the capture drain thread.
+ */
+
+#ifndef TSNPERF_PTPMON_H
+#define TSNPERF_PTPMON_H
+
+#include <stdint.h>
+
+#include "ring.h"
+#include "timebase.h"
+
+#define TP_PTP_ANNOUNCE         0xB
+#define TP_PTPMON_CORR_JUMP_NS  1000
+
+enum {
+    TP_PTP_EV_SYNC_GAP,
+    TP_PTP_EV_SYNC_INTERVAL,
+    TP_PTP_EV_CORRECTION,
+    TP_PTP_EV_GM_CHANGE,
+    TP_PTP_EV_STEP,
+    TP_PTP_EV_KINDS
+};
+
+typedef struct {
+    uint8_t kind;
+    int64_t value;
+    uint64_t host_ns;           // Capture clock
+    uint64_t ptp_ns;            // Switch PTP time (0 = never mapped)
+} tp_ptp_event_t;
+
+typedef struct {
+    int have_sync;
+    uint8_t source[10];
+    uint16_t last_seq;
+    uint64_t last_sync_ns;
+    int have_corr[2];           // Sync, Follow_Up
+    int64_t last_corr_ns[2];
+    int have_gm;
+    uint8_t gm[8];
+    uint64_t resets;            // Timebase resets seen
+    int64_t offset_ns;          // Last valid ptp - host
+    int have_offset;
+    uint64_t events[TP_PTP_EV_KINDS];
+    tp_ring_t *out;
+} tp_ptpmon_t;
+
+void tp_ptpmon_init(tp_ptpmon_t *m, tp_ring_t *out);
+
+// Feed one captured PTP frame after the timebase saw it (drain thread)
+void tp_ptpmon_frame(tp_ptpmon_t *m, const tp_timebase_t *tb, const uint8_t *pkt, uint32_t caplen,
+                     uint64_t host_ns);
+
+const char *tp_ptp_event_name(int kind);
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * queue.c - Train classification against the gate schedule
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame.h"
+#include "queue.h"
+
+void tp_queue_init(tp_queue_est_t *q, const tp_gcl_t *gcl, uint32_t link_mbps,
+                   uint64_t jitter_ns, int64_t phase_ns, tp_ring_t *out) {
+    memset(q, 0, sizeof(*q));
+    q->gcl = gcl;
+    q->link_mbps = link_mbps ? link_mbps : 1000;
+    q->jitter_ns = jitter_ns;
+    q->out = out;
+
+    if (gcl) {
+        for (int tc = 0; tc < TP_GCL_MAX_TC; tc++) {
+            // Always-open TCs never build up a gate-open backlog
+            q->gated[tc] = gcl->n_windows[tc] > 0 && gcl->windows[tc][0].len_ns < gcl->cycle_ns;
+        }
+        if (phase_ns >= 0) {
+            q->phase_ns = phase_ns % (int64_t)gcl->cycle_ns;
+            q->phase_locked = 1;
+        }
+    }
+}
+
+void tp_queue_close_train(tp_queue_est_t *q, int tc) {
+    tp_train_t *t = &q->train[tc];
+    if (t->frames == 0) return;
+
+    tp_queue_sample_t s = {
+        .start_ns = t->start_ns,
+        .cycle = -1,
+        .drain_ns = t->last_ns - t->start_ns + tp_wire_ns(t->first_len, q->link_mbps),
+        .depth = t->frames,
+        .bytes = t->bytes,
+        .tc = (uint8_t)tc,
+    };
+    t->frames = 0;
+
+    tp_queue_summary_t *sum = &q->summary[tc];
+    const tp_gcl_t *g = q->gcl;
+
+    if (g && q->gated[tc]) {
+        if (!q->phase_locked) {
+            // Single frames may arrive anywhere in the window; wait for a backlog
+            if (s.depth < 2) return;
+            int64_t phase = ((int64_t)s.start_ns - (int64_t)g->windows[tc][0].open_ns) % (int64_t)g->cycle_ns;
+            q->phase_ns = phase;
+            q->phase_locked = 1;
+        }
+
+        int64_t err;
+        uint64_t pos = tp_gcl_cycle_pos(g, s.start_ns, q->phase_ns);
+        int w = tp_gcl_nearest_open(g, tc, pos, &err);
+
+        // A lower-priority frame already on the wire may delay the first departure
+        int64_t tol = (int64_t)(q->jitter_ns + tp_wire_ns(TP_MAX_FRAME_LEN, q->link_mbps));
+        if (llabs(err) > tol) {
+            // Queue was empty at gate open; this traffic arrived mid-window
+            sum->unaligned++;
+            return;
+        }
+
+        // Follow slow drift between the host clock and the switch schedule
+        if (!q->phase_fixed) q->phase_ns += err / 16;
+
+        int64_t open_abs = (int64_t)s.start_ns - err - (int64_t)g->windows[tc][w].open_ns - q->phase_ns;
+        s.cycle = (open_abs + (int64_t)g->cycle_ns / 2) / (int64_t)g->cycle_ns;
+        s.overrun = s.drain_ns > g->windows[tc][w].len_ns;
+    } else if (s.depth < 2) {
+        // Without a schedule a lone frame says nothing about queueing
+        return;
+    }
+
+    sum->trains++;
+    sum->depth_sum += s.depth;
+    if (s.depth > sum->max_depth) sum->max_depth = s.depth;
+    if (s.drain_ns > sum->max_drain_ns) sum->max_drain_ns = s.drain_ns;
+    sum->overruns += s.overrun;
+
+    if (q->out) tp_ring_push(q->out, &s);
+}
+
+void tp_queue_flush(tp_queue_est_t *q) {
+    for (int tc = 0; tc < TP_GCL_MAX_TC; tc++) tp_queue_close_train(q, tc);
+}
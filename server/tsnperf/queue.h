@@ -0,0 +1,102 @@
+/*
+ * queue.h - Per-TC queue occupancy inference from departure trains
+ *
+ * Switch queue depths are not observable directly, but frames that were
+ * waiting behind a closed gate leave back to back at line rate once it
+ * opens. A train is a run of same-TC frames whose arrival gaps stay within
+ * one wire time (plus capture jitter). With a GCL, a train that starts at
+ * a gate-open instant is the backlog of that cycle: its length is the queue
+ * depth at gate open and its duration the drain time. Without a GCL every
+ * multi-frame train is reported as a backlog burst.
+ *
+ * The host clock and the switch schedule are not synchronized, so the
+ * cycle phase is either given (capture-clock time of a cycle start) or
+ * locked from the first backlog train and then tracked from the gate-open
+ * alignment error of later trains. Fed switch PTP timestamps
+ * (tsnperf/timebase.h) with the AdminBaseTime as phase, the phase is exact
+ * and set phase_fixed.
+ *
+ * Samples go to an SPSC ring written by the capture thread.
+ */
+
+#ifndef TSNPERF_QUEUE_H
+#define TSNPERF_QUEUE_H
+
+#include <stdint.h>
+
+#include "gcl.h"
+#include "ring.h"
+
+typedef struct {
+    uint64_t start_ns;      // First frame of the train (capture clock)
+    int64_t cycle;          // Cycle index since the phase reference, -1 without GCL
+    uint64_t drain_ns;      // First frame start to last frame end
+    uint32_t depth;         // Frames in the train
+    uint32_t bytes;
+    uint8_t tc;
+    uint8_t overrun;        // Drain did not fit in the gate window
+} tp_queue_sample_t;
+
+typedef struct {
+    uint64_t start_ns;
+    uint64_t last_ns;
+    uint32_t first_len;
+    uint32_t frames;
+    uint32_t bytes;
+} tp_train_t;
+
+typedef struct {
+    uint64_t trains;        // Backlog trains reported
+    uint64_t unaligned;     // Trains not starting at a gate-open instant
+    uint64_t depth_sum;
+    uint32_t max_depth;
+    uint64_t max_drain_ns;
+    uint64_t overruns;
+} tp_queue_summary_t;
+
+typedef struct {
+    const tp_gcl_t *gcl;    // NULL = no schedule known
+    uint32_t link_mbps;
+    uint64_t jitter_ns;     // Capture timestamp jitter tolerance
+    int64_t phase_ns;
+    int phase_locked;
+    int phase_fixed;        // Timestamps already in the switch timebase: no drift tracking
+    int gated[TP_GCL_MAX_TC];
+    tp_train_t train[TP_GCL_MAX_TC];
+    tp_queue_summary_t summary[TP_GCL_MAX_TC];
+    tp_ring_t *out;
+} tp_queue_est_t;
+
+// phase_ns < 0 = lock the cycle phase from the traffic
+void tp_queue_init(tp_queue_est_t *q, const tp_gcl_t *gcl, uint32_t link_mbps,
+                   uint64_t jitter_ns, int64_t phase_ns, tp_ring_t *out);
+
+void tp_queue_close_train(tp_queue_est_t *q, int tc);
+
+// Feed one frame (capture thread)
+static inline void tp_queue_frame(tp_queue_est_t *q, int tc, uint64_t ts_ns, uint32_t len) {
+    tp_train_t *t = &q->train[tc];
+
+    if (t->frames > 0) {
+        uint64_t gap = ts_ns - t->last_ns;
+        uint64_t wire = tp_wire_ns(len > t->first_len ? len : t->first_len, q->link_mbps);
+        if (ts_ns >= t->last_ns && gap <= wire + wire / 4 + q->jitter_ns) {
+            t->last_ns = ts_ns;
+            t->frames++;
+            t->bytes += len;
+            return;
+        }
+        tp_queue_close_train(q, tc);
+    }
+
+    t->start_ns = ts_ns;
+    t->last_ns = ts_ns;
+    t->first_len = len;
+    t->frames = 1;
+    t->bytes = len;
+}
+
+// Close all open trains (after the capture thread stopped)
+void tp_queue_flush(tp_queue_est_t *q);
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * ring.c - SPSC ring allocation
+ */
+
+#include "arena.h"
+#include "ring.h"
+
+int tp_ring_init_in(tp_ring_t *r, struct tp_arena *arena, const char *name, uint32_t capacity,
+                    uint32_t elem_size) {
+    uint32_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+
+    memset(r, 0, sizeof(*r));
+    r->buf = tp_arena_alloc(arena, name, (size_t)cap * elem_size);
+    if (!r->buf) return -1;
+    r->mask = cap - 1;
+    r->elem_size = elem_size;
+    r->arena = arena;
+    return 0;
+}
+
+int tp_ring_init(tp_ring_t *r, uint32_t capacity, uint32_t elem_size) {
+    return tp_ring_init_in(r, NULL, "ring", capacity, elem_size);
+}
+
+void tp_ring_free(tp_ring_t *r) {
+    tp_arena_free(r->arena, r->buf);
+    r->buf = NULL;
+}
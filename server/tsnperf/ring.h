@@ -0,0 +1,75 @@
+/*
+ * ring.h - Lock-free single-producer/single-consumer ring of fixed-size records
+ *
+ * Capacity is a power of two. Producer and consumer indices live on
+ * separate cache lines and each side caches the other's index, so the
+ * common case touches no shared line.
+ */
+
+#ifndef TSNPERF_RING_H
+#define TSNPERF_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define TP_CACHELINE 64
+
+struct tp_arena;
+
+typedef struct {
+    // Producer side
+    _Alignas(TP_CACHELINE) _Atomic uint64_t head;
+    uint64_t tail_cache;
+    uint64_t full_count;        // Records rejected because the ring was full
+    // Consumer side
+    _Alignas(TP_CACHELINE) _Atomic uint64_t tail;
+    uint64_t head_cache;
+    // Read-only after init
+    _Alignas(TP_CACHELINE) uint8_t *buf;
+    uint32_t mask;
+    uint32_t elem_size;
+    struct tp_arena *arena;     // Owner of buf, NULL = heap
+} tp_ring_t;
+
+// Allocate a ring of at least capacity records. Returns 0 on success.
+int tp_ring_init(tp_ring_t *r, uint32_t capacity, uint32_t elem_size);
+// Same, with the buffer carved from an arena (tsnperf/arena.h) and
+// accounted there under name
+int tp_ring_init_in(tp_ring_t *r, struct tp_arena *arena, const char *name, uint32_t capacity,
+                    uint32_t elem_size);
+void tp_ring_free(tp_ring_t *r);
+
+static inline int tp_ring_push(tp_ring_t *r, const void *rec) {
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (head - r->tail_cache > r->mask) {
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if (head - r->tail_cache > r->mask) {
+            r->full_count++;
+            return 0;
+        }
+    }
+    memcpy(r->buf + (size_t)(head & r->mask) * r->elem_size, rec, r->elem_size);
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return 1;
+}
+
+static inline int tp_ring_pop(tp_ring_t *r, void *rec) {
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (tail == r->head_cache) {
+        r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (tail == r->head_cache) return 0;
+    }
+    memcpy(rec, r->buf + (size_t)(tail & r->mask) * r->elem_size, r->elem_size);
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+// Records currently queued (approximate from either side)
+static inline uint64_t tp_ring_depth(const tp_ring_t *r) {
+    return atomic_load_explicit((_Atomic uint64_t *)&r->head, memory_order_relaxed) -
+           atomic_load_explicit((_Atomic uint64_t *)&r->tail, memory_order_relaxed);
+}
+
+#endif
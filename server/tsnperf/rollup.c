@@ -0,0 +1,359 @@
+/*
+ * rollup.c - Append-only rollup segments, tier cascade, retention and mmap reads
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rollup.h"
+
+#define NSEC 1000000000ULL
+
+const char *const tp_rollup_tier_names[TP_ROLLUP_TIERS] = { "1s", "1m", "1h" };
+const uint32_t tp_rollup_resolution_s[TP_ROLLUP_TIERS] = { 1, 60, 3600 };
+const uint64_t tp_rollup_default_retain_s[TP_ROLLUP_TIERS] = { 86400, 90 * 86400, 0 };
+
+// Segment span per tier: 3600, 1440 and 720 records
+static const uint64_t segment_span_s[TP_ROLLUP_TIERS] = { 3600, 86400, 30 * 86400 };
+
+static uint64_t bucket_lower(int b) {
+    if (b == 0) return 0;
+    int e = 6 + (b - 1) / 2;
+    return (1ULL << e) | ((b - 1) % 2 ? 1ULL << (e - 1) : 0);
+}
+
+uint64_t tp_rollup_quantile(const uint32_t *sketch, double q) {
+    uint64_t total = 0;
+    for (int b = 0; b < TP_ROLLUP_SKETCH; b++) total += sketch[b];
+    if (total == 0) return 0;
+
+    uint64_t target = (uint64_t)(q * total);
+    if (target >= total) target = total - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < TP_ROLLUP_SKETCH; b++) {
+        seen += sketch[b];
+        if (seen > target) return b < TP_ROLLUP_SKETCH - 1 ? bucket_lower(b + 1) - 1 : bucket_lower(b);
+    }
+    return bucket_lower(TP_ROLLUP_SKETCH - 1);
+}
+
+void tp_rollup_merge(tp_rollup_rec_t *dst, const tp_rollup_rec_t *src) {
+    dst->seconds += src->seconds;
+    dst->frames += src->frames;
+    dst->bytes += src->bytes;
+    dst->lost += src->lost;
+    dst->ooo += src->ooo;
+    dst->gate_in += src->gate_in;
+    dst->gate_out += src->gate_out;
+    dst->lat_count += src->lat_count;
+    dst->lat_sum_ns += src->lat_sum_ns;
+    dst->interval_sum_ns += src->interval_sum_ns;
+    for (int b = 0; b < TP_ROLLUP_SKETCH; b++) {
+        tp_rollup_sketch_add(dst->lat, b, src->lat[b]);
+        tp_rollup_sketch_add(dst->interval, b, src->interval[b]);
+    }
+}
+
+int tp_rollup_tier(const char *name) {
+    for (int t = 0; t < TP_ROLLUP_TIERS; t++) {
+        if (strcmp(name, tp_rollup_tier_names[t]) == 0) return t;
+    }
+    return -1;
+}
+
+static int mkdir_p(const char *path) {
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", path);
+    for (char *p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, 0755) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    return mkdir(buf, 0755) != 0 && errno != EEXIST ? -1 : 0;
+}
+
+static void tier_dir(char *buf, size_t len, const char *dir, int tier) {
+    snprintf(buf, len, "%s/%s", dir, tp_rollup_tier_names[tier]);
+}
+
+int tp_rollup_open(tp_rollup_t *r, const char *dir, const uint64_t *retain_s) {
+    memset(r, 0, sizeof(*r));
+    snprintf(r->dir, sizeof(r->dir), "%s", dir);
+    for (int t = 0; t < TP_ROLLUP_TIERS; t++) {
+        r->fd[t] = -1;
+        r->retain_s[t] = retain_s ? retain_s[t] : tp_rollup_default_retain_s[t];
+
+        char path[512];
+        tier_dir(path, sizeof(path), dir, t);
+        if (mkdir_p(path) != 0) return -1;
+    }
+    return 0;
+}
+
+// Open (or continue) the segment starting at seg_ns for appending
+static int segment_open(tp_rollup_t *r, int tier, uint64_t seg_ns) {
+    if (r->fd[tier] >= 0) close(r->fd[tier]);
+    r->fd[tier] = -1;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s/%llu.tsr", r->dir, tp_rollup_tier_names[tier],
+             (unsigned long long)(seg_ns / NSEC));
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) goto fail;
+
+    if (st.st_size == 0) {
+        tp_rollup_hdr_t h = {
+            .version = TP_ROLLUP_VERSION,
+            .rec_size = sizeof(tp_rollup_rec_t),
+            .resolution_s = tp_rollup_resolution_s[tier],
+            .start_ns = seg_ns,
+            .span_ns = segment_span_s[tier] * NSEC,
+        };
+        memcpy(h.magic, TP_ROLLUP_MAGIC, 4);
+        if (write(fd, &h, sizeof(h)) != (ssize_t)sizeof(h)) goto fail;
+    } else {
+        tp_rollup_hdr_t h;
+        if (pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || memcmp(h.magic, TP_ROLLUP_MAGIC, 4) != 0 ||
+            h.rec_size != sizeof(tp_rollup_rec_t) || h.start_ns != seg_ns) {
+            goto fail;
+        }
+        // Drop a record torn by a crash, then continue after the last one
+        off_t n = (st.st_size - (off_t)sizeof(h)) / (off_t)sizeof(tp_rollup_rec_t);
+        off_t end = (off_t)sizeof(h) + n * (off_t)sizeof(tp_rollup_rec_t);
+        if (end != st.st_size && ftruncate(fd, end) != 0) goto fail;
+        uint64_t last;
+        if (n > 0 && pread(fd, &last, sizeof(last), end - (off_t)sizeof(tp_rollup_rec_t)) == (ssize_t)sizeof(last) &&
+            last > r->last_ns[tier]) {
+            r->last_ns[tier] = last;
+        }
+    }
+    r->fd[tier] = fd;
+    r->seg_start_ns[tier] = seg_ns;
+    return 0;
+
+fail:
+    close(fd);
+    return -1;
+}
+
+// Unlink segments whose whole span is older than the tier's retention
+static void apply_retention(tp_rollup_t *r, int tier, uint64_t now_ns) {
+    if (r->retain_s[tier] == 0) return;
+    char path[512];
+    tier_dir(path, sizeof(path), r->dir, tier);
+    DIR *d = opendir(path);
+    if (!d) return;
+
+    uint64_t now_s = now_ns / NSEC;
+    struct dirent *e;
+    while ((e = readdir(d))) {
+        char *end;
+        unsigned long long start = strtoull(e->d_name, &end, 10);
+        if (end == e->d_name || strcmp(end, ".tsr") != 0) continue;
+        if (start + segment_span_s[tier] + r->retain_s[tier] < now_s) {
+            char file[800];
+            snprintf(file, sizeof(file), "%s/%s", path, e->d_name);
+            unlink(file);
+        }
+    }
+    closedir(d);
+}
+
+static int tier_write(tp_rollup_t *r, int tier, const tp_rollup_rec_t *rec) {
+    uint64_t span = segment_span_s[tier] * NSEC;
+    uint64_t seg = rec->t_ns - rec->t_ns % span;
+
+    if (r->fd[tier] < 0 || seg != r->seg_start_ns[tier]) {
+        if (segment_open(r, tier, seg) != 0) {
+            r->errors++;
+            return -1;
+        }
+        apply_retention(r, tier, rec->t_ns);
+    }
+    // Segments stay sorted: a clock step backwards loses records, not order
+    if (rec->t_ns < r->last_ns[tier] ||
+        write(r->fd[tier], rec, sizeof(*rec)) != (ssize_t)sizeof(*rec)) {
+        r->errors++;
+        return -1;
+    }
+    r->last_ns[tier] = rec->t_ns;
+    r->records++;
+    return 0;
+}
+
+static void flush_tier(tp_rollup_t *r, int tier) {
+    for (int tc = 0; tc < TP_ROLLUP_MAX_TC; tc++) {
+        if (!r->have[tier][tc]) continue;
+        tier_write(r, tier, &r->acc[tier][tc]);
+        r->have[tier][tc] = 0;
+    }
+}
+
+int tp_rollup_add(tp_rollup_t *r, const tp_rollup_rec_t *rec) {
+    if (rec->tc >= TP_ROLLUP_MAX_TC) return -1;
+    int rc = tier_write(r, TP_ROLLUP_1S, rec);
+
+    // Coarser tiers merge the 1 s records directly
+    for (int tier = TP_ROLLUP_1M; tier < TP_ROLLUP_TIERS; tier++) {
+        uint64_t res = tp_rollup_resolution_s[tier] * NSEC;
+        uint64_t start = rec->t_ns - rec->t_ns % res;
+        if (start != r->acc_start_ns[tier]) {
+            flush_tier(r, tier);
+            r->acc_start_ns[tier] = start;
+        }
+        tp_rollup_rec_t *a = &r->acc[tier][rec->tc];
+        if (!r->have[tier][rec->tc]) {
+            memset(a, 0, sizeof(*a));
+            a->t_ns = start;
+            a->tc = rec->tc;
+            r->have[tier][rec->tc] = 1;
+        }
+        tp_rollup_merge(a, rec);
+    }
+    return rc;
+}
+
+void tp_rollup_close(tp_rollup_t *r) {
+    for (int tier = TP_ROLLUP_1M; tier < TP_ROLLUP_TIERS; tier++) flush_tier(r, tier);
+    for (int tier = 0; tier < TP_ROLLUP_TIERS; tier++) {
+        if (r->fd[tier] >= 0) close(r->fd[tier]);
+        r->fd[tier] = -1;
+    }
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Segment start times (s) of a tier, ascending. Returns count or -1.
+static int list_segments(const char *dir, int tier, uint64_t **out) {
+    char path[512];
+    tier_dir(path, sizeof(path), dir, tier);
+    DIR *d = opendir(path);
+    if (!d) return -1;
+
+    int n = 0, cap = 0;
+    uint64_t *starts = NULL;
+    struct dirent *e;
+    while ((e = readdir(d))) {
+        char *end;
+        unsigned long long start = strtoull(e->d_name, &end, 10);
+        if (end == e->d_name || strcmp(end, ".tsr") != 0) continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 64;
+            uint64_t *grown = realloc(starts, cap * sizeof(*starts));
+            if (!grown) break;
+            starts = grown;
+        }
+        starts[n++] = start;
+    }
+    closedir(d);
+    qsort(starts, n, sizeof(*starts), cmp_u64);
+    *out = starts;
+    return n;
+}
+
+typedef struct {
+    void *map;
+    size_t len;
+    const tp_rollup_rec_t *recs;
+    size_t n;
+} segment_map_t;
+
+static int segment_map(const char *dir, int tier, uint64_t start_s, segment_map_t *m) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s/%llu.tsr", dir, tp_rollup_tier_names[tier], (unsigned long long)start_s);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(tp_rollup_hdr_t)) {
+        close(fd);
+        return -1;
+    }
+    m->len = st.st_size;
+    m->map = mmap(NULL, m->len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m->map == MAP_FAILED) return -1;
+
+    const tp_rollup_hdr_t *h = m->map;
+    if (memcmp(h->magic, TP_ROLLUP_MAGIC, 4) != 0 || h->rec_size != sizeof(tp_rollup_rec_t)) {
+        munmap(m->map, m->len);
+        return -1;
+    }
+    // A writer may be mid-append: whole records only
+    m->recs = (const tp_rollup_rec_t *)((const char *)m->map + sizeof(*h));
+    m->n = (m->len - sizeof(*h)) / sizeof(tp_rollup_rec_t);
+    return 0;
+}
+
+long tp_rollup_scan(const char *dir, int tier, uint64_t from_ns, uint64_t to_ns, tp_rollup_fn fn, void *ctx) {
+    uint64_t *starts;
+    int n = list_segments(dir, tier, &starts);
+    if (n < 0) return -1;
+
+    long visited = 0;
+    for (int i = 0; i < n; i++) {
+        uint64_t seg_ns = starts[i] * NSEC;
+        if (seg_ns >= to_ns || seg_ns + segment_span_s[tier] * NSEC <= from_ns) continue;
+
+        segment_map_t m;
+        if (segment_map(dir, tier, starts[i], &m) != 0) continue;
+
+        // First record at or after from_ns
+        size_t lo = 0, hi = m.n;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (m.recs[mid].t_ns < from_ns) lo = mid + 1;
+            else hi = mid;
+        }
+        for (size_t k = lo; k < m.n && m.recs[k].t_ns < to_ns; k++) {
+            fn(&m.recs[k], ctx);
+            visited++;
+        }
+        munmap(m.map, m.len);
+    }
+    free(starts);
+    return visited;
+}
+
+int tp_rollup_extent(const char *dir, int tier, uint64_t *first_ns, uint64_t *last_ns) {
+    uint64_t *starts;
+    int n = list_segments(dir, tier, &starts);
+    if (n < 0) return -1;
+
+    int found = 0;
+    for (int i = 0; i < n && !found; i++) {
+        segment_map_t m;
+        if (segment_map(dir, tier, starts[i], &m) != 0) continue;
+        if (m.n > 0) {
+            *first_ns = m.recs[0].t_ns;
+            found = 1;
+        }
+        munmap(m.map, m.len);
+    }
+    for (int i = n - 1; i >= 0 && found == 1; i--) {
+        segment_map_t m;
+        if (segment_map(dir, tier, starts[i], &m) != 0) continue;
+        if (m.n > 0) {
+            *last_ns = m.recs[m.n - 1].t_ns;
+            found = 2;
+        }
+        munmap(m.map, m.len);
+    }
+    free(starts);
+    return found == 2 ? 0 : -1;
+}
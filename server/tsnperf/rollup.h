@@ -0,0 +1,123 @@
+/*
+ * rollup.h - Multi-resolution per-TC time series on disk for soak tests
+ *
+ * A rollup store keeps one record per TC per bucket at three resolutions
+ * (tiers): 1 s, 1 min and 1 h. A record holds frame/byte counts, loss,
+ * gate-window accuracy and mergeable log sketches of latency and
+ * inter-arrival time, so a coarse bucket is exactly the merge of the fine
+ * ones and any time range reads back as a few thousand records.
+ *
+ * Layout: <dir>/<tier>/<segment start, unix s>.tsr. A segment covers a
+ * fixed span (1 h of 1 s records, 1 day of 1 min, 30 days of 1 h); the
+ * file is a header plus fixed-size records appended in time order and
+ * never rewritten. Retention unlinks whole segments once their span is
+ * older than the tier's limit. Readers mmap segments and binary-search
+ * the range, so zooming never replays packets.
+ *
+ * The writer is fed 1 s records and cascades the coarser tiers itself;
+ * buckets still open at close are flushed with their coverage in
+ * `seconds`. Sketch counts saturate at 2^32 - 1 (a 1 h bucket of one TC
+ * above ~1.2 Mpps).
+ */
+
+#ifndef TSNPERF_ROLLUP_H
+#define TSNPERF_ROLLUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TP_ROLLUP_TIERS       3
+#define TP_ROLLUP_MAX_TC      8
+#define TP_ROLLUP_SKETCH      48
+#define TP_ROLLUP_SKETCH_MIN  64        // ns; bucket 0 holds everything below
+#define TP_ROLLUP_MAGIC       "TSR1"
+#define TP_ROLLUP_VERSION     1
+
+enum { TP_ROLLUP_1S = 0, TP_ROLLUP_1M = 1, TP_ROLLUP_1H = 2 };
+
+typedef struct {
+    uint64_t t_ns;              // Bucket start, capture (wall) clock
+    uint32_t seconds;           // Seconds of data merged in
+    uint8_t tc;
+    uint8_t reserved[3];
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t lost;
+    uint64_t ooo;
+    uint64_t gate_in;           // Frames inside / outside their gate windows
+    uint64_t gate_out;
+    uint64_t lat_count;
+    uint64_t lat_sum_ns;
+    uint64_t interval_sum_ns;
+    uint32_t lat[TP_ROLLUP_SKETCH];
+    uint32_t interval[TP_ROLLUP_SKETCH];
+} tp_rollup_rec_t;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t rec_size;
+    uint32_t resolution_s;
+    uint64_t start_ns;          // Segment start
+    uint64_t span_ns;
+    uint8_t reserved[32];
+} tp_rollup_hdr_t;
+
+typedef struct {
+    char dir[256];
+    uint64_t retain_s[TP_ROLLUP_TIERS];     // 0 = keep forever
+    int fd[TP_ROLLUP_TIERS];
+    uint64_t seg_start_ns[TP_ROLLUP_TIERS];
+    uint64_t last_ns[TP_ROLLUP_TIERS];      // Newest record written
+    uint64_t acc_start_ns[TP_ROLLUP_TIERS]; // Open bucket of the cascaded tiers
+    int have[TP_ROLLUP_TIERS][TP_ROLLUP_MAX_TC];
+    tp_rollup_rec_t acc[TP_ROLLUP_TIERS][TP_ROLLUP_MAX_TC];
+    uint64_t records;
+    uint64_t errors;
+} tp_rollup_t;
+
+extern const char *const tp_rollup_tier_names[TP_ROLLUP_TIERS];    // "1s", "1m", "1h"
+extern const uint32_t tp_rollup_resolution_s[TP_ROLLUP_TIERS];
+extern const uint64_t tp_rollup_default_retain_s[TP_ROLLUP_TIERS];
+
+// Sketch bucket of v: two per power of two from 64 ns, the last open-ended
+static inline int tp_rollup_bucket(uint64_t v) {
+    if (v < TP_ROLLUP_SKETCH_MIN) return 0;
+    int e = 63 - __builtin_clzll(v);
+    int b = 1 + 2 * (e - 6) + (int)((v >> (e - 1)) & 1);
+    return b < TP_ROLLUP_SKETCH ? b : TP_ROLLUP_SKETCH - 1;
+}
+
+static inline void tp_rollup_sketch_add(uint32_t *sketch, int b, uint64_t n) {
+    uint64_t v = sketch[b] + n;
+    sketch[b] = v > UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+}
+
+// Value at quantile q (0..1) as the upper bound of its bucket; 0 if empty
+uint64_t tp_rollup_quantile(const uint32_t *sketch, double q);
+
+void tp_rollup_merge(tp_rollup_rec_t *dst, const tp_rollup_rec_t *src);
+
+// Tier index of "1s" / "1m" / "1h", -1 if unknown
+int tp_rollup_tier(const char *name);
+
+// Open (creating) a store. retain_s NULL = defaults. Returns 0 on success.
+int tp_rollup_open(tp_rollup_t *r, const char *dir, const uint64_t *retain_s);
+
+// Append one 1 s record (t_ns on a second boundary, ascending per TC)
+int tp_rollup_add(tp_rollup_t *r, const tp_rollup_rec_t *rec);
+
+// Flush open minute/hour buckets and close the files
+void tp_rollup_close(tp_rollup_t *r);
+
+// Reader callback; records arrive in time order
+typedef void (*tp_rollup_fn)(const tp_rollup_rec_t *rec, void *ctx);
+
+// Visit tier's records with t_ns in [from_ns, to_ns). Returns the number
+// of records visited or -1 if the tier does not exist.
+long tp_rollup_scan(const char *dir, int tier, uint64_t from_ns, uint64_t to_ns, tp_rollup_fn fn, void *ctx);
+
+// First and last record time of a tier. Returns 0 if it holds records.
+int tp_rollup_extent(const char *dir, int tier, uint64_t *first_ns, uint64_t *last_ns);
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ * rt.c - Real-time process setup
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "rt.h"
+
+void tp_setup_realtime(int prio_below_max, int verbose) {
+    struct sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO) - prio_below_max;
+    if (sched_setscheduler(0, SCHED_FIFO, &param) < 0 && verbose) {
+        fprintf(stderr, "Warning: Failed to set SCHED_FIFO (run as root): %s\n", strerror(errno));
+    }
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0 && verbose) {
+        fprintf(stderr, "Warning: mlockall failed: %s\n", strerror(errno));
+    }
+}
+
+int tp_pin_thread(int cpu) {
+    if (cpu < 0) return 0;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
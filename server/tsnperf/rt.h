@@ -0,0 +1,15 @@
+/*
+ * rt.h - Real-time process setup (SCHED_FIFO + mlockall)
+ */
+
+#ifndef TSNPERF_RT_H
+#define TSNPERF_RT_H
+
+// Apply SCHED_FIFO at (max - prio_below_max) and lock memory.
+// Failures are reported on stderr when verbose, never fatal.
+void tp_setup_realtime(int prio_below_max, int verbose);
+
+// Pin the calling thread to a CPU (-1 = leave as is). Returns 0 on success.
+int tp_pin_thread(int cpu);
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * score.c - Per-cycle TAS scorecards
+ */
+
+#include <string.h>
+
+#include "score.h"
+
+int tp_score_init(tp_score_t *sc, const tp_gcl_t *gcl, int64_t phase_ns, uint32_t link_mbps,
+                  uint64_t tol_ns, tp_ring_t *out) {
+    memset(sc, 0, sizeof(*sc));
+    if (gcl->cycle_ns > UINT32_MAX) return -1;
+    sc->gcl = gcl;
+    sc->phase_ns = phase_ns;
+    sc->link_mbps = link_mbps ? link_mbps : 1000;
+    sc->tol_ns = tol_ns;
+    sc->out = out;
+    return 0;
+}
+
+void tp_score_flush(tp_score_t *sc) {
+    if (!sc->open) return;
+    tp_ring_push(sc->out, &sc->cur);
+    sc->cycles++;
+    sc->open = 0;
+}
+
+void tp_score_frame(tp_score_t *sc, int tc, uint64_t t_ns, uint32_t len) {
+    const tp_gcl_t *g = sc->gcl;
+    int64_t cyc = (int64_t)g->cycle_ns;
+    int64_t d = (int64_t)t_ns - sc->phase_ns;
+    int64_t cycle = d / cyc - (d % cyc < 0);
+
+    if (sc->open && cycle != sc->cur.cycle) {
+        if (cycle < sc->cur.cycle) {
+            sc->stale++;
+            return;
+        }
+        tp_score_flush(sc);
+    }
+    if (!sc->open) {
+        memset(&sc->cur, 0, sizeof(sc->cur));
+        sc->cur.cycle = cycle;
+        sc->open = 1;
+    }
+
+    tp_score_rec_t *r = &sc->cur;
+    uint32_t pos = (uint32_t)tp_gcl_cycle_pos(g, t_ns, sc->phase_ns);
+    if (r->frames[tc]++ == 0) r->first_ns[tc] = pos;
+    r->last_ns[tc] = pos;
+
+    uint64_t excess;
+    if (tp_gcl_window_of(g, tc, pos, tp_wire_ns(len, sc->link_mbps), sc->tol_ns, &excess) < 0) {
+        r->wrong[tc]++;
+        if (excess > r->max_excess_ns[tc]) r->max_excess_ns[tc] = (uint32_t)excess;
+    }
+}
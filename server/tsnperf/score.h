@@ -0,0 +1,55 @@
+/*
+ * score.h - Per-cycle TAS scorecards
+ *
+ * Cumulative gate counts hide cycle-to-cycle variation: one bad cycle in a
+ * thousand after a PTP step disappears in the average. With the cycle phase
+ * known (PTP time and AdminBaseTime, or a capture-clock base), every frame
+ * is folded into a small record of the GCL cycle it arrived in: per TC the
+ * frame count, the frames outside all of the TC's windows (wrong slot), how
+ * far the worst of them stuck out, and the first and last arrival phase.
+ *
+ * A record is closed when the first frame of a later cycle arrives (or on
+ * flush) and pushed to an SPSC ring read by the stats thread. Cycles
+ * without frames produce no record; cycle numbers tell the gaps.
+ */
+
+#ifndef TSNPERF_SCORE_H
+#define TSNPERF_SCORE_H
+
+#include <stdint.h>
+
+#include "gcl.h"
+#include "ring.h"
+
+typedef struct {
+    int64_t cycle;                          // Cycle index since the phase reference
+    uint32_t frames[TP_GCL_MAX_TC];
+    uint32_t wrong[TP_GCL_MAX_TC];          // Outside every window of the TC (beyond tol)
+    uint32_t max_excess_ns[TP_GCL_MAX_TC];  // Furthest a wrong-slot frame stuck out
+    uint32_t first_ns[TP_GCL_MAX_TC];       // Arrival phase within the cycle
+    uint32_t last_ns[TP_GCL_MAX_TC];
+} tp_score_rec_t;
+
+typedef struct {
+    const tp_gcl_t *gcl;
+    int64_t phase_ns;           // Time of a cycle start
+    uint32_t link_mbps;
+    uint64_t tol_ns;
+    int open;                   // cur holds a cycle
+    tp_score_rec_t cur;
+    uint64_t cycles;            // Records closed
+    uint64_t stale;             // Frames of an already closed cycle (not scored)
+    tp_ring_t *out;
+} tp_score_t;
+
+// Cycle positions are kept in 32 bits: fails for cycles over ~4.29 s
+int tp_score_init(tp_score_t *sc, const tp_gcl_t *gcl, int64_t phase_ns, uint32_t link_mbps,
+                  uint64_t tol_ns, tp_ring_t *out);
+
+// Feed one frame in the phase's time domain (one writer)
+void tp_score_frame(tp_score_t *sc, int tc, uint64_t t_ns, uint32_t len);
+
+// Close the cycle in progress (after the writer stopped)
+void tp_score_flush(tp_score_t *sc);
+
+#endif
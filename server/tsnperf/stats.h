@@ -0,0 +1,121 @@
+/*
+ * stats.h - Per-flow counters and seqlock-protected snapshots
+ *
+ * The hot path is the only writer of a flow's counters. Reporting threads
+ * take snapshots through a seqlock instead of a mutex, so a slow reader
+ * never stalls packet processing.
+ */
+
+#ifndef TSNPERF_STATS_H
+#define TSNPERF_STATS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+typedef struct {
+    _Atomic uint32_t seq;
+} tp_seqlock_t;
+
+static inline void tp_seqlock_write_begin(tp_seqlock_t *l) {
+    uint32_t s = atomic_load_explicit(&l->seq, memory_order_relaxed);
+    atomic_store_explicit(&l->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void tp_seqlock_write_end(tp_seqlock_t *l) {
+    uint32_t s = atomic_load_explicit(&l->seq, memory_order_relaxed);
+    atomic_store_explicit(&l->seq, s + 1, memory_order_release);
+}
+
+static inline uint32_t tp_seqlock_read_begin(const tp_seqlock_t *l) {
+    uint32_t s;
+    while ((s = atomic_load_explicit((_Atomic uint32_t *)&l->seq, memory_order_acquire)) & 1) {
+        // Writer in progress
+    }
+    return s;
+}
+
+static inline int tp_seqlock_read_retry(const tp_seqlock_t *l, uint32_t s) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit((_Atomic uint32_t *)&l->seq, memory_order_relaxed) != s;
+}
+
+// Consistent copy of len bytes guarded by l
+static inline void tp_snapshot(const tp_seqlock_t *l, void *dst, const void *src, size_t len) {
+    uint32_t s;
+    do {
+        s = tp_seqlock_read_begin(l);
+        memcpy(dst, src, len);
+    } while (tp_seqlock_read_retry(l, s));
+}
+
+typedef struct {
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t first_ns;
+    uint64_t last_ns;
+    uint64_t interval_sum_ns;
+    uint64_t interval_min_ns;
+    uint64_t interval_max_ns;
+    // Sequence/timestamp payload
+    uint64_t seq_count;
+    uint64_t seq_lost;
+    uint64_t seq_ooo;
+    uint32_t last_seq;
+    uint64_t lat_count;
+    uint64_t lat_sum_ns;
+    uint64_t lat_min_ns;
+    uint64_t lat_max_ns;
+} tp_flow_stats_t;
+
+// Account one frame. Returns the inter-arrival interval (0 for the first frame).
+static inline uint64_t tp_flow_update(tp_flow_stats_t *f, uint64_t ts_ns, uint32_t len) {
+    uint64_t interval = 0;
+    if (f->count == 0) {
+        f->first_ns = ts_ns;
+        f->interval_min_ns = UINT64_MAX;
+    } else {
+        interval = ts_ns - f->last_ns;
+        f->interval_sum_ns += interval;
+        if (interval < f->interval_min_ns) f->interval_min_ns = interval;
+        if (interval > f->interval_max_ns) f->interval_max_ns = interval;
+    }
+    f->last_ns = ts_ns;
+    f->count++;
+    f->bytes += len;
+    return interval;
+}
+
+// Account a sequence/timestamp payload. Returns latency in ns, or -1 if
+// tx_ns is ahead of rx_ns (different clock domains).
+static inline int64_t tp_flow_seq(tp_flow_stats_t *f, uint32_t seq, uint64_t tx_ns, uint64_t rx_ns) {
+    if (f->seq_count > 0) {
+        int32_t delta = (int32_t)(seq - f->last_seq);
+        if (delta > 1) f->seq_lost += delta - 1;
+        else if (delta <= 0) f->seq_ooo++;
+        if (delta > 0) f->last_seq = seq;
+    } else {
+        f->last_seq = seq;
+    }
+    f->seq_count++;
+
+    if (rx_ns < tx_ns) return -1;
+    uint64_t lat = rx_ns - tx_ns;
+    if (f->lat_count == 0 || lat < f->lat_min_ns) f->lat_min_ns = lat;
+    if (lat > f->lat_max_ns) f->lat_max_ns = lat;
+    f->lat_sum_ns += lat;
+    f->lat_count++;
+    return (int64_t)lat;
+}
+
+static inline double tp_flow_avg_interval_ns(const tp_flow_stats_t *f) {
+    return f->count > 1 ? (double)f->interval_sum_ns / (f->count - 1) : 0;
+}
+
+static inline double tp_flow_kbps(const tp_flow_stats_t *f) {
+    return f->count > 1 && f->last_ns > f->first_ns ?
+        f->bytes * 8.0 * 1e6 / (f->last_ns - f->first_ns) : 0;
+}
+
+#endif
@@ -0,0 +1,400 @@
+/*
+ * synth.c - Heuristic list scheduler producing per-port GCLs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "synth.h"
+
+// GCL intervals are 32-bit; keep every entry (and the cycle) below that
+#define MAX_HYPERPERIOD_NS 1000000000ULL
+
+typedef struct {
+    int idx;
+    int64_t slack;
+} order_t;
+
+void tp_synth_cfg_init(tp_synth_cfg_t *cfg, uint32_t link_mbps) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->link_mbps = link_mbps ? link_mbps : 1000;
+    cfg->hop_ns = 1000;
+    cfg->max_entries = 256;
+    cfg->objective = TP_SYNTH_BE;
+}
+
+int tp_synth_port(tp_synth_cfg_t *cfg, const char *name) {
+    for (int i = 0; i < cfg->n_ports; i++) {
+        if (strcmp(cfg->ports[i], name) == 0) return i;
+    }
+    if (cfg->n_ports >= TP_SYNTH_MAX_PORTS) return -1;
+    snprintf(cfg->ports[cfg->n_ports], TP_SYNTH_NAME_LEN, "%s", name);
+    return cfg->n_ports++;
+}
+
+static uint64_t gcd64(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static uint64_t max_latency(const tp_synth_stream_t *s) {
+    return s->max_latency_ns ? s->max_latency_ns : s->period_ns;
+}
+
+// Period the stream occupies within a cycle of length c
+static uint64_t slot_period(const tp_synth_stream_t *s, uint64_t c) {
+    return s->period_ns < c ? s->period_ns : c;
+}
+
+// Circular overlap of [x, x + xl) and [y, y + yl) on a cycle of length c
+static int overlap(uint64_t x, uint64_t xl, uint64_t y, uint64_t yl, uint64_t c) {
+    if (!xl || !yl) return 0;
+    if (xl >= c || yl >= c) return 1;
+    x %= c;
+    y %= c;
+    return (y + c - x) % c < xl || (x + c - y) % c < yl;
+}
+
+static int lower_bound(const tp_synth_port_t *p, uint64_t start) {
+    int lo = 0, hi = p->n_slots;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (p->slots[mid].start < start) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static void insert_slot(tp_synth_port_t *p, const tp_synth_slot_t *s, uint64_t c) {
+    if (p->n_slots == p->cap) {
+        p->cap = p->cap ? p->cap * 2 : 64;
+        p->slots = realloc(p->slots, sizeof(*p->slots) * p->cap);
+    }
+    int i = lower_bound(p, s->start);
+    memmove(&p->slots[i + 1], &p->slots[i], sizeof(*p->slots) * (p->n_slots - i));
+    p->slots[i] = *s;
+    p->n_slots++;
+
+    uint64_t span = (s->end - s->start) + (s->start + c - s->arrive) % c;
+    if (span > p->max_span) p->max_span = span;
+}
+
+static void remove_slot(tp_synth_port_t *p, uint64_t start) {
+    int i = lower_bound(p, start);
+    if (i >= p->n_slots || p->slots[i].start != start) return;
+    memmove(&p->slots[i], &p->slots[i + 1], sizeof(*p->slots) * (p->n_slots - i - 1));
+    p->n_slots--;
+}
+
+/*
+ * Check a frame queued at a and sent in [s, e) against the port's slots.
+ * Returns 0 if free; 1 if the link is busy or the window would release a
+ * queued frame of the same TC (*next = earliest new start); 2 if a window
+ * of the same TC opens while this frame waits (*next = delay the arrival
+ * needs). Times are absolute, slots are stored mod c.
+ */
+static int check_slot(const tp_synth_port_t *p, uint64_t c, uint64_t a, uint64_t s, uint64_t e, int tc, uint64_t *next) {
+    if (p->n_slots == 0) return 0;
+
+    // Slots whose arrive..end can touch [a, e) start within max_span of it
+    uint64_t span = p->max_span;
+    uint64_t len = (e - a) + 2 * span;
+    uint64_t from = (a % c + c - span % c) % c;
+    int n = p->n_slots;
+    int i = len >= c ? 0 : lower_bound(p, from);
+    if (i == n) i = 0;
+
+    for (int k = 0; k < n; k++, i = (i + 1) % n) {
+        const tp_synth_slot_t *q = &p->slots[i];
+        if (len < c && (q->start + c - from) % c >= len) break;
+
+        uint64_t q_len = q->end - q->start;
+        uint64_t q_wait = (q->start + c - q->arrive) % c;
+        int busy = overlap(s, e - s, q->start, q_len, c);
+        int releases = q->tc == tc && overlap(s, e - s, q->arrive, q_wait, c);
+        if (busy || releases) {
+            *next = s + (q->end % c + c - s % c) % c;
+            if (*next == s) *next = s + 1;
+            return 1;
+        }
+        if (q->tc == tc && overlap(q->start, q_len, a, s - a, c)) {
+            *next = (q->end % c + c - a % c) % c;
+            if (*next == 0) *next = 1;
+            return 2;
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    int port;
+    uint64_t start;
+} placed_t;
+
+static void rollback(tp_synth_t *sol, const placed_t *placed, int n) {
+    for (int i = 0; i < n; i++) remove_slot(&sol->ports[placed[i].port], placed[i].start);
+}
+
+// Search the lowest talker offset that fits every instance on every hop
+static int place_stream(const tp_synth_cfg_t *cfg, tp_synth_t *sol, const tp_synth_stream_t *st,
+                        tp_synth_result_t *res, placed_t *placed) {
+    uint64_t c = sol->cycle_ns;
+    uint64_t period = slot_period(st, c);
+    uint64_t n_inst = c / period;
+    uint64_t tx = tp_wire_ns(st->frame, cfg->link_mbps);
+    uint64_t limit = max_latency(st);
+    if (tx > c) return 0;
+
+    uint64_t phi = 0;
+    while (phi < period) {
+        int n_placed = 0;
+        uint64_t shift = 0, worst = 0;
+
+        for (uint64_t k = 0; k < n_inst && !shift; k++) {
+            uint64_t t = phi + k * period;
+            uint64_t a = t + tx + cfg->hop_ns;
+            uint64_t first_wait = 0;
+
+            for (int h = 0; h < st->n_hops && !shift; h++) {
+                tp_synth_port_t *p = &sol->ports[st->hops[h]];
+                uint64_t s = a, next;
+                for (;;) {
+                    if (s % c + tx > c) s += c - s % c;     // Never straddle the cycle wrap
+                    if (s - a >= c) {
+                        shift = s - a;
+                        break;
+                    }
+                    int r = check_slot(p, c, a, s, s + tx, st->tc, &next);
+                    if (r == 0) break;
+                    if (r == 2) {
+                        shift = next;
+                        break;
+                    }
+                    s = next;
+                }
+                if (shift) break;
+
+                if (!first_wait && s > a) first_wait = s - a;
+                tp_synth_slot_t slot = { .arrive = a % c, .start = s % c, .end = s % c + tx, .tc = st->tc };
+                insert_slot(p, &slot, c);
+                placed[n_placed++] = (placed_t){ .port = st->hops[h], .start = slot.start };
+                a = s + tx + cfg->hop_ns;
+            }
+            if (shift) break;
+
+            uint64_t latency = a - t;
+            if (latency > limit) {
+                // Waiting made it late: start later so the first queue is empty
+                if (!first_wait) {
+                    rollback(sol, placed, n_placed);
+                    return 0;
+                }
+                shift = first_wait;
+                break;
+            }
+            if (latency > worst) worst = latency;
+        }
+
+        if (!shift) {
+            res->scheduled = 1;
+            res->offset_ns = phi;
+            res->latency_ns = worst;
+            return 1;
+        }
+        rollback(sol, placed, n_placed);
+        phi += shift;
+    }
+    return 0;
+}
+
+static void emit(tp_synth_port_t *p, uint8_t gates, uint64_t ns) {
+    if (!ns) return;
+    if (p->n_entries > 0 && p->entries[p->n_entries - 1].gates == gates) {
+        p->entries[p->n_entries - 1].interval_ns += (uint32_t)ns;
+        return;
+    }
+    p->entries[p->n_entries++] = (tp_gcl_entry_t){ .gates = gates, .interval_ns = (uint32_t)ns };
+}
+
+// Best-effort time before a window: open gates, then the guard band closed
+static void emit_gap(tp_synth_port_t *p, uint8_t be, uint64_t gap, uint64_t guard) {
+    if (be && guard) {
+        uint64_t closed = gap < guard ? gap : guard;
+        emit(p, be, gap - closed);
+        emit(p, 0, closed);
+        p->be_ns += gap - closed;
+    } else {
+        emit(p, be, gap);
+        if (be) p->be_ns += gap;
+    }
+}
+
+static void build_gcl(const tp_synth_cfg_t *cfg, tp_synth_port_t *p, uint64_t c) {
+    p->entries = malloc(sizeof(*p->entries) * (3 * (size_t)p->n_slots + 2));
+    p->n_entries = 0;
+    p->tc_mask = 0;
+    for (int i = 0; i < p->n_slots; i++) p->tc_mask |= 1U << p->slots[i].tc;
+
+    if (p->n_slots == 0) {
+        emit(p, 0xff, c);
+        p->be_ns = c;
+        return;
+    }
+
+    uint8_t be = (uint8_t)~p->tc_mask;
+    uint64_t guard = cfg->guard_frame ? tp_wire_ns(cfg->guard_frame, cfg->link_mbps) : 0;
+    uint64_t pos = 0;
+    for (int i = 0; i < p->n_slots;) {
+        const tp_synth_slot_t *w = &p->slots[i];
+        uint64_t end = w->end;
+        for (i++; i < p->n_slots && p->slots[i].start == end && p->slots[i].tc == w->tc; i++) end = p->slots[i].end;
+
+        emit_gap(p, be, w->start - pos, guard);
+        emit(p, 1U << w->tc, end - w->start);
+        p->protected_ns += end - w->start;
+        pos = end;
+    }
+    // The tail runs into the first window of the next cycle
+    emit_gap(p, be, c - pos, guard);
+}
+
+static int cycle_compatible(const tp_synth_cfg_t *cfg, uint64_t c) {
+    for (int i = 0; i < cfg->n_streams; i++) {
+        uint64_t period = cfg->streams[i].period_ns;
+        if (c % period != 0 && period % c != 0) return 0;
+    }
+
+    // Cheap lower bound: reserved time per port must fit in the cycle
+    uint64_t busy[TP_SYNTH_MAX_PORTS] = {0};
+    for (int i = 0; i < cfg->n_streams; i++) {
+        const tp_synth_stream_t *st = &cfg->streams[i];
+        uint64_t tx = tp_wire_ns(st->frame, cfg->link_mbps) * (c / slot_period(st, c));
+        for (int h = 0; h < st->n_hops; h++) busy[st->hops[h]] += tx;
+    }
+    for (int p = 0; p < cfg->n_ports; p++) {
+        if (busy[p] > c) return 0;
+    }
+    return 1;
+}
+
+static int cmp_order(const void *a, const void *b) {
+    const order_t *x = a, *y = b;
+    if (x->slack != y->slack) return x->slack < y->slack ? -1 : 1;
+    return x->idx - y->idx;
+}
+
+static void attempt(const tp_synth_cfg_t *cfg, uint64_t c, const order_t *order, tp_synth_t *sol) {
+    sol->cycle_ns = c;
+    sol->streams = calloc(cfg->n_streams, sizeof(*sol->streams));
+
+    // Rollback log sized for the stream with the most slots
+    size_t placed_cap = 1;
+    for (int i = 0; i < cfg->n_streams; i++) {
+        const tp_synth_stream_t *st = &cfg->streams[i];
+        size_t need = (size_t)(c / slot_period(st, c)) * st->n_hops;
+        if (need > placed_cap) placed_cap = need;
+    }
+    placed_t *placed = malloc(sizeof(*placed) * placed_cap);
+
+    for (int i = 0; i < cfg->n_streams; i++) {
+        int idx = order[i].idx;
+        if (place_stream(cfg, sol, &cfg->streams[idx], &sol->streams[idx], placed)) sol->n_scheduled++;
+    }
+    free(placed);
+
+    sol->feasible = sol->n_scheduled == cfg->n_streams;
+    for (int p = 0; p < cfg->n_ports; p++) {
+        build_gcl(cfg, &sol->ports[p], c);
+        if (sol->ports[p].n_entries > cfg->max_entries) sol->feasible = 0;
+    }
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+int tp_synth_solve(const tp_synth_cfg_t *cfg, tp_synth_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (cfg->n_streams <= 0 || cfg->link_mbps == 0) return -1;
+
+    uint64_t hyper = 1;
+    for (int i = 0; i < cfg->n_streams; i++) {
+        const tp_synth_stream_t *st = &cfg->streams[i];
+        if (st->period_ns == 0 || st->n_hops < 1 || st->tc < 0 || st->tc >= TP_GCL_MAX_TC) return -1;
+        hyper = hyper / gcd64(hyper, st->period_ns) * st->period_ns;
+        if (hyper > MAX_HYPERPERIOD_NS) return -1;
+    }
+    out->hyperperiod_ns = hyper;
+
+    order_t *order = malloc(sizeof(*order) * cfg->n_streams);
+    for (int i = 0; i < cfg->n_streams; i++) {
+        const tp_synth_stream_t *st = &cfg->streams[i];
+        uint64_t hop = tp_wire_ns(st->frame, cfg->link_mbps) + cfg->hop_ns;
+        // Least slack first; higher TCs win ties through the TC term
+        order[i].idx = i;
+        order[i].slack = (int64_t)max_latency(st) - (int64_t)(hop * (st->n_hops + 1)) - st->tc;
+    }
+    qsort(order, cfg->n_streams, sizeof(*order), cmp_order);
+
+    // Candidate cycles, shortest first
+    uint64_t *cand;
+    int n_cand = 0;
+    if (cfg->cycle_ns) {
+        cand = malloc(sizeof(*cand));
+        if (cfg->cycle_ns <= MAX_HYPERPERIOD_NS) cand[n_cand++] = cfg->cycle_ns;
+    } else if (cfg->objective == TP_SYNTH_CYCLE) {
+        size_t cap = 64;
+        cand = malloc(sizeof(*cand) * cap);
+        for (uint64_t d = 1; d * d <= hyper; d++) {
+            if (hyper % d) continue;
+            if ((size_t)n_cand + 2 > cap) cand = realloc(cand, sizeof(*cand) * (cap *= 2));
+            cand[n_cand++] = d;
+            if (d != hyper / d) cand[n_cand++] = hyper / d;
+        }
+        qsort(cand, n_cand, sizeof(*cand), cmp_u64);
+    } else {
+        cand = malloc(sizeof(*cand));
+        cand[n_cand++] = hyper;
+    }
+
+    int solved = 0;
+    for (int i = 0; i < n_cand && !out->feasible; i++) {
+        if (!cycle_compatible(cfg, cand[i])) continue;
+
+        tp_synth_t sol;
+        memset(&sol, 0, sizeof(sol));
+        sol.hyperperiod_ns = hyper;
+        attempt(cfg, cand[i], order, &sol);
+        int candidates = out->candidates + 1;
+
+        // Keep the first feasible cycle, else the one placing most streams
+        if (!solved || sol.feasible || sol.n_scheduled > out->n_scheduled) {
+            tp_synth_free(out);
+            *out = sol;
+            solved = 1;
+        } else {
+            tp_synth_free(&sol);
+        }
+        out->candidates = candidates;
+    }
+    free(cand);
+    free(order);
+    return solved ? 0 : -1;
+}
+
+void tp_synth_free(tp_synth_t *out) {
+    for (int p = 0; p < TP_SYNTH_MAX_PORTS; p++) {
+        free(out->ports[p].slots);
+        free(out->ports[p].entries);
+        out->ports[p].slots = NULL;
+        out->ports[p].entries = NULL;
+    }
+    free(out->streams);
+    out->streams = NULL;
+}
@@ -0,0 +1,105 @@
+/*
+ * synth.h - GCL synthesis from stream requirements (heuristic list scheduler)
+ *
+ * Streams are periodic frames with a PCP/TC, a deadline and a path of
+ * switch egress ports. Each frame instance gets an exclusive transmission
+ * slot on every port of its path; the GCL of a port opens the stream's TC
+ * only for its slots and leaves the rest of the cycle to best effort.
+ *
+ * Streams are placed most-constrained first (least latency slack, then
+ * higher TC). For each stream the talker offset is searched upward from 0;
+ * a frame may wait at a hop, but never while a window of its own TC opens
+ * on that port (the window would release it early) and never inside
+ * another frame's wait of the same TC. On a conflict the offset jumps past
+ * the blocking slot, so a stream costs O(conflicts) checks, not O(period).
+ *
+ * Objectives:
+ *   TP_SYNTH_BE     cycle = hyperperiod (or fixed), slots packed as early as
+ *                   possible so windows merge and best effort keeps the rest
+ *   TP_SYNTH_CYCLE  smallest cycle dividing the hyperperiod that every
+ *                   period divides or is a multiple of; streams with a
+ *                   longer period get a slot in every cycle
+ */
+
+#ifndef TSNPERF_SYNTH_H
+#define TSNPERF_SYNTH_H
+
+#include <stdint.h>
+
+#include "gcl.h"
+
+#define TP_SYNTH_MAX_PORTS 64
+#define TP_SYNTH_MAX_HOPS  8
+#define TP_SYNTH_NAME_LEN  32
+
+enum { TP_SYNTH_BE = 0, TP_SYNTH_CYCLE = 1 };
+
+typedef struct {
+    char id[TP_SYNTH_NAME_LEN];
+    uint64_t period_ns;
+    uint32_t frame;             // Bytes as captured (no FCS)
+    uint64_t max_latency_ns;    // Talker start to last byte at the listener; 0 = period
+    int tc;
+    int n_hops;
+    int hops[TP_SYNTH_MAX_HOPS];    // Port indices, talker side first
+} tp_synth_stream_t;
+
+typedef struct {
+    uint32_t link_mbps;
+    uint64_t hop_ns;            // Propagation + bridge delay per link
+    uint32_t guard_frame;       // BE frame to guard before a window (0 = hardware guard band)
+    int max_entries;            // GCL length limit per port
+    int objective;
+    uint64_t cycle_ns;          // Fixed cycle, 0 = derive from the periods
+    int n_ports;
+    char ports[TP_SYNTH_MAX_PORTS][TP_SYNTH_NAME_LEN];
+    int n_streams;
+    tp_synth_stream_t *streams;
+} tp_synth_cfg_t;
+
+// Reserved transmission of one frame instance on a port, positions mod cycle
+typedef struct {
+    uint64_t arrive;            // Frame queued (start - arrive = wait)
+    uint64_t start;
+    uint64_t end;
+    int tc;
+} tp_synth_slot_t;
+
+typedef struct {
+    int n_slots, cap;
+    tp_synth_slot_t *slots;     // Sorted by start
+    uint64_t max_span;          // Longest arrive..end, bounds range queries
+    int n_entries;
+    tp_gcl_entry_t *entries;
+    uint8_t tc_mask;            // TCs with scheduled streams
+    uint64_t protected_ns;
+    uint64_t be_ns;
+} tp_synth_port_t;
+
+typedef struct {
+    int scheduled;
+    uint64_t offset_ns;         // Talker send offset within the stream period
+    uint64_t latency_ns;        // Worst instance
+} tp_synth_result_t;
+
+typedef struct {
+    uint64_t cycle_ns;
+    uint64_t hyperperiod_ns;
+    int feasible;               // Every stream placed and every GCL fits
+    int n_scheduled;
+    int candidates;             // Cycles tried
+    tp_synth_port_t ports[TP_SYNTH_MAX_PORTS];
+    tp_synth_result_t *streams;
+} tp_synth_t;
+
+void tp_synth_cfg_init(tp_synth_cfg_t *cfg, uint32_t link_mbps);
+
+// Index of a port name, added if new; -1 when the table is full
+int tp_synth_port(tp_synth_cfg_t *cfg, const char *name);
+
+// Returns 0 when a schedule was produced (check out->feasible), -1 on
+// invalid input (no streams, hyperperiod too long)
+int tp_synth_solve(const tp_synth_cfg_t *cfg, tp_synth_t *out);
+void tp_synth_free(tp_synth_t *out);
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * timebase.c - PTP Sync/Follow_Up parsing and robust clock mapping fit
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame.h"
+#include "timebase.h"
+
+void tp_timebase_init(tp_timebase_t *tb) {
+    memset(tb, 0, sizeof(*tb));
+}
+
+int tp_ptp_parse(const uint8_t *pkt, uint32_t caplen, tp_ptp_msg_t *m) {
+    if (caplen < TP_ETH_HLEN + TP_VLAN_HLEN) return -1;
+
+    uint32_t off = TP_ETH_HLEN;
+    uint16_t ethertype = tp_rd16(pkt + 12);
+    if (ethertype == TP_ETH_TYPE_VLAN) {
+        ethertype = tp_rd16(pkt + 16);
+        off += TP_VLAN_HLEN;
+    }
+    // Header plus the 10-byte origin timestamp
+    if (ethertype != TP_ETH_TYPE_PTP || caplen < off + TP_PTP_HDR_LEN + 10) return -1;
+
+    const uint8_t *h = pkt + off;
+    m->type = h[0] & 0x0F;
+    if ((m->type != TP_PTP_SYNC && m->type != TP_PTP_FOLLOW_UP) || (h[1] & 0x0F) != 2) return -1;
+
+    m->domain = h[4];
+    m->two_step = (h[6] & 0x02) != 0;
+    m->correction_ns = (int64_t)tp_rd64(h + 8) / 65536;     // Scaled nanoseconds
+    memcpy(m->source, h + 20, sizeof(m->source));
+    m->seq_id = tp_rd16(h + 30);
+    m->log_interval = (int8_t)h[33];
+
+    const uint8_t *ts = h + TP_PTP_HDR_LEN;
+    uint64_t sec = ((uint64_t)tp_rd16(ts) << 32) | tp_rd32(ts + 2);
+    m->origin_ns = sec * 1000000000ULL + tp_rd32(ts + 6);
+    return 0;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *v, int n) {
+    qsort(v, n, sizeof(*v), cmp_double);
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+// Theil-Sen over the window, relative to the newest sample
+static void refit(tp_timebase_t *tb) {
+    static double pairs[TP_TIMEBASE_WINDOW * (TP_TIMEBASE_WINDOW - 1) / 2];
+    double x[TP_TIMEBASE_WINDOW], y[TP_TIMEBASE_WINDOW], r[TP_TIMEBASE_WINDOW];
+    int n = tb->n;
+    int newest = (tb->head + TP_TIMEBASE_WINDOW - 1) % TP_TIMEBASE_WINDOW;
+
+    for (int i = 0; i < n; i++) {
+        int k = (newest + TP_TIMEBASE_WINDOW - i) % TP_TIMEBASE_WINDOW;
+        x[i] = (double)(int64_t)(tb->host[k] - tb->host[newest]);
+        y[i] = (double)(tb->offset[k] - tb->offset[newest]);
+    }
+
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < i; j++) {
+            if (x[i] != x[j]) pairs[m++] = (y[i] - y[j]) / (x[i] - x[j]);
+        }
+    }
+    double rate = m ? median(pairs, m) : 0;
+
+    for (int i = 0; i < n; i++) r[i] = y[i] - rate * x[i];
+    double intercept = median(r, n);
+    for (int i = 0; i < n; i++) r[i] = fabs(y[i] - rate * x[i] - intercept);
+    double spread = 1.4826 * median(r, n);
+
+    tb->rate = rate;
+    tb->ref_host_ns = tb->host[newest];
+    tb->ref_offset_ns = tb->offset[newest] + llround(intercept);
+    tb->valid = n >= TP_TIMEBASE_MIN_FIT;
+
+    tb->status.valid = tb->valid;
+    tb->status.rate_ppb = rate * 1e9;
+    tb->status.offset_ns = tb->ref_offset_ns;
+    tb->status.spread_ns = spread;
+    tb->status.last_host_ns = tb->ref_host_ns;
+}
+
+static void restart(tp_timebase_t *tb) {
+    tb->n = 0;
+    tb->head = 0;
+    tb->valid = 0;
+    tb->rejects = 0;
+    memset(tb->pending, 0, sizeof(tb->pending));
+}
+
+int tp_timebase_sample(tp_timebase_t *tb, uint64_t host_ns, uint64_t ptp_ns) {
+    tp_seqlock_write_begin(&tb->lock);
+
+    if (tb->valid) {
+        double resid = (double)(int64_t)(ptp_ns - tp_timebase_map(tb, host_ns));
+        double tol = TP_TIMEBASE_MAD_K * tb->status.spread_ns;
+        if (tol < TP_TIMEBASE_MIN_TOL_NS) tol = TP_TIMEBASE_MIN_TOL_NS;
+
+        if (fabs(resid) > tol) {
+            tb->status.outliers++;
+            if (++tb->rejects < TP_TIMEBASE_RESET) {
+                tp_seqlock_write_end(&tb->lock);
+                return 0;
+            }
+            // Consistently off: the PTP clock stepped
+            restart(tb);
+            tb->status.resets++;
+        }
+    }
+    tb->rejects = 0;
+
+    tb->host[tb->head] = host_ns;
+    tb->offset[tb->head] = (int64_t)(ptp_ns - host_ns);
+    tb->head = (tb->head + 1) % TP_TIMEBASE_WINDOW;
+    if (tb->n < TP_TIMEBASE_WINDOW) tb->n++;
+    refit(tb);
+    tb->status.samples++;
+
+    tp_seqlock_write_end(&tb->lock);
+    return 1;
+}
+
+int tp_timebase_frame(tp_timebase_t *tb, const uint8_t *pkt, uint32_t caplen, uint64_t host_ns) {
+    tp_ptp_msg_t m;
+    if (tp_ptp_parse(pkt, caplen, &m) != 0) return 0;
+
+    // Follow one sync source; another may take over once it goes quiet
+    int same = tb->have_source && m.domain == tb->domain &&
+               memcmp(m.source, tb->source, sizeof(m.source)) == 0;
+    if (!same) {
+        if (tb->have_source && host_ns - tb->source_ns < TP_TIMEBASE_STALE_NS) return 0;
+        if (tb->have_source) {
+            tp_seqlock_write_begin(&tb->lock);
+            restart(tb);
+            tb->status.valid = 0;
+            tb->status.resets++;
+            tp_seqlock_write_end(&tb->lock);
+        }
+        memcpy(tb->source, m.source, sizeof(m.source));
+        tb->domain = m.domain;
+        tb->have_source = 1;
+    }
+    tb->source_ns = host_ns;
+
+    if (m.type == TP_PTP_SYNC) {
+        if (!m.two_step) return tp_timebase_sample(tb, host_ns, m.origin_ns + m.correction_ns);
+
+        tp_ptp_pending_t *p = &tb->pending[tb->pending_next];
+        tb->pending_next = (tb->pending_next + 1) % TP_TIMEBASE_PENDING;
+        *p = (tp_ptp_pending_t){ .valid = 1, .seq_id = m.seq_id, .host_ns = host_ns,
+                                 .correction_ns = m.correction_ns };
+        return 0;
+    }
+
+    for (int i = 0; i < TP_TIMEBASE_PENDING; i++) {
+        tp_ptp_pending_t *p = &tb->pending[i];
+        if (!p->valid || p->seq_id != m.seq_id) continue;
+        p->valid = 0;
+        return tp_timebase_sample(tb, p->host_ns, m.origin_ns + p->correction_ns + m.correction_ns);
+    }
+    return 0;
+}
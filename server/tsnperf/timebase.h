@@ -0,0 +1,120 @@
+/*
+ * timebase.h - Capture clock to switch PTP time mapping from Sync/Follow_Up
+ *
+ * Gates open on the switch's PTP clock; capture timestamps are host
+ * CLOCK_REALTIME. The TAP sees the Sync/Follow_Up pairs the switch sends
+ * downstream: preciseOriginTimestamp plus the correctionFields of both
+ * messages is the switch's PTP time when the Sync left, and the capture
+ * timestamp of the Sync is the host time of the same instant. Every pair
+ * (or one-step Sync) is one (host, ptp) sample.
+ *
+ * The mapping ptp = host + offset + rate * (host - ref) is fitted over the
+ * last TP_TIMEBASE_WINDOW samples with Theil-Sen (median pairwise slope,
+ * median intercept), so a few delayed or misstamped Syncs move neither.
+ * Once the fit is valid a new sample whose residual exceeds
+ * max(TP_TIMEBASE_MIN_TOL_NS, TP_TIMEBASE_MAD_K * spread) is rejected;
+ * TP_TIMEBASE_RESET rejections in a row mean the PTP clock stepped (new
+ * grandmaster, time jump) and restart the fit at the latest sample.
+ *
+ * The fit follows the first sync source seen and only changes source
+ * after TP_TIMEBASE_STALE_NS without a sample.
+ *
+ * Single writer: parsing, fitting and mapping run on the capture drain
+ * thread. Other threads read tp_timebase_status() snapshots.
+ */
+
+#ifndef TSNPERF_TIMEBASE_H
+#define TSNPERF_TIMEBASE_H
+
+#include <stdint.h>
+
+#include "stats.h"
+
+#define TP_TIMEBASE_WINDOW     32
+#define TP_TIMEBASE_MIN_FIT    4            // Samples before the mapping is used
+#define TP_TIMEBASE_RESET      4            // Consecutive outliers that restart the fit
+#define TP_TIMEBASE_MIN_TOL_NS 2000
+#define TP_TIMEBASE_MAD_K      5
+#define TP_TIMEBASE_STALE_NS   3000000000ULL
+#define TP_TIMEBASE_PENDING    8            // Two-step Syncs awaiting their Follow_Up
+
+#define TP_PTP_HDR_LEN         34
+#define TP_PTP_SYNC            0x0
+#define TP_PTP_FOLLOW_UP       0x8
+
+typedef struct {
+    int type;
+    uint8_t domain;
+    int two_step;
+    uint16_t seq_id;
+    int8_t log_interval;    // logMessageInterval
+    uint8_t source[10];     // sourcePortIdentity
+    int64_t correction_ns;
+    uint64_t origin_ns;     // (precise)OriginTimestamp
+} tp_ptp_msg_t;
+
+typedef struct {
+    int valid;
+    uint64_t samples;       // Accepted into the fit
+    uint64_t outliers;
+    uint64_t resets;
+    double rate_ppb;        // PTP clock rate relative to the host clock
+    int64_t offset_ns;      // ptp - host at the latest sample
+    double spread_ns;       // 1.4826 * median absolute residual
+    uint64_t last_host_ns;
+} tp_timebase_status_t;
+
+typedef struct {
+    int valid;
+    uint16_t seq_id;
+    uint64_t host_ns;
+    int64_t correction_ns;
+} tp_ptp_pending_t;
+
+typedef struct {
+    // Mapping, read on the writer thread only
+    int valid;
+    uint64_t ref_host_ns;
+    int64_t ref_offset_ns;
+    double rate;
+
+    int n, head;
+    uint64_t host[TP_TIMEBASE_WINDOW];
+    int64_t offset[TP_TIMEBASE_WINDOW];
+    int rejects;
+    int have_source;
+    uint8_t source[10];
+    uint8_t domain;
+    uint64_t source_ns;     // Last frame from the followed source
+    tp_ptp_pending_t pending[TP_TIMEBASE_PENDING];
+    int pending_next;
+
+    tp_seqlock_t lock;
+    tp_timebase_status_t status;
+} tp_timebase_t;
+
+void tp_timebase_init(tp_timebase_t *tb);
+
+// Parse a Sync or Follow_Up frame (untagged or single-tagged). Returns 0
+// on success, -1 for anything else.
+int tp_ptp_parse(const uint8_t *pkt, uint32_t caplen, tp_ptp_msg_t *m);
+
+// Feed one captured PTP frame. Returns 1 if it added a sample.
+int tp_timebase_frame(tp_timebase_t *tb, const uint8_t *pkt, uint32_t caplen, uint64_t host_ns);
+
+// Feed one (host, ptp) sample. Returns 1 if accepted, 0 if rejected.
+int tp_timebase_sample(tp_timebase_t *tb, uint64_t host_ns, uint64_t ptp_ns);
+
+// PTP time of a capture timestamp; 0 until the fit is valid (writer thread)
+static inline uint64_t tp_timebase_map(const tp_timebase_t *tb, uint64_t host_ns) {
+    if (!tb->valid) return 0;
+    int64_t dt = (int64_t)(host_ns - tb->ref_host_ns);
+    return host_ns + (uint64_t)(tb->ref_offset_ns + (int64_t)(tb->rate * (double)dt));
+}
+
+// Consistent copy of the fit status (any thread)
+static inline void tp_timebase_status(const tp_timebase_t *tb, tp_timebase_status_t *out) {
+    tp_snapshot(&tb->lock, out, &tb->status, sizeof(*out));
+}
+
+#endif
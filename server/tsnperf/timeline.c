@@ -0,0 +1,465 @@
+/*
+ * timeline.c - Timeline compiler (per-stream generators merged by launch time) and mmap reader
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "payload.h"
+#include "timeline.h"
+
+#define REC_BUF 4096
+
+void tp_tl_stream_init(tp_tl_stream_t *st) {
+    memset(st, 0, sizeof(*st));
+    st->vlan_id = 100;
+    st->burst = 1;
+}
+
+// Frame length without FCS; unset = minimum, or what a PRBS body needs
+static uint32_t stream_frame(const tp_tl_stream_t *st) {
+    if (st->frame) return st->frame;
+    return st->prbs ? TP_TL_PRBS_FRAME : TP_MIN_FRAME_LEN;
+}
+
+static uint64_t gcd64(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// lcm capped at cap (returns cap + 1 when it would exceed it)
+static uint64_t lcm_capped(uint64_t a, uint64_t b, uint64_t cap) {
+    if (!a) return b;
+    if (!b) return a;
+    uint64_t m = a / gcd64(a, b);
+    if (m > cap / b) return cap + 1;
+    return m * b;
+}
+
+// Frame times of one stream in launch order
+typedef struct {
+    const tp_tl_stream_t *st;
+    int64_t base;           // First burst start
+    int64_t k;              // Burst index
+    uint32_t b;             // Frame within the burst
+    int64_t end;            // Exclusive
+    int64_t start;
+    int64_t profile;        // on + off, 0 = none
+    int64_t next;
+    int done;
+} gen_t;
+
+static int burst_on(const gen_t *g, int64_t bs) {
+    if (!g->profile) return 1;
+    int64_t ph = bs % g->profile;
+    if (ph < 0) ph += g->profile;
+    return ph < (int64_t)g->st->on_ns;
+}
+
+// Advance to the next frame time at or after the current position
+static void gen_next(gen_t *g) {
+    const tp_tl_stream_t *st = g->st;
+    for (;;) {
+        int64_t bs = g->base + g->k * (int64_t)st->period_ns;
+        if (bs >= g->end) {
+            g->done = 1;
+            return;
+        }
+        if (g->b < st->burst && burst_on(g, bs)) {
+            int64_t t = bs + (int64_t)g->b * (int64_t)st->gap_ns;
+            g->b++;
+            if (t >= g->end) continue;
+            if (t < g->start) continue;
+            g->next = t;
+            return;
+        }
+        g->k++;
+        g->b = 0;
+    }
+}
+
+// Min-heap of generators by (next, stream index)
+static int gen_less(const gen_t *a, const gen_t *b) {
+    return a->next < b->next || (a->next == b->next && a->st < b->st);
+}
+
+static void heap_down(gen_t **h, int n, int i) {
+    for (;;) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < n && gen_less(h[l], h[m])) m = l;
+        if (r < n && gen_less(h[r], h[m])) m = r;
+        if (m == i) return;
+        gen_t *t = h[i];
+        h[i] = h[m];
+        h[m] = t;
+        i = m;
+    }
+}
+
+static int fail(tp_tl_summary_t *sum, const char *msg, const char *id) {
+    if (id) snprintf(sum->error, sizeof(sum->error), "%s: %s", id, msg);
+    else snprintf(sum->error, sizeof(sum->error), "%s", msg);
+    return -1;
+}
+
+// I/O error on file: its basename (bounded to fit sum->error) and errno
+static void io_fail(tp_tl_summary_t *sum, const char *what, const char *file) {
+    const char *name = strrchr(file, '/');
+    snprintf(sum->error, sizeof(sum->error), "%s %.64s: %s", what, name ? name + 1 : file, strerror(errno));
+}
+
+static int flow_of(uint32_t *keys, uint32_t *n_flows, int vid, int tc) {
+    uint32_t key = ((uint32_t)vid << 3) | (uint32_t)tc;
+    for (uint32_t i = 0; i < *n_flows; i++) {
+        if (keys[i] == key) return (int)i;
+    }
+    if (*n_flows >= TP_TL_MAX_FLOWS) return -1;
+    keys[*n_flows] = key;
+    return (int)(*n_flows)++;
+}
+
+static int check_stream(const tp_tl_cfg_t *cfg, const tp_tl_stream_t *st, tp_tl_summary_t *sum) {
+    if (st->tc < 0 || st->tc >= TP_GCL_MAX_TC) return fail(sum, "tc out of range", st->id);
+    if (st->vlan_id < 0 || st->vlan_id > 4095) return fail(sum, "vlan out of range", st->id);
+    if (!st->period_ns || !st->burst) return fail(sum, "period and burst must be > 0", st->id);
+    uint32_t frame = stream_frame(st);
+    if (frame < TP_MIN_FRAME_LEN || frame > TP_MAX_FRAME_LEN) return fail(sum, "frame size out of range", st->id);
+    if (st->prbs && frame < TP_PAYLOAD_OFFSET + TP_PAYLOAD_CHECK_MIN) return fail(sum, "frame too short for prbs", st->id);
+    if ((uint64_t)(st->burst - 1) * st->gap_ns >= st->period_ns) return fail(sum, "burst longer than period", st->id);
+    if ((st->on_ns != 0) != (st->off_ns != 0)) return fail(sum, "profile needs both on and off", st->id);
+    if (st->align) {
+        if (!cfg->gcl) return fail(sum, "align needs a GCL", st->id);
+        if (!cfg->gcl->n_windows[st->tc]) return fail(sum, "tc never opens in the GCL", st->id);
+    }
+    return 0;
+}
+
+int tp_tl_compile(const tp_tl_cfg_t *cfg, const char *path, tp_tl_summary_t *sum) {
+    tp_tl_stream_stat_t *stats = sum->streams;
+    memset(sum, 0, sizeof(*sum));
+    sum->streams = stats;
+    if (stats) memset(stats, 0, sizeof(*stats) * cfg->n_streams);
+
+    if (cfg->n_streams <= 0) return fail(sum, "no streams", NULL);
+    if (cfg->n_streams > TP_TL_MAX_TEMPLATES) return fail(sum, "too many streams", NULL);
+    if (!cfg->link_mbps) return fail(sum, "link speed must be > 0", NULL);
+
+    int bounded = 0;
+    uint64_t length = cfg->length_ns;
+    for (int i = 0; i < cfg->n_streams; i++) {
+        const tp_tl_stream_t *st = &cfg->streams[i];
+        if (check_stream(cfg, st, sum) < 0) return -1;
+        if (st->start_ns || st->stop_ns) bounded = 1;
+        if (!cfg->length_ns) {
+            length = lcm_capped(length, st->period_ns, TP_TL_MAX_LENGTH_NS);
+            length = lcm_capped(length, st->on_ns + st->off_ns, TP_TL_MAX_LENGTH_NS);
+        }
+    }
+    if (!cfg->length_ns && cfg->gcl) length = lcm_capped(length, cfg->gcl->cycle_ns, TP_TL_MAX_LENGTH_NS);
+    if (length > TP_TL_MAX_LENGTH_NS) return fail(sum, "pass longer than 60 s (hyperperiod too long, set a length)", NULL);
+    int loop = !cfg->once && !bounded;
+    // Passes only join seamlessly if a set length is whole periods of everything
+    if (loop && cfg->length_ns) {
+        for (int i = 0; i < cfg->n_streams; i++) {
+            const tp_tl_stream_t *st = &cfg->streams[i];
+            uint64_t profile = st->on_ns + st->off_ns;
+            if (length % st->period_ns || (profile && length % profile)) {
+                return fail(sum, "looping length not a multiple of the period and on+off (use --once)", st->id);
+            }
+        }
+        if (cfg->gcl && length % cfg->gcl->cycle_ns) {
+            return fail(sum, "looping length not a multiple of the GCL cycle (use --once)", NULL);
+        }
+    }
+
+    // Templates and flows
+    tp_tl_tpl_t *tpls = calloc(cfg->n_streams, sizeof(*tpls));
+    uint32_t *flow_keys = calloc(TP_TL_MAX_FLOWS, sizeof(uint32_t));
+    uint32_t *per_pass = calloc(TP_TL_MAX_FLOWS, sizeof(uint32_t));
+    gen_t *gens = calloc(cfg->n_streams, sizeof(*gens));
+    gen_t **heap = calloc(cfg->n_streams, sizeof(*heap));
+    uint64_t *wire = calloc(cfg->n_streams, sizeof(*wire));
+    tp_tl_rec_t *buf = malloc(sizeof(*buf) * REC_BUF);
+    FILE *out = NULL;
+    char tmp[4096] = "";
+    int rc = -1;
+
+    if (!tpls || !flow_keys || !per_pass || !gens || !heap || !wire || !buf) {
+        fail(sum, "out of memory", NULL);
+        goto done;
+    }
+
+    uint32_t n_flows = 0;
+    for (int i = 0; i < cfg->n_streams; i++) {
+        const tp_tl_stream_t *st = &cfg->streams[i];
+        tp_frame_spec_t spec;
+        tp_frame_spec_init(&spec, cfg->dst_mac, cfg->src_mac, st->vlan_id, st->tc);
+        spec.payload_len = (int)stream_frame(st) - TP_PAYLOAD_OFFSET;
+        int len = tp_frame_build(tpls[i].frame, sizeof(tpls[i].frame), &spec);
+        if (len < 0) {
+            fail(sum, "template build failed", st->id);
+            goto done;
+        }
+        if (st->prbs) tp_payload_fill(tpls[i].frame + TP_PAYLOAD_OFFSET, spec.payload_len, tp_payload_seed(st->prbs_seed, st->tc));
+        int flow = flow_of(flow_keys, &n_flows, st->vlan_id, st->tc);
+        if (flow < 0) {
+            fail(sum, "too many flows", NULL);
+            goto done;
+        }
+        tpls[i].len = (uint16_t)len;
+        tpls[i].tc = (uint8_t)st->tc;
+        tpls[i].flow = (uint16_t)flow;
+        snprintf(tpls[i].id, sizeof(tpls[i].id), "%s", st->id);
+        wire[i] = tp_wire_ns((uint32_t)len, cfg->link_mbps);
+
+        gen_t *g = &gens[i];
+        g->st = st;
+        g->base = (int64_t)st->offset_ns;
+        if (st->align) g->base += (int64_t)cfg->gcl->windows[st->tc][0].open_ns;
+        g->start = (int64_t)st->start_ns;
+        g->end = st->stop_ns && st->stop_ns < length ? (int64_t)st->stop_ns : (int64_t)length;
+        g->profile = (int64_t)(st->on_ns + st->off_ns);
+        if (loop) {
+            // A pass repeats: fold the offset into the period and start one burst
+            // early so the tail of the previous pass's last burst opens this one
+            g->base %= (int64_t)st->period_ns;
+            g->k = -1;
+        }
+        gen_next(g);
+    }
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    out = fopen(tmp, "w+b");
+    if (!out) {
+        io_fail(sum, "open", tmp);
+        goto done;
+    }
+
+    tp_tl_hdr_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TP_TL_MAGIC, 4);
+    h.version = TP_TL_VERSION;
+    h.rec_size = sizeof(tp_tl_rec_t);
+    h.tpl_size = sizeof(tp_tl_tpl_t);
+    h.n_templates = (uint32_t)cfg->n_streams;
+    h.n_flows = n_flows;
+    h.length_ns = length;
+    h.align_ns = cfg->gcl ? cfg->gcl->cycle_ns : 0;
+    h.loop = (uint32_t)loop;
+    h.link_mbps = cfg->link_mbps;
+    h.flow_off = sizeof(h);
+    h.tpl_off = (h.flow_off + sizeof(uint32_t) * n_flows + 63) & ~63ULL;
+    h.rec_off = h.tpl_off + sizeof(tp_tl_tpl_t) * (uint64_t)cfg->n_streams;
+
+    // Placeholder header and flows, rewritten at the end
+    static const uint8_t zero[64];
+    if (fwrite(&h, sizeof(h), 1, out) != 1) goto io_error;
+    for (uint64_t pos = sizeof(h); pos < h.tpl_off; pos += 64) {
+        uint64_t n = h.tpl_off - pos < 64 ? h.tpl_off - pos : 64;
+        if (fwrite(zero, 1, n, out) != n) goto io_error;
+    }
+    if (fwrite(tpls, sizeof(*tpls), cfg->n_streams, out) != (size_t)cfg->n_streams) goto io_error;
+    uint32_t crc = tp_crc32c(0, tpls, sizeof(*tpls) * cfg->n_streams);
+
+    // Merge the streams by launch time
+    int n_heap = 0;
+    for (int i = 0; i < cfg->n_streams; i++) {
+        if (!gens[i].done) heap[n_heap++] = &gens[i];
+    }
+    for (int i = n_heap / 2 - 1; i >= 0; i--) heap_down(heap, n_heap, i);
+
+    uint64_t n_recs = 0, wire_total = 0;
+    int64_t prev_t = -1, first_t = -1;
+    uint64_t prev_end = 0;
+    int n_buf = 0;
+    sum->min_gap_ns = UINT64_MAX;
+    while (n_heap) {
+        gen_t *g = heap[0];
+        int s = (int)(g->st - cfg->streams);
+        int64_t t = g->next;
+
+        if (n_recs >= TP_TL_MAX_RECORDS) {
+            fail(sum, "too many records (shorten the pass or lower the rates)", NULL);
+            goto done;
+        }
+        tp_tl_rec_t *r = &buf[n_buf++];
+        r->launch_ns = (uint64_t)t;
+        r->tpl = (uint16_t)s;
+        r->flow = tpls[s].flow;
+        r->seq = per_pass[r->flow]++;
+        n_recs++;
+
+        if (prev_t >= 0) {
+            if ((uint64_t)(t - prev_t) < sum->min_gap_ns) sum->min_gap_ns = (uint64_t)(t - prev_t);
+            if ((uint64_t)t < prev_end) sum->overlaps++;
+        } else {
+            first_t = t;
+        }
+        prev_t = t;
+        prev_end = (uint64_t)t + wire[s];
+        wire_total += wire[s];
+
+        if (stats) {
+            stats[s].frames++;
+            if (cfg->gcl) {
+                uint64_t excess;
+                uint64_t pos = tp_gcl_cycle_pos(cfg->gcl, (uint64_t)t, 0);
+                if (tp_gcl_window_of(cfg->gcl, g->st->tc, pos, wire[s], 0, &excess) < 0) stats[s].outside++;
+            }
+        }
+
+        if (n_buf == REC_BUF) {
+            if (fwrite(buf, sizeof(*buf), n_buf, out) != (size_t)n_buf) goto io_error;
+            crc = tp_crc32c(crc, buf, sizeof(*buf) * n_buf);
+            n_buf = 0;
+        }
+
+        gen_next(g);
+        if (g->done) heap[0] = heap[--n_heap];
+        heap_down(heap, n_heap, 0);
+    }
+    if (n_buf) {
+        if (fwrite(buf, sizeof(*buf), n_buf, out) != (size_t)n_buf) goto io_error;
+        crc = tp_crc32c(crc, buf, sizeof(*buf) * n_buf);
+    }
+    if (!n_recs) {
+        fail(sum, "no frames in the pass", NULL);
+        goto done;
+    }
+    // A looping pass is followed by its own first record: check the seam too
+    if (loop) {
+        uint64_t next_first = length + (uint64_t)first_t;
+        if (next_first - (uint64_t)prev_t < sum->min_gap_ns) sum->min_gap_ns = next_first - (uint64_t)prev_t;
+        if (prev_end > next_first) sum->overlaps++;
+    }
+    if (wire_total > length) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "link overloaded: load %.2f (wire time exceeds the pass length)",
+                 (double)wire_total / (double)length);
+        fail(sum, msg, NULL);
+        goto done;
+    }
+    crc = tp_crc32c(crc, per_pass, sizeof(uint32_t) * n_flows);
+
+    h.n_records = n_recs;
+    h.digest = crc;
+    if (fseek(out, 0, SEEK_SET) != 0 || fwrite(&h, sizeof(h), 1, out) != 1 ||
+        fwrite(per_pass, sizeof(uint32_t), n_flows, out) != n_flows) {
+        goto io_error;
+    }
+    if (fclose(out) != 0) {
+        out = NULL;
+        goto io_error;
+    }
+    out = NULL;
+    if (rename(tmp, path) != 0) goto io_error;
+
+    sum->n_records = n_recs;
+    sum->length_ns = length;
+    sum->n_flows = n_flows;
+    sum->digest = crc;
+    sum->loop = loop;
+    sum->load = (double)wire_total / (double)length;
+    rc = 0;
+    goto done;
+
+io_error:
+    io_fail(sum, "write", tmp);
+done:
+    if (out) fclose(out);
+    if (rc != 0 && tmp[0]) unlink(tmp);
+    free(tpls);
+    free(flow_keys);
+    free(per_pass);
+    free(gens);
+    free(heap);
+    free(wire);
+    free(buf);
+    return rc;
+}
+
+static int open_fail(tp_tl_file_t *f, char *err, size_t cap, const char *msg) {
+    snprintf(err, cap, "%s", msg);
+    tp_tl_close(f);
+    return -1;
+}
+
+int tp_tl_open(tp_tl_file_t *f, const char *path, char *err, size_t cap) {
+    memset(f, 0, sizeof(*f));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        snprintf(err, cap, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) < 0 || (size_t)sb.st_size < sizeof(tp_tl_hdr_t)) {
+        close(fd);
+        snprintf(err, cap, "%s: not a timeline", path);
+        return -1;
+    }
+    f->len = (size_t)sb.st_size;
+    f->map = mmap(NULL, f->len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (f->map == MAP_FAILED) {
+        f->map = NULL;
+        snprintf(err, cap, "mmap %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    const tp_tl_hdr_t *h = f->map;
+    if (memcmp(h->magic, TP_TL_MAGIC, 4) != 0 || h->version != TP_TL_VERSION ||
+        h->rec_size != sizeof(tp_tl_rec_t) || h->tpl_size != sizeof(tp_tl_tpl_t)) {
+        return open_fail(f, err, cap, "not a timeline or unsupported version");
+    }
+    if (!h->n_records || !h->n_templates || !h->length_ns || h->n_records > TP_TL_MAX_RECORDS ||
+        h->n_templates > TP_TL_MAX_TEMPLATES || h->n_flows > TP_TL_MAX_FLOWS ||
+        h->flow_off + sizeof(uint32_t) * h->n_flows > h->tpl_off ||
+        h->tpl_off + sizeof(tp_tl_tpl_t) * (uint64_t)h->n_templates > h->rec_off ||
+        h->rec_off + sizeof(tp_tl_rec_t) * h->n_records > f->len ||
+        (h->tpl_off & 7) || (h->rec_off & 7)) {
+        return open_fail(f, err, cap, "timeline layout is corrupt");
+    }
+
+    f->hdr = h;
+    f->flows = (const uint32_t *)((const uint8_t *)f->map + h->flow_off);
+    f->tpls = (const tp_tl_tpl_t *)((const uint8_t *)f->map + h->tpl_off);
+    f->recs = (const tp_tl_rec_t *)((const uint8_t *)f->map + h->rec_off);
+
+    uint32_t crc = tp_crc32c(0, f->tpls, sizeof(tp_tl_tpl_t) * h->n_templates);
+    crc = tp_crc32c(crc, f->recs, sizeof(tp_tl_rec_t) * h->n_records);
+    crc = tp_crc32c(crc, f->flows, sizeof(uint32_t) * h->n_flows);
+    if (crc != h->digest) return open_fail(f, err, cap, "timeline digest mismatch");
+
+    for (uint32_t i = 0; i < h->n_templates; i++) {
+        const tp_tl_tpl_t *t = &f->tpls[i];
+        if (t->len < TP_MIN_FRAME_LEN || t->len > TP_MAX_FRAME_LEN || t->flow >= h->n_flows ||
+            t->tc >= TP_GCL_MAX_TC) {
+            return open_fail(f, err, cap, "timeline template is corrupt");
+        }
+    }
+    uint64_t prev = 0;
+    for (uint64_t i = 0; i < h->n_records; i++) {
+        const tp_tl_rec_t *r = &f->recs[i];
+        if (r->tpl >= h->n_templates || r->launch_ns < prev || r->launch_ns >= h->length_ns) {
+            return open_fail(f, err, cap, "timeline records are corrupt or unsorted");
+        }
+        prev = r->launch_ns;
+    }
+    return 0;
+}
+
+void tp_tl_close(tp_tl_file_t *f) {
+    if (f->map) munmap(f->map, f->len);
+    memset(f, 0, sizeof(*f));
+}
@@ -0,0 +1,156 @@
+/*
+ * timeline.h - Ahead-of-time compiled send schedules
+ *
+ * A timeline holds the whole send schedule of a multi-stream test, worked
+ * out before the run: the frame templates plus one record per frame, sorted
+ * by launch time. traffic-sender --timeline mmaps the file, so its RT loop
+ * only waits for the next record, stamps that template and sends it. No
+ * rate arithmetic or stream selection happens on the send path.
+ *
+ * Streams send a burst of `burst` frames every period, gap_ns apart,
+ * starting at offset_ns. Options:
+ *   start/stop   only between these times
+ *   on/off       profile; bursts starting in the off part are skipped
+ *   align        offset measured from the open instant of the stream's
+ *                first TC window in the GCL cycle
+ * The compiler also reports frames that would not fit their gate window
+ * and frames launched before the previous one has left the wire.
+ *
+ * One pass covers length_ns (default: the hyperperiod of all periods,
+ * profiles and the GCL cycle). A looping timeline is played pass after
+ * pass. Sequence numbers count per flow (VLAN, PCP) in launch order; pass
+ * p adds p * the flow's frames per pass. With align_ns the player starts
+ * on a multiple of it in CLOCK_REALTIME.
+ *
+ * Layout: header | flows (frames per pass, u32) | templates | records.
+ * The digest is the CRC32C of the templates, records and flows, so two
+ * timelines with equal digests send exactly the same frames at the same
+ * times. `tsn-timeline --dump` prints a file as text for diffing.
+ */
+
+#ifndef TSNPERF_TIMELINE_H
+#define TSNPERF_TIMELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "frame.h"
+#include "gcl.h"
+
+#define TP_TL_MAGIC         "TPTL"
+#define TP_TL_VERSION       1
+#define TP_TL_NAME_LEN      32
+#define TP_TL_MAX_TEMPLATES 4096
+#define TP_TL_MAX_FLOWS     4096
+#define TP_TL_MAX_RECORDS   (256ULL * 1024 * 1024)
+#define TP_TL_MAX_LENGTH_NS (60ULL * 1000000000ULL)
+#define TP_TL_FRAME_CAP     1536        // Template slot (TP_MAX_FRAME_LEN rounded up)
+#define TP_TL_PRBS_FRAME    128         // Default frame with a PRBS body
+
+typedef struct {
+    uint64_t launch_ns;     // From the start of the pass
+    uint32_t seq;           // Flow sequence number within the pass
+    uint16_t tpl;
+    uint16_t flow;
+} tp_tl_rec_t;
+
+typedef struct {
+    uint16_t len;
+    uint8_t tc;
+    uint8_t reserved;
+    uint16_t flow;
+    uint16_t reserved2;
+    char id[TP_TL_NAME_LEN];        // Stream id
+    uint8_t frame[TP_TL_FRAME_CAP];
+} tp_tl_tpl_t;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t rec_size;
+    uint32_t tpl_size;
+    uint32_t n_templates;
+    uint32_t n_flows;
+    uint64_t n_records;
+    uint64_t length_ns;     // One pass
+    uint64_t align_ns;      // Start on a multiple of this, 0 = anywhere
+    uint32_t loop;          // Play passes back to back
+    uint32_t link_mbps;
+    uint32_t digest;
+    uint32_t reserved0;
+    uint64_t flow_off;
+    uint64_t tpl_off;
+    uint64_t rec_off;
+    uint8_t reserved[32];
+} tp_tl_hdr_t;
+
+typedef struct {
+    char id[TP_TL_NAME_LEN];
+    int tc;
+    int vlan_id;
+    uint32_t frame;         // Bytes without FCS, 0 = 60 (128 with prbs)
+    int prbs;               // PRBS-31 payload (payload.h)
+    uint32_t prbs_seed;
+    uint64_t period_ns;
+    uint32_t burst;         // Frames per period
+    uint64_t gap_ns;        // Within a burst
+    uint64_t offset_ns;
+    uint64_t start_ns;      // 0 = from the start
+    uint64_t stop_ns;       // 0 = to the end of the pass
+    uint64_t on_ns;         // Profile; 0 = always on
+    uint64_t off_ns;
+    int align;              // offset_ns from the TC's first window open
+} tp_tl_stream_t;
+
+typedef struct {
+    uint8_t dst_mac[6];
+    uint8_t src_mac[6];
+    uint32_t link_mbps;
+    uint64_t length_ns;     // 0 = hyperperiod; when looping, whole periods, profiles and cycles
+    int once;               // Don't loop
+    const tp_gcl_t *gcl;    // Optional: alignment, window check and align_ns
+    int n_streams;
+    tp_tl_stream_t *streams;
+} tp_tl_cfg_t;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t outside;       // Not within a window of its TC
+} tp_tl_stream_stat_t;
+
+typedef struct {
+    uint64_t n_records;
+    uint64_t length_ns;
+    uint32_t n_flows;
+    uint32_t digest;
+    int loop;
+    uint64_t min_gap_ns;    // Closest launch spacing (UINT64_MAX with < 2 records)
+    uint64_t overlaps;      // Launched before the previous frame left the wire (incl. the loop seam)
+    double load;            // Wire time / pass length, <= 1 (compiling fails above)
+    tp_tl_stream_stat_t *streams;   // Per cfg stream, owned by the caller
+    char error[128];
+} tp_tl_summary_t;
+
+// Defaults: burst 1, VLAN 100
+void tp_tl_stream_init(tp_tl_stream_t *st);
+
+// Compile cfg into path. sum->streams may be NULL. Returns 0, or -1 with
+// sum->error set.
+int tp_tl_compile(const tp_tl_cfg_t *cfg, const char *path, tp_tl_summary_t *sum);
+
+// Read-only mapping of a timeline file
+typedef struct {
+    void *map;
+    size_t len;
+    const tp_tl_hdr_t *hdr;
+    const uint32_t *flows;
+    const tp_tl_tpl_t *tpls;
+    const tp_tl_rec_t *recs;
+} tp_tl_file_t;
+
+// Map and validate a timeline (layout and digest). Returns 0, or -1 with
+// err (cap bytes) set.
+int tp_tl_open(tp_tl_file_t *f, const char *path, char *err, size_t cap);
+void tp_tl_close(tp_tl_file_t *f);
+
+#endif
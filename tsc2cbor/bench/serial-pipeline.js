@@ -0,0 +1,237 @@
+#!/usr/bin/env node
+/**
+ * serial-pipeline.js - MUP1 serial throughput, stop-and-wait vs pipelined
+ *
+ * Runs SerialManager against a fake VelocityDRIVE-SP device on a pty. The
+ * device models the board side of the link: a UART of --baud in each
+ * direction and one CPU that spends --proc-us on every CoAP request, so
+ * round trips cost what they cost on hardware and a deeper request window
+ * can overlap them.
+ *
+ * python3 opens the pty (Node has no openpty) and bridges its master side
+ * to this process; the device itself is implemented here.
+ *
+ * Run: node bench/serial-pipeline.js [--baud 115200] [--proc-us 2000]
+ *        [--patch-kb 16] [--fetch-kb 16] [--requests 20] [--windows 1,2,4,8]
+ */
+
+import { spawn } from 'child_process';
+import { SerialManager } from '../lib/serial/serial.js';
+import { FrameBuffer, buildFrame, FrameType } from '../lib/serial/mup1-v2.js';
+import {
+  buildMessage,
+  parseResponse,
+  MessageType,
+  MethodCode,
+  ResponseCode,
+  OptionNumber,
+  encodeBlock2Value,
+  encodeBlock1Value
+} from '../lib/coap/coap.js';
+
+function parseArgs(argv) {
+  const args = { baud: 115200, procUs: 2000, patchKb: 16, fetchKb: 16, requests: 20, windows: [1, 2, 4, 8] };
+  for (let i = 2; i < argv.length; i++) {
+    const v = argv[i + 1];
+    switch (argv[i]) {
+      case '--baud': args.baud = Number(v); i++; break;
+      case '--proc-us': args.procUs = Number(v); i++; break;
+      case '--patch-kb': args.patchKb = Number(v); i++; break;
+      case '--fetch-kb': args.fetchKb = Number(v); i++; break;
+      case '--requests': args.requests = Number(v); i++; break;
+      case '--windows': args.windows = v.split(',').map(Number); i++; break;
+      default:
+        console.error(`Unknown option: ${argv[i]}`);
+        process.exit(2);
+    }
+  }
+  return args;
+}
+
+// Raw pty pair; prints the slave path, then copies master <-> stdio
+const PTY_BRIDGE = `
+import os, pty, select, sys, tty
+master, slave = pty.openpty()
+tty.setraw(slave)
+print(os.ttyname(slave), flush=True)
+out = sys.stdout.fileno()
+inp = sys.stdin.fileno()
+while True:
+    r, _, _ = select.select([master, inp], [], [])
+    if master in r:
+        os.write(out, os.read(master, 65536))
+    if inp in r:
+        data = os.read(inp, 65536)
+        if not data:
+            break
+        os.write(master, data)
+`;
+
+function openPty() {
+  return new Promise((resolve, reject) => {
+    const proc = spawn('python3', ['-c', PTY_BRIDGE], { stdio: ['pipe', 'pipe', 'inherit'] });
+    proc.on('error', reject);
+    proc.stdout.once('data', (line) => {
+      const path = line.toString().split('\n')[0].trim();
+      if (!path.startsWith('/dev/')) {
+        reject(new Error(`pty bridge: ${line}`));
+        return;
+      }
+      resolve({ proc, path });
+    });
+  });
+}
+
+const ackOf = (req, code, options = [], payload = null) => buildMessage({
+  type: MessageType.ACK,
+  code,
+  messageId: req.messageId,
+  token: req.token,
+  options,
+  payload
+});
+
+/**
+ * Fake board: FIFO CPU behind a full-duplex UART
+ */
+class FakeDevice {
+  constructor(bridge, { baud, procUs, fetchBytes }) {
+    this.bridge = bridge;
+    this.byteNs = 10e9 / baud;          // 8N1
+    this.procNs = procUs * 1000;
+    this.frames = new FrameBuffer();
+    this.rxFree = 0;
+    this.cpuFree = 0;
+    this.txFree = 0;
+    this.representation = Buffer.alloc(fetchBytes, 0xA5);
+    this.requests = 0;
+    bridge.stdout.on('data', (data) => this.receive(data));
+  }
+
+  now() {
+    return Number(process.hrtime.bigint());
+  }
+
+  receive(data) {
+    const arrived = this.now();
+    for (const frame of this.frames.addData(data)) {
+      // Serialize the frame on the RX line, then queue it for the CPU
+      const rxDone = Math.max(arrived, this.rxFree) + (frame.payload.length + 7) * this.byteNs;
+      this.rxFree = rxDone;
+      if (frame.type === FrameType.PING_REQ) {
+        this.send(buildFrame(Buffer.from('VelocitySP-fake'), { type: FrameType.ANNOUNCE }), rxDone);
+        continue;
+      }
+      if (frame.type !== FrameType.COAP) continue;
+      const done = Math.max(rxDone, this.cpuFree) + this.procNs;
+      this.cpuFree = done;
+      this.requests++;
+      this.send(buildFrame(this.handle(parseResponse(frame.payload)), { type: FrameType.COAP_RESPONSE }), done);
+    }
+  }
+
+  send(frame, readyNs) {
+    const txDone = Math.max(readyNs, this.txFree) + frame.length * this.byteNs;
+    this.txFree = txDone;
+    setTimeout(() => this.bridge.stdin.write(frame), Math.max(0, (txDone - this.now()) / 1e6));
+  }
+
+  handle(req) {
+    const opt = (n) => req.options.find(o => o.number === n);
+    if (req.code === MethodCode.IPATCH || req.code === MethodCode.PUT) {
+      const block1 = req.getBlock1Value();
+      if (block1 && block1.m) {
+        return ackOf(req, ResponseCode.CONTINUE, [{ number: OptionNumber.BLOCK1, value: encodeBlock1Value(block1.num, true, block1.szx) }]);
+      }
+      return ackOf(req, ResponseCode.CHANGED, block1
+        ? [{ number: OptionNumber.BLOCK1, value: encodeBlock1Value(block1.num, false, block1.szx) }]
+        : []);
+    }
+    if (req.code === MethodCode.FETCH) {
+      const block2 = opt(OptionNumber.BLOCK2) ? req.getBlock2Value() : { num: 0, szx: 6 };
+      const size = 1 << (block2.szx + 4);
+      const start = block2.num * size;
+      const chunk = this.representation.slice(start, start + size);
+      const more = start + chunk.length < this.representation.length;
+      const options = [{ number: OptionNumber.BLOCK2, value: encodeBlock2Value(block2.num, more, block2.szx) }];
+      if (block2.num === 0) options.push({ number: OptionNumber.SIZE2, value: this.representation.length });
+      return ackOf(req, ResponseCode.CONTENT, options, chunk);
+    }
+    return ackOf(req, 0x85);   // 4.05
+  }
+}
+
+async function connect(path, args) {
+  const manager = new SerialManager();
+  await manager.connect(path, { baudRate: args.baud });
+  const deadline = Date.now() + 5000;
+  while (!manager.boardReady) {
+    if (Date.now() > deadline) throw new Error('No ANNOUNCE from fake device');
+    await new Promise(resolve => setTimeout(resolve, 10));
+  }
+  return manager;
+}
+
+async function run(manager, window, args) {
+  manager.window = window;
+  manager.stats = { requests: 0, writes: 0, frames: 0, maxInFlight: 0 };
+
+  const patch = Buffer.alloc(args.patchKb * 1024, 0x5A);
+  const result = {};
+
+  let start = process.hrtime.bigint();
+  await manager.sendiPatchRequest(patch);
+  result.patchMs = Number(process.hrtime.bigint() - start) / 1e6;
+
+  start = process.hrtime.bigint();
+  const fetched = await manager.sendiFetchRequest([1000]);
+  result.fetchMs = Number(process.hrtime.bigint() - start) / 1e6;
+  if (fetched.payload.length !== args.fetchKb * 1024) {
+    throw new Error(`Fetched ${fetched.payload.length} bytes, expected ${args.fetchKb * 1024}`);
+  }
+
+  // Independent small requests, e.g. one iPATCH per leaf
+  start = process.hrtime.bigint();
+  await Promise.all(Array.from({ length: args.requests }, () => manager.sendiPatchRequest(Buffer.alloc(32, 1))));
+  result.smallMs = Number(process.hrtime.bigint() - start) / 1e6;
+
+  result.stats = manager.getPipelineStats();
+  return result;
+}
+
+async function main() {
+  const args = parseArgs(process.argv);
+  const { proc, path } = await openPty();
+  const device = new FakeDevice(proc, { baud: args.baud, procUs: args.procUs, fetchBytes: args.fetchKb * 1024 });
+
+  console.log(`fake device on ${path}: ${args.baud} baud, ${args.procUs} us per request`);
+  console.log(`workload: ${args.patchKb} KiB iPATCH, ${args.fetchKb} KiB iFETCH, ${args.requests} x 32 B iPATCH\n`);
+  console.log('window  patch_ms  patch_kBps  fetch_ms  fetch_kBps  small_ms  req/s   writes  frames  max_inflight');
+
+  const manager = await connect(path, args);
+  for (const window of args.windows) {
+    const r = await run(manager, window, args);
+    console.log([
+      String(window).padStart(6),
+      r.patchMs.toFixed(1).padStart(9),
+      (args.patchKb * 1024 / r.patchMs).toFixed(1).padStart(11),
+      r.fetchMs.toFixed(1).padStart(9),
+      (args.fetchKb * 1024 / r.fetchMs).toFixed(1).padStart(11),
+      r.smallMs.toFixed(1).padStart(9),
+      (args.requests * 1000 / r.smallMs).toFixed(0).padStart(6),
+      String(r.stats.writes).padStart(8),
+      String(r.stats.frames).padStart(7),
+      String(r.stats.maxInFlight).padStart(13)
+    ].join(' '));
+  }
+  console.log(`\n${device.requests} requests served`);
+
+  await manager.disconnect();
+  proc.kill();
+  process.exit(0);
+}
+
+main().catch((err) => {
+  console.error(err.message);
+  process.exit(1);
+});
@@ -69,6 +69,7 @@ const OptionNumber = {
   LOCATION_QUERY: 20,
   BLOCK2: 23, // RFC 7959 - Response block-wise transfer
   BLOCK1: 27, // RFC 7959 - Request block-wise transfer
+  SIZE2: 28,  // RFC 7959 - Total size of the response representation
   PROXY_URI: 35,
   PROXY_SCHEME: 39,
   SIZE1: 60
@@ -515,6 +516,10 @@ function parseResponse(data) {
     getBlock1Value: () => {
       const block1Opt = options.find(opt => opt.number === OptionNumber.BLOCK1);
       return block1Opt ? decodeBlock1Value(block1Opt.value) : null;
+    },
+    getSize2Value: () => {
+      const size2Opt = options.find(opt => opt.number === OptionNumber.SIZE2);
+      return size2Opt ? size2Opt.value.reduce((v, b) => v * 256 + b, 0) : null;
     }
   };
 }
@@ -0,0 +1,125 @@
+/**
+ * Codec Plan Module
+ *
+ * Compiles a leaf's typeInfo (from yang-type-extractor) once into a codec
+ * plan, so value-encoder.js / value-decoder.js don't re-interpret the type
+ * for every value:
+ * - kind: built-in type name, with unresolved typedefs mapped by what they carry
+ * - enum: the nameToValue / valueToName BiMap (O(1) both ways)
+ * - bits: name → position Map plus a (byte, mask) table in declaration order
+ * - decimal64: fraction digits and the 10^fd scale
+ * - union: member plans in YANG order, plus the members selected by
+ *   Tag(44)/Tag(45) for tag dispatch
+ *
+ * The encoder and decoder compile their own executors from a plan on first
+ * use and keep them on it (plan.encode / plan.decode). Plans are cached per
+ * typeInfo object; compileCodecPlans() builds them for a whole catalog at
+ * load time and indexes them by SID (typeTable.plansBySid).
+ *
+ * @module codec-plan
+ */
+
+const BUILTIN_TYPES = new Set(['enumeration', 'identityref', 'decimal64', 'bits', 'union',
+  'binary', 'boolean', 'string', 'empty',
+  'uint8', 'uint16', 'uint32', 'uint64', 'int8', 'int16', 'int32', 'int64']);
+
+// Returned by an executor in union context when the value doesn't fit the member
+export const NO_MATCH = Symbol('codec-plan.no-match');
+
+const plans = new WeakMap();   // typeInfo → plan
+
+/**
+ * Get (or compile) the codec plan for a typeInfo
+ * @param {object} typeInfo - Type information from yang-type-extractor
+ * @returns {object|null} Codec plan, or null without type info
+ */
+export function getCodecPlan(typeInfo) {
+  if (!typeInfo || !typeInfo.type) return null;
+  let plan = plans.get(typeInfo);
+  if (!plan) {
+    plan = compileCodecPlan(typeInfo);
+    plans.set(typeInfo, plan);
+  }
+  return plan;
+}
+
+/**
+ * Compile a codec plan from type info
+ * @param {object} typeInfo - Type information from yang-type-extractor
+ * @returns {object} Codec plan
+ */
+function compileCodecPlan(typeInfo) {
+  const builtin = BUILTIN_TYPES.has(typeInfo.type) ? typeInfo.type : null;
+
+  // A typedef the loader couldn't resolve still decodes by what it carries
+  let implied = null;
+  if (!builtin) {
+    if (typeInfo.enum) implied = 'enumeration';
+    else if (typeInfo.bits) implied = 'bits';
+    else if (typeInfo.base) implied = 'identityref';
+  }
+
+  const plan = {
+    type: typeInfo.type,
+    original: typeInfo.original || null,
+    kind: builtin,               // encoder: non-built-in types are auto-encoded
+    decodeKind: builtin || implied,
+    enum: typeInfo.enum || null,
+    bitPositions: null,
+    bitTable: null,
+    fractionDigits: 0,
+    scale: 1,
+    members: null,
+    hasUnionTypes: false,
+    enumMember: null,
+    identityMember: null,
+    base: typeInfo.base || null,
+    encode: null,
+    decode: null
+  };
+
+  if (typeInfo.bits) {
+    plan.bitPositions = new Map(Object.entries(typeInfo.bits));
+    plan.bitTable = Object.entries(typeInfo.bits).map(([name, position]) => ({
+      name,
+      byte: Math.floor(position / 8),
+      mask: 1 << (position % 8)
+    }));
+  }
+
+  if (builtin === 'decimal64') {
+    plan.fractionDigits = typeInfo.fractionDigits || 2;
+    plan.scale = Math.pow(10, plan.fractionDigits);
+  }
+
+  if (builtin === 'union') {
+    const memberTypes = typeInfo.unionTypes || typeInfo.types || [];
+    plan.members = memberTypes.map(member => getCodecPlan(member) || compileCodecPlan({ type: null }));
+    plan.hasUnionTypes = Array.isArray(typeInfo.unionTypes) && typeInfo.unionTypes.length > 0;
+    plan.enumMember = plan.members.find(m => m.type === 'enumeration' || m.enum) || null;
+    plan.identityMember = plan.members.find(m => m.type === 'identityref' || m.base) || null;
+  }
+
+  return plan;
+}
+
+/**
+ * Compile codec plans for every typed leaf of a catalog
+ *
+ * Called by loadYangInputs() after the cache is written (plans hold
+ * closures and are rebuilt from the cached type info on every load).
+ *
+ * @param {object} typeTable - Type table from loadYangInputs
+ * @param {object} sidInfo - SID info from loadYangInputs
+ * @returns {Map<number, object>} SID → codec plan (also set as typeTable.plansBySid)
+ */
+export function compileCodecPlans(typeTable, sidInfo) {
+  const plansBySid = new Map();
+  for (const [path, typeInfo] of typeTable.types) {
+    const plan = getCodecPlan(typeInfo);
+    const sid = sidInfo?.pathToInfo.get(path)?.sid;
+    if (plan && sid !== undefined) plansBySid.set(sid, plan);
+  }
+  typeTable.plansBySid = plansBySid;
+  return plansBySid;
+}
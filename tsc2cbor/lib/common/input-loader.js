@@ -11,6 +11,7 @@
 
 import { buildSidInfo } from './sid-resolver.js';
 import { extractYangTypes } from './yang-type-extractor.js';
+import { compileCodecPlans } from './codec-plan.js';
 import fs from 'fs';
 import path from 'path';
 
@@ -201,7 +202,9 @@ export async function loadYangInputs(yangCacheDir, verbose = false, options = {}
       console.log('Loading YANG/SID from cache...');
     }
     try {
-      return await loadFromCache(cacheFile, verbose);
+      const cached = await loadFromCache(cacheFile, verbose);
+      compileCodecPlans(cached.typeTable, cached.sidInfo);
+      return cached;
     } catch (err) {
       if (verbose) {
         console.log(`  Cache load failed: ${err.message}, rebuilding...`);
@@ -473,5 +476,8 @@ export async function loadYangInputs(yangCacheDir, verbose = false, options = {}
     }
   }
 
+  // Step 10: Compile per-SID codec plans (after the cache save: plans aren't serialized)
+  compileCodecPlans(typeTable, sidInfo);
+
   return { sidInfo, typeTable, schemaInfo };
 }
@@ -5,7 +5,7 @@
  * CBOR Map with Delta-SID → Nested JSON Object
  */
 
-import { decodeValue } from './value-decoder.js';
+import { decodeSidValue } from './value-decoder.js';
 
 /**
  * Decode CBOR Map to nested object, resolving Delta-SIDs
@@ -84,9 +84,6 @@ function cborToJsonDelta(cborData, sidToInfo, typeTable, sidInfo, parentSid = nu
       }
       // String keys remain unchanged
 
-      // Get type info for value decoding
-      const typeInfo = yangPath ? typeTable.types.get(yangPath) : null;
-
       // Recursively decode value
       let decodedValue;
       const isNestedMap = value instanceof Map;
@@ -96,9 +93,9 @@ function cborToJsonDelta(cborData, sidToInfo, typeTable, sidInfo, parentSid = nu
         // Nested structure - recurse with current absoluteSid as parentSid
         decodedValue = cborToJsonDelta(value, sidToInfo, typeTable, sidInfo, absoluteSid);
       } else {
-        // Leaf value - decode based on type
-        decodedValue = typeInfo
-          ? decodeValue(value, typeInfo, sidInfo, false, null, yangPath)
+        // Leaf value - decode with the SID's compiled codec plan
+        decodedValue = yangPath
+          ? decodeSidValue(value, absoluteSid, yangPath, typeTable, sidInfo)
           : value;
       }
 
@@ -7,7 +7,7 @@
  * CBOR Map with Delta-SID → Instance-Identifier Array
  */
 
-import { decodeValue } from './value-decoder.js';
+import { decodeSidValue } from './value-decoder.js';
 
 /**
  * List key definitions for known YANG modules
@@ -115,10 +115,7 @@ function extractInstanceIds(cborData, sidToInfo, typeTable, sidInfo, parentSid,
             }
 
             if (nodeInfo && keyNames.includes(nodeInfo.localName)) {
-              const typeInfo = typeTable.types.get(nodeInfo.path);
-              const decodedValue = typeInfo
-                ? decodeValue(value, typeInfo, sidInfo, false, null, nodeInfo.path)
-                : value;
+              const decodedValue = decodeSidValue(value, absoluteSid, nodeInfo.path, typeTable, sidInfo);
               itemKeys[nodeInfo.localName] = decodedValue;
             }
           }
@@ -177,10 +174,7 @@ function extractInstanceIds(cborData, sidToInfo, typeTable, sidInfo, parentSid,
 
       if (isLeafValue(value)) {
         const xpath = buildXPath(newPrefixedPath, listKeys);
-        const typeInfo = typeTable.types.get(nodeInfo.path);
-        const decodedValue = typeInfo
-          ? decodeValue(value, typeInfo, sidInfo, false, null, nodeInfo.path)
-          : value;
+        const decodedValue = decodeSidValue(value, absoluteSid, nodeInfo.path, typeTable, sidInfo);
 
         results.push({ [xpath]: decodedValue });
       } else if (Array.isArray(value)) {
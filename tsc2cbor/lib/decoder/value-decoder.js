@@ -8,9 +8,13 @@
  * 1. CBOR value 받기
  * 2. TypeInfo로 타입 판단
  * 3. BiMap 사용해서 원본 값 복원
+ *
+ * 타입별 디코더는 codec plan(common/codec-plan.js)에서 한 번만 컴파일되고,
+ * 값마다 타입을 다시 해석하지 않는다.
  */
 
 import { Tag } from 'cbor-x';
+import { getCodecPlan, NO_MATCH } from '../common/codec-plan.js';
 
 /**
  * Decode CBOR value to original YANG value
@@ -23,136 +27,153 @@ import { Tag } from 'cbor-x';
  * @returns {*} Decoded value
  */
 export function decodeValue(cborValue, typeInfo, sidInfo = null, isUnion = false, typeTable = null, yangPath = null) {
-  if (!typeInfo || !typeInfo.type) {
+  const plan = getCodecPlan(typeInfo);
+  if (!plan) {
     return cborValue; // No type info, return as-is
   }
 
-  // CRITICAL FIX: Resolve typedef to base type
-  // If typeInfo.type is not a built-in type, it might be a typedef
-  // Check if typeInfo has resolved type info (enum, bits, etc.)
-  // If not, this might be a typedef that needs resolution
-  let resolvedTypeInfo = typeInfo;
-
-  // If typeInfo has original type stored and is different from type
-  // Or if type is not a built-in type, try to use original or resolve
-  if (typeInfo.original && typeInfo.original !== typeInfo.type) {
-    // This is a typedef - use the original info if it has enum/bits/etc
-    if (typeInfo.enum || typeInfo.bits || typeInfo.base) {
-      // Type info already has resolved information, use it
-      resolvedTypeInfo = typeInfo;
-    }
+  return decoderOf(plan)(cborValue, sidInfo, isUnion, yangPath, throwMiss);
+}
+
+/**
+ * Decode a leaf value by its SID, using the plan compiled at catalog load
+ * (typeTable.plansBySid); falls back to the path's type info
+ * @param {*} cborValue - CBOR encoded value
+ * @param {number} sid - Absolute SID of the leaf
+ * @param {string} yangPath - YANG path of the leaf
+ * @param {object} typeTable - Type table from loadYangInputs
+ * @param {object} sidInfo - SID tree for identity resolution
+ * @returns {*} Decoded value
+ */
+export function decodeSidValue(cborValue, sid, yangPath, typeTable, sidInfo) {
+  const plan = typeTable.plansBySid?.get(sid) || getCodecPlan(typeTable.types.get(yangPath));
+  if (!plan) {
+    return cborValue;
+  }
+
+  return decoderOf(plan)(cborValue, sidInfo, false, yangPath, throwMiss);
+}
+
+/*
+ * Executors compiled from a codec plan: (cborValue, sidInfo, isUnion, yangPath, miss).
+ * A value that doesn't fit the type is reported through miss(makeMessage):
+ * throwMiss raises the error, unionMiss returns NO_MATCH so a union can try
+ * its next member without an exception.
+ */
+const throwMiss = (makeMessage) => {
+  throw new Error(makeMessage());
+};
+const unionMiss = () => NO_MATCH;
+
+// Executors that never reject a value
+const TOTAL_KINDS = new Set([null, 'decimal64', 'binary', 'boolean', 'string', 'empty',
+  'uint8', 'uint16', 'uint32', 'uint64', 'int8', 'int16', 'int32', 'int64']);
+
+const passThrough = (cborValue) => cborValue;
+
+/**
+ * Get the decoder executor of a plan, compiling it on first use
+ * @param {object} plan - Codec plan from codec-plan.js
+ * @returns {Function} Executor
+ */
+function decoderOf(plan) {
+  if (!plan.decode) {
+    plan.decode = compileDecoder(plan);
   }
+  return plan.decode;
+}
 
-  switch (resolvedTypeInfo.type) {
+/**
+ * Compile the decoder executor for a plan
+ * Typedefs carrying enum/bits/base were already mapped to their kind by the plan
+ * @param {object} plan - Codec plan
+ * @returns {Function} Executor
+ */
+function compileDecoder(plan) {
+  switch (plan.decodeKind) {
     case 'enumeration':
-      return decodeEnum(cborValue, resolvedTypeInfo, isUnion, yangPath);
+      return compileEnum(plan);
 
     case 'identityref':
-      return decodeIdentity(cborValue, resolvedTypeInfo, sidInfo, isUnion);
+      return decodeIdentity;
 
     case 'decimal64':
-      return decodeDecimal64(cborValue);
+      return decodeDecimal64;
 
     case 'bits':
-      return decodeBits(cborValue, resolvedTypeInfo);
+      return compileBits(plan);
 
     case 'union':
-      return decodeUnion(cborValue, resolvedTypeInfo, sidInfo, typeTable, yangPath);
+      return compileUnion(plan);
 
     case 'binary':
-      return decodeBinary(cborValue);
-
-    case 'boolean':
-      return cborValue; // Already boolean
-
-    case 'string':
-      return cborValue; // Already string
-
-    case 'uint8':
-    case 'uint16':
-    case 'uint32':
-    case 'uint64':
-    case 'int8':
-    case 'int16':
-    case 'int32':
-    case 'int64':
-      return cborValue; // Already number
+      return decodeBinary;
 
     default:
-      // CRITICAL FIX: Check if this is a typedef with enum/bits/identityref embedded
-      if (resolvedTypeInfo.enum) {
-        // Has enum definition - treat as enumeration
-        return decodeEnum(cborValue, resolvedTypeInfo, isUnion, yangPath);
-      }
-      if (resolvedTypeInfo.bits) {
-        // Has bits definition - treat as bits
-        return decodeBits(cborValue, resolvedTypeInfo);
-      }
-      if (resolvedTypeInfo.base) {
-        // Has base identity - treat as identityref
-        return decodeIdentity(cborValue, resolvedTypeInfo, sidInfo, isUnion);
-      }
-
+      // boolean, string, integers: already decoded by cbor-x
       // Unknown type or primitive - return as-is
-      return cborValue;
+      return passThrough;
   }
 }
 
 /**
- * Decode enum value to name
- * @param {number|Tag} cborValue - CBOR enum value (number or Tag(44))
- * @param {object} typeInfo - Type info with enum definition
- * @param {boolean} isUnion - Whether inside union
- * @param {string} yangPath - YANG path for error reporting
- * @returns {string} Enum name
+ * Enum value to name through the plan's BiMap
+ * @param {object} plan - Codec plan with enum definition
+ * @returns {Function} Executor taking a number or Tag(44) (in union)
  */
-function decodeEnum(cborValue, typeInfo, isUnion, yangPath = null) {
-  // Extract value from Tag(44) if in union
-  let value = cborValue;
-  if (isUnion && cborValue instanceof Tag && cborValue.tag === 44) {
-    value = cborValue.value;
-  }
-
-  if (!typeInfo.enum) {
-    throw new Error(`Enum type info missing enum definition${yangPath ? ` for path: ${yangPath}` : ''}`);
-  }
+function compileEnum(plan) {
+  const enumDef = plan.enum;
+  const pathInfo = (yangPath) => (yangPath ? ` Path: ${yangPath}.` : '');
+  const typeNote = () => `Type: ${plan.type}, Original: ${plan.original || 'N/A'}`;
+
+  return (cborValue, sidInfo, isUnion, yangPath, miss) => {
+    // Extract value from Tag(44) if in union
+    let value = cborValue;
+    if (isUnion && cborValue instanceof Tag && cborValue.tag === 44) {
+      value = cborValue.value;
+    }
 
-  let enumName;
+    if (!enumDef) {
+      return miss(() => `Enum type info missing enum definition${yangPath ? ` for path: ${yangPath}` : ''}`);
+    }
 
-  if (typeof value === 'string') {
-    // String input: validate against nameToValue map
-    if (typeInfo.enum.nameToValue && typeInfo.enum.nameToValue.has(value)) {
-      enumName = value; // Already a valid enum name
-    } else {
-      const availableNames = Array.from(typeInfo.enum.valueToName.values());
-      const pathInfo = yangPath ? ` Path: ${yangPath}.` : '';
-      throw new Error(`Enum name "${value}" not found in enum definition.${pathInfo} Available names: ${availableNames.join(', ')}. Type: ${typeInfo.type}, Original: ${typeInfo.original || 'N/A'}`);
+    if (typeof value === 'string') {
+      // String input: validate against nameToValue map
+      if (enumDef.nameToValue && enumDef.nameToValue.has(value)) {
+        return value; // Already a valid enum name
+      }
+      return miss(() => {
+        const availableNames = Array.from(enumDef.valueToName.values());
+        return `Enum name "${value}" not found in enum definition.${pathInfo(yangPath)} Available names: ${availableNames.join(', ')}. ${typeNote()}`;
+      });
     }
-  } else if (typeof value === 'number') {
-    // Numeric input: use BiMap value → name (O(1))
-    enumName = typeInfo.enum.valueToName.get(value);
-    if (!enumName) {
-      const availableValues = Array.from(typeInfo.enum.valueToName.keys()).sort((a, b) => a - b);
-      const pathInfo = yangPath ? ` Path: ${yangPath}.` : '';
-      throw new Error(`Enum value ${value} not found in enum definition.${pathInfo} Available values: ${availableValues.join(', ')}. Type: ${typeInfo.type}, Original: ${typeInfo.original || 'N/A'}`);
+
+    if (typeof value === 'number') {
+      // Numeric input: use BiMap value → name (O(1))
+      const enumName = enumDef.valueToName.get(value);
+      if (!enumName) {
+        return miss(() => {
+          const availableValues = Array.from(enumDef.valueToName.keys()).sort((a, b) => a - b);
+          return `Enum value ${value} not found in enum definition.${pathInfo(yangPath)} Available values: ${availableValues.join(', ')}. ${typeNote()}`;
+        });
+      }
+      return enumName;
     }
-  } else {
-    const pathInfo = yangPath ? ` Path: ${yangPath}.` : '';
-    throw new Error(`Unexpected enum value type: ${typeof value}.${pathInfo} Expected number or string.`);
-  }
 
-  return enumName;
+    return miss(() => `Unexpected enum value type: ${typeof value}.${pathInfo(yangPath)} Expected number or string.`);
+  };
 }
 
 /**
  * Decode identity SID to identity name
  * @param {number|Tag} cborValue - Identity SID (number or Tag(45))
- * @param {object} typeInfo - Type info with identity base
  * @param {object} sidInfo - SID tree with sidToIdentity map
  * @param {boolean} isUnion - Whether inside union
+ * @param {string} yangPath - Unused
+ * @param {Function} miss - Mismatch handler
  * @returns {string} Identity name
  */
-function decodeIdentity(cborValue, typeInfo, sidInfo, isUnion) {
+function decodeIdentity(cborValue, sidInfo, isUnion, yangPath, miss) {
   // Extract SID from Tag(45) if in union
   let sid = cborValue;
   if (isUnion && cborValue instanceof Tag && cborValue.tag === 45) {
@@ -160,13 +181,13 @@ function decodeIdentity(cborValue, typeInfo, sidInfo, isUnion) {
   }
 
   if (!sidInfo || !sidInfo.sidToIdentity) {
-    throw new Error('SID tree missing sidToIdentity map');
+    return miss(() => 'SID tree missing sidToIdentity map');
   }
 
   // Use BiMap: SID → identity name
   const identityName = sidInfo.sidToIdentity.get(sid);
   if (!identityName) {
-    throw new Error(`Identity SID ${sid} not found in SID tree`);
+    return miss(() => `Identity SID ${sid} not found in SID tree`);
   }
 
   return identityName;
@@ -196,43 +217,38 @@ function decodeDecimal64(cborValue) {
 }
 
 /**
- * Decode bits from CBOR Tag(43) byte array
- * @param {Tag|Buffer} cborValue - CBOR bits value
- * @param {object} typeInfo - Type info with bit definitions
- * @returns {string[]} Array of bit names
+ * Bits from a CBOR Tag(43) byte array, using the plan's (byte, mask) table
+ * @param {object} plan - Codec plan with bit definitions
+ * @returns {Function} Executor returning an array of bit names
  */
-function decodeBits(cborValue, typeInfo) {
-  let buffer = cborValue;
+function compileBits(plan) {
+  const bitTable = plan.bitTable;
 
-  // Extract buffer from Tag(43)
-  if (cborValue instanceof Tag && cborValue.tag === 43) {
-    buffer = cborValue.value;
-  }
+  return (cborValue, sidInfo, isUnion, yangPath, miss) => {
+    let buffer = cborValue;
 
-  if (!Buffer.isBuffer(buffer)) {
-    throw new Error('Expected Buffer for bits type');
-  }
-
-  if (!typeInfo.bits) {
-    throw new Error('Bits type info missing bits definition');
-  }
+    // Extract buffer from Tag(43)
+    if (cborValue instanceof Tag && cborValue.tag === 43) {
+      buffer = cborValue.value;
+    }
 
-  const result = [];
+    if (!Buffer.isBuffer(buffer)) {
+      return miss(() => 'Expected Buffer for bits type');
+    }
 
-  // Check each bit position
-  for (const [bitName, position] of Object.entries(typeInfo.bits)) {
-    const byteIndex = Math.floor(position / 8);
-    const bitIndex = position % 8;
+    if (!bitTable) {
+      return miss(() => 'Bits type info missing bits definition');
+    }
 
-    if (byteIndex < buffer.length) {
-      const byte = buffer[byteIndex];
-      if ((byte & (1 << bitIndex)) !== 0) {
-        result.push(bitName);
+    const result = [];
+    for (const bit of bitTable) {
+      if (bit.byte < buffer.length && (buffer[bit.byte] & bit.mask) !== 0) {
+        result.push(bit.name);
       }
     }
-  }
 
-  return result;
+    return result;
+  };
 }
 
 /**
@@ -256,58 +272,45 @@ function decodeBinary(cborValue) {
 }
 
 /**
- * Decode union type by checking CBOR Tag
- * @param {*} cborValue - CBOR value (may have Tag 44 or 45)
- * @param {object} typeInfo - Union type info
- * @param {object} sidInfo - SID tree
- * @param {object} typeTable - Type table for typedef resolution
- * @param {string} yangPath - YANG path for error reporting
- * @returns {*} Decoded value
+ * Union by CBOR Tag, then by member type in YANG order
+ * Tag(44)/Tag(45) go straight to the plan's enum/identity member; other
+ * values try the members in order until one accepts the value. Members
+ * after one that accepts everything are dropped from the order.
+ * @param {object} plan - Union codec plan
+ * @returns {Function} Executor
  */
-function decodeUnion(cborValue, typeInfo, sidInfo, typeTable, yangPath = null) {
-  // Check for union-specific tags
-  if (cborValue instanceof Tag) {
-    if (cborValue.tag === 44) {
-      // Tag(44) = enum in union
-      // Find enum type in union
-      for (const memberType of typeInfo.unionTypes || typeInfo.types || []) {
-        if (memberType.type === 'enumeration' || memberType.enum) {
-          return decodeEnum(cborValue, memberType, true, yangPath);
-        }
-      }
-    } else if (cborValue.tag === 45) {
-      // Tag(45) = identity in union
-      for (const memberType of typeInfo.unionTypes || typeInfo.types || []) {
-        if (memberType.type === 'identityref' || memberType.base) {
-          return decodeIdentity(cborValue, memberType, sidInfo, true);
-        }
-      }
-    }
+function compileUnion(plan) {
+  const { enumMember, identityMember } = plan;
+
+  const order = [];
+  for (const member of plan.members) {
+    order.push(member);
+    if (TOTAL_KINDS.has(member.decodeKind)) break;
   }
 
-  // Try each union member type
-  if (typeInfo.unionTypes && Array.isArray(typeInfo.unionTypes)) {
-    for (const memberType of typeInfo.unionTypes) {
-      try {
-        return decodeValue(cborValue, memberType, sidInfo, true, typeTable, yangPath);
-      } catch (err) {
-        // Try next type
-        continue;
+  return (cborValue, sidInfo, isUnion, yangPath, miss) => {
+    // Check for union-specific tags
+    if (cborValue instanceof Tag) {
+      if (cborValue.tag === 44 && enumMember) {
+        // Tag(44) = enum in union
+        return decoderOf(enumMember)(cborValue, sidInfo, true, yangPath, miss);
+      }
+      if (cborValue.tag === 45 && identityMember) {
+        // Tag(45) = identity in union
+        return decoderOf(identityMember)(cborValue, sidInfo, true, yangPath, miss);
       }
     }
-  } else if (typeInfo.types && Array.isArray(typeInfo.types)) {
-    for (const memberType of typeInfo.types) {
-      try {
-        return decodeValue(cborValue, memberType, sidInfo, true, typeTable, yangPath);
-      } catch (err) {
-        // Try next type
-        continue;
+
+    for (const member of order) {
+      const decoded = decoderOf(member)(cborValue, sidInfo, true, yangPath, unionMiss);
+      if (decoded !== NO_MATCH) {
+        return decoded;
       }
     }
-  }
 
-  // Fallback
-  return cborValue;
+    // Fallback
+    return cborValue;
+  };
 }
 
 /**
@@ -331,15 +334,8 @@ export function decodeObjectValues(sidObject, typeTable, sidInfo) {
       continue;
     }
 
-    // Step 2: Get TypeInfo for this path
-    const typeInfo = typeTable.types.get(yangPath);
-
-    // Step 3: Decode value based on TypeInfo
-    const decodedValue = typeInfo
-      ? decodeValue(cborValue, typeInfo, sidInfo, false)
-      : cborValue;
-
-    decoded[yangPath] = decodedValue;
+    // Step 2: Decode value with the SID's codec plan
+    decoded[yangPath] = decodeSidValue(cborValue, sid, yangPath, typeTable, sidInfo);
   }
 
   return decoded;
@@ -1,7 +1,9 @@
 /**
  * Value Encoder Module
  *
- * Encodes values based on YANG type information with RFC 9254 CBOR Tags
+ * Encodes values based on YANG type information with RFC 9254 CBOR Tags.
+ * Each type is compiled once into an executor (see common/codec-plan.js);
+ * encodeValue() only looks the plan up and runs it.
  *
  * CBOR Tags (RFC 9254):
  * - Tag 4: decimal64 as [-fractionDigits, mantissa]
@@ -12,6 +14,7 @@
 
 import cbor from 'cbor';
 import { resolveIdentityToSid } from '../common/sid-resolver.js';
+import { getCodecPlan, NO_MATCH } from '../common/codec-plan.js';
 
 // Use cbor library's Tagged class for CBOR tag encoding
 // Note: cbor uses Tagged(tagNumber, value), not Tag(value, tagNumber)
@@ -32,128 +35,151 @@ export function encodeValue(value, typeInfo, sidInfo = null, isUnion = false) {
   }
 
   // If no type info, auto-detect
-  if (!typeInfo || !typeInfo.type) {
+  const plan = getCodecPlan(typeInfo);
+  if (!plan) {
     return autoEncodeValue(value);
   }
 
-  const yangType = typeInfo.type;
+  return encoderOf(plan)(value, sidInfo, isUnion, throwMiss);
+}
+
+/*
+ * Executors compiled from a codec plan: (value, sidInfo, isUnion, miss).
+ * A value that doesn't fit the type is reported through miss(makeMessage):
+ * throwMiss raises the error, unionMiss returns NO_MATCH so a union can try
+ * its next member without an exception.
+ */
+const throwMiss = (makeMessage) => {
+  throw new Error(makeMessage());
+};
+const unionMiss = () => NO_MATCH;
+
+// Executors that accept every non-null value
+const TOTAL_KINDS = new Set([null, 'boolean', 'string', 'binary', 'empty', 'union']);
 
-  switch (yangType) {
+/**
+ * Get the encoder executor of a plan, compiling it on first use
+ * @param {object} plan - Codec plan from codec-plan.js
+ * @returns {Function} Executor
+ */
+function encoderOf(plan) {
+  if (!plan.encode) {
+    plan.encode = compileEncoder(plan);
+  }
+  return plan.encode;
+}
+
+/**
+ * Compile the encoder executor for a plan (one switch per type, not per value)
+ * @param {object} plan - Codec plan
+ * @returns {Function} Executor
+ */
+function compileEncoder(plan) {
+  switch (plan.kind) {
     case 'enumeration':
-      return encodeEnum(value, typeInfo, isUnion);
+      return compileEnum(plan);
 
     case 'identityref':
-      return encodeIdentity(value, typeInfo, sidInfo, isUnion);
+      return encodeIdentity;
 
     case 'decimal64':
-      return encodeDecimal64(value, typeInfo);
+      return compileDecimal64(plan);
 
     case 'bits':
-      return encodeBits(value, typeInfo, isUnion);
+      return compileBits(plan);
 
     case 'boolean':
-      return Boolean(value);
+      return (value) => Boolean(value);
 
     case 'uint8':
     case 'uint16':
     case 'uint32':
     case 'uint64':
-      return encodeUint(value);
+      return encodeUint;
 
     case 'int8':
     case 'int16':
     case 'int32':
     case 'int64':
-      return encodeInt(value);
+      return encodeInt;
 
     case 'string':
-      // Convert MAC address format: colon to dash (YANG ieee:mac-address standard)
-      const stringValue = String(value);
-      if (isMacAddress(stringValue)) {
-        const converted = stringValue.replace(/:/g, '-');
-        // Debug: log conversion
-        if (process.env.DEBUG_MAC) {
-          console.log(`MAC conversion: ${stringValue} → ${converted}`);
-        }
-        return converted;
-      }
-      return stringValue;
+      return encodeString;
 
     case 'binary':
-      return encodeBinary(value);
+      return encodeBinary;
 
     case 'empty':
-      return null; // RFC 9254: empty type is encoded as null
+      return () => null; // RFC 9254: empty type is encoded as null
 
     case 'union':
-      return encodeUnion(value, typeInfo, sidInfo);
+      return compileUnion(plan);
 
     default:
       // Unknown type - auto-detect
-      return autoEncodeValue(value);
+      return autoEncodeValue;
   }
 }
 
 /**
- * Encode enum value with optional Tag(44) for union context
- * @param {string|number} value - Enum value (name or number)
- * @param {object} typeInfo - Type information with enum mapping
- * @param {boolean} isUnion - Whether in union context
- * @returns {number|Tag} Enum integer or Tag(44, integer)
+ * Enum value with optional Tag(44) for union context
+ * Name → value through the plan's BiMap (O(1))
+ * @param {object} plan - Codec plan with enum mapping
+ * @returns {Function} Executor returning enum integer or Tag(44, integer)
  */
-function encodeEnum(value, typeInfo, isUnion = false) {
-  let enumValue;
+function compileEnum(plan) {
+  const nameToValue = plan.enum ? plan.enum.nameToValue : null;
+  const valueToName = plan.enum ? plan.enum.valueToName : null;
 
-  if (typeof value === 'number') {
-    // If in union context, validate that this number is a valid enum value
-    if (isUnion && typeInfo.enum) {
-      // BiMap: valueToName has all valid values
-      if (!typeInfo.enum.valueToName.has(value)) {
-        throw new Error(`Numeric value ${value} is not a valid enum value`);
+  return (value, sidInfo, isUnion, miss) => {
+    let enumValue;
+
+    if (typeof value === 'number') {
+      // If in union context, validate that this number is a valid enum value
+      if (isUnion && valueToName && !valueToName.has(value)) {
+        return miss(() => `Numeric value ${value} is not a valid enum value`);
+      }
+      enumValue = value;
+    } else if (typeof value === 'string') {
+      enumValue = nameToValue ? nameToValue.get(value) : undefined;
+      if (enumValue === undefined) {
+        return miss(() => `Enum value "${value}" not found in type definition`);
       }
-    }
-    enumValue = value;
-  } else if (typeof value === 'string') {
-    // Look up enum name → value using BiMap (O(1))
-    if (typeInfo.enum && typeInfo.enum.nameToValue.has(value)) {
-      enumValue = typeInfo.enum.nameToValue.get(value);
     } else {
-      throw new Error(`Enum value "${value}" not found in type definition`);
+      return miss(() => `Invalid enum value type: ${typeof value}`);
     }
-  } else {
-    throw new Error(`Invalid enum value type: ${typeof value}`);
-  }
 
-  // RFC 9254: Use Tag(44) for enum in union context
-  return isUnion ? new Tagged(44, enumValue) : enumValue;
+    // RFC 9254: Use Tag(44) for enum in union context
+    return isUnion ? new Tagged(44, enumValue) : enumValue;
+  };
 }
 
 /**
  * Encode identity value with optional Tag(45) for union context
  * @param {string|number} value - Identity name or SID
- * @param {object} typeInfo - Type information with base identity
  * @param {object} sidInfo - SID tree for identity→SID resolution
  * @param {boolean} isUnion - Whether in union context
+ * @param {Function} miss - Mismatch handler
  * @returns {number|Tag} Identity SID or Tag(45, SID)
  */
-function encodeIdentity(value, typeInfo, sidInfo, isUnion = false) {
+function encodeIdentity(value, sidInfo, isUnion, miss) {
   let sid;
 
   if (typeof value === 'number') {
     sid = value;
   } else if (typeof value === 'string') {
     if (!sidInfo) {
-      throw new Error('SID tree required for identity resolution');
+      return miss(() => 'SID tree required for identity resolution');
     }
 
     // Resolve identity name → SID
     sid = resolveIdentityToSid(value, sidInfo);
 
     if (sid === null) {
-      throw new Error(`Identity "${value}" not found in SID tree`);
+      return miss(() => `Identity "${value}" not found in SID tree`);
     }
   } else {
-    throw new Error(`Invalid identity value type: ${typeof value}`);
+    return miss(() => `Invalid identity value type: ${typeof value}`);
   }
 
   // RFC 9254: Use Tag(45) for identityref in union context
@@ -161,118 +187,119 @@ function encodeIdentity(value, typeInfo, sidInfo, isUnion = false) {
 }
 
 /**
- * Encode decimal64 with RFC 9254 Tag(4)
- * @param {number|string} value - Decimal value (e.g., 3.14)
- * @param {object} typeInfo - Type information with fractionDigits
- * @returns {Tag} Tag(4, [-fractionDigits, mantissa])
+ * Decimal64 with RFC 9254 Tag(4), scale taken from the plan
+ * Example: 3.14 with fd=2 → Tag(4, [-2, 314])
+ * @param {object} plan - Codec plan with fractionDigits and scale
+ * @returns {Function} Executor returning Tag(4, [-fractionDigits, mantissa])
  */
-function encodeDecimal64(value, typeInfo) {
-  const fractionDigits = typeInfo.fractionDigits || 2;
-  const numValue = typeof value === 'string' ? parseFloat(value) : value;
+function compileDecimal64(plan) {
+  const { fractionDigits, scale } = plan;
 
-  if (isNaN(numValue)) {
-    throw new Error(`Invalid decimal64 value: ${value}`);
-  }
+  return (value, sidInfo, isUnion, miss) => {
+    const numValue = typeof value === 'string' ? parseFloat(value) : value;
 
-  // Calculate mantissa: value * 10^fractionDigits
-  const mantissa = Math.round(numValue * Math.pow(10, fractionDigits));
+    if (isNaN(numValue)) {
+      return miss(() => `Invalid decimal64 value: ${value}`);
+    }
 
-  // RFC 9254: Tag(4, [-fractionDigits, mantissa])
-  // Example: 3.14 with fd=2 → Tag(4, [-2, 314])
-  return new Tagged(4, [-fractionDigits, mantissa]);
+    return new Tagged(4, [-fractionDigits, Math.round(numValue * scale)]);
+  };
 }
 
 /**
- * Encode bits per RFC 9254
+ * Bits per RFC 9254, positions from the plan's name → position Map
  * - Normal context: byte string only
  * - Union context: Tag(43) + byte string (to distinguish from other types)
- * @param {string|Array} value - Bits value (e.g., "bit0 bit2" or ["bit0", "bit2"])
- * @param {object} typeInfo - Type information with bit definitions
- * @param {boolean} isUnion - Whether in union context
- * @returns {Buffer|Tagged} Byte buffer or Tag(43, byteBuffer)
+ * @param {object} plan - Codec plan with bit positions
+ * @returns {Function} Executor taking "bit0 bit2" or ["bit0", "bit2"]
  */
-function encodeBits(value, typeInfo, isUnion = false) {
-  let bitNames = [];
+function compileBits(plan) {
+  const bitPositions = plan.bitPositions;
 
-  if (Array.isArray(value)) {
-    bitNames = value;
-  } else if (typeof value === 'string') {
-    bitNames = value.split(/\s+/).filter(Boolean);
-  } else {
-    throw new Error(`Invalid bits value type: ${typeof value}`);
-  }
+  return (value, sidInfo, isUnion, miss) => {
+    let bitNames;
 
-  if (!typeInfo.bits) {
-    throw new Error('Bits type definition not found');
-  }
+    if (Array.isArray(value)) {
+      bitNames = value;
+    } else if (typeof value === 'string') {
+      bitNames = value.split(/\s+/).filter(Boolean);
+    } else {
+      return miss(() => `Invalid bits value type: ${typeof value}`);
+    }
 
-  // Convert bit names to positions
-  const positions = bitNames.map(name => {
-    const pos = typeInfo.bits[name];
-    if (pos === undefined) {
-      throw new Error(`Bit "${name}" not found in type definition`);
+    if (!bitPositions) {
+      return miss(() => 'Bits type definition not found');
     }
-    return pos;
-  });
-
-  // Convert positions to byte array
-  // Find max position to determine byte array size
-  const maxPos = Math.max(...positions, -1);
-  const numBytes = Math.ceil((maxPos + 1) / 8);
-  const bytes = Buffer.alloc(numBytes);
-
-  // Set bits
-  positions.forEach(pos => {
-    const byteIndex = Math.floor(pos / 8);
-    const bitIndex = pos % 8;
-    bytes[byteIndex] |= (1 << bitIndex);
-  });
-
-  // RFC 9254: Use Tag(43) only in union context to distinguish bits from other types
-  return isUnion ? new Tagged(43, bytes) : bytes;
+
+    // Convert bit names to positions, tracking the highest for the byte count
+    const positions = new Array(bitNames.length);
+    let maxPos = -1;
+    for (let i = 0; i < bitNames.length; i++) {
+      const pos = bitPositions.get(bitNames[i]);
+      if (pos === undefined) {
+        return miss(() => `Bit "${bitNames[i]}" not found in type definition`);
+      }
+      positions[i] = pos;
+      if (pos > maxPos) maxPos = pos;
+    }
+
+    const bytes = Buffer.alloc(Math.ceil((maxPos + 1) / 8));
+    for (const pos of positions) {
+      bytes[pos >> 3] |= (1 << (pos & 7));
+    }
+
+    // RFC 9254: Use Tag(43) only in union context to distinguish bits from other types
+    return isUnion ? new Tagged(43, bytes) : bytes;
+  };
 }
 
 /**
- * Encode union value
- * Union types need special handling - must detect actual type and apply appropriate Tag
- * @param {*} value - Union value
- * @param {object} typeInfo - Type information with unionTypes
- * @param {object} sidInfo - SID tree
- * @returns {*} Encoded value with appropriate Tag
+ * Union value: first member type (in YANG order) that accepts the value,
+ * encoded in union context so it gets its Tag. Members after one that
+ * accepts everything can never be reached and are dropped from the order.
+ * @param {object} plan - Codec plan with member plans
+ * @returns {Function} Executor
  */
-function encodeUnion(value, typeInfo, sidInfo) {
-  if (!typeInfo.unionTypes || typeInfo.unionTypes.length === 0) {
-    return autoEncodeValue(value);
+function compileUnion(plan) {
+  if (!plan.hasUnionTypes) {
+    return autoEncodeValue;
   }
 
-  // Try each union type in order
-  for (const unionType of typeInfo.unionTypes) {
-    try {
-      // Attempt to encode with isUnion=true for Tag wrapping
-      return encodeValue(value, unionType, sidInfo, true);
-    } catch (err) {
-      // Try next type
-      continue;
-    }
+  const order = [];
+  for (const member of plan.members) {
+    order.push(member);
+    if (TOTAL_KINDS.has(member.kind)) break;
   }
 
-  // If no type matched, return as-is
-  console.warn(`Union value could not be encoded with any union type: ${value}`);
-  return autoEncodeValue(value);
+  return (value, sidInfo) => {
+    for (const member of order) {
+      const encoded = encoderOf(member)(value, sidInfo, true, unionMiss);
+      if (encoded !== NO_MATCH) {
+        return encoded;
+      }
+    }
+
+    // If no type matched, return as-is
+    console.warn(`Union value could not be encoded with any union type: ${value}`);
+    return autoEncodeValue(value);
+  };
 }
 
 /**
  * Encode unsigned integer
  * @param {number|string} value - Unsigned integer value
+ * @param {object} sidInfo - Unused
+ * @param {boolean} isUnion - Unused
+ * @param {Function} miss - Mismatch handler
  * @returns {number} Validated unsigned integer
  */
-function encodeUint(value) {
+function encodeUint(value, sidInfo, isUnion, miss) {
   const num = Number(value);
   if (num < 0) {
-    throw new Error(`Unsigned integer cannot be negative: ${value}`);
+    return miss(() => `Unsigned integer cannot be negative: ${value}`);
   }
   if (!Number.isInteger(num)) {
-    throw new Error(`Unsigned integer must be an integer: ${value}`);
+    return miss(() => `Unsigned integer must be an integer: ${value}`);
   }
   return num;
 }
@@ -280,16 +307,38 @@ function encodeUint(value) {
 /**
  * Encode signed integer
  * @param {number|string} value - Signed integer value
+ * @param {object} sidInfo - Unused
+ * @param {boolean} isUnion - Unused
+ * @param {Function} miss - Mismatch handler
  * @returns {number} Validated signed integer
  */
-function encodeInt(value) {
+function encodeInt(value, sidInfo, isUnion, miss) {
   const num = Number(value);
   if (!Number.isInteger(num)) {
-    throw new Error(`Signed integer must be an integer: ${value}`);
+    return miss(() => `Signed integer must be an integer: ${value}`);
   }
   return num;
 }
 
+/**
+ * Encode string value
+ * Converts MAC address format: colon to dash (YANG ieee:mac-address standard)
+ * @param {*} value - String value
+ * @returns {string} String
+ */
+function encodeString(value) {
+  const stringValue = String(value);
+  if (isMacAddress(stringValue)) {
+    const converted = stringValue.replace(/:/g, '-');
+    // Debug: log conversion
+    if (process.env.DEBUG_MAC) {
+      console.log(`MAC conversion: ${stringValue} → ${converted}`);
+    }
+    return converted;
+  }
+  return stringValue;
+}
+
 /**
  * Encode binary value
  * @param {string|Buffer} value - Binary value (base64 string or Buffer)
@@ -389,6 +438,8 @@ export function encodeObjectValues(obj, typeTable = {}, sidInfo = null, currentP
  * @returns {boolean} True if MAC address format
  */
 function isMacAddress(value) {
+  if (value.length !== 17) return false;
+
   // MAC address patterns (IEEE 802 format):
   // - Colon separated: DE:68:FE:C8:1C:01
   // - Dash separated: DE-68-FE-C8-1C-01
@@ -31,6 +31,10 @@ const NL  = 0x0D;  // '\r'
 const ESC_00 = 0x30;  // '0' (escaped 0x00)
 const ESC_FF = 0x46;  // 'F' (escaped 0xFF)
 
+// Longest frame: a 1024-byte CoAP block (SZX 6) with every byte escaped,
+// plus CoAP header and options
+const MAX_FRAME_LEN = 2 * 1024 + 64;
+
 // Frame types
 const FrameType = {
   ANNOUNCE:      0x50,  // 'P' (Frame sent by device after PING_REQ)
@@ -342,7 +346,7 @@ class FrameBuffer {
 
       if (eofIndex === -1) {
         // No EOF yet, wait for more data
-        if (this.buffer.length > 1024) {
+        if (this.buffer.length > MAX_FRAME_LEN) {
           // Frame too big, discard
           this.buffer = this.buffer.slice(1);
         }
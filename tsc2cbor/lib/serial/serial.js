@@ -2,6 +2,15 @@
  * Serial Port Communication for MUP1/CoAP
  *
  * Handles UART communication with Microchip VelocityDRIVE-SP board
+ *
+ * Requests are pipelined: up to `window` CoAP requests (MUP1_WINDOW,
+ * default 4) are outstanding at once and matched to their responses by
+ * message ID, in any order. Frames queued in the same tick go out in one
+ * port.write. Block1 uploads keep a window of blocks in flight once the
+ * first block has settled the block size, and Block2 downloads request the
+ * remaining blocks ahead when the server sends Size2. MUP1_WINDOW=1 is the
+ * old stop-and-wait behaviour. The baud rate defaults to MUP1_BAUD or
+ * 115200; serialport's native termios binding takes non-standard rates.
  */
 
 import { SerialPort } from 'serialport';
@@ -37,6 +46,10 @@ const debugLog = (...args) => {
 const DEFAULT_BLOCK_SIZE_EXPONENT = 6; // SZX=6 means 1024 bytes (2^(6+4))
 const MIN_BLOCK_SIZE_EXPONENT = 4;     // SZX=4 means 256 bytes minimum
 
+// Pipelining
+const DEFAULT_WINDOW = 4;              // Outstanding CoAP requests
+const DEFAULT_BAUD_RATE = 115200;
+
 /**
  * Serial Communication Manager
  */
@@ -52,6 +65,14 @@ class SerialManager extends EventEmitter {
     this.boardReady = false;  // Track if board has completed booting
     this.announceReceived = false;  // Track if ANNOUNCE frame received
     this.verbose = options.verbose || false;  // Verbose output mode
+
+    // Request window and write coalescing
+    this.window = Math.max(1, options.window || Number(process.env.MUP1_WINDOW) || DEFAULT_WINDOW);
+    this.inFlight = 0;
+    this.windowWaiters = [];
+    this.writeQueue = [];
+    this.lastMessageId = Math.floor(Math.random() * 65536);
+    this.stats = { requests: 0, writes: 0, frames: 0, maxInFlight: 0 };
   }
 
   /**
@@ -98,7 +119,7 @@ class SerialManager extends EventEmitter {
     }
 
     const portOptions = {
-      baudRate: options.baudRate || 115200,
+      baudRate: options.baudRate || Number(process.env.MUP1_BAUD) || DEFAULT_BAUD_RATE,
       dataBits: options.dataBits || 8,
       stopBits: options.stopBits || 1,
       parity: options.parity || 'none',
@@ -207,7 +228,7 @@ class SerialManager extends EventEmitter {
     const token = options.token || Buffer.alloc(0);
 
     // Initial request with query payload
-    const initialMessageId = Math.floor(Math.random() * 65536);
+    const initialMessageId = this._nextMessageId();
     const coapFrame = buildiFetchRequest(query, {
       messageId: initialMessageId,
       token,
@@ -226,47 +247,19 @@ class SerialManager extends EventEmitter {
     }
 
     // Handle block-wise transfer (Block2 continuation)
-    let block2 = firstResponse.getBlock2Value();
-    let more = block2 ? block2.m : false;
-    let blockNum = block2 ? block2.num : 0;
-
-    while (more) {
-      blockNum++;
-      const messageId = Math.floor(Math.random() * 65536);
-      const block2Value = encodeBlock2Value(blockNum, false, block2.szx);
-
-      // For FETCH continuation, only send URI_PATH and Block2 (no payload)
-      const continuationFrame = buildMessage({
-        type: MessageType.CON,
-        code: MethodCode.FETCH,
-        messageId,
-        token,
-        options: [
-          { number: OptionNumber.URI_PATH, value: 'c' },
-          { number: OptionNumber.BLOCK2, value: block2Value }
-        ]
-      });
-
-      this.log(`[CoAP] Requesting block ${blockNum}`);
-      const response = await this._sendRequest(continuationFrame, messageId);
-      lastResponse = response;
-
-      if (!response.isSuccess()) {
-        throw new Error(`Block ${blockNum} failed with code ${response.code}`);
-      }
-
-      if (response.payload) {
-        payloads.push(response.payload);
-      }
-
-      const nextBlock2 = response.getBlock2Value();
-      if (nextBlock2) {
-        more = nextBlock2.m;
-        block2 = nextBlock2;
-      } else {
-        more = false;
-      }
-    }
+    // For FETCH continuation, only send URI_PATH and Block2 (no payload)
+    const rest = await this._readBlock2(firstResponse, (blockNum, szx, messageId) => buildMessage({
+      type: MessageType.CON,
+      code: MethodCode.FETCH,
+      messageId,
+      token,
+      options: [
+        { number: OptionNumber.URI_PATH, value: 'c' },
+        { number: OptionNumber.BLOCK2, value: encodeBlock2Value(blockNum, false, szx) }
+      ]
+    }));
+    payloads.push(...rest.payloads);
+    lastResponse = rest.lastResponse;
 
     this.log(`[CoAP] iFETCH complete. Assembled ${payloads.length} block(s).`);
     const assembledPayload = Buffer.concat(payloads);
@@ -306,16 +299,14 @@ class SerialManager extends EventEmitter {
     this.log(`[CoAP] Starting iPATCH with payload size: ${totalSize} bytes, Token: ${token.toString('hex')}`);
 
     // Initialize block parameters
-    let szx = options.blockSize || DEFAULT_BLOCK_SIZE_EXPONENT;
-    let blockSize = 1 << (szx + 4);
-    let blockNum = 0;
-    let offset = 0;
+    const szx = options.blockSize || DEFAULT_BLOCK_SIZE_EXPONENT;
+    const blockSize = 1 << (szx + 4);
 
     // Check if block-wise transfer is needed
     if (totalSize <= blockSize) {
       // Payload fits in single block - use simple iPATCH
       this.log('[CoAP] Payload fits in single block, sending without Block1 option');
-      const messageId = Math.floor(Math.random() * 65536);
+      const messageId = this._nextMessageId();
       const coapFrame = buildiPatchRequest(payload, {
         messageId,
         token,
@@ -326,88 +317,7 @@ class SerialManager extends EventEmitter {
 
     // Block-wise transfer needed
     this.log(`[CoAP] Block-wise transfer required: ${totalSize} bytes with block size ${blockSize}`);
-
-    let lastResponse = null;
-
-    while (offset < totalSize) {
-      const chunk = payload.slice(offset, offset + blockSize);
-      const moreBlocks = (offset + chunk.length) < totalSize;
-      const messageId = Math.floor(Math.random() * 65536);
-
-      // Encode Block1 option
-      const block1Value = encodeBlock1Value(blockNum, moreBlocks, szx);
-      const block1Option = { number: OptionNumber.BLOCK1, value: block1Value };
-
-      this.log(`[CoAP] Sending block ${blockNum}: offset=${offset}, size=${chunk.length}, more=${moreBlocks}, szx=${szx}`);
-
-      // Build iPATCH request with Block1 option
-      const coapOptions = [
-        { number: OptionNumber.URI_PATH, value: 'c' },
-        { number: OptionNumber.CONTENT_FORMAT, value: ContentFormat.YANG_INSTANCES_CBOR },
-        { number: OptionNumber.ACCEPT, value: ContentFormat.YANG_DATA_CBOR_SID },
-        block1Option
-      ];
-
-      const coapFrame = buildMessage({
-        type: MessageType.CON,
-        code: MethodCode.IPATCH,
-        messageId,
-        token,
-        options: coapOptions,
-        payload: chunk
-      });
-
-      try {
-        const response = await this._sendRequest(coapFrame, messageId);
-        lastResponse = response;
-
-        this.log(`[CoAP] Block ${blockNum} response: code=${response.code} (${response.getCodeClass()}.${response.getCodeDetail()})`);
-
-        // Check response code
-        if (moreBlocks) {
-          // Expect 2.31 Continue for intermediate blocks
-          if (response.code !== ResponseCode.CONTINUE) {
-            throw new Error(`Expected 2.31 Continue for block ${blockNum}, got ${response.code} (${response.getCodeClass()}.${response.getCodeDetail()})`);
-          }
-        } else {
-          // Last block - expect final response (e.g., 2.04 Changed)
-          if (!response.isSuccess()) {
-            throw new Error(`Final block ${blockNum} failed with code ${response.code} (${response.getCodeClass()}.${response.getCodeDetail()})`);
-          }
-        }
-
-        // Check for Block1 option in response (server acknowledgment and negotiation)
-        const responseBlock1 = response.getBlock1Value();
-        if (responseBlock1) {
-          this.log(`[CoAP] Server acknowledged block ${responseBlock1.num}, szx=${responseBlock1.szx}`);
-
-          // Verify block number matches
-          if (responseBlock1.num !== blockNum) {
-            throw new Error(`Block number mismatch! Sent ${blockNum}, server acknowledged ${responseBlock1.num}`);
-          }
-
-          // Handle SZX negotiation (server may request smaller blocks)
-          if (responseBlock1.szx < szx) {
-            this.log(`[CoAP] Server requested smaller block size: szx ${szx} -> ${responseBlock1.szx}`);
-            szx = responseBlock1.szx;
-            blockSize = 1 << (szx + 4);
-            // Don't change offset - continue from where we left off
-            // Next iteration will use new block size
-          }
-        }
-
-        // Move to next block
-        offset += chunk.length;
-        blockNum++;
-
-      } catch (error) {
-        console.error(`[CoAP] Block-wise iPATCH failed at block ${blockNum}:`, error);
-        throw error;
-      }
-    }
-
-    this.log(`[CoAP] Block-wise iPATCH complete. Sent ${blockNum} block(s), total ${totalSize} bytes`);
-    return lastResponse;
+    return this._sendBlock1(MethodCode.IPATCH, payload, token, szx, 'iPATCH');
   }
 
   /**
@@ -440,16 +350,14 @@ class SerialManager extends EventEmitter {
     this.log(`[CoAP] Starting PUT with payload size: ${totalSize} bytes, Token: ${token.toString('hex')}`);
 
     // Initialize block parameters
-    let szx = options.blockSize || DEFAULT_BLOCK_SIZE_EXPONENT;
-    let blockSize = 1 << (szx + 4);
-    let blockNum = 0;
-    let offset = 0;
+    const szx = options.blockSize || DEFAULT_BLOCK_SIZE_EXPONENT;
+    const blockSize = 1 << (szx + 4);
 
     // Check if block-wise transfer is needed
     if (totalSize <= blockSize) {
       // Payload fits in single block - use simple PUT without Block1
       this.log('[CoAP] Payload fits in single block, sending without Block1 option');
-      const messageId = Math.floor(Math.random() * 65536);
+      const messageId = this._nextMessageId();
       const coapFrame = buildPutRequest(payloadBuffer, {
         messageId,
         token,
@@ -460,88 +368,7 @@ class SerialManager extends EventEmitter {
 
     // Block-wise transfer needed
     this.log(`[CoAP] Block-wise transfer required: ${totalSize} bytes with block size ${blockSize}`);
-
-    let lastResponse = null;
-
-    while (offset < totalSize) {
-      const chunk = payloadBuffer.slice(offset, offset + blockSize);
-      const moreBlocks = (offset + chunk.length) < totalSize;
-      const messageId = Math.floor(Math.random() * 65536);
-
-      // Encode Block1 option
-      const block1Value = encodeBlock1Value(blockNum, moreBlocks, szx);
-      const block1Option = { number: OptionNumber.BLOCK1, value: block1Value };
-
-      this.log(`[CoAP] Sending block ${blockNum}: offset=${offset}, size=${chunk.length}, more=${moreBlocks}, szx=${szx}`);
-
-      // Build PUT request with Block1 option
-      const coapOptions = [
-        { number: OptionNumber.URI_PATH, value: 'c' },
-        { number: OptionNumber.CONTENT_FORMAT, value: ContentFormat.YANG_INSTANCES_CBOR },
-        { number: OptionNumber.ACCEPT, value: ContentFormat.YANG_DATA_CBOR_SID },
-        block1Option
-      ];
-
-      const coapFrame = buildMessage({
-        type: MessageType.CON,
-        code: MethodCode.PUT,
-        messageId,
-        token,
-        options: coapOptions,
-        payload: chunk
-      });
-
-      try {
-        const response = await this._sendRequest(coapFrame, messageId);
-        lastResponse = response;
-
-        this.log(`[CoAP] Block ${blockNum} response: code=${response.code} (${response.getCodeClass()}.${response.getCodeDetail()})`);
-
-        // Check response code
-        if (moreBlocks) {
-          // Expect 2.31 Continue for intermediate blocks
-          if (response.code !== ResponseCode.CONTINUE) {
-            throw new Error(`Expected 2.31 Continue for block ${blockNum}, got ${response.code} (${response.getCodeClass()}.${response.getCodeDetail()})`);
-          }
-        } else {
-          // Last block - expect final response (e.g., 2.04 Changed or 2.01 Created)
-          if (!response.isSuccess()) {
-            throw new Error(`Final block ${blockNum} failed with code ${response.code} (${response.getCodeClass()}.${response.getCodeDetail()})`);
-          }
-        }
-
-        // Check for Block1 option in response (server acknowledgment and negotiation)
-        const responseBlock1 = response.getBlock1Value();
-        if (responseBlock1) {
-          this.log(`[CoAP] Server acknowledged block ${responseBlock1.num}, szx=${responseBlock1.szx}`);
-
-          // Verify block number matches
-          if (responseBlock1.num !== blockNum) {
-            throw new Error(`Block number mismatch! Sent ${blockNum}, server acknowledged ${responseBlock1.num}`);
-          }
-
-          // Handle SZX negotiation (server may request smaller blocks)
-          if (responseBlock1.szx < szx) {
-            this.log(`[CoAP] Server requested smaller block size: szx ${szx} -> ${responseBlock1.szx}`);
-            szx = responseBlock1.szx;
-            blockSize = 1 << (szx + 4);
-            // Don't change offset - continue from where we left off
-            // Next iteration will use new block size
-          }
-        }
-
-        // Move to next block
-        offset += chunk.length;
-        blockNum++;
-
-      } catch (error) {
-        console.error(`[CoAP] Block-wise PUT failed at block ${blockNum}:`, error);
-        throw error;
-      }
-    }
-
-    this.log(`[CoAP] Block-wise PUT complete. Sent ${blockNum} block(s), total ${totalSize} bytes`);
-    return lastResponse;
+    return this._sendBlock1(MethodCode.PUT, payloadBuffer, token, szx, 'PUT');
   }
 
   /**
@@ -551,7 +378,7 @@ class SerialManager extends EventEmitter {
    * @returns {Promise<Object>} CoAP response
    */
   async sendPostRequest(payload, options = {}) {
-    const messageId = options.messageId || Math.floor(Math.random() * 65536);
+    const messageId = options.messageId || this._nextMessageId();
     const token = options.token || Buffer.alloc(0);
 
     const coapFrame = buildPostRequest(payload, {
@@ -589,7 +416,7 @@ class SerialManager extends EventEmitter {
     // --- 1. Initial Request ---
     // First, send a regular GET without a Block2 option.
     // The server will respond with a Block2 option if the payload is large.
-    const initialMessageId = Math.floor(Math.random() * 65536);
+    const initialMessageId = this._nextMessageId();
     const { token: _token, messageId: _mid, ...restOptions } = options;
 
     const initialCoapFrame = buildGetRequest({
@@ -611,9 +438,7 @@ class SerialManager extends EventEmitter {
     }
 
     // --- 2. Check if block-wise transfer is needed and loop ---
-    let block2 = firstResponse.getBlock2Value();
-    let more = block2 ? block2.m : false;
-    let blockNum = block2 ? block2.num : 0;
+    const block2 = firstResponse.getBlock2Value();
 
     if (block2) {
       this.log(`[CoAP] Received block ${block2.num}, more=${block2.m}, size=${block2.size}`);
@@ -624,52 +449,18 @@ class SerialManager extends EventEmitter {
       this.log('[CoAP] Response without Block2 option, transfer complete.');
     }
 
-    while (more) {
-      blockNum++;
-
-      try {
-        const messageId = Math.floor(Math.random() * 65536);
-        // Use the SZX value provided by the server in the first response
-        const block2Value = encodeBlock2Value(blockNum, false, block2.szx);
-        const block2Option = { number: OptionNumber.BLOCK2, value: block2Value };
-
-        const coapFrame = buildGetRequest({
-          ...restOptions,
-          messageId,
-          token,
-          options: [block2Option, ...(options.options || [])],
-        });
-
-        this.log(`[CoAP] Requesting block ${blockNum}`);
-        const coapResponse = await this._sendRequest(coapFrame, messageId);
-        lastResponse = coapResponse;
-
-        if (!coapResponse.isSuccess()) {
-          throw new Error(`CoAP request failed for block ${blockNum} with code ${coapResponse.code} (${coapResponse.getCodeClass()}.${coapResponse.getCodeDetail()})`);
-        }
-
-        if (coapResponse.payload) {
-          payloads.push(coapResponse.payload);
-        }
-
-        const nextBlock2 = coapResponse.getBlock2Value();
-        if (nextBlock2) {
-          this.log(`[CoAP] Received block ${nextBlock2.num}, more=${nextBlock2.m}, size=${nextBlock2.size}`);
-          if (nextBlock2.num !== blockNum) {
-            throw new Error(`Received block out of order. Expected ${blockNum}, got ${nextBlock2.num}`);
-          }
-          more = nextBlock2.m;
-          block2 = nextBlock2; // Update block info for next potential request
-        } else {
-          // This case is unexpected in the middle of a transfer but we handle it gracefully.
-          this.log('[CoAP] Response in block-wise transfer missing Block2 option. Assuming transfer is complete.');
-          more = false;
-        }
-      } catch (error) {
-        console.error(`[CoAP] Block-wise transfer failed at block ${blockNum}:`, error);
-        throw error; // Re-throw to reject the main promise
-      }
-    }
+    // Use the SZX value provided by the server in the first response
+    const rest = await this._readBlock2(firstResponse, (blockNum, blockSzx, messageId) => buildGetRequest({
+      ...restOptions,
+      messageId,
+      token,
+      options: [
+        { number: OptionNumber.BLOCK2, value: encodeBlock2Value(blockNum, false, blockSzx) },
+        ...(options.options || [])
+      ],
+    }));
+    payloads.push(...rest.payloads);
+    lastResponse = rest.lastResponse;
 
     this.log(`[CoAP] Block-wise transfer complete. Assembling ${payloads.length} block(s).`);
 
@@ -690,6 +481,260 @@ class SerialManager extends EventEmitter {
     };
   }
 
+  /**
+   * Send a Block1 (RFC 7959) upload
+   *
+   * The first block goes alone so the server can settle the block size;
+   * after that up to `window` blocks are in flight. A server asking for
+   * smaller blocks later in the transfer is followed only when no other
+   * block is in flight (always the case with window 1).
+   * @private
+   * @param {number} code - Method code (IPATCH or PUT)
+   * @param {Buffer} payload - Complete payload
+   * @param {Buffer} token - Token shared by all blocks
+   * @param {number} szx - Initial block size exponent
+   * @param {string} label - Method name for logs
+   * @returns {Promise<Object>} Response to the last block
+   */
+  async _sendBlock1(code, payload, token, szx, label) {
+    const totalSize = payload.length;
+    let blockSize = 1 << (szx + 4);
+    let blockNum = 0;
+    let offset = 0;
+    let lastResponse = null;
+    const inFlight = [];
+
+    const sendBlock = () => {
+      const chunk = payload.slice(offset, offset + blockSize);
+      const block = { num: blockNum, more: (offset + chunk.length) < totalSize };
+      const messageId = this._nextMessageId();
+
+      this.log(`[CoAP] Sending block ${block.num}: offset=${offset}, size=${chunk.length}, more=${block.more}, szx=${szx}`);
+
+      const coapFrame = buildMessage({
+        type: MessageType.CON,
+        code,
+        messageId,
+        token,
+        options: [
+          { number: OptionNumber.URI_PATH, value: 'c' },
+          { number: OptionNumber.CONTENT_FORMAT, value: ContentFormat.YANG_INSTANCES_CBOR },
+          { number: OptionNumber.ACCEPT, value: ContentFormat.YANG_DATA_CBOR_SID },
+          { number: OptionNumber.BLOCK1, value: encodeBlock1Value(block.num, block.more, szx) }
+        ],
+        payload: chunk
+      });
+
+      block.response = this._sendRequest(coapFrame, messageId);
+      block.response.catch(() => {});   // Awaited in order below; later blocks may fail after an abort
+      offset += chunk.length;
+      blockNum++;
+      return block;
+    };
+
+    try {
+      while (offset < totalSize || inFlight.length) {
+        const limit = lastResponse ? this.window : 1;
+        while (offset < totalSize && inFlight.length < limit) {
+          inFlight.push(sendBlock());
+        }
+
+        const block = inFlight.shift();
+        const response = await block.response;
+        lastResponse = response;
+
+        this.log(`[CoAP] Block ${block.num} response: code=${response.code} (${response.getCodeClass()}.${response.getCodeDetail()})`);
+
+        if (block.more) {
+          // Expect 2.31 Continue for intermediate blocks
+          if (response.code !== ResponseCode.CONTINUE) {
+            throw new Error(`Expected 2.31 Continue for block ${block.num}, got ${response.code} (${response.getCodeClass()}.${response.getCodeDetail()})`);
+          }
+        } else if (!response.isSuccess()) {
+          // Last block - expect final response (e.g., 2.04 Changed)
+          throw new Error(`Final block ${block.num} failed with code ${response.code} (${response.getCodeClass()}.${response.getCodeDetail()})`);
+        }
+
+        // Check for Block1 option in response (server acknowledgment and negotiation)
+        const responseBlock1 = response.getBlock1Value();
+        if (responseBlock1) {
+          this.log(`[CoAP] Server acknowledged block ${responseBlock1.num}, szx=${responseBlock1.szx}`);
+
+          if (responseBlock1.num !== block.num) {
+            throw new Error(`Block number mismatch! Sent ${block.num}, server acknowledged ${responseBlock1.num}`);
+          }
+
+          // Handle SZX negotiation (server may request smaller blocks)
+          if (responseBlock1.szx < szx && offset < totalSize) {
+            if (inFlight.length) {
+              throw new Error(`Server reduced block size after block ${block.num} with ${inFlight.length} block(s) in flight`);
+            }
+            this.log(`[CoAP] Server requested smaller block size: szx ${szx} -> ${responseBlock1.szx}`);
+            szx = responseBlock1.szx;
+            blockSize = 1 << (szx + 4);
+            // Continue from the same offset; block numbers count in the new size
+            blockNum = offset / blockSize;
+          }
+        }
+      }
+    } catch (error) {
+      console.error(`[CoAP] Block-wise ${label} failed:`, error);
+      throw error;
+    }
+
+    this.log(`[CoAP] Block-wise ${label} complete. Sent ${blockNum} block(s), total ${totalSize} bytes`);
+    return lastResponse;
+  }
+
+  /**
+   * Read the remaining Block2 (RFC 7959) blocks after a first response
+   *
+   * With Size2 in the first response the block count is known and up to
+   * `window` block requests are sent ahead; otherwise one at a time.
+   * @private
+   * @param {Object} firstResponse - Response carrying block 0
+   * @param {Function} buildBlock - (blockNum, szx, messageId) => CoAP frame
+   * @returns {Promise<{payloads: Buffer[], lastResponse: Object}>}
+   */
+  async _readBlock2(firstResponse, buildBlock) {
+    const payloads = [];
+    let lastResponse = firstResponse;
+    const first = firstResponse.getBlock2Value();
+    if (!first || !first.m) {
+      return { payloads, lastResponse };
+    }
+
+    const size2 = firstResponse.getSize2Value();
+    const total = size2 ? Math.ceil(size2 / first.size) : Infinity;
+    const ahead = size2 ? this.window : 1;
+    const inFlight = [];
+    let nextNum = first.num + 1;
+    let more = true;
+
+    const request = (num) => {
+      const messageId = this._nextMessageId();
+      this.log(`[CoAP] Requesting block ${num}`);
+      const response = this._sendRequest(buildBlock(num, first.szx, messageId), messageId);
+      response.catch(() => {});
+      return { num, response };
+    };
+
+    try {
+      while (more) {
+        while (inFlight.length < ahead && nextNum < total) {
+          inFlight.push(request(nextNum++));
+        }
+        if (!inFlight.length) inFlight.push(request(nextNum++));
+
+        const { num, response } = inFlight.shift();
+        lastResponse = await response;
+
+        if (!lastResponse.isSuccess()) {
+          throw new Error(`CoAP request failed for block ${num} with code ${lastResponse.code} (${lastResponse.getCodeClass()}.${lastResponse.getCodeDetail()})`);
+        }
+        if (lastResponse.payload) {
+          payloads.push(lastResponse.payload);
+        }
+
+        const block2 = lastResponse.getBlock2Value();
+        if (block2) {
+          this.log(`[CoAP] Received block ${block2.num}, more=${block2.m}, size=${block2.size}`);
+          if (block2.num !== num) {
+            throw new Error(`Received block out of order. Expected ${num}, got ${block2.num}`);
+          }
+          more = block2.m;
+        } else {
+          // Unexpected in the middle of a transfer; treat as complete
+          this.log('[CoAP] Response in block-wise transfer missing Block2 option. Assuming transfer is complete.');
+          more = false;
+        }
+      }
+    } catch (error) {
+      console.error('[CoAP] Block-wise transfer failed:', error);
+      throw error;
+    }
+
+    return { payloads, lastResponse };
+  }
+
+  /**
+   * Next free CoAP message ID (sequential, skipping IDs still outstanding)
+   * @private
+   * @returns {number}
+   */
+  _nextMessageId() {
+    do {
+      this.lastMessageId = (this.lastMessageId + 1) & 0xFFFF;
+    } while (this.pendingRequests.has(this.lastMessageId));
+    return this.lastMessageId;
+  }
+
+  /**
+   * Wait for a slot in the request window
+   * @private
+   */
+  async _acquireSlot() {
+    if (this.inFlight < this.window) {
+      this.inFlight++;
+    } else {
+      // A finishing request hands its slot over directly
+      await new Promise(resolve => this.windowWaiters.push(resolve));
+    }
+    this.stats.maxInFlight = Math.max(this.stats.maxInFlight, this.inFlight);
+  }
+
+  /**
+   * @private
+   */
+  _releaseSlot() {
+    const next = this.windowWaiters.shift();
+    if (next) {
+      next();
+    } else {
+      this.inFlight--;
+    }
+  }
+
+  /**
+   * Queue a frame for the next coalesced port.write
+   * @private
+   * @param {Buffer} frame - MUP1 frame
+   * @param {Function} onError - Called if the write fails
+   */
+  _queueWrite(frame, onError) {
+    this.writeQueue.push({ frame, onError });
+    if (this.writeQueue.length === 1) {
+      setImmediate(() => this._flushWrites());
+    }
+  }
+
+  /**
+   * Write all queued frames at once
+   * @private
+   */
+  _flushWrites() {
+    const batch = this.writeQueue;
+    this.writeQueue = [];
+    if (batch.length === 0) return;
+
+    if (!this.port) {
+      batch.forEach(({ onError }) => onError(new Error('Port closed')));
+      return;
+    }
+
+    const data = batch.length === 1 ? batch[0].frame : Buffer.concat(batch.map(({ frame }) => frame));
+    this.stats.writes++;
+    this.stats.frames += batch.length;
+    debugLog(`[DEBUG] Writing ${batch.length} frame(s), ${data.length} bytes`);
+
+    this.port.write(data, (err) => {
+      if (err) {
+        debugLog(`[DEBUG] Write failed: ${err.message}`);
+        batch.forEach(({ onError }) => onError(err));
+      }
+    });
+  }
+
   /**
    * Send CoAP frame with MUP1 wrapper
    * @private
@@ -721,33 +766,37 @@ class SerialManager extends EventEmitter {
     debugLog(`  CoAP size: ${coapFrame.length} bytes`);
     debugLog(`  Message ID: ${messageId}`);
 
+    await this._acquireSlot();
+    if (!this.isConnected) {
+      this._releaseSlot();
+      throw new Error('Not connected');
+    }
+    this.stats.requests++;
+
     // Create promise for response
     return new Promise((resolve, reject) => {
+      let settled = false;
+      const settle = (fn) => (value) => {
+        if (settled) return;
+        settled = true;
+        clearTimeout(timeout);
+        this.pendingRequests.delete(messageId);
+        this._releaseSlot();
+        fn(value);
+      };
+
       // Set timeout
       const timeout = setTimeout(() => {
         debugLog(`[DEBUG] Request timeout after ${this.requestTimeout}ms (Message ID: ${messageId})`);
-        this.pendingRequests.delete(messageId);
-        reject(new Error('Request timeout'));
+        pending.reject(new Error('Request timeout'));
       }, this.requestTimeout);
 
       // Store pending request
-      this.pendingRequests.set(messageId, {
-        resolve,
-        reject,
-        timeout
-      });
+      const pending = { resolve: settle(resolve), reject: settle(reject), timeout };
+      this.pendingRequests.set(messageId, pending);
 
-      // Send frame
-      this.port.write(mup1Frame, (err) => {
-        if (err) {
-          debugLog(`[DEBUG] Write failed: ${err.message}`);
-          clearTimeout(timeout);
-          this.pendingRequests.delete(messageId);
-          reject(new Error(`Write failed: ${err.message}`));
-        } else {
-          debugLog(`[DEBUG] Frame sent to serial port`);
-        }
-      });
+      // Send frame (coalesced with other frames queued in this tick)
+      this._queueWrite(mup1Frame, (err) => pending.reject(new Error(`Write failed: ${err.message}`)));
     });
   }
 
@@ -862,6 +911,15 @@ class SerialManager extends EventEmitter {
       isOpen: this.port.isOpen
     };
   }
+
+  /**
+   * Pipelining counters: requests sent, port writes and the frames they
+   * carried, and the most requests that were outstanding at once
+   * @returns {Object}
+   */
+  getPipelineStats() {
+    return { window: this.window, inFlight: this.inFlight, ...this.stats };
+  }
 }
 
 export {
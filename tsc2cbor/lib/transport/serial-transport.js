@@ -11,7 +11,7 @@ import { SerialManager } from '../serial/serial.js';
 class SerialTransport extends Transport {
   constructor(options = {}) {
     super(options);
-    this.serialManager = new SerialManager({ verbose: options.verbose });
+    this.serialManager = new SerialManager({ verbose: options.verbose, window: options.window });
     this.portPath = null;
 
     // Forward events from SerialManager
@@ -56,7 +56,7 @@ class SerialTransport extends Transport {
    * Connect to serial port
    * @param {Object} options - Connection options
    * @param {string} options.device - Serial device path (e.g., /dev/ttyACM0)
-   * @param {number} options.baudRate - Baud rate (default: 115200)
+   * @param {number} options.baudRate - Baud rate (default: MUP1_BAUD or 115200)
    * @returns {Promise<void>}
    */
   async connect(options = {}) {
@@ -68,7 +68,7 @@ class SerialTransport extends Transport {
     this.log(`Connecting to serial port: ${this.portPath}`);
 
     await this.serialManager.connect(this.portPath, {
-      baudRate: options.baudRate || 115200
+      baudRate: options.baudRate
     });
   }
 